@@ -127,6 +127,11 @@ void Agent::readPendingDatagrams() {
                 
                 // let this continue through to the NodeList so it updates last heard timestamp
                 // for the sending audio mixer
+                NodeList::getInstance()->processNodeData(senderSockAddr, receivedPacket);
+            } else if (datagramPacketType == PacketTypeSilentAudioFrame) {
+                // the mixer sends these in place of mixes of silence, so there's nothing left to hear
+                _receivedAudioBuffer.resetToSilence();
+                
                 NodeList::getInstance()->processNodeData(senderSockAddr, receivedPacket);
             } else {
                 NodeList::getInstance()->processNodeData(senderSockAddr, receivedPacket);
@@ -30,12 +30,30 @@
 const QString ASSIGNMENT_CLIENT_TARGET_NAME = "assignment-client";
 const long long ASSIGNMENT_REQUEST_INTERVAL_MSECS = 1 * 1000;
 
+/// The types that can run alongside other assignments in one process: they keep no process-wide state, and any threads
+/// of their own use the assignment's NodeList.  Octree servers share static stats and an instance pointer, agents share
+/// the script engine's static scripting interfaces, and the metavoxel server persists to a fixed file.
+const Assignment::Type HOSTABLE_ASSIGNMENT_TYPES[] = { Assignment::AudioMixerType, Assignment::AvatarMixerType };
+const int NUM_HOSTABLE_ASSIGNMENT_TYPES = sizeof(HOSTABLE_ASSIGNMENT_TYPES) / sizeof(HOSTABLE_ASSIGNMENT_TYPES[0]);
+
+static bool isHostableAssignmentType(Assignment::Type type) {
+    for (int i = 0; i < NUM_HOSTABLE_ASSIGNMENT_TYPES; i++) {
+        if (HOSTABLE_ASSIGNMENT_TYPES[i] == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
 int hifiSockAddrMeta = qRegisterMetaType<HifiSockAddr>("HifiSockAddr");
 
 AssignmentClient::AssignmentClient(int &argc, char **argv) :
     QCoreApplication(argc, argv),
     _currentAssignment(),
-    _assignmentServerHostname(DEFAULT_ASSIGNMENT_SERVER_HOSTNAME)
+    _assignmentServerHostname(DEFAULT_ASSIGNMENT_SERVER_HOSTNAME),
+    _maxHostedAssignments(1),
+    _hostedAssignments(),
+    _hostedTypeIndex(0)
 {
     DTLSClientSession::globalInit();
     
@@ -72,6 +90,22 @@ AssignmentClient::AssignmentClient(int &argc, char **argv) :
     // setup our _requestAssignment member variable from the passed arguments
     _requestAssignment = Assignment(Assignment::RequestCommand, requestAssignmentType, assignmentPool);
     
+    // check for a request to host several assignments in this process, each with its own NodeList on its own thread
+    const QString MAX_ASSIGNMENTS_OPTION = "--max-assignments";
+    
+    argumentIndex = argumentList.indexOf(MAX_ASSIGNMENTS_OPTION);
+    
+    if (argumentIndex != -1) {
+        _maxHostedAssignments = qMax(argumentList[argumentIndex + 1].toInt(), 1);
+        
+        if (_maxHostedAssignments > 1 && requestAssignmentType != Assignment::AllTypes
+                && !isHostableAssignmentType(requestAssignmentType)) {
+            qDebug() << "Assignments of type" << requestAssignmentType << "cannot share a process."
+                << "Hosting one assignment at a time.";
+            _maxHostedAssignments = 1;
+        }
+    }
+    
     // create a NodeList as an unassigned client
     NodeList* nodeList = NodeList::createInstance(NodeType::Unassigned);
     
@@ -109,7 +143,20 @@ AssignmentClient::~AssignmentClient() {
 }
 
 void AssignmentClient::sendAssignmentRequest() {
-    if (!_currentAssignment) {
+    if (_maxHostedAssignments > 1) {
+        if (_hostedAssignments.size() < _maxHostedAssignments) {
+            if (_requestAssignment.getType() != Assignment::AllTypes) {
+                NodeList::getInstance()->sendAssignment(_requestAssignment);
+                
+            } else {
+                // we can only take the types that share a process, so ask for each of those in turn
+                Assignment hostedRequest(Assignment::RequestCommand, HOSTABLE_ASSIGNMENT_TYPES[_hostedTypeIndex],
+                                         _requestAssignment.getPool());
+                _hostedTypeIndex = (_hostedTypeIndex + 1) % NUM_HOSTABLE_ASSIGNMENT_TYPES;
+                NodeList::getInstance()->sendAssignment(hostedRequest);
+            }
+        }
+    } else if (!_currentAssignment) {
         NodeList::getInstance()->sendAssignment(_requestAssignment);
     }
 }
@@ -126,7 +173,20 @@ void AssignmentClient::readPendingDatagrams() {
                                                senderSockAddr.getAddressPointer(), senderSockAddr.getPortPointer());
         
         if (nodeList->packetVersionAndHashMatch(receivedPacket)) {
-            if (packetTypeForPacket(receivedPacket) == PacketTypeCreateAssignment) {
+            if (packetTypeForPacket(receivedPacket) == PacketTypeCreateAssignment && _maxHostedAssignments > 1) {
+                SharedAssignmentPointer hostedAssignment(AssignmentFactory::unpackAssignment(receivedPacket));
+                
+                if (!hostedAssignment) {
+                    qDebug() << "Received an assignment that could not be unpacked. Re-requesting.";
+                    
+                } else if (!isHostableAssignmentType(hostedAssignment->getType())
+                           || _hostedAssignments.size() >= _maxHostedAssignments) {
+                    qDebug() << "Received an assignment that cannot be hosted alongside the others -" << *hostedAssignment;
+                    
+                } else {
+                    deployHostedAssignment(hostedAssignment, senderSockAddr);
+                }
+            } else if (packetTypeForPacket(receivedPacket) == PacketTypeCreateAssignment) {
                 // construct the deployed assignment from the packet data
                 _currentAssignment = SharedAssignmentPointer(AssignmentFactory::unpackAssignment(receivedPacket));
                 
@@ -172,6 +232,38 @@ void AssignmentClient::readPendingDatagrams() {
     }
 }
 
+void AssignmentClient::deployHostedAssignment(const SharedAssignmentPointer& assignment,
+                                              const HifiSockAddr& senderSockAddr) {
+    qDebug() << "Received an assignment to host -" << *assignment;
+    
+    _hostedAssignments.append(assignment);
+    
+    // the thread gives the assignment its own NodeList checking in with whoever sent us the assignment
+    AssignmentThread* workerThread = new AssignmentThread(assignment, this);
+    workerThread->hostNodeList(senderSockAddr, _assignmentServerHostname);
+    
+    connect(assignment.data(), &ThreadedAssignment::finished, workerThread, &QThread::quit);
+    connect(assignment.data(), &ThreadedAssignment::finished, this, &AssignmentClient::hostedAssignmentCompleted);
+    connect(workerThread, &QThread::finished, workerThread, &QThread::deleteLater);
+    
+    assignment->moveToThread(workerThread);
+    workerThread->start();
+}
+
+void AssignmentClient::hostedAssignmentCompleted() {
+    ThreadedAssignment* finishedAssignment = static_cast<ThreadedAssignment*>(sender());
+    
+    for (int i = 0; i < _hostedAssignments.size(); i++) {
+        if (_hostedAssignments.at(i).data() == finishedAssignment) {
+            qDebug() << "Hosted assignment finished -" << *finishedAssignment;
+            
+            // if the assignment thread is still around it has its own shared pointer to the assignment
+            _hostedAssignments.removeAt(i);
+            break;
+        }
+    }
+}
+
 void AssignmentClient::handleAuthenticationRequest() {
     const QString DATA_SERVER_USERNAME_ENV = "HIFI_AC_USERNAME";
     const QString DATA_SERVER_PASSWORD_ENV = "HIFI_AC_PASSWORD";
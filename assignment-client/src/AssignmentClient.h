@@ -25,11 +25,18 @@ private slots:
     void sendAssignmentRequest();
     void readPendingDatagrams();
     void assignmentCompleted();
+    void hostedAssignmentCompleted();
     void handleAuthenticationRequest();
 private:
+    void deployHostedAssignment(const SharedAssignmentPointer& assignment, const HifiSockAddr& senderSockAddr);
+    
     Assignment _requestAssignment;
     SharedAssignmentPointer _currentAssignment;
     QString _assignmentServerHostname;
+    
+    int _maxHostedAssignments;
+    QList<SharedAssignmentPointer> _hostedAssignments;
+    int _hostedTypeIndex;
 };
 
 #endif // hifi_AssignmentClient_h
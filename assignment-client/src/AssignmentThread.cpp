@@ -9,11 +9,43 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <NodeList.h>
+
 #include "AssignmentThread.h"
 
 AssignmentThread::AssignmentThread(const SharedAssignmentPointer& assignment, QObject* parent) :
     QThread(parent),
-    _assignment(assignment)
+    _assignment(assignment),
+    _hostsNodeList(false)
 {
     
 }
+
+void AssignmentThread::hostNodeList(const HifiSockAddr& domainSockAddr, const QString& domainHostname) {
+    _hostsNodeList = true;
+    _domainSockAddr = domainSockAddr;
+    _domainHostname = domainHostname;
+}
+
+void AssignmentThread::run() {
+    if (!_hostsNodeList) {
+        QThread::run();
+        return;
+    }
+    
+    // create the NodeList on this thread so that its socket lives here with the assignment
+    NodeList* nodeList = NodeList::createThreadInstance(NodeType::Unassigned);
+    nodeList->getDomainHandler().setSockAddr(_domainSockAddr, _domainHostname);
+    nodeList->getDomainHandler().setAssignmentUUID(_assignment->getUUID());
+    
+    // let the assignment handle the incoming datagrams for its duration
+    connect(&nodeList->getNodeSocket(), &QUdpSocket::readyRead, _assignment.data(),
+            &ThreadedAssignment::readPendingDatagrams);
+    
+    // run the assignment once the event loop is going
+    QMetaObject::invokeMethod(_assignment.data(), "run", Qt::QueuedConnection);
+    exec();
+    
+    LimitedNodeList::setThreadInstance(NULL);
+    delete nodeList;
+}
@@ -19,8 +19,19 @@
 class AssignmentThread : public QThread {
 public:
     AssignmentThread(const SharedAssignmentPointer& assignment, QObject* parent);
+    
+    /// Has the thread give the assignment its own NodeList (and socket) checking in with the specified domain, so that
+    /// it can be hosted alongside other assignments in this process.  The thread then runs the assignment itself.
+    void hostNodeList(const HifiSockAddr& domainSockAddr, const QString& domainHostname);
+    
+protected:
+    virtual void run();
+    
 private:
     SharedAssignmentPointer _assignment;
+    bool _hostsNodeList;
+    HifiSockAddr _domainSockAddr;
+    QString _domainHostname;
 };
 
 #endif // hifi_AssignmentThread_h
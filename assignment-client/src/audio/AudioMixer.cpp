@@ -42,10 +42,12 @@
 #include <NodeList.h>
 #include <Node.h>
 #include <PacketHeaders.h>
+#include <PacketReceiver.h>
 #include <SharedUtil.h>
 #include <StdDev.h>
 #include <UUID.h>
 
+#include "AudioCodec.h"
 #include "AudioRingBuffer.h"
 #include "AudioMixerClientData.h"
 #include "AvatarAudioRingBuffer.h"
@@ -60,6 +62,13 @@ const float LOUDNESS_TO_DISTANCE_RATIO = 0.00305f;
 
 const QString AUDIO_MIXER_LOGGING_TARGET_NAME = "audio-mixer";
 
+const int AUDIO_RECEIVE_QUEUE_CAPACITY = 4096;
+const int OTHER_RECEIVE_QUEUE_CAPACITY = 1024;
+
+// while a listener's mix is empty, we remind it once a second or so that it's silent rather than lost
+const int SILENT_MIX_MARKER_INTERVAL_FRAMES = 100;
+const int16_t NUM_SILENT_MIX_SAMPLES = NETWORK_BUFFER_LENGTH_SAMPLES_STEREO;
+
 void attachNewBufferToNode(Node *newNode) {
     if (!newNode->getLinkedData()) {
         newNode->setLinkedData(new AudioMixerClientData());
@@ -73,12 +82,13 @@ AudioMixer::AudioMixer(const QByteArray& packet) :
     _performanceThrottlingRatio(0.0f),
     _numStatFrames(0),
     _sumListeners(0),
+    _sumSilentListeners(0),
     _sumMixes(0)
 {
     
 }
 
-void AudioMixer::addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
+bool AudioMixer::addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
                                                           AvatarAudioRingBuffer* listeningNodeBuffer) {
     float bearingRelativeAngleToSource = 0.0f;
     float attenuationCoefficient = 1.0f;
@@ -98,7 +108,7 @@ void AudioMixer::addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuf
         if (bufferToAdd->getNextOutputTrailingLoudness() / distanceBetween <= _minAudibilityThreshold) {
             // according to mixer performance we have decided this does not get to be mixed in
             // bail out
-            return;
+            return false;
         }
         
         ++_sumMixes;
@@ -305,13 +315,17 @@ void AudioMixer::addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuf
             _clientSamples[parentIndex + delayedChannelOffset] = shortResults[3];
         }
     }
+    
+    return true;
 }
 
-void AudioMixer::prepareMixForListeningNode(Node* node) {
+bool AudioMixer::prepareMixForListeningNode(Node* node) {
     AvatarAudioRingBuffer* nodeRingBuffer = ((AudioMixerClientData*) node->getLinkedData())->getAvatarAudioRingBuffer();
 
     // zero out the client mix for this node
     memset(_clientSamples, 0, NETWORK_BUFFER_LENGTH_BYTES_STEREO);
+    
+    bool hasMixedSource = false;
 
     // loop through all other nodes that have sufficient audio to mix
     foreach (const SharedNodePointer& otherNode, NodeList::getInstance()->getNodeHash()) {
@@ -327,11 +341,15 @@ void AudioMixer::prepareMixForListeningNode(Node* node) {
                      || otherNodeBuffer->shouldLoopbackForNode())
                     && otherNodeBuffer->willBeAddedToMix()
                     && otherNodeBuffer->getNextOutputTrailingLoudness() > 0) {
-                    addBufferToMixForListeningNodeWithBuffer(otherNodeBuffer, nodeRingBuffer);
+                    if (addBufferToMixForListeningNodeWithBuffer(otherNodeBuffer, nodeRingBuffer)) {
+                        hasMixedSource = true;
+                    }
                 }
             }
         }
     }
+    
+    return hasMixedSource;
 }
 
 
@@ -359,7 +377,7 @@ void AudioMixer::readPendingDatagrams() {
 }
 
 void AudioMixer::sendStatsPacket() {
-    static QJsonObject statsObject;
+    QJsonObject statsObject;
     statsObject["trailing_sleep_percentage"] = _trailingSleepRatio * 100.0f;
     statsObject["performance_throttling_ratio"] = _performanceThrottlingRatio;
 
@@ -371,9 +389,12 @@ void AudioMixer::sendStatsPacket() {
         statsObject["average_mixes_per_listener"] = 0.0;
     }
     
-//    ThreadedAssignment::addPacketStatsAndSendStatsPacket(statsObject);
+    statsObject["average_silent_listeners_per_frame"] = (float) _sumSilentListeners / (float) _numStatFrames;
+    
+    ThreadedAssignment::addPacketStatsAndSendStatsPacket(statsObject);
     
     _sumListeners = 0;
+    _sumSilentListeners = 0;
     _sumMixes = 0;
     _numStatFrames = 0;
 }
@@ -387,13 +408,23 @@ void AudioMixer::run() {
     nodeList->addNodeTypeToInterestSet(NodeType::Agent);
 
     nodeList->linkedDataCreateCallback = attachNewBufferToNode;
+    
+    if (isReceiveThreadRequested()) {
+        // receive continuously, and take what's arrived at the start of each frame
+        PacketReceiver* receiver = new PacketReceiver(OTHER_RECEIVE_QUEUE_CAPACITY);
+        receiver->addQueue("audio", QList<PacketType>() << PacketTypeMicrophoneAudioNoEcho
+            << PacketTypeMicrophoneAudioWithEcho << PacketTypeInjectAudio << PacketTypeSilentAudioFrame,
+            AUDIO_RECEIVE_QUEUE_CAPACITY);
+        startReceiveThread(receiver);
+    }
 
     int nextFrame = 0;
     timeval startTime;
 
     gettimeofday(&startTime, NULL);
     
-    char* clientMixBuffer = new char[NETWORK_BUFFER_LENGTH_BYTES_STEREO
+    // room for the mix in the least compressed codec
+    char* clientMixBuffer = new char[NETWORK_BUFFER_LENGTH_BYTES_STEREO + sizeof(AudioCodecType_t)
                                      + numBytesForPacketHeaderGivenPacketType(PacketTypeMixedAudio)];
     
     int usecToSleep = BUFFER_SEND_INTERVAL_USECS;
@@ -403,6 +434,10 @@ void AudioMixer::run() {
 
     while (!_isFinished) {
         
+        if (hasReceiveThread()) {
+            readPendingDatagrams();
+        }
+        
         foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
             if (node->getLinkedData()) {
                 ((AudioMixerClientData*) node->getLinkedData())->checkBuffersBeforeFrameSend(JITTER_BUFFER_SAMPLES);
@@ -464,12 +499,33 @@ void AudioMixer::run() {
         foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
             if (node->getType() == NodeType::Agent && node->getActiveSocket() && node->getLinkedData()
                 && ((AudioMixerClientData*) node->getLinkedData())->getAvatarAudioRingBuffer()) {
-                prepareMixForListeningNode(node.data());
+                AudioMixerClientData* listenerData = (AudioMixerClientData*) node->getLinkedData();
                 
-                int numBytesPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeMixedAudio);
-
-                memcpy(clientMixBuffer + numBytesPacketHeader, _clientSamples, NETWORK_BUFFER_LENGTH_BYTES_STEREO);
-                nodeList->writeDatagram(clientMixBuffer, NETWORK_BUFFER_LENGTH_BYTES_STEREO + numBytesPacketHeader, node);
+                if (prepareMixForListeningNode(node.data())) {
+                    int numBytesPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeMixedAudio);
+                    
+                    // encode the mix with whatever codec the listener sends its own audio in
+                    const int NUM_MIX_CHANNELS = 2;
+                    int numAudioBytes = AudioCodec::encodeWithType(listenerData->getAvatarAudioRingBuffer()->getCodecType(),
+                        _clientSamples, NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL, NUM_MIX_CHANNELS,
+                        clientMixBuffer + numBytesPacketHeader);
+                    nodeList->writeDatagram(clientMixBuffer, numAudioBytes + numBytesPacketHeader, node);
+                    
+                    listenerData->setNumSilentFramesSent(0);
+                    
+                } else {
+                    // nothing reached this listener, so rather than a mix of zeros we tell it (now and then) that the
+                    // stream is silent, and it can stop expecting audio until the next mix arrives
+                    int numSilentFramesSent = listenerData->getNumSilentFramesSent();
+                    if (numSilentFramesSent % SILENT_MIX_MARKER_INTERVAL_FRAMES == 0) {
+                        int numBytesPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeSilentAudioFrame);
+                        memcpy(clientMixBuffer + numBytesPacketHeader, &NUM_SILENT_MIX_SAMPLES, sizeof(int16_t));
+                        nodeList->writeDatagram(clientMixBuffer, sizeof(int16_t) + numBytesPacketHeader, node);
+                    }
+                    listenerData->setNumSilentFramesSent(numSilentFramesSent + 1);
+                    
+                    ++_sumSilentListeners;
+                }
                 
                 ++_sumListeners;
             }
@@ -35,11 +35,13 @@ public slots:
     void sendStatsPacket();
 private:
     /// adds one buffer to the mix for a listening node
-    void addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
+    /// \return false if the buffer was too quiet (at the listener's distance) to be mixed in
+    bool addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
                                                   AvatarAudioRingBuffer* listeningNodeBuffer);
     
-    /// prepares and sends a mix to one Node
-    void prepareMixForListeningNode(Node* node);
+    /// prepares a mix for one Node
+    /// \return whether any source made it into the mix
+    bool prepareMixForListeningNode(Node* node);
     
     // client samples capacity is larger than what will be sent to optimize mixing
     // we are MMX adding 4 samples at a time so we need client samples to have an extra 4
@@ -50,6 +52,7 @@ private:
     float _performanceThrottlingRatio;
     int _numStatFrames;
     int _sumListeners;
+    int _sumSilentListeners;
     int _sumMixes;
 };
 
@@ -19,7 +19,8 @@
 #include "AudioMixerClientData.h"
 
 AudioMixerClientData::AudioMixerClientData() :
-    _ringBuffers()
+    _ringBuffers(),
+    _numSilentFramesSent(0)
 {
     
 }
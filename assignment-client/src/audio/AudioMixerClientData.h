@@ -30,8 +30,13 @@ public:
     int parseData(const QByteArray& packet);
     void checkBuffersBeforeFrameSend(int jitterBufferLengthSamples);
     void pushBuffersAfterFrameSend();
+    
+    /// Returns the number of frames in a row for which this listener's mix has been empty.
+    int getNumSilentFramesSent() const { return _numSilentFramesSent; }
+    void setNumSilentFramesSent(int numSilentFramesSent) { _numSilentFramesSent = numSilentFramesSent; }
 private:
     std::vector<PositionalAudioRingBuffer*> _ringBuffers;
+    int _numSilentFramesSent;
 };
 
 #endif // hifi_AudioMixerClientData_h
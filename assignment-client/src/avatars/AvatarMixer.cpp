@@ -12,12 +12,14 @@
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDateTime>
 #include <QtCore/QJsonObject>
+#include <QtCore/QRunnable>
 #include <QtCore/QTimer>
 #include <QtCore/QThread>
 
 #include <Logging.h>
 #include <NodeList.h>
 #include <PacketHeaders.h>
+#include <PacketReceiver.h>
 #include <SharedUtil.h>
 #include <UUID.h>
 
@@ -29,19 +31,30 @@ const QString AVATAR_MIXER_LOGGING_NAME = "avatar-mixer";
 
 const unsigned int AVATAR_DATA_SEND_INTERVAL_MSECS = (1.0f / 60.0f) * 1000;
 
+const int AVATAR_RECEIVE_QUEUE_CAPACITY = 4096;
+const int OTHER_RECEIVE_QUEUE_CAPACITY = 1024;
+
 AvatarMixer::AvatarMixer(const QByteArray& packet) :
     ThreadedAssignment(packet),
     _broadcastThread(),
+    _broadcastNodeList(NULL),
     _lastFrameTimestamp(QDateTime::currentMSecsSinceEpoch()),
-    _trailingSleepRatio(1.0f),
+    _trailingFrameRatio(0.0f),
     _performanceThrottlingRatio(0.0f),
+    _framesSinceCutoffEvent(0),
     _sumListeners(0),
     _numStatFrames(0),
     _sumBillboardPackets(0),
-    _sumIdentityPackets(0)
+    _sumIdentityPackets(0),
+    _sumFrameUsecs(0),
+    _maxFrameUsecs(0),
+    _sumSnapshotUsecs(0),
+    _numFramesOverBudget(0),
+    _sumWorkers(0),
+    _threadNodeList(NULL)
 {
-    // make sure we hear about node kills so we can tell the other nodes
-    connect(NodeList::getInstance(), &NodeList::nodeKilled, this, &AvatarMixer::nodeKilled);
+    // the broadcast thread takes a share of the listeners itself
+    _workerPool.setMaxThreadCount(qMax(QThread::idealThreadCount() - 1, 1));
 }
 
 AvatarMixer::~AvatarMixer() {
@@ -57,161 +70,276 @@ void attachAvatarDataToNode(Node* newNode) {
 
 const float BILLBOARD_AND_IDENTITY_SEND_PROBABILITY = 1.0f / 300.0f;
 
+/// The fewest listeners worth handing to a worker of their own; below this, the threads cost more than they save.
+const int MIN_LISTENERS_PER_BROADCAST_WORKER = 16;
+
+/// Sends a range of the frame's listeners their data on one of the worker threads.
+class AvatarBroadcastWorker : public QRunnable {
+public:
+    
+    AvatarBroadcastWorker(AvatarMixer* mixer, int firstListener, int lastListener, BroadcastWorkerStats& stats);
+    
+    virtual void run();
+
+private:
+    
+    AvatarMixer* _mixer;
+    int _firstListener;
+    int _lastListener;
+    BroadcastWorkerStats& _stats;
+};
+
+AvatarBroadcastWorker::AvatarBroadcastWorker(AvatarMixer* mixer, int firstListener, int lastListener,
+        BroadcastWorkerStats& stats) :
+    _mixer(mixer),
+    _firstListener(firstListener),
+    _lastListener(lastListener),
+    _stats(stats)
+{
+}
+
+void AvatarBroadcastWorker::run() {
+    // the pool's threads aren't the mixer's own, so it counts what we use
+    quint64 cpuStart = usecThreadCPUTime();
+    _mixer->broadcastToListeners(_firstListener, _lastListener, _stats);
+    _mixer->addThreadCPUUsecs(usecThreadCPUTime() - cpuStart);
+}
+
+/// A small generator for each worker, since rand shares its state (and a lock) between threads.
+static float nextRandomFloat(quint32& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (state % 10000) / 10000.0f;
+}
+
+/// Starts a bulk packet in a buffer of its own, since the last one went to the queue.  Reserving keeps the appends from
+/// going back to the heap.
+static void startBulkPacket(QByteArray& packet, const QByteArray& header) {
+    packet = header;
+    packet.reserve(MAX_PACKET_SIZE);
+}
+
+/// Hands a packet to the broadcast thread to send; the packet data is shared, not copied.
+static void queuePacket(BroadcastWorkerStats& stats, const QByteArray& packet, const SharedNodePointer& destination) {
+    AvatarBroadcastPacket outgoing;
+    outgoing.destination = destination;
+    outgoing.packet = packet;
+    stats.packets.append(outgoing);
+}
+
 // NOTE: some additional optimizations to consider.
 //    1) use the view frustum to cull those avatars that are out of view. Since avatar data doesn't need to be present
 //       if the avatar is not in view or in the keyhole.
 void AvatarMixer::broadcastAvatarData() {
+    quint64 frameStart = usecTimestampNow();
+    quint64 cpuStart = usecThreadCPUTime();
     
-    int idleTime = QDateTime::currentMSecsSinceEpoch() - _lastFrameTimestamp;
+    if (hasReceiveThread()) {
+        // take whatever's arrived since the last frame
+        readPendingDatagrams();
+    }
     
     ++_numStatFrames;
     
-    const float STRUGGLE_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD = 0.10f;
-    const float BACK_OFF_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD = 0.20f;
+    _broadcastNodeList = NodeList::getInstance();
+    takeSnapshot();
+    quint64 snapshotEnd = usecTimestampNow();
+    _sumSnapshotUsecs += snapshotEnd - frameStart;
     
-    const float RATIO_BACK_OFF = 0.02f;
+    // split the listeners between the workers, keeping the last share for this thread
+    int numWorkers = qBound(1, _listeners.size() / MIN_LISTENERS_PER_BROADCAST_WORKER, QThread::idealThreadCount());
+    QVector<BroadcastWorkerStats> workerStats(numWorkers);
+    int listenersPerWorker = (_listeners.size() + numWorkers - 1) / numWorkers;
+    for (int i = 0; i < numWorkers - 1; i++) {
+        _workerPool.start(new AvatarBroadcastWorker(this, i * listenersPerWorker, (i + 1) * listenersPerWorker,
+            workerStats[i]));
+    }
+    broadcastToListeners((numWorkers - 1) * listenersPerWorker, _listeners.size(), workerStats[numWorkers - 1]);
+    _workerPool.waitForDone();
     
-    const int TRAILING_AVERAGE_FRAMES = 100;
-    int framesSinceCutoffEvent = TRAILING_AVERAGE_FRAMES;
+    // QUdpSocket isn't safe to share, so the packets all go out from this thread, in the order the workers built them
+    foreach (const BroadcastWorkerStats& stats, workerStats) {
+        foreach (const AvatarBroadcastPacket& packet, stats.packets) {
+            _broadcastNodeList->writeDatagram(packet.packet, packet.destination);
+        }
+        _sumListeners += stats.listeners;
+        _sumBillboardPackets += stats.billboardPackets;
+        _sumIdentityPackets += stats.identityPackets;
+    }
+    _sumWorkers += numWorkers;
     
-    const float CURRENT_FRAME_RATIO = 1.0f / TRAILING_AVERAGE_FRAMES;
-    const float PREVIOUS_FRAMES_RATIO = 1.0f - CURRENT_FRAME_RATIO;
+    // let go of the nodes and data until the next frame
+    _snapshot.clear();
+    _listeners.clear();
     
-    _trailingSleepRatio = (PREVIOUS_FRAMES_RATIO * _trailingSleepRatio)
-        + (idleTime * CURRENT_FRAME_RATIO / (float) AVATAR_DATA_SEND_INTERVAL_MSECS);
+    _lastFrameTimestamp = QDateTime::currentMSecsSinceEpoch();
     
-    float lastCutoffRatio = _performanceThrottlingRatio;
-    bool hasRatioChanged = false;
+    quint64 frameUsecs = usecTimestampNow() - frameStart;
+    _sumFrameUsecs += frameUsecs;
+    _maxFrameUsecs = qMax(_maxFrameUsecs, frameUsecs);
+    if (frameUsecs > AVATAR_DATA_SEND_INTERVAL_MSECS * USECS_PER_MSEC) {
+        ++_numFramesOverBudget;
+    }
+    updatePerformanceThrottling(frameUsecs);
     
-    if (framesSinceCutoffEvent >= TRAILING_AVERAGE_FRAMES) {
-        if (_trailingSleepRatio <= STRUGGLE_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD) {
-            // we're struggling - change our min required loudness to reduce some load
-            _performanceThrottlingRatio = _performanceThrottlingRatio + (0.5f * (1.0f - _performanceThrottlingRatio));
+    // we're on the broadcast thread rather than the assignment's, so our time is counted separately
+    addThreadCPUUsecs(usecThreadCPUTime() - cpuStart);
+}
+
+void AvatarMixer::takeSnapshot() {
+    populatePacketHeader(_bulkPacketHeader, PacketTypeBulkAvatarData);
+    
+    foreach (const SharedNodePointer& node, _broadcastNodeList->getNodeHash()) {
+        AvatarMixerClientData* nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData());
+        if (!nodeData) {
+            continue;
+        }
+        AvatarSnapshot snapshot;
+        snapshot.node = node;
+        
+        // this is the only time in the frame we need the lock, and we hold it just long enough to copy
+        QMutexLocker locker(&nodeData->getMutex());
+        
+        AvatarData& avatar = nodeData->getAvatar();
+        snapshot.position = avatar.getPosition();
+        
+        // the avatar's data is the same for every listener, so it's only written once a frame
+        snapshot.avatarData = node->getUUID().toRfc4122();
+        snapshot.avatarData.append(avatar.toByteArray());
+        
+        snapshot.billboardChangeTimestamp = nodeData->getBillboardChangeTimestamp();
+        if (snapshot.billboardChangeTimestamp > 0) {
+            snapshot.billboardPacket = nodeData->getBillboardPacket(node->getUUID());
+        }
+        snapshot.identityChangeTimestamp = nodeData->getIdentityChangeTimestamp();
+        if (snapshot.identityChangeTimestamp > 0) {
+            snapshot.identityPacket = nodeData->getIdentityPacket(node->getUUID());
+        }
+        
+        snapshot.isNewListener = false;
+        if (node->getType() == NodeType::Agent && node->getActiveSocket()) {
+            // if the receiving avatar has just connected make sure we send out everyone's billboard and identity
+            snapshot.isNewListener = !nodeData->checkAndSetHasReceivedFirstPackets();
+            _listeners.append(_snapshot.size());
+        }
+        _snapshot.append(snapshot);
+    }
+}
+
+void AvatarMixer::broadcastToListeners(int firstListener, int lastListener, BroadcastWorkerStats& stats) {
+    quint32 randomState = (quint32)usecTimestampNow() ^ ((quint32)firstListener * 2654435761u);
+    if (randomState == 0) {
+        randomState = 1;
+    }
+    
+    QByteArray mixedAvatarByteArray;
+    
+    for (int i = firstListener; i < lastListener; i++) {
+        const AvatarSnapshot& listener = _snapshot.at(_listeners.at(i));
+        ++stats.listeners;
+        
+        startBulkPacket(mixedAvatarByteArray, _bulkPacketHeader);
+        
+        // this is an AGENT we have received head data from
+        // send back a packet with other active node data to this node
+        for (int j = 0; j < _snapshot.size(); j++) {
+            const AvatarSnapshot& other = _snapshot.at(j);
+            if (other.node == listener.node) {
+                continue;
+            }
+            float distanceToAvatar = glm::length(listener.position - other.position);
+            //  The full rate distance is the distance at which EVERY update will be sent for this avatar
+            //  at a distance of twice the full rate distance, there will be a 50% chance of sending this avatar's update
+            const float FULL_RATE_DISTANCE = 2.f;
             
-            qDebug() << "Mixer is struggling, sleeping" << _trailingSleepRatio * 100 << "% of frame time. Old cutoff was"
-            << lastCutoffRatio << "and is now" << _performanceThrottlingRatio;
-            hasRatioChanged = true;
-        } else if (_trailingSleepRatio >= BACK_OFF_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD && _performanceThrottlingRatio != 0) {
-            // we've recovered and can back off the required loudness
-            _performanceThrottlingRatio = _performanceThrottlingRatio - RATIO_BACK_OFF;
+            //  Decide whether to send this avatar's data based on it's distance from us
+            if ((_performanceThrottlingRatio != 0 && nextRandomFloat(randomState) >= (1.0f - _performanceThrottlingRatio))
+                || (distanceToAvatar != 0.f && nextRandomFloat(randomState) >= FULL_RATE_DISTANCE / distanceToAvatar)) {
+                continue;
+            }
+            if (other.avatarData.size() + mixedAvatarByteArray.size() > MAX_PACKET_SIZE) {
+                queuePacket(stats, mixedAvatarByteArray, listener.node);
+                
+                // the queued packet keeps that buffer, so start a new one
+                startBulkPacket(mixedAvatarByteArray, _bulkPacketHeader);
+            }
             
-            if (_performanceThrottlingRatio < 0) {
-                _performanceThrottlingRatio = 0;
+            // copy the avatar into the mixedAvatarByteArray packet, whose reserved capacity it fits
+            mixedAvatarByteArray.append(other.avatarData);
+            
+            // we will also force a send of billboard or identity packet
+            // if either has changed in the last frame
+            
+            if (!other.billboardPacket.isEmpty()
+                && (listener.isNewListener
+                    || other.billboardChangeTimestamp > _lastFrameTimestamp
+                    || nextRandomFloat(randomState) < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
+                queuePacket(stats, other.billboardPacket, listener.node);
+                
+                ++stats.billboardPackets;
             }
             
-            qDebug() << "Mixer is recovering, sleeping" << _trailingSleepRatio * 100 << "% of frame time. Old cutoff was"
-            << lastCutoffRatio << "and is now" << _performanceThrottlingRatio;
-            hasRatioChanged = true;
+            if (!other.identityPacket.isEmpty()
+                && (listener.isNewListener
+                    || other.identityChangeTimestamp > _lastFrameTimestamp
+                    || nextRandomFloat(randomState) < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
+                queuePacket(stats, other.identityPacket, listener.node);
+                
+                ++stats.identityPackets;
+            }
         }
         
-        if (hasRatioChanged) {
-            framesSinceCutoffEvent = 0;
-        }
+        queuePacket(stats, mixedAvatarByteArray, listener.node);
     }
+}
+
+void AvatarMixer::updatePerformanceThrottling(quint64 frameUsecs) {
+    const float STRUGGLE_TRIGGER_FRAME_RATIO_THRESHOLD = 0.90f;
+    const float BACK_OFF_TRIGGER_FRAME_RATIO_THRESHOLD = 0.80f;
     
-    if (!hasRatioChanged) {
-        ++framesSinceCutoffEvent;
-    }
+    const float RATIO_BACK_OFF = 0.02f;
     
-    static QByteArray mixedAvatarByteArray;
+    const int TRAILING_AVERAGE_FRAMES = 100;
     
-    int numPacketHeaderBytes = populatePacketHeader(mixedAvatarByteArray, PacketTypeBulkAvatarData);
+    const float CURRENT_FRAME_RATIO = 1.0f / TRAILING_AVERAGE_FRAMES;
+    const float PREVIOUS_FRAMES_RATIO = 1.0f - CURRENT_FRAME_RATIO;
     
-    NodeList* nodeList = NodeList::getInstance();
+    // the share of the frame interval that the frames take, which (unlike the time we sleep) doesn't depend on how
+    // promptly the timer fires
+    _trailingFrameRatio = (PREVIOUS_FRAMES_RATIO * _trailingFrameRatio)
+        + (frameUsecs * CURRENT_FRAME_RATIO / (float) (AVATAR_DATA_SEND_INTERVAL_MSECS * USECS_PER_MSEC));
     
-    AvatarMixerClientData* nodeData = NULL;
-    AvatarMixerClientData* otherNodeData = NULL;
+    float lastCutoffRatio = _performanceThrottlingRatio;
+    bool hasRatioChanged = false;
     
-    foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
-        if (node->getLinkedData() && node->getType() == NodeType::Agent && node->getActiveSocket()
-            && (nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData()))->getMutex().tryLock()) {
-            ++_sumListeners;
-            
-            // reset packet pointers for this node
-            mixedAvatarByteArray.resize(numPacketHeaderBytes);
-            
-            AvatarData& avatar = nodeData->getAvatar();
-            glm::vec3 myPosition = avatar.getPosition();
+    if (_framesSinceCutoffEvent >= TRAILING_AVERAGE_FRAMES) {
+        if (_trailingFrameRatio >= STRUGGLE_TRIGGER_FRAME_RATIO_THRESHOLD) {
+            // we're struggling - drop some of the updates to reduce some load
+            _performanceThrottlingRatio = _performanceThrottlingRatio + (0.5f * (1.0f - _performanceThrottlingRatio));
             
-            // this is an AGENT we have received head data from
-            // send back a packet with other active node data to this node
-            foreach (const SharedNodePointer& otherNode, nodeList->getNodeHash()) {
-                if (otherNode->getLinkedData() && otherNode->getUUID() != node->getUUID()
-                    && (otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData()))->getMutex().tryLock()) {
-                    
-                    AvatarMixerClientData* otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData());
-                    AvatarData& otherAvatar = otherNodeData->getAvatar();
-                    glm::vec3 otherPosition = otherAvatar.getPosition();
+            qDebug() << "Mixer is struggling, frames take" << _trailingFrameRatio * 100
+                << "% of frame time. Old cutoff was" << lastCutoffRatio << "and is now" << _performanceThrottlingRatio;
+            hasRatioChanged = true;
+        } else if (_trailingFrameRatio <= BACK_OFF_TRIGGER_FRAME_RATIO_THRESHOLD && _performanceThrottlingRatio != 0) {
+            // we've recovered and can back off the dropped updates
+            _performanceThrottlingRatio = _performanceThrottlingRatio - RATIO_BACK_OFF;
             
-                    float distanceToAvatar = glm::length(myPosition - otherPosition);
-                    //  The full rate distance is the distance at which EVERY update will be sent for this avatar
-                    //  at a distance of twice the full rate distance, there will be a 50% chance of sending this avatar's update
-                    const float FULL_RATE_DISTANCE = 2.f;
-                    
-                    //  Decide whether to send this avatar's data based on it's distance from us
-                    if ((_performanceThrottlingRatio == 0 || randFloat() < (1.0f - _performanceThrottlingRatio))
-                        && (distanceToAvatar == 0.f || randFloat() < FULL_RATE_DISTANCE / distanceToAvatar)) {
-                        QByteArray avatarByteArray;
-                        avatarByteArray.append(otherNode->getUUID().toRfc4122());
-                        avatarByteArray.append(otherAvatar.toByteArray());
-                        
-                        if (avatarByteArray.size() + mixedAvatarByteArray.size() > MAX_PACKET_SIZE) {
-                            nodeList->writeDatagram(mixedAvatarByteArray, node);
-                            
-                            // reset the packet
-                            mixedAvatarByteArray.resize(numPacketHeaderBytes);
-                        }
-                        
-                        // copy the avatar into the mixedAvatarByteArray packet
-                        mixedAvatarByteArray.append(avatarByteArray);
-                        
-                        // if the receiving avatar has just connected make sure we send out the mesh and billboard
-                        // for this avatar (assuming they exist)
-                        bool forceSend = !nodeData->checkAndSetHasReceivedFirstPackets();
-                        
-                        // we will also force a send of billboard or identity packet
-                        // if either has changed in the last frame
-                        
-                        if (otherNodeData->getBillboardChangeTimestamp() > 0
-                            && (forceSend
-                                || otherNodeData->getBillboardChangeTimestamp() > _lastFrameTimestamp
-                                || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
-                            QByteArray billboardPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarBillboard);
-                            billboardPacket.append(otherNode->getUUID().toRfc4122());
-                            billboardPacket.append(otherNodeData->getAvatar().getBillboard());
-                            nodeList->writeDatagram(billboardPacket, node);
-                            
-                            ++_sumBillboardPackets;
-                        }
-                        
-                        if (otherNodeData->getIdentityChangeTimestamp() > 0
-                            && (forceSend
-                                || otherNodeData->getIdentityChangeTimestamp() > _lastFrameTimestamp
-                                || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
-                                
-                            QByteArray identityPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarIdentity);
-                            
-                            QByteArray individualData = otherNodeData->getAvatar().identityByteArray();
-                            individualData.replace(0, NUM_BYTES_RFC4122_UUID, otherNode->getUUID().toRfc4122());
-                            identityPacket.append(individualData);
-                            
-                            nodeList->writeDatagram(identityPacket, node);
-                                
-                            ++_sumIdentityPackets;
-                        }
-                    }
-                
-                    otherNodeData->getMutex().unlock();
-                }
+            if (_performanceThrottlingRatio < 0) {
+                _performanceThrottlingRatio = 0;
             }
             
-            nodeList->writeDatagram(mixedAvatarByteArray, node);
-            
-            nodeData->getMutex().unlock();
+            qDebug() << "Mixer is recovering, frames take" << _trailingFrameRatio * 100
+                << "% of frame time. Old cutoff was" << lastCutoffRatio << "and is now" << _performanceThrottlingRatio;
+            hasRatioChanged = true;
         }
     }
     
-    _lastFrameTimestamp = QDateTime::currentMSecsSinceEpoch();
+    if (hasRatioChanged) {
+        _framesSinceCutoffEvent = 0;
+    } else {
+        ++_framesSinceCutoffEvent;
+    }
 }
 
 void AvatarMixer::nodeKilled(SharedNodePointer killedNode) {
@@ -250,8 +378,8 @@ void AvatarMixer::readPendingDatagrams() {
                         AvatarData& avatar = nodeData->getAvatar();
                         
                         // parse the identity packet and update the change timestamp if appropriate
+                        QMutexLocker nodeDataLocker(&nodeData->getMutex());
                         if (avatar.hasIdentityChangedAfterParsing(receivedPacket)) {
-                            QMutexLocker nodeDataLocker(&nodeData->getMutex());
                             nodeData->setIdentityChangeTimestamp(QDateTime::currentMSecsSinceEpoch());
                         }
                     }
@@ -267,8 +395,8 @@ void AvatarMixer::readPendingDatagrams() {
                         AvatarData& avatar = nodeData->getAvatar();
                         
                         // parse the billboard packet and update the change timestamp if appropriate
+                        QMutexLocker nodeDataLocker(&nodeData->getMutex());
                         if (avatar.hasBillboardChangedAfterParsing(receivedPacket)) {
-                            QMutexLocker nodeDataLocker(&nodeData->getMutex());
                             nodeData->setBillboardChangeTimestamp(QDateTime::currentMSecsSinceEpoch());
                         }
                         
@@ -295,15 +423,26 @@ void AvatarMixer::sendStatsPacket() {
     statsObject["average_billboard_packets_per_frame"] = (float) _sumBillboardPackets / (float) _numStatFrames;
     statsObject["average_identity_packets_per_frame"] = (float) _sumIdentityPackets / (float) _numStatFrames;
     
-    statsObject["trailing_sleep_percentage"] = _trailingSleepRatio * 100;
+    statsObject["trailing_frame_budget_percentage"] = _trailingFrameRatio * 100;
     statsObject["performance_throttling_ratio"] = _performanceThrottlingRatio;
     
+    statsObject["average_frame_usecs"] = (float) _sumFrameUsecs / (float) _numStatFrames;
+    statsObject["max_frame_usecs"] = (double) _maxFrameUsecs;
+    statsObject["average_snapshot_usecs"] = (float) _sumSnapshotUsecs / (float) _numStatFrames;
+    statsObject["frames_over_budget"] = _numFramesOverBudget;
+    statsObject["average_broadcast_workers"] = (float) _sumWorkers / (float) _numStatFrames;
+    
     ThreadedAssignment::addPacketStatsAndSendStatsPacket(statsObject);
     
     _sumListeners = 0;
     _sumBillboardPackets = 0;
     _sumIdentityPackets = 0;
     _numStatFrames = 0;
+    _sumFrameUsecs = 0;
+    _maxFrameUsecs = 0;
+    _sumSnapshotUsecs = 0;
+    _numFramesOverBudget = 0;
+    _sumWorkers = 0;
 }
 
 void AvatarMixer::run() {
@@ -314,6 +453,22 @@ void AvatarMixer::run() {
     
     nodeList->linkedDataCreateCallback = attachAvatarDataToNode;
     
+    // make sure we hear about node kills so we can tell the other nodes
+    // (this is done here rather than on construction, when we may not yet have our own NodeList)
+    connect(nodeList, &NodeList::nodeKilled, this, &AvatarMixer::nodeKilled);
+    
+    if (isReceiveThreadRequested()) {
+        // receive continuously, and have the broadcast thread take what's arrived at the start of each frame
+        PacketReceiver* receiver = new PacketReceiver(OTHER_RECEIVE_QUEUE_CAPACITY);
+        receiver->addQueue("avatar", QList<PacketType>() << PacketTypeAvatarData << PacketTypeAvatarIdentity
+            << PacketTypeAvatarBillboard, AVATAR_RECEIVE_QUEUE_CAPACITY);
+        startReceiveThread(receiver);
+    }
+    
+    // if we're hosted alongside other assignments, the broadcast thread needs to use our NodeList rather than the shared one
+    _threadNodeList = LimitedNodeList::getThreadInstance();
+    connect(&_broadcastThread, &QThread::started, this, &AvatarMixer::bindNodeListToBroadcastThread, Qt::DirectConnection);
+    
     // setup the timer that will be fired on the broadcast thread
     QTimer* broadcastTimer = new QTimer();
     broadcastTimer->setInterval(AVATAR_DATA_SEND_INTERVAL_MSECS);
@@ -326,3 +481,7 @@ void AvatarMixer::run() {
     // start the broadcastThread
     _broadcastThread.start();
 }
+
+void AvatarMixer::bindNodeListToBroadcastThread() {
+    LimitedNodeList::setThreadInstance(_threadNodeList);
+}
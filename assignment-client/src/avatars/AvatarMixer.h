@@ -15,8 +15,44 @@
 #ifndef hifi_AvatarMixer_h
 #define hifi_AvatarMixer_h
 
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+#include <glm/glm.hpp>
+
 #include <ThreadedAssignment.h>
 
+/// The state of one avatar as of the start of a frame, which the broadcast workers read without locking anything.
+class AvatarSnapshot {
+public:
+    SharedNodePointer node;
+    glm::vec3 position;
+    QByteArray avatarData; ///< the node's UUID followed by the avatar's data, as they go in a bulk packet
+    QByteArray billboardPacket; ///< empty if the avatar has no billboard
+    quint64 billboardChangeTimestamp;
+    QByteArray identityPacket; ///< empty if the avatar has no identity
+    quint64 identityChangeTimestamp;
+    bool isNewListener; ///< whether the node has yet to be sent everyone's billboard and identity
+};
+
+/// A packet that a broadcast worker built, for the broadcast thread to send once the workers are done.
+class AvatarBroadcastPacket {
+public:
+    SharedNodePointer destination;
+    QByteArray packet;
+};
+
+/// What one broadcast worker did over a frame: the packets it built and the counts for the stats.
+class BroadcastWorkerStats {
+public:
+    BroadcastWorkerStats() : listeners(0), billboardPackets(0), identityPackets(0) { }
+    
+    QVector<AvatarBroadcastPacket> packets;
+    int listeners;
+    int billboardPackets;
+    int identityPackets;
+};
+
 /// Handles assignments of type AvatarMixer - distribution of avatar data to various clients
 class AvatarMixer : public ThreadedAssignment {
 public:
@@ -33,20 +69,48 @@ public slots:
     
     void sendStatsPacket();
     
+    /// Builds the packets that send the listeners in the given range of the frame's snapshot everyone else's data.
+    /// Called from the broadcast workers, each with its own range, so it touches nothing but the snapshot and the
+    /// worker's stats; the node list's socket belongs to the broadcast thread, which sends what the workers built.
+    void broadcastToListeners(int firstListener, int lastListener, BroadcastWorkerStats& stats);
+    
 private:
     void broadcastAvatarData();
+    void bindNodeListToBroadcastThread();
+    
+    /// Copies the state of every avatar, so that the broadcast workers needn't lock the client data.
+    void takeSnapshot();
+    
+    /// Raises or lowers the share of updates we drop according to how much of the frame interval the frames take.
+    void updatePerformanceThrottling(quint64 frameUsecs);
     
     QThread _broadcastThread;
+    QThreadPool _workerPool;
+    
+    // the frame's snapshot, which stays fixed while the workers run
+    QVector<AvatarSnapshot> _snapshot;
+    QVector<int> _listeners; ///< the indices in the snapshot of the agents to send to
+    QByteArray _bulkPacketHeader;
+    NodeList* _broadcastNodeList;
     
     quint64 _lastFrameTimestamp;
     
-    float _trailingSleepRatio;
+    float _trailingFrameRatio;
     float _performanceThrottlingRatio;
+    int _framesSinceCutoffEvent;
     
     int _sumListeners;
     int _numStatFrames;
     int _sumBillboardPackets;
     int _sumIdentityPackets;
+    
+    quint64 _sumFrameUsecs;
+    quint64 _maxFrameUsecs;
+    quint64 _sumSnapshotUsecs;
+    int _numFramesOverBudget;
+    int _sumWorkers;
+    
+    LimitedNodeList* _threadNodeList;
 };
 
 #endif // hifi_AvatarMixer_h
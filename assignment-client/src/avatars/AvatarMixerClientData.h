@@ -33,11 +33,22 @@ public:
     quint64 getIdentityChangeTimestamp() const { return _identityChangeTimestamp; }
     void setIdentityChangeTimestamp(quint64 identityChangeTimestamp) { _identityChangeTimestamp = identityChangeTimestamp; }
     
+    /// Returns the billboard packet to send for this avatar, rebuilding it only if the billboard has changed since.
+    const QByteArray& getBillboardPacket(const QUuid& nodeUUID);
+    
+    /// Returns the identity packet to send for this avatar, rebuilding it only if the identity has changed since.
+    const QByteArray& getIdentityPacket(const QUuid& nodeUUID);
+    
 private:
     AvatarData _avatar;
     bool _hasReceivedFirstPackets;
     quint64 _billboardChangeTimestamp;
     quint64 _identityChangeTimestamp;
+    
+    QByteArray _billboardPacket;
+    quint64 _billboardPacketTimestamp;
+    QByteArray _identityPacket;
+    quint64 _identityPacketTimestamp;
 };
 
 #endif // hifi_AvatarMixerClientData_h
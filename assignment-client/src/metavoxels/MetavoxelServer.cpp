@@ -10,8 +10,12 @@
 //
 
 #include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
 
 #include <PacketHeaders.h>
+#include <SharedUtil.h>
 
 #include <MetavoxelMessages.h>
 #include <MetavoxelUtil.h>
@@ -20,15 +24,74 @@
 
 const int SEND_INTERVAL = 50;
 
+const int PERSIST_INTERVAL = 1000 * 30; // every 30 seconds
+
+const char* LOCAL_METAVOXELS_PERSIST_FILE = "resources/metavoxels.dat";
+
+const quint32 SNAPSHOT_MAGIC = 0x4D565344; // "MVSD"
+const quint32 JOURNAL_MAGIC = 0x4D56534A; // "MVSJ"
+
 MetavoxelServer::MetavoxelServer(const QByteArray& packet) :
-    ThreadedAssignment(packet) {
+    ThreadedAssignment(packet),
+    _persistFilename(LOCAL_METAVOXELS_PERSIST_FILE),
+    _persister(NULL),
+    _generation(0),
+    _journalStream(&_journalFile),
+    _journalOut(NULL) {
     
     _sendTimer.setSingleShot(true);
     connect(&_sendTimer, SIGNAL(timeout()), SLOT(sendDeltas()));
+    
+    connect(&_persistTimer, SIGNAL(timeout()), SLOT(maybeSaveData()));
+}
+
+MetavoxelServer::~MetavoxelServer() {
+    delete _journalOut;
+    _journalFile.close();
+    
+    if (_persister) {
+        // write out a final snapshot before we go (this also waits for any pending snapshot to finish)
+        QThread* persistThread = _persister->thread();
+        QMetaObject::invokeMethod(_persister, "save", Qt::BlockingQueuedConnection,
+            Q_ARG(const MetavoxelData&, _data), Q_ARG(int, _generation + 1));
+        persistThread->quit();
+        persistThread->wait();
+        delete _persister;
+        delete persistThread;
+    }
 }
 
 void MetavoxelServer::applyEdit(const MetavoxelEditMessage& edit) {
     edit.apply(_data, SharedObject::getWeakHash());
+    
+    // record the edit in the journal so that it survives until the next snapshot
+    if (_journalOut) {
+        *_journalOut << edit;
+        _journalOut->flush();
+        _journalOut->persistAndResetWriteMappings();
+        _journalFile.flush();
+    }
+}
+
+BitstreamRecording MetavoxelServer::getDelta(const MetavoxelData& reference, const MetavoxelLOD& referenceLOD,
+        const MetavoxelLOD& lod) {
+    foreach (const SharedDelta& delta, _sharedDeltas) {
+        if (delta.reference == reference && delta.referenceLOD == referenceLOD && delta.lod == lod) {
+            return delta.recording;
+        }
+    }
+    
+    // record the delta rather than writing it directly, so that each session can replay it using its own mappings
+    SharedDelta delta = { reference, referenceLOD, lod };
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    Bitstream out(stream);
+    out.startRecording(delta.recording);
+    _data.writeDelta(reference, referenceLOD, out, lod);
+    out.stopRecording(data);
+    
+    _sharedDeltas.append(delta);
+    return delta.recording;
 }
 
 const QString METAVOXEL_SERVER_LOGGING_NAME = "metavoxel-server";
@@ -41,6 +104,23 @@ void MetavoxelServer::run() {
     
     connect(nodeList, SIGNAL(nodeAdded(SharedNodePointer)), SLOT(maybeAttachSession(const SharedNodePointer&)));
     
+    // restore the data before we start sending it
+    loadPersistedData();
+    
+    // snapshots are written on their own thread from copies of the data
+    QThread* persistThread = new QThread();
+    _persister = new MetavoxelPersister(_persistFilename, _savedData);
+    _persister->moveToThread(persistThread);
+    persistThread->start();
+    
+    if (_data == _savedData) {
+        beginJournal(++_generation);
+    } else {
+        // fold any replayed edits into a fresh snapshot
+        maybeSaveData();
+    }
+    _persistTimer.start(PERSIST_INTERVAL);
+    
     _lastSend = QDateTime::currentMSecsSinceEpoch();
     _sendTimer.start(SEND_INTERVAL);
 }
@@ -74,13 +154,15 @@ void MetavoxelServer::maybeAttachSession(const SharedNodePointer& node) {
 }
 
 void MetavoxelServer::sendDeltas() {
-    // send deltas for all sessions
+    // send deltas for all sessions, sharing the encoded deltas where possible
     foreach (const SharedNodePointer& node, NodeList::getInstance()->getNodeHash()) {
         if (node->getType() == NodeType::Agent) {
             static_cast<MetavoxelSession*>(node->getLinkedData())->sendDelta();
         }
     }
     
+    _sharedDeltas.clear();
+    
     // restart the send timer
     qint64 now = QDateTime::currentMSecsSinceEpoch();
     int elapsed = now - _lastSend;
@@ -89,6 +171,163 @@ void MetavoxelServer::sendDeltas() {
     _sendTimer.start(qMax(0, 2 * SEND_INTERVAL - elapsed));
 }
 
+void MetavoxelServer::maybeSaveData() {
+    if (_data == _savedData) {
+        return; // nothing has changed since the last snapshot
+    }
+    // edits from here on go into the next generation's journal; the persister gets a (cheap) copy of the data
+    _savedData = _data;
+    beginJournal(++_generation);
+    QMetaObject::invokeMethod(_persister, "save", Q_ARG(const MetavoxelData&, _savedData), Q_ARG(int, _generation));
+}
+
+void MetavoxelServer::loadPersistedData() {
+    quint64 loadStarted = usecTimestampNow();
+    
+    // read the snapshot straight from the file, falling back to a temporary left over from an interrupted save
+    QFile file(_persistFilename);
+    if (!file.exists()) {
+        file.setFileName(_persistFilename + ".tmp");
+    }
+    int snapshotGeneration = 0;
+    if (file.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&file);
+        quint32 magic;
+        stream >> magic >> snapshotGeneration;
+        if (magic == SNAPSHOT_MAGIC) {
+            Bitstream in(stream, Bitstream::FULL_METADATA);
+            in >> _data;
+        }
+        if (magic != SNAPSHOT_MAGIC || stream.status() != QDataStream::Ok) {
+            qDebug() << "Failed to read metavoxel snapshot" << file.fileName();
+            _data = MetavoxelData();
+            snapshotGeneration = 0;
+        }
+        file.close();
+    }
+    _generation = snapshotGeneration;
+    _savedData = _data;
+    
+    // replay the edits made since the snapshot was taken
+    int editCount = 0;
+    foreach (int generation, MetavoxelPersister::getJournalGenerations(_persistFilename)) {
+        QFile journalFile(MetavoxelPersister::getJournalFilename(_persistFilename, generation));
+        if (generation < snapshotGeneration) {
+            journalFile.remove(); // already contained in the snapshot
+            continue;
+        }
+        _generation = qMax(_generation, generation);
+        if (!journalFile.open(QIODevice::ReadOnly)) {
+            qDebug() << "Failed to open metavoxel journal" << journalFile.fileName();
+            continue;
+        }
+        QDataStream stream(&journalFile);
+        quint32 magic;
+        stream >> magic;
+        if (magic != JOURNAL_MAGIC) {
+            qDebug() << "Invalid metavoxel journal" << journalFile.fileName();
+            continue;
+        }
+        Bitstream in(stream, Bitstream::FULL_METADATA);
+        while (!stream.atEnd()) {
+            MetavoxelEditMessage edit;
+            in >> edit;
+            if (stream.status() != QDataStream::Ok) {
+                break; // truncated by a crash mid-write
+            }
+            in.reset();
+            in.persistAndResetReadMappings();
+            edit.apply(_data, SharedObject::getWeakHash());
+            editCount++;
+        }
+    }
+    // freshly read nodes are all distinct; share the identical ones
+    _data.consolidate();
+    
+    qDebug() << "Loaded metavoxel data, generation" << _generation << "replayed edits:" << editCount <<
+        "elapsed usecs:" << (usecTimestampNow() - loadStarted);
+}
+
+void MetavoxelServer::beginJournal(int generation) {
+    delete _journalOut;
+    _journalOut = NULL;
+    _journalFile.close();
+    
+    _journalFile.setFileName(MetavoxelPersister::getJournalFilename(_persistFilename, generation));
+    if (!_journalFile.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to open metavoxel journal" << _journalFile.fileName();
+        return;
+    }
+    _journalStream.resetStatus();
+    _journalStream << JOURNAL_MAGIC;
+    _journalOut = new Bitstream(_journalStream, Bitstream::FULL_METADATA);
+}
+
+QString MetavoxelPersister::getJournalFilename(const QString& persistFilename, int generation) {
+    return persistFilename + "." + QString::number(generation) + ".journal";
+}
+
+QList<int> MetavoxelPersister::getJournalGenerations(const QString& persistFilename) {
+    QFileInfo info(persistFilename);
+    QString prefix = info.fileName() + ".";
+    QString suffix = ".journal";
+    QList<int> generations;
+    foreach (const QString& name, info.absoluteDir().entryList(QStringList() << prefix + "*" + suffix, QDir::Files)) {
+        bool ok;
+        int generation = name.mid(prefix.size(), name.size() - prefix.size() - suffix.size()).toInt(&ok);
+        if (ok) {
+            generations.append(generation);
+        }
+    }
+    qSort(generations);
+    return generations;
+}
+
+MetavoxelPersister::MetavoxelPersister(const QString& persistFilename, const MetavoxelData& savedData) :
+    _persistFilename(persistFilename),
+    _savedData(savedData) {
+}
+
+void MetavoxelPersister::save(const MetavoxelData& data, int generation) {
+    if (data == _savedData) {
+        return;
+    }
+    quint64 saveStarted = usecTimestampNow();
+    
+    // write to a temporary file first so that a crash leaves the previous snapshot intact
+    QString temporaryFilename = _persistFilename + ".tmp";
+    QFile file(temporaryFilename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to open metavoxel snapshot" << temporaryFilename;
+        return;
+    }
+    QDataStream stream(&file);
+    stream << SNAPSHOT_MAGIC << generation;
+    Bitstream out(stream, Bitstream::FULL_METADATA);
+    out << data;
+    out.flush();
+    if (stream.status() != QDataStream::Ok || !file.flush()) {
+        qDebug() << "Failed to write metavoxel snapshot" << temporaryFilename;
+        return;
+    }
+    file.close();
+    
+    QFile::remove(_persistFilename);
+    if (!QFile::rename(temporaryFilename, _persistFilename)) {
+        qDebug() << "Failed to replace metavoxel snapshot" << _persistFilename;
+        return;
+    }
+    
+    // the journals from before this snapshot are no longer needed
+    foreach (int journalGeneration, getJournalGenerations(_persistFilename)) {
+        if (journalGeneration < generation) {
+            QFile::remove(getJournalFilename(_persistFilename, journalGeneration));
+        }
+    }
+    _savedData = data;
+    qDebug() << "Saved metavoxel data, generation" << generation << "elapsed usecs:" << (usecTimestampNow() - saveStarted);
+}
+
 MetavoxelSession::MetavoxelSession(MetavoxelServer* server, const SharedNodePointer& node) :
     _server(server),
     _sequencer(byteArrayWithPopulatedHeader(PacketTypeMetavoxelData)),
@@ -122,7 +361,7 @@ void MetavoxelSession::sendDelta() {
     }
     Bitstream& out = _sequencer.startPacket();
     out << QVariant::fromValue(MetavoxelDeltaMessage());
-    _server->getData().writeDelta(_sendRecords.first().data, _sendRecords.first().lod, out, _lod);
+    out << _server->getDelta(_sendRecords.first().data, _sendRecords.first().lod, _lod);
     _sequencer.endPacket();
     
     // record the send
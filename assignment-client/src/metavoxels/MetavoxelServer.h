@@ -12,6 +12,7 @@
 #ifndef hifi_MetavoxelServer_h
 #define hifi_MetavoxelServer_h
 
+#include <QFile>
 #include <QList>
 #include <QTimer>
 
@@ -21,6 +22,7 @@
 #include <MetavoxelData.h>
 
 class MetavoxelEditMessage;
+class MetavoxelPersister;
 class MetavoxelSession;
 
 /// Maintains a shared metavoxel system, accepting change requests and broadcasting updates.
@@ -30,11 +32,16 @@ class MetavoxelServer : public ThreadedAssignment {
 public:
     
     MetavoxelServer(const QByteArray& packet);
+    virtual ~MetavoxelServer();
 
     void applyEdit(const MetavoxelEditMessage& edit);
 
     const MetavoxelData& getData() const { return _data; }
 
+    /// Returns the encoded delta between the supplied reference and the current data.  Sessions with the same reference
+    /// state and LOD receive identical deltas, so each distinct delta is encoded only once per send interval.
+    BitstreamRecording getDelta(const MetavoxelData& reference, const MetavoxelLOD& referenceLOD, const MetavoxelLOD& lod);
+
     virtual void run();
     
     virtual void readPendingDatagrams();
@@ -43,13 +50,63 @@ private slots:
 
     void maybeAttachSession(const SharedNodePointer& node);
     void sendDeltas();    
+    void maybeSaveData();
     
 private:
     
+    void loadPersistedData();
+    void beginJournal(int generation);
+    
+
+    class SharedDelta {
+    public:
+        MetavoxelData reference;
+        MetavoxelLOD referenceLOD;
+        MetavoxelLOD lod;
+        BitstreamRecording recording;
+    };
+    
     QTimer _sendTimer;
     qint64 _lastSend;
     
     MetavoxelData _data;
+    
+    QList<SharedDelta> _sharedDeltas;
+    
+    QString _persistFilename;
+    QTimer _persistTimer;
+    MetavoxelPersister* _persister;
+    int _generation;
+    MetavoxelData _savedData;
+    
+    QFile _journalFile;
+    QDataStream _journalStream;
+    Bitstream* _journalOut;
+};
+
+/// Writes snapshots of the metavoxel data on a separate thread.  Each snapshot is tagged with a generation number; the edit
+/// journals numbered at or above the generation of the snapshot on disk hold the edits made since it was taken.
+class MetavoxelPersister : public QObject {
+    Q_OBJECT
+
+public:
+    
+    /// Returns the name of the journal for the specified generation.
+    static QString getJournalFilename(const QString& persistFilename, int generation);
+    
+    /// Returns the generations of the existing journals, in ascending order.
+    static QList<int> getJournalGenerations(const QString& persistFilename);
+    
+    MetavoxelPersister(const QString& persistFilename, const MetavoxelData& savedData);
+    
+    /// Writes the supplied data to the snapshot file (unless it matches the last snapshot), then removes any journals from
+    /// earlier generations.
+    Q_INVOKABLE void save(const MetavoxelData& data, int generation);
+    
+private:
+    
+    QString _persistFilename;
+    MetavoxelData _savedData;
 };
 
 /// Contains the state of a single client session.
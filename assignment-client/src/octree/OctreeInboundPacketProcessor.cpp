@@ -104,6 +104,15 @@ void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendin
             atByte += editDataBytesRead;
         }
 
+        // average each element above the packet's edits once, rather than once per edit below it
+        quint64 startLock = usecTimestampNow();
+        _myServer->getOctree()->lockForWrite();
+        quint64 startProcess = usecTimestampNow();
+        _myServer->getOctree()->reaverageChangedElements();
+        _myServer->getOctree()->unlock();
+        processTime += usecTimestampNow() - startProcess;
+        lockWaitTime += startProcess - startLock;
+
         if (debugProcessPacket) {
             printf("OctreeInboundPacketProcessor::processPacket() DONE LOOPING FOR %c "
                    "packetData=%p packetLength=%d voxelData=%p atByte=%d\n",
@@ -29,6 +29,10 @@ OctreeQueryNode::OctreeQueryNode() :
     _maxSearchLevel(1),
     _maxLevelReachedInLastSearch(1),
     _lastTimeBagEmpty(0),
+    _hasVersionSent(false),
+    _lastVersionSent(0),
+    _sceneVersion(0),
+    _isSceneIncremental(false),
     _viewFrustumChanging(false),
     _viewFrustumJustStoppedChanging(true),
     _currentPacketIsColor(true),
@@ -280,6 +284,18 @@ bool OctreeQueryNode::updateCurrentViewFrustum() {
     return currentViewFrustumChanged;
 }
 
+void OctreeQueryNode::setSceneVersion(quint64 sceneVersion, bool isSceneIncremental) {
+    _sceneVersion = sceneVersion;
+    _isSceneIncremental = isSceneIncremental;
+}
+
+void OctreeQueryNode::sceneVersionSent() {
+    _lastVersionSent = _sceneVersion;
+    _hasVersionSent = true;
+    _isSceneIncremental = false;
+    sceneChanges.clear();
+}
+
 void OctreeQueryNode::setViewSent(bool viewSent) {
     _viewSent = viewSent;
     if (viewSent) {
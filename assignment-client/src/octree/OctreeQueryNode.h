@@ -17,7 +17,8 @@
 #include <OctreePacketData.h>
 #include <OctreeQuery.h>
 
-#include <CoverageMap.h>
+#include <CoverageMapV3.h>
+#include <OctreeChangeJournal.h>
 #include <OctreeConstants.h>
 #include <OctreeElementBag.h>
 #include <OctreeSceneStats.h>
@@ -55,7 +56,8 @@ public:
     void setMaxLevelReached(int maxLevelReached) { _maxLevelReachedInLastSearch = maxLevelReached; }
 
     OctreeElementBag nodeBag;
-    CoverageMap map;
+    CoverageMapV3 map;
+    OctreeChangeSet sceneChanges; ///< what changed since the last version sent, when the scene is incremental
 
     ViewFrustum& getCurrentViewFrustum() { return _currentViewFrustum; }
     ViewFrustum& getLastKnownViewFrustum() { return _lastKnownViewFrustum; }
@@ -76,6 +78,21 @@ public:
     quint64 getLastTimeBagEmpty() const { return _lastTimeBagEmpty; }
     void setLastTimeBagEmpty(quint64 lastTimeBagEmpty) { _lastTimeBagEmpty = lastTimeBagEmpty; }
 
+    /// Checks whether the client has received a whole scene since we started tracking the tree's change journal.
+    bool hasVersionSent() const { return _hasVersionSent; }
+
+    /// Returns the version of the tree (see OctreeChangeJournal) as of the last scene the client received in full.
+    quint64 getLastVersionSent() const { return _lastVersionSent; }
+
+    quint64 getSceneVersion() const { return _sceneVersion; }
+
+    /// Notes the tree's version as a scene starts, and whether the scene need only visit sceneChanges.
+    void setSceneVersion(quint64 sceneVersion, bool isSceneIncremental);
+    bool isSceneIncremental() const { return _isSceneIncremental; }
+
+    /// Notes that the client has received the whole of the current scene.
+    void sceneVersionSent();
+
     bool getCurrentPacketIsColor() const { return _currentPacketIsColor; }
     bool getCurrentPacketIsCompressed() const { return _currentPacketIsCompressed; }
     bool getCurrentPacketFormatMatches() {
@@ -118,6 +135,10 @@ private:
     ViewFrustum _currentViewFrustum;
     ViewFrustum _lastKnownViewFrustum;
     quint64 _lastTimeBagEmpty;
+    bool _hasVersionSent;
+    quint64 _lastVersionSent;
+    quint64 _sceneVersion;
+    bool _isSceneIncremental;
     bool _viewFrustumChanging;
     bool _viewFrustumJustStoppedChanging;
     bool _currentPacketIsColor;
@@ -67,6 +67,11 @@ bool OctreeSendThread::process() {
 
     OctreeServer::didProcess(this);
 
+    // hand the server what we used last time around, so that its stats count the send threads
+    if (_myServer) {
+        _myServer->addThreadCPUUsecs(takeCPUUsecs());
+    }
+
     float lockWaitElapsedUsec = OctreeServer::SKIP_TIME;
     quint64 lockWaitStart = usecTimestampNow();
     _processLock.lock();
@@ -310,6 +315,21 @@ int OctreeSendThread::packetDistributor(const SharedNodePointer& node, OctreeQue
         _packetData.changeSettings(wantCompression, targetSize);
     }
 
+    // If the client has everything up to the tree's current version and hasn't moved, then there's nothing to encode,
+    // and no need to take the lock to find that out. Just flush anything still waiting.
+    OctreeChangeJournal* changeJournal = _myServer->getOctree()->getChangeJournal();
+    if (changeJournal && !viewFrustumChanged && !isFullScene && nodeData->nodeBag.isEmpty() &&
+            nodeData->hasVersionSent() && nodeData->getLastVersionSent() == changeJournal->getVersion()) {
+        if (nodeData->isPacketWaiting()) {
+            handlePacketSend(node, nodeData, trueBytesSent, truePacketsSent);
+        }
+        if (_myServer->hasSpecialPacketToSend(node) && !nodeData->isShuttingDown()) {
+            trueBytesSent += _myServer->sendSpecialPacket(node);
+            truePacketsSent++;
+        }
+        return truePacketsSent;
+    }
+
     const ViewFrustum* lastViewFrustum =  wantDelta ? &nodeData->getLastKnownViewFrustum() : NULL;
 
     // If the current view frustum has changed OR we have nothing to send, then search against
@@ -351,6 +371,16 @@ int OctreeSendThread::packetDistributor(const SharedNodePointer& node, OctreeQue
         // TODO: add these to stats page
         //::startSceneSleepTime = _usleepTime;
         
+        // If the client has received every version up to some point, and hasn't moved since, then the scene need only
+        // visit the subtrees that changed after that (and the paths down to them)
+        if (changeJournal) {
+            quint64 sceneVersion = changeJournal->getVersion();
+            nodeData->sceneChanges.clear();
+            bool isSceneIncremental = !viewFrustumChanged && !isFullScene && nodeData->hasVersionSent() &&
+                changeJournal->getChangesSince(nodeData->getLastVersionSent(), nodeData->sceneChanges);
+            nodeData->setSceneVersion(sceneVersion, isSceneIncremental);
+        }
+
         // start tracking our stats
         nodeData->stats.sceneStarted(isFullScene, viewFrustumChanged, _myServer->getOctree()->getRoot(), _myServer->getJurisdiction());
 
@@ -413,7 +443,7 @@ int OctreeSendThread::packetDistributor(const SharedNodePointer& node, OctreeQue
                 */
 
                 bool wantOcclusionCulling = nodeData->getWantOcclusionCulling();
-                CoverageMap* coverageMap = wantOcclusionCulling ? &nodeData->map : IGNORE_COVERAGE_MAP;
+                CoverageMapV3* coverageMap = wantOcclusionCulling ? &nodeData->map : IGNORE_COVERAGE_MAP;
                 
                 float voxelSizeScale = nodeData->getOctreeSizeScale();
                 int boundaryLevelAdjustClient = nodeData->getBoundaryLevelAdjust();
@@ -425,7 +455,9 @@ int OctreeSendThread::packetDistributor(const SharedNodePointer& node, OctreeQue
                                              WANT_EXISTS_BITS, DONT_CHOP, wantDelta, lastViewFrustum,
                                              wantOcclusionCulling, coverageMap, boundaryLevelAdjust, voxelSizeScale,
                                              nodeData->getLastTimeBagEmpty(),
-                                             isFullScene, &nodeData->stats, _myServer->getJurisdiction());
+                                             isFullScene, &nodeData->stats, _myServer->getJurisdiction(),
+                                             nodeData->isSceneIncremental() ? &nodeData->sceneChanges
+                                                                            : IGNORE_CHANGE_SET);
 
                 // TODO: should this include the lock time or not? This stat is sent down to the client,
                 // it seems like it may be a good idea to include the lock time as part of the encode time
@@ -568,6 +600,7 @@ int OctreeSendThread::packetDistributor(const SharedNodePointer& node, OctreeQue
         if (nodeData->nodeBag.isEmpty()) {
             nodeData->updateLastKnownViewFrustum();
             nodeData->setViewSent(true);
+            nodeData->sceneVersionSent();
             nodeData->map.erase(); // It would be nice if we could save this, and only reset it when the view frustum changes
         }
 
@@ -304,6 +304,9 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
             showStats = true;
         } else if (url.path() == "/resetStats") {
             _octreeInboundPacketProcessor->resetStats();
+            _octreeInboundPacketProcessor->getPacketQueue().resetStats();
+            _jurisdictionSender->getPacketQueue().resetStats();
+            _jurisdictionSender->getPacketSender().getPacketQueue().resetStats();
             resetSendingStats();
             showStats = true;
         }
@@ -627,6 +630,28 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
         statsString += QString("  Average Wait Lock Time/Element: %1 usecs\r\n")
             .arg(locale.toString((uint)averageLockWaitTimePerElement).rightJustified(COLUMN_WIDTH, ' '));
 
+        NetworkPacketQueue& inboundQueue = _octreeInboundPacketProcessor->getPacketQueue();
+        statsString += QString("         Inbound Queue Depth: %1 of %2 packets\r\n")
+            .arg(locale.toString(inboundQueue.size()).rightJustified(COLUMN_WIDTH, ' '))
+            .arg(locale.toString(inboundQueue.getCapacity()));
+        statsString += QString("    Inbound Queue High-Water: %1 packets\r\n")
+            .arg(locale.toString(inboundQueue.getHighWaterMark()).rightJustified(COLUMN_WIDTH, ' '));
+        statsString += QString("       Inbound Queue Dropped: %1 packets\r\n")
+            .arg(locale.toString(inboundQueue.getDropCount()).rightJustified(COLUMN_WIDTH, ' '));
+
+        // jurisdiction requests come in through one queue, and the replies go out through the other (which turns
+        // packets away, for the sender to retry, rather than dropping them)
+        NetworkPacketQueue& requestQueue = _jurisdictionSender->getPacketQueue();
+        statsString += QString(" Jurisdiction Request High-Water: %1 packets\r\n")
+            .arg(locale.toString(requestQueue.getHighWaterMark()).rightJustified(COLUMN_WIDTH, ' '));
+        statsString += QString("    Jurisdiction Request Dropped: %1 packets\r\n")
+            .arg(locale.toString(requestQueue.getDropCount()).rightJustified(COLUMN_WIDTH, ' '));
+        NetworkPacketQueue& replyQueue = _jurisdictionSender->getPacketSender().getPacketQueue();
+        statsString += QString("   Jurisdiction Reply High-Water: %1 packets\r\n")
+            .arg(locale.toString(replyQueue.getHighWaterMark()).rightJustified(COLUMN_WIDTH, ' '));
+        statsString += QString("  Jurisdiction Reply Turned Away: %1 packets\r\n")
+            .arg(locale.toString(replyQueue.getDropCount()).rightJustified(COLUMN_WIDTH, ' '));
+
 
         int senderNumber = 0;
         NodeToSenderStatsMap& allSenderStats = _octreeInboundPacketProcessor->getSingleSenderStats();
@@ -859,6 +884,9 @@ void OctreeServer::run() {
     // Before we do anything else, create our tree...
     OctreeElement::resetPopulationStatistics();
     _tree = createTree();
+
+    // edits leave the averages above them for the inbound packet processor to bring up to date once per packet
+    _tree->setDefersReaveraging(true);
     
     // use common init to setup common timers and logging
     commonInit(getMyLoggingServerTargetName(), getMyNodeType());
@@ -1195,6 +1223,17 @@ void OctreeServer::sendStatsPacket() {
     statsObject1[baseName + QString(".1.2.octree.internalElementCount")] = (double)OctreeElement::getInternalNodeCount();
     statsObject1[baseName + QString(".1.3.octree.leafElementCount")] = (double)OctreeElement::getLeafNodeCount();
 
+    // the send threads count themselves; these are the rest of the threads we own
+    if (_persistThread) {
+        addThreadCPUUsecs(_persistThread->takeCPUUsecs());
+    }
+    if (_jurisdictionSender) {
+        addThreadCPUUsecs(_jurisdictionSender->takeCPUUsecs());
+    }
+    if (_octreeInboundPacketProcessor) {
+        addThreadCPUUsecs(_octreeInboundPacketProcessor->takeCPUUsecs());
+    }
+
     ThreadedAssignment::addPacketStatsAndSendStatsPacket(statsObject1);
 
     static QJsonObject statsObject2;
@@ -69,6 +69,19 @@ void VoxelServer::beforeRun() {
         qDebug("Using Minimal Environment=%s", debug::valueOf(_sendMinimalEnvironment));
     }
     qDebug("Sending environments=%s", debug::valueOf(_sendEnvironments));
-    
+
+    // should we pack dense subtrees into bricks? Default is no, but this command line packs them from the given level
+    const char* MINIMUM_BRICK_LEVEL = "--minimumBrickLevel";
+    const char* minimumBrickLevel = getCmdOption(_argc, _argv, MINIMUM_BRICK_LEVEL);
+    if (minimumBrickLevel) {
+        ((VoxelTree*)_tree)->setMinimumBrickLevel(atoi(minimumBrickLevel));
+        qDebug("Packing bricks from level %s", minimumBrickLevel);
+    }
+
+    // lets the send threads find out what changed since each client's last scene without walking the tree (the
+    // particle and model trees change their elements' contents in place, without the handleSubtreeChanged calls that
+    // the journal hears from, so their servers do without one)
+    _tree->enableChangeJournal();
+
     NodeList::getInstance()->addNodeTypeToInterestSet(NodeType::AnimationServer);
 }
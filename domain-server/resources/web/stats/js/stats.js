@@ -4,6 +4,25 @@ function qs(key) {
     return match && decodeURIComponent(match[1].replace(/\+/g, " "));
 }
 
+// nested stats (like the per-node traffic breakdown) get one row per value, keyed by their path
+function statsRows(json, prefix) {
+  var rows = "";
+  
+  $.each(json, function(key, value) {
+    if (value !== null && typeof value == 'object') {
+      rows += statsRows(value, prefix + key + " / ");
+    } else {
+      rows += "<tr>";
+      rows += "<td class='stats-key'>" + prefix + key + "</td>";
+      var formattedValue = (typeof value == 'number' ? value.toLocaleString() : value);
+      rows += "<td>" + formattedValue + "</td>";
+      rows += "</tr>";
+    }
+  });
+  
+  return rows;
+}
+
 $(document).ready(function(){
   // setup a function to grab the nodeStats
   function getNodeStats() {
@@ -12,20 +31,21 @@ $(document).ready(function(){
     
     var statsTableBody = "";
     
-    $.getJSON("/nodes/" + uuid + ".json", function(json){
+    // without a node, show the domain-server's own traffic
+    var statsURL = uuid ? "/nodes/" + uuid + ".json" : "/traffic.json";
+    
+    $.getJSON(statsURL, function(json){
       
       // update the table header with the right node type
-      $('#stats-lead h3').html(json.node_type + " stats (" + uuid + ")");
+      if (uuid) {
+        $('#stats-lead h3').html(json.node_type + " stats (" + uuid + ")");
+      } else {
+        $('#stats-lead h3').html("domain-server traffic");
+      }
       
       delete json.node_type;
       
-      $.each(json, function(key, value) {
-        statsTableBody += "<tr>";
-        statsTableBody += "<td class='stats-key'>" + key + "</td>";
-        var formattedValue = (typeof value == 'number' ? value.toLocaleString() : value);
-        statsTableBody += "<td>" + formattedValue + "</td>";
-        statsTableBody += "</tr>";
-      });
+      statsTableBody += statsRows(json, "");
       
       $('#stats-table tbody').html(statsTableBody);
     }).fail(function(data) {
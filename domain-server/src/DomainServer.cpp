@@ -10,6 +10,7 @@
 //
 
 #include <QtCore/QDir>
+#include <QtCore/QtEndian>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
@@ -22,6 +23,7 @@
 #include <AccountManager.h>
 #include <HifiConfigVariantMap.h>
 #include <HTTPConnection.h>
+#include <PacketBuffer.h>
 #include <PacketHeaders.h>
 #include <SharedUtil.h>
 #include <UUID.h>
@@ -33,6 +35,8 @@
 
 const quint16 DOMAIN_SERVER_HTTP_PORT = 8080;
 
+const int MAX_DOMAIN_LIST_CHANGES = 1000;
+
 DomainServer::DomainServer(int argc, char* argv[]) :
     QCoreApplication(argc, argv),
     _HTTPManager(DOMAIN_SERVER_HTTP_PORT, QString("%1/resources/web/").arg(QCoreApplication::applicationDirPath()), this),
@@ -42,7 +46,10 @@ DomainServer::DomainServer(int argc, char* argv[]) :
     _x509Credentials(NULL),
     _dhParams(NULL),
     _priorityCache(NULL),
-    _dtlsSessions()
+    _dtlsSessions(),
+    _domainListVersion(1),
+    _oldestDomainListVersion(1),
+    _domainListChanges()
 {
     gnutls_global_init();
     
@@ -392,7 +399,8 @@ int DomainServer::parseNodeDataFromByteArray(NodeType_t& nodeType, HifiSockAddr&
     return packetStream.device()->pos();
 }
 
-NodeSet DomainServer::nodeInterestListFromPacket(const QByteArray& packet, int numPreceedingBytes) {
+NodeSet DomainServer::nodeInterestListFromPacket(const QByteArray& packet, int numPreceedingBytes,
+                                                 quint32* acknowledgedVersion) {
     QDataStream packetStream(packet);
     packetStream.skipRawData(numPreceedingBytes);
     
@@ -407,84 +415,152 @@ NodeSet DomainServer::nodeInterestListFromPacket(const QByteArray& packet, int n
         nodeInterestSet.insert((NodeType_t) nodeType);
     }
     
+    if (acknowledgedVersion) {
+        // the version of the list the node already has follows the interest types
+        *acknowledgedVersion = 0;
+        packetStream >> *acknowledgedVersion;
+    }
+    
     return nodeInterestSet;
 }
 
 void DomainServer::sendDomainListToNode(const SharedNodePointer& node, const HifiSockAddr &senderSockAddr,
-                                        const NodeSet& nodeInterestList) {
+                                        const NodeSet& nodeInterestList, quint32 acknowledgedVersion) {
     
-    QByteArray broadcastPacket = byteArrayWithPopulatedHeader(PacketTypeDomainList);
+    DomainServerNodeData* nodeData = reinterpret_cast<DomainServerNodeData*>(node->getLinkedData());
     
-    // always send the node their own UUID back
-    QDataStream broadcastDataStream(&broadcastPacket, QIODevice::Append);
-    broadcastDataStream << node->getUUID();
+    LimitedNodeList* nodeList = LimitedNodeList::getInstance();
     
-    int numBroadcastPacketLeadBytes = broadcastDataStream.device()->pos();
+    // we can only send what changed if the node has a list we know about, for the same interest types
+    bool sendFullList = !nodeData->hasReceivedDomainList() || acknowledgedVersion < _oldestDomainListVersion
+        || acknowledgedVersion > _domainListVersion || nodeInterestList != nodeData->getNodeInterestSet();
+    quint32 baseVersion = sendFullList ? 0 : acknowledgedVersion;
     
-    DomainServerNodeData* nodeData = reinterpret_cast<DomainServerNodeData*>(node->getLinkedData());
+    nodeData->setNodeInterestSet(nodeInterestList);
+    nodeData->setHasReceivedDomainList(true);
     
-    LimitedNodeList* nodeList = LimitedNodeList::getInstance();
+    // gather the nodes to send: all interesting ones for the full list, otherwise those that changed since the ack
+    QList<QUuid> changedUUIDs;
+    if (sendFullList) {
+        foreach (const SharedNodePointer& otherNode, nodeList->getNodeHash()) {
+            changedUUIDs.append(otherNode->getUUID());
+        }
+    } else {
+        // each version is one change, so those after the acknowledged version start at a known place in the log
+        QSet<QUuid> seenUUIDs;
+        for (int i = acknowledgedVersion - _oldestDomainListVersion; i < _domainListChanges.size(); i++) {
+            const DomainListChange& change = _domainListChanges.at(i);
+            if (nodeInterestList.contains(change.nodeType) && !seenUUIDs.contains(change.nodeUUID)) {
+                seenUUIDs.insert(change.nodeUUID);
+                changedUUIDs.append(change.nodeUUID);
+            }
+        }
+    }
     
-    if (nodeInterestList.size() > 0) {
+    // the records go back to back in one buffer, rather than in an array apiece, and we note where each one ends
+    QByteArray recordBytes;
+    QDataStream nodeDataStream(&recordBytes, QIODevice::Append);
+    QVector<int> recordEnds;
+    foreach (const QUuid& otherNodeUUID, changedUUIDs) {
+        if (otherNodeUUID == node->getUUID()) {
+            continue;
+        }
         
-        DTLSServerSession* dtlsSession = _isUsingDTLS ? _dtlsSessions[senderSockAddr] : NULL;
-        unsigned int dataMTU = dtlsSession ? gnutls_dtls_get_data_mtu(*dtlsSession->getGnuTLSSession()) : MAX_PACKET_SIZE;
+        SharedNodePointer otherNode = nodeList->nodeWithUUID(otherNodeUUID);
+        if (!otherNode) {
+            // the node has been killed since the acknowledged version
+            nodeDataStream << DomainListRecord::NodeRemoved << otherNodeUUID;
+            recordEnds.append(recordBytes.size());
+            continue;
+        }
         
-        // if the node has any interest types, send back those nodes as well
-        foreach (const SharedNodePointer& otherNode, nodeList->getNodeHash()) {
+        if (!nodeInterestList.contains(otherNode->getType())) {
+            continue;
+        }
+        
+        nodeDataStream << DomainListRecord::NodeUpdated << *otherNode.data();
+        
+        // pack the secret that these two nodes will use to communicate with each other
+        QUuid secretUUID = nodeData->getSessionSecretHash().value(otherNode->getUUID());
+        if (secretUUID.isNull()) {
+            // generate a new secret UUID these two nodes can use
+            secretUUID = QUuid::createUuid();
             
-            // reset our nodeByteArray and nodeDataStream
-            QByteArray nodeByteArray;
-            QDataStream nodeDataStream(&nodeByteArray, QIODevice::Append);
+            // set that on the current Node's sessionSecretHash
+            nodeData->getSessionSecretHash().insert(otherNode->getUUID(), secretUUID);
+            
+            // set it on the other Node's sessionSecretHash
+            reinterpret_cast<DomainServerNodeData*>(otherNode->getLinkedData())
+                ->getSessionSecretHash().insert(node->getUUID(), secretUUID);
             
-            if (otherNode->getUUID() != node->getUUID() && nodeInterestList.contains(otherNode->getType())) {
-                
-                // don't send avatar nodes to other avatars, that will come from avatar mixer
-                nodeDataStream << *otherNode.data();
-                
-                // pack the secret that these two nodes will use to communicate with each other
-                QUuid secretUUID = nodeData->getSessionSecretHash().value(otherNode->getUUID());
-                if (secretUUID.isNull()) {
-                    // generate a new secret UUID these two nodes can use
-                    secretUUID = QUuid::createUuid();
-                    
-                    // set that on the current Node's sessionSecretHash
-                    nodeData->getSessionSecretHash().insert(otherNode->getUUID(), secretUUID);
-                    
-                    // set it on the other Node's sessionSecretHash
-                    reinterpret_cast<DomainServerNodeData*>(otherNode->getLinkedData())
-                        ->getSessionSecretHash().insert(node->getUUID(), secretUUID);
-                    
-                }
-                
-                nodeDataStream << secretUUID;
-                
-                if (broadcastPacket.size() +  nodeByteArray.size() > dataMTU) {
-                    // we need to break here and start a new packet
-                    // so send the current one
-                    
-                    if (!dtlsSession) {
-                        nodeList->writeDatagram(broadcastPacket, node, senderSockAddr);
-                    } else {
-                        dtlsSession->writeDatagram(broadcastPacket);
-                    }
-                    
-                    // reset the broadcastPacket structure
-                    broadcastPacket.resize(numBroadcastPacketLeadBytes);
-                    broadcastDataStream.device()->seek(numBroadcastPacketLeadBytes);
-                }
-                
-                // append the nodeByteArray to the current state of broadcastDataStream
-                broadcastPacket.append(nodeByteArray);
-            }
         }
         
-        // always write the last broadcastPacket
+        nodeDataStream << secretUUID;
+        recordEnds.append(recordBytes.size());
+    }
+    
+    DTLSServerSession* dtlsSession = _isUsingDTLS ? _dtlsSessions[senderSockAddr] : NULL;
+    int dataMTU = dtlsSession ? (int) gnutls_dtls_get_data_mtu(*dtlsSession->getGnuTLSSession()) : MAX_PACKET_SIZE;
+    
+    // always send the node their own UUID back, followed by the versions and the packet's place in the list
+    QByteArray leadBytes = byteArrayWithPopulatedHeader(PacketTypeDomainList);
+    QDataStream leadDataStream(&leadBytes, QIODevice::Append);
+    leadDataStream << node->getUUID() << baseVersion << _domainListVersion;
+    
+    const int PACKET_INDEX_BYTES = 2 * sizeof(quint16);
+    int maxPayloadSize = dataMTU - leadBytes.size() - PACKET_INDEX_BYTES;
+    
+    // split the records into packets up front so that each one can say how many make up the list
+    QVector<int> payloadEnds;
+    int payloadStart = 0;
+    int previousRecordEnd = 0;
+    foreach (int recordEnd, recordEnds) {
+        if (previousRecordEnd > payloadStart && recordEnd - payloadStart > maxPayloadSize) {
+            payloadEnds.append(previousRecordEnd);
+            payloadStart = previousRecordEnd;
+        }
+        previousRecordEnd = recordEnd;
+    }
+    
+    // always send at least one packet, since the list is also the reply to the check in
+    payloadEnds.append(previousRecordEnd);
+    
+    // each packet is written once, in place, into a pooled buffer: the lead, the indices, then its run of records
+    PacketBufferPool& bufferPool = PacketBufferPool::getInstance();
+    payloadStart = 0;
+    for (int i = 0; i < payloadEnds.size(); i++) {
+        int payloadSize = payloadEnds.at(i) - payloadStart;
+        QByteArray broadcastPacket = bufferPool.take(leadBytes.size() + PACKET_INDEX_BYTES + payloadSize);
+        uchar* packetPosition = reinterpret_cast<uchar*>(broadcastPacket.data());
+        
+        memcpy(packetPosition, leadBytes.constData(), leadBytes.size());
+        packetPosition += leadBytes.size();
+        
+        // big-endian, as QDataStream writes them
+        qToBigEndian((quint16) i, packetPosition);
+        packetPosition += sizeof(quint16);
+        qToBigEndian((quint16) payloadEnds.size(), packetPosition);
+        packetPosition += sizeof(quint16);
+        
+        memcpy(packetPosition, recordBytes.constData() + payloadStart, payloadSize);
+        payloadStart = payloadEnds.at(i);
+        
         if (!dtlsSession) {
             nodeList->writeDatagram(broadcastPacket, node, senderSockAddr);
         } else {
             dtlsSession->writeDatagram(broadcastPacket);
         }
+        bufferPool.recycle(broadcastPacket);
+    }
+}
+
+void DomainServer::recordDomainListChange(const SharedNodePointer& node) {
+    DomainListChange change = { ++_domainListVersion, node->getUUID(), node->getType() };
+    _domainListChanges.append(change);
+    
+    // nodes that acknowledged a version older than what we keep will get the full list
+    while (_domainListChanges.size() > MAX_DOMAIN_LIST_CHANGES) {
+        _oldestDomainListVersion = _domainListChanges.takeFirst().version;
     }
 }
 
@@ -658,13 +734,24 @@ void DomainServer::processDatagram(const QByteArray& receivedPacket, const HifiS
                 int numNodeInfoBytes = parseNodeDataFromByteArray(throwawayNodeType, nodePublicAddress, nodeLocalAddress,
                                                                   receivedPacket, senderSockAddr);
                 
-                SharedNodePointer checkInNode = nodeList->updateSocketsForNode(nodeUUID, nodePublicAddress, nodeLocalAddress);
+                SharedNodePointer checkInNode = nodeList->nodeWithUUID(nodeUUID);
+                HifiSockAddr oldPublicAddress = checkInNode->getPublicSocket();
+                HifiSockAddr oldLocalAddress = checkInNode->getLocalSocket();
+                
+                checkInNode = nodeList->updateSocketsForNode(nodeUUID, nodePublicAddress, nodeLocalAddress);
+                
+                if (checkInNode->getPublicSocket() != oldPublicAddress || checkInNode->getLocalSocket() != oldLocalAddress) {
+                    // the other nodes need to hear about the new sockets
+                    recordDomainListChange(checkInNode);
+                }
                 
                 // update last receive to now
                 quint64 timeNow = usecTimestampNow();
                 checkInNode->setLastHeardMicrostamp(timeNow);
-            
-                sendDomainListToNode(checkInNode, senderSockAddr, nodeInterestListFromPacket(receivedPacket, numNodeInfoBytes));
+                
+                quint32 acknowledgedVersion = 0;
+                NodeSet nodeInterestList = nodeInterestListFromPacket(receivedPacket, numNodeInfoBytes, &acknowledgedVersion);
+                sendDomainListToNode(checkInNode, senderSockAddr, nodeInterestList, acknowledgedVersion);
             } else {
                 // new node - add this node to our NodeList
                 // and send back session UUID right away
@@ -731,6 +818,7 @@ bool DomainServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
     
     const QString URI_ASSIGNMENT = "/assignment";
     const QString URI_NODES = "/nodes";
+    const QString URI_TRAFFIC = "/traffic.json";
     
     const QString UUID_REGEX_STRING = "[0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12}";
     
@@ -800,6 +888,16 @@ bool DomainServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
             // send the response
             connection->respond(HTTPConnection::StatusCode200, nodesDocument.toJson(), qPrintable(JSON_MIME_TYPE));
             
+            return true;
+        } else if (url.path() == URI_TRAFFIC) {
+            // our own traffic with each node since the last request, in the same form the nodes report theirs in
+            LimitedNodeList* nodeList = LimitedNodeList::getInstance();
+            QJsonObject trafficJSON;
+            trafficJSON[TRAFFIC_STATS_KEY] = nodeList->getTrafficStats().takeStats(nodeList->getNodeHash());
+            
+            QJsonDocument trafficDocument(trafficJSON);
+            connection->respond(HTTPConnection::StatusCode200, trafficDocument.toJson(), qPrintable(JSON_MIME_TYPE));
+            
             return true;
         } else {
             const QString NODE_JSON_REGEX_STRING = QString("\\%1\\/(%2).json\\/?$").arg(URI_NODES).arg(UUID_REGEX_STRING);
@@ -934,10 +1032,14 @@ void DomainServer::refreshStaticAssignmentAndAddToQueue(SharedAssignmentPointer&
 void DomainServer::nodeAdded(SharedNodePointer node) {
     // we don't use updateNodeWithData, so add the DomainServerNodeData to the node here
     node->setLinkedData(new DomainServerNodeData());
+    
+    recordDomainListChange(node);
 }
 
 void DomainServer::nodeKilled(SharedNodePointer node) {
     
+    recordDomainListChange(node);
+    
     DomainServerNodeData* nodeData = reinterpret_cast<DomainServerNodeData*>(node->getLinkedData());
     
     if (nodeData) {
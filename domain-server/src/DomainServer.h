@@ -30,6 +30,14 @@
 
 typedef QSharedPointer<Assignment> SharedAssignmentPointer;
 
+/// A change to the domain's node list, recorded so that nodes can be sent only what changed since their last list.
+class DomainListChange {
+public:
+    quint32 version;
+    QUuid nodeUUID;
+    NodeType_t nodeType;
+};
+
 class DomainServer : public QCoreApplication, public HTTPRequestHandler {
     Q_OBJECT
 public:
@@ -61,9 +69,11 @@ private:
                                                const QJsonObject& authJsonObject = QJsonObject());
     int parseNodeDataFromByteArray(NodeType_t& nodeType, HifiSockAddr& publicSockAddr,
                                     HifiSockAddr& localSockAddr, const QByteArray& packet, const HifiSockAddr& senderSockAddr);
-    NodeSet nodeInterestListFromPacket(const QByteArray& packet, int numPreceedingBytes);
+    NodeSet nodeInterestListFromPacket(const QByteArray& packet, int numPreceedingBytes,
+                                       quint32* acknowledgedVersion = NULL);
     void sendDomainListToNode(const SharedNodePointer& node, const HifiSockAddr& senderSockAddr,
-                              const NodeSet& nodeInterestList);
+                              const NodeSet& nodeInterestList, quint32 acknowledgedVersion = 0);
+    void recordDomainListChange(const SharedNodePointer& node);
     
     void parseAssignmentConfigs(QSet<Assignment::Type>& excludedTypes);
     void addStaticAssignmentToAssignmentHash(Assignment* newAssignment);
@@ -93,6 +103,10 @@ private:
     gnutls_priority_t* _priorityCache;
     
     QHash<HifiSockAddr, DTLSServerSession*> _dtlsSessions;
+    
+    quint32 _domainListVersion;
+    quint32 _oldestDomainListVersion;
+    QList<DomainListChange> _domainListChanges;
 };
 
 #endif // hifi_DomainServer_h
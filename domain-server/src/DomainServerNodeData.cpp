@@ -14,6 +14,7 @@
 #include <QtCore/QVariant>
 
 #include <PacketHeaders.h>
+#include <TrafficStats.h>
 
 #include "DomainServerNodeData.h"
 
@@ -21,7 +22,9 @@ DomainServerNodeData::DomainServerNodeData() :
     _sessionSecretHash(),
     _staticAssignmentUUID(),
     _statsJSONObject(),
-    _sendingSockAddr()
+    _sendingSockAddr(),
+    _nodeInterestSet(),
+    _hasReceivedDomainList(false)
 {
     
 }
@@ -36,6 +39,12 @@ void DomainServerNodeData::parseJSONStatsPacket(const QByteArray& statsPacket) {
     packetStream >> unpackedVariantMap;
     
     QJsonObject unpackedStatsJSON = QJsonObject::fromVariantMap(unpackedVariantMap);
+    
+    // the traffic breakdown covers only the nodes that were busiest since the last one, so it replaces rather than merges
+    if (unpackedStatsJSON.contains(TRAFFIC_STATS_KEY)) {
+        _statsJSONObject.remove(TRAFFIC_STATS_KEY);
+    }
+    
     _statsJSONObject = mergeJSONStatsFromNewObject(unpackedStatsJSON, _statsJSONObject);
 }
 
@@ -16,6 +16,7 @@
 #include <QtCore/QUuid>
 
 #include <HifiSockAddr.h>
+#include <LimitedNodeList.h>
 #include <NodeData.h>
 
 class DomainServerNodeData : public NodeData {
@@ -34,6 +35,12 @@ public:
     const HifiSockAddr& getSendingSockAddr() { return _sendingSockAddr; }
     
     QHash<QUuid, QUuid>& getSessionSecretHash() { return _sessionSecretHash; }
+    
+    void setNodeInterestSet(const NodeSet& nodeInterestSet) { _nodeInterestSet = nodeInterestSet; }
+    const NodeSet& getNodeInterestSet() const { return _nodeInterestSet; }
+    
+    void setHasReceivedDomainList(bool hasReceivedDomainList) { _hasReceivedDomainList = hasReceivedDomainList; }
+    bool hasReceivedDomainList() const { return _hasReceivedDomainList; }
 private:
     QJsonObject mergeJSONStatsFromNewObject(const QJsonObject& newObject, QJsonObject destinationObject);
     
@@ -41,6 +48,8 @@ private:
     QUuid _staticAssignmentUUID;
     QJsonObject _statsJSONObject;
     HifiSockAddr _sendingSockAddr;
+    NodeSet _nodeInterestSet;
+    bool _hasReceivedDomainList;
 };
 
 #endif // hifi_DomainServerNodeData_h
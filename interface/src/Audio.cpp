@@ -32,6 +32,7 @@
 #include <QtMultimedia/QAudioOutput>
 #include <QSvgRenderer>
 
+#include <AudioCodec.h>
 #include <NodeList.h>
 #include <PacketHeaders.h>
 #include <SharedUtil.h>
@@ -47,6 +48,9 @@ static const float AUDIO_CALLBACK_MSECS = (float) NETWORK_BUFFER_LENGTH_SAMPLES_
 
 static const int NUMBER_OF_NOISE_SAMPLE_FRAMES = 300;
 
+// the codec we send our audio in (and ask for the mix in)
+static const AudioCodecType_t MICROPHONE_AUDIO_CODEC = AudioCodecType::ADPCM;
+
 // Mute icon configration
 static const int MUTE_ICON_SIZE = 24;
 
@@ -80,6 +84,7 @@ Audio::Audio(int16_t initialJitterBufferSamples, QObject* parent) :
     _toneInjectionEnabled(false),
     _noiseGateFramesToClose(0),
     _totalPacketsReceived(0),
+    _isReceivingSilence(false),
     _totalInputAudioSamples(0),
     _collisionSoundMagnitude(0.0f),
     _collisionSoundFrequency(0.0f),
@@ -389,9 +394,10 @@ void Audio::handleAudioInput() {
     static char monoAudioDataPacket[MAX_PACKET_SIZE];
 
     static int numBytesPacketHeader = numBytesForPacketHeaderGivenPacketType(PacketTypeMicrophoneAudioNoEcho);
-    static int leadingBytes = numBytesPacketHeader + sizeof(glm::vec3) + sizeof(glm::quat);
+    static int leadingBytes = numBytesPacketHeader + sizeof(glm::vec3) + sizeof(glm::quat) + sizeof(AudioCodecType_t);
 
-    static int16_t* monoAudioSamples = (int16_t*) (monoAudioDataPacket + leadingBytes);
+    // the samples are encoded into the packet once they're ready, so they're kept apart from it
+    static int16_t monoAudioSamples[NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL];
 
     float inputToNetworkInputRatio = calculateDeviceToNetworkInputRatio(_numInputCallbackBytes);
 
@@ -581,11 +587,13 @@ void Audio::handleAudioInput() {
                 packetType = PacketTypeSilentAudioFrame;
                 
                 // we need to indicate how many silent samples this is to the audio mixer
-                monoAudioSamples[0] = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+                int16_t numSilentSamples = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+                memcpy(monoAudioDataPacket + leadingBytes, &numSilentSamples, sizeof(int16_t));
                 numAudioBytes = sizeof(int16_t);
                 
             } else {
-                numAudioBytes = NETWORK_BUFFER_LENGTH_BYTES_PER_CHANNEL;
+                numAudioBytes = AudioCodec::getCodec(MICROPHONE_AUDIO_CODEC)->encode(monoAudioSamples,
+                    NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL, 1, monoAudioDataPacket + leadingBytes);
                 
                 if (Menu::getInstance()->isOptionChecked(MenuOption::EchoServerAudio)) {
                     packetType = PacketTypeMicrophoneAudioWithEcho;
@@ -604,6 +612,9 @@ void Audio::handleAudioInput() {
             memcpy(currentPacketPtr, &headOrientation, sizeof(headOrientation));
             currentPacketPtr += sizeof(headOrientation);
             
+            // tell the mixer how we encode, both so it can decode us and so it can encode our mix the same way
+            *currentPacketPtr = MICROPHONE_AUDIO_CODEC;
+            
             nodeList->writeDatagram(monoAudioDataPacket, numAudioBytes + leadingBytes, audioMixer);
 
             Application::getInstance()->getBandwidthMeter()->outputStream(BandwidthMeter::AUDIO)
@@ -621,12 +632,32 @@ void Audio::addReceivedAudioToBuffer(const QByteArray& audioByteArray) {
     gettimeofday(&currentReceiveTime, NULL);
     _totalPacketsReceived++;
 
+    if (packetTypeForPacket(audioByteArray) == PacketTypeSilentAudioFrame) {
+        // the mixer has nothing for us, and won't send anything more until it does: the stream is ending, so play out
+        // the tail of it (even if it's short of what we'd wait for to start playback), and only once the ring buffer
+        // has run dry reset it, so that the next stream fills the jitter buffer afresh without being called a starve
+        _isReceivingSilence = true;
+        if (_audioOutput) {
+            pushRingBufferToOutput(true);
+        }
+        if (_ringBuffer.samplesAvailable() == 0) {
+            _ringBuffer.reset();
+        }
+        
+        Application::getInstance()->getBandwidthMeter()->inputStream(BandwidthMeter::AUDIO)
+            .updateValue(audioByteArray.size());
+        _lastReceiveTime = currentReceiveTime;
+        return;
+    }
+
     double timeDiff = diffclock(&_lastReceiveTime, &currentReceiveTime);
     
-    //  Discard first few received packets for computing jitter (often they pile up on start)
-    if (_totalPacketsReceived > NUM_INITIAL_PACKETS_DISCARD) {
+    //  Discard first few received packets for computing jitter (often they pile up on start), along with the gap
+    //  before the first mix after a silence
+    if (_totalPacketsReceived > NUM_INITIAL_PACKETS_DISCARD && !_isReceivingSilence) {
         _stdev.addValue(timeDiff);
     }
+    _isReceivingSilence = false;
 
     if (_stdev.getSamples() > STANDARD_DEVIATION_SAMPLE_COUNT) {
         _measuredJitter = _stdev.getStDev();
@@ -669,11 +700,15 @@ void Audio::toggleAudioNoiseReduction() {
 
 void Audio::processReceivedAudio(const QByteArray& audioByteArray) {
     _ringBuffer.parseData(audioByteArray);
+    pushRingBufferToOutput(false);
+}
 
+void Audio::pushRingBufferToOutput(bool isStreamEnding) {
     float networkOutputToOutputRatio = (_desiredOutputFormat.sampleRate() / (float) _outputFormat.sampleRate())
         * (_desiredOutputFormat.channelCount() / (float) _outputFormat.channelCount());
     
-    if (!_ringBuffer.isStarved() && _audioOutput && _audioOutput->bytesFree() == _audioOutput->bufferSize()) {
+    if (!isStreamEnding && !_ringBuffer.isStarved() && _audioOutput &&
+            _audioOutput->bytesFree() == _audioOutput->bufferSize()) {
         // we don't have any audio data left in the output buffer
         // we just starved
         //qDebug() << "Audio output just starved.";
@@ -692,7 +727,7 @@ void Audio::processReceivedAudio(const QByteArray& audioByteArray) {
         
         int numSamplesNeededToStartPlayback = NETWORK_BUFFER_LENGTH_SAMPLES_STEREO + (_jitterBufferSamples * 2);
         
-        if (!_ringBuffer.isNotStarvedOrHasMinimumSamples(numSamplesNeededToStartPlayback)) {
+        if (!isStreamEnding && !_ringBuffer.isNotStarvedOrHasMinimumSamples(numSamplesNeededToStartPlayback)) {
             //  We are still waiting for enough samples to begin playback
             // qDebug() << numNetworkOutputSamples << " samples so far, waiting for " << numSamplesNeededToStartPlayback;
         } else {
@@ -138,6 +138,7 @@ private:
     bool _toneInjectionEnabled;
     int _noiseGateFramesToClose;
     int _totalPacketsReceived;
+    bool _isReceivingSilence; ///< whether the mixer's last word was that it has nothing for us
     int _totalInputAudioSamples;
     
     float _collisionSoundMagnitude;
@@ -176,6 +177,9 @@ private:
     // Process received audio
     void processReceivedAudio(const QByteArray& audioByteArray);
 
+    // Play what's in the ring buffer; once the stream is ending, play it out even if it's short of the jitter buffer
+    void pushRingBufferToOutput(bool isStreamEnding);
+
     bool switchInputToAudioDevice(const QAudioDeviceInfo& inputDeviceInfo);
     bool switchOutputToAudioDevice(const QAudioDeviceInfo& outputDeviceInfo);
 
@@ -262,7 +262,12 @@ MetavoxelClient::~MetavoxelClient() {
 
 static MetavoxelLOD getLOD() {
     const float FIXED_LOD_THRESHOLD = 0.01f;
-    return MetavoxelLOD(Application::getInstance()->getCamera()->getPosition(), FIXED_LOD_THRESHOLD);
+    
+    // quantize the position so that nearby clients are more likely to share delta encodings on the server
+    const float LOD_POSITION_GRANULARITY = 0.5f;
+    glm::vec3 position = glm::floor(Application::getInstance()->getCamera()->getPosition() / LOD_POSITION_GRANULARITY +
+        glm::vec3(0.5f, 0.5f, 0.5f)) * LOD_POSITION_GRANULARITY;
+    return MetavoxelLOD(position, FIXED_LOD_THRESHOLD);
 }
 
 void MetavoxelClient::guide(MetavoxelVisitor& visitor) {
@@ -163,6 +163,6 @@ void ImportTask::run() {
         qDebug() << "[ERROR] Invalid file extension." << endl;
     }
     
-    // Here we reaverage the tree so that he is ready for preview
-    voxelSystem->getTree()->reaverageOctreeElements();
+    // Here we reaverage what was imported so that the tree is ready for preview
+    voxelSystem->getTree()->reaverageChangedElements();
 }
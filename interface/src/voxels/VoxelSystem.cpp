@@ -1991,8 +1991,8 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
     VoxelTreeElement* voxel = (VoxelTreeElement*)element;
     hideOutOfViewArgs* args = (hideOutOfViewArgs*)extraData;
     
-    // If we're still recursing the tree using this operator, then we don't know if we're inside or outside...
-    // so before we move forward we need to determine our frustum location
+    // This is only called on the root. Below it, hideOutOfViewElement() classifies each voxel's children together, so
+    // here we need to determine our frustum location ourselves
     ViewFrustum::location inFrustum = voxel->inFrustum(args->thisViewFrustum);
 
     // If we've culled at least once, then we will use the status of this voxel in the last culled frustum to determine
@@ -2004,6 +2004,14 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
         inLastCulledFrustum = voxel->inFrustum(args->lastViewFrustum);
     }
 
+    hideOutOfViewElement(voxel, inFrustum, inLastCulledFrustum, voxel->furthestDistanceToCamera(args->thisViewFrustum),
+        args);
+    return false; // hideOutOfViewElement() does its own recursing
+}
+
+void VoxelSystem::hideOutOfViewElement(VoxelTreeElement* voxel, ViewFrustum::location inFrustum,
+                                       ViewFrustum::location inLastCulledFrustum, float furthestDistance,
+                                       hideOutOfViewArgs* args) {
     // ok, now do some processing for this node...
     switch (inFrustum) {
         case ViewFrustum::OUTSIDE: {
@@ -2013,14 +2021,14 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
             if (args->culledOnce && args->wantDeltaFrustums && inLastCulledFrustum == ViewFrustum::OUTSIDE) {
                 args->nodesScanned++;
                 args->nodesOutsideOutside++;
-                return false; // stop recursing this branch!
+                return; // stop recursing this branch!
             }
 
             // if this node is fully OUTSIDE the view, but previously intersected and/or was inside the last view, then
             // we need to hide it. Additionally we know that ALL of it's children are also fully OUTSIDE so we can recurse
             // the children and simply mark them as hidden
             args->tree->recurseNodeWithOperation(voxel, hideAllSubTreeOperation, args );
-            return false;
+            return;
 
         } break;
         case ViewFrustum::INSIDE: {
@@ -2030,14 +2038,14 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
             if (args->culledOnce && args->wantDeltaFrustums && inLastCulledFrustum == ViewFrustum::INSIDE) {
                 args->nodesScanned++;
                 args->nodesInsideInside++;
-                return false; // stop recursing this branch!
+                return; // stop recursing this branch!
             }
 
             // if this node is fully INSIDE the view, but previously INTERSECTED and/or was OUTSIDE the last view, then
             // we need to show it. Additionally we know that ALL of it's children are also fully INSIDE so we can recurse
             // the children and simply mark them as visible (as appropriate based on LOD)
             args->tree->recurseNodeWithOperation(voxel, showAllSubTreeOperation, args);
-            return false;
+            return;
         } break;
         case ViewFrustum::INTERSECT: {
             args->nodesScanned++;
@@ -2046,7 +2054,7 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
             // previously INSIDE and visible. So in this case stop recursing
             if (args->culledOnce && args->wantDeltaFrustums && inLastCulledFrustum == ViewFrustum::INSIDE) {
                 args->nodesIntersectInside++;
-                return false; // stop recursing this branch!
+                return; // stop recursing this branch!
             }
 
             args->nodesIntersect++;
@@ -2057,25 +2065,37 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
             
             float voxelSizeScale = Menu::getInstance()->getVoxelSizeScale();
             int boundaryLevelAdjust = Menu::getInstance()->getBoundaryLevelAdjust();
-            bool shouldRender = voxel->calculateShouldRender(&args->thisViewFrustum, voxelSizeScale, boundaryLevelAdjust);
+            bool shouldRender = voxel->calculateShouldRenderAtDistance(furthestDistance, voxelSizeScale,
+                                                                       boundaryLevelAdjust);
             voxel->setShouldRender(shouldRender);
             
             if (voxel->getShouldRender() && !voxel->isKnownBufferIndex()) {
                 voxel->setDirtyBit(); // will this make it draw?
                 voxel->markWithChangedTime(); // both are needed to force redraw
                 args->nodesShown++;
-                return false;
+                return;
             }
 
             // If it INTERSECTS but shouldn't be displayed, then it's probably a parent and it is at least partially in view.
             // So we DO want to recurse the children because some of them may not be in view... nothing specifically to do,
-            // just keep iterating the children
-            return true;
-
+            // just keep iterating the children, which we classify against both views all at once
+            ViewFrustum::ChildLocations childLocations;
+            ViewFrustum::ChildLocations childLocationsLastCulled;
+            voxel->childrenInFrustum(args->thisViewFrustum, childLocations);
+            bool wantLastCulled = args->culledOnce && args->wantDeltaFrustums;
+            if (wantLastCulled) {
+                voxel->childrenInFrustum(args->lastViewFrustum, childLocationsLastCulled);
+            }
+            for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+                VoxelTreeElement* child = voxel->getChildAtIndex(i);
+                if (child) {
+                    hideOutOfViewElement(child, childLocations.getLocation(i),
+                        wantLastCulled ? childLocationsLastCulled.getLocation(i) : ViewFrustum::OUTSIDE,
+                        childLocations.furthestDistances[i], args);
+                }
+            }
         } break;
     } // switch
-
-    return true; // keep going!
 }
 
 
@@ -29,6 +29,7 @@
 #include "PrimitiveRenderer.h"
 
 class ProgramObject;
+class hideOutOfViewArgs;
 
 const int NUM_CHILDREN = 8;
 
@@ -146,6 +147,9 @@ private:
     static bool inspectForExteriorOcclusionsOperation(OctreeElement* element, void* extraData);
     static bool inspectForInteriorOcclusionsOperation(OctreeElement* element, void* extraData);
     static bool hideOutOfViewOperation(OctreeElement* element, void* extraData);
+    static void hideOutOfViewElement(VoxelTreeElement* voxel, ViewFrustum::location inFrustum,
+                                     ViewFrustum::location inLastCulledFrustum, float furthestDistance,
+                                     hideOutOfViewArgs* args);
     static bool hideAllSubTreeOperation(OctreeElement* element, void* extraData);
     static bool showAllSubTreeOperation(OctreeElement* element, void* extraData);
     static bool getVoxelEnclosingOperation(OctreeElement* element, void* extraData);
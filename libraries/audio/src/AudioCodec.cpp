@@ -0,0 +1,238 @@
+//
+//  AudioCodec.cpp
+//  libraries/audio/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+
+#include "AudioCodec.h"
+
+const AudioCodec* AudioCodec::getCodec(AudioCodecType_t type) {
+    static PCMAudioCodec pcmCodec;
+    static ADPCMAudioCodec adpcmCodec;
+
+    switch (type) {
+        case AudioCodecType::PCM:
+            return &pcmCodec;
+        case AudioCodecType::ADPCM:
+            return &adpcmCodec;
+        default:
+            return NULL;
+    }
+}
+
+int AudioCodec::encodeWithType(AudioCodecType_t type, const int16_t* samples, int numFrames, int numChannels,
+        char* destination) {
+    const AudioCodec* codec = getCodec(type);
+    if (!codec) {
+        // fall back to something everyone understands
+        codec = getCodec(AudioCodecType::PCM);
+    }
+    *destination = codec->getType();
+    destination += sizeof(AudioCodecType_t);
+    return sizeof(AudioCodecType_t) + codec->encode(samples, numFrames, numChannels, destination);
+}
+
+AudioCodec::~AudioCodec() {
+}
+
+int PCMAudioCodec::getMaxEncodedSize(int numFrames, int numChannels) const {
+    return numFrames * numChannels * sizeof(int16_t);
+}
+
+int PCMAudioCodec::encode(const int16_t* samples, int numFrames, int numChannels, char* destination) const {
+    int numBytes = numFrames * numChannels * sizeof(int16_t);
+    memcpy(destination, samples, numBytes);
+    return numBytes;
+}
+
+int PCMAudioCodec::decode(const char* data, int size, int16_t* destination, int maxSamples) const {
+    int numSamples = size / sizeof(int16_t);
+    if (numSamples > maxSamples) {
+        return -1;
+    }
+    memcpy(destination, data, numSamples * sizeof(int16_t));
+    return numSamples;
+}
+
+// the standard IMA ADPCM tables
+const int ADPCM_STEP_SIZES[] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107,
+    118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894,
+    6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767 };
+const int MAX_ADPCM_STEP_INDEX = sizeof(ADPCM_STEP_SIZES) / sizeof(ADPCM_STEP_SIZES[0]) - 1;
+const int ADPCM_INDEX_ADJUSTMENTS[] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+/// The block header: the channel count and the number of frames, then the starting state of each channel.
+const int ADPCM_BLOCK_HEADER_BYTES = sizeof(quint8) + sizeof(quint16);
+const int ADPCM_CHANNEL_HEADER_BYTES = sizeof(int16_t) + sizeof(quint8) + sizeof(quint8);
+
+const int MAX_ADPCM_CHANNELS = 8;
+const int MAX_ADPCM_FRAMES = 65535;
+
+class ADPCMChannelState {
+public:
+    int predictor;
+    int stepIndex;
+
+    /// Applies a four-bit code to the state.  The encoder and decoder share this, so they never drift apart.
+    int16_t apply(int code);
+};
+
+int16_t ADPCMChannelState::apply(int code) {
+    int step = ADPCM_STEP_SIZES[stepIndex];
+    int delta = step >> 3;
+    if (code & 4) {
+        delta += step;
+    }
+    if (code & 2) {
+        delta += step >> 1;
+    }
+    if (code & 1) {
+        delta += step >> 2;
+    }
+    predictor = qBound(-32768, (code & 8) ? predictor - delta : predictor + delta, 32767);
+    stepIndex = qBound(0, stepIndex + ADPCM_INDEX_ADJUSTMENTS[code & 7], MAX_ADPCM_STEP_INDEX);
+    return predictor;
+}
+
+int ADPCMAudioCodec::getMaxEncodedSize(int numFrames, int numChannels) const {
+    return ADPCM_BLOCK_HEADER_BYTES + numChannels * ADPCM_CHANNEL_HEADER_BYTES + ((numFrames - 1) * numChannels + 1) / 2;
+}
+
+int ADPCMAudioCodec::encode(const int16_t* samples, int numFrames, int numChannels, char* destination) const {
+    numChannels = qBound(1, numChannels, MAX_ADPCM_CHANNELS);
+    numFrames = qBound(0, numFrames, MAX_ADPCM_FRAMES);
+
+    char* position = destination;
+    *position++ = (quint8)numChannels;
+    quint16 frameCount = numFrames;
+    memcpy(position, &frameCount, sizeof(quint16));
+    position += sizeof(quint16);
+
+    if (numFrames == 0) {
+        return position - destination;
+    }
+
+    // each channel starts from its first sample exactly, with a step size that suits the first difference
+    ADPCMChannelState states[MAX_ADPCM_CHANNELS];
+    for (int i = 0; i < numChannels; i++) {
+        ADPCMChannelState& state = states[i];
+        state.predictor = samples[i];
+        state.stepIndex = 0;
+        if (numFrames > 1) {
+            int firstDifference = qAbs(samples[numChannels + i] - samples[i]);
+            while (state.stepIndex < MAX_ADPCM_STEP_INDEX && ADPCM_STEP_SIZES[state.stepIndex] < firstDifference) {
+                state.stepIndex++;
+            }
+        }
+        int16_t predictor = state.predictor;
+        memcpy(position, &predictor, sizeof(int16_t));
+        position += sizeof(int16_t);
+        *position++ = (quint8)state.stepIndex;
+        *position++ = 0;
+    }
+
+    // pack the codes for the remaining samples in order, low nibble first
+    const int16_t* sample = samples + numChannels;
+    const int16_t* end = samples + numFrames * numChannels;
+    bool highNibble = false;
+    for (int channel = 0; sample != end; sample++) {
+        ADPCMChannelState& state = states[channel];
+        int difference = *sample - state.predictor;
+        int code = 0;
+        if (difference < 0) {
+            code = 8;
+            difference = -difference;
+        }
+        int step = ADPCM_STEP_SIZES[state.stepIndex];
+        if (difference >= step) {
+            code |= 4;
+            difference -= step;
+        }
+        step >>= 1;
+        if (difference >= step) {
+            code |= 2;
+            difference -= step;
+        }
+        step >>= 1;
+        if (difference >= step) {
+            code |= 1;
+        }
+        state.apply(code);
+
+        if (highNibble) {
+            *position++ |= (char)(code << 4);
+        } else {
+            *position = (char)code;
+        }
+        highNibble = !highNibble;
+
+        if (++channel == numChannels) {
+            channel = 0;
+        }
+    }
+    if (highNibble) {
+        position++;
+    }
+    return position - destination;
+}
+
+int ADPCMAudioCodec::decode(const char* data, int size, int16_t* destination, int maxSamples) const {
+    if (size < ADPCM_BLOCK_HEADER_BYTES) {
+        return -1;
+    }
+    const char* position = data;
+    int numChannels = (quint8)*position++;
+    quint16 numFrames;
+    memcpy(&numFrames, position, sizeof(quint16));
+    position += sizeof(quint16);
+
+    if (numFrames == 0) {
+        return 0;
+    }
+    int numSamples = numFrames * numChannels;
+    if (numChannels == 0 || numChannels > MAX_ADPCM_CHANNELS || numSamples > maxSamples
+            || size < getMaxEncodedSize(numFrames, numChannels)) {
+        return -1;
+    }
+
+    ADPCMChannelState states[MAX_ADPCM_CHANNELS];
+    for (int i = 0; i < numChannels; i++) {
+        int16_t predictor;
+        memcpy(&predictor, position, sizeof(int16_t));
+        position += sizeof(int16_t);
+        states[i].predictor = predictor;
+        states[i].stepIndex = qMin((int)(quint8)*position++, MAX_ADPCM_STEP_INDEX);
+        position++;
+        destination[i] = predictor;
+    }
+
+    int16_t* sample = destination + numChannels;
+    int16_t* end = destination + numSamples;
+    bool highNibble = false;
+    for (int channel = 0; sample != end; sample++) {
+        int code;
+        if (highNibble) {
+            code = ((quint8)*position++) >> 4;
+        } else {
+            code = *position & 0x0F;
+        }
+        highNibble = !highNibble;
+
+        *sample = states[channel].apply(code);
+
+        if (++channel == numChannels) {
+            channel = 0;
+        }
+    }
+    return numSamples;
+}
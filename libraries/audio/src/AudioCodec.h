@@ -0,0 +1,79 @@
+//
+//  AudioCodec.h
+//  libraries/audio/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioCodec_h
+#define hifi_AudioCodec_h
+
+#include <stdint.h>
+
+#include <QtCore/QtGlobal>
+
+typedef quint8 AudioCodecType_t;
+
+namespace AudioCodecType {
+    const AudioCodecType_t PCM = 0;
+    const AudioCodecType_t ADPCM = 1;
+}
+
+/// The most samples a single packet's worth of encoded audio can decode to.
+const int MAX_DECODED_SAMPLES_PER_PACKET = 4096;
+
+/// Encodes and decodes blocks of interleaved 16-bit samples.  Each block is self-contained (it carries its own channel
+/// count and starting state), so losing a packet never affects the ones after it.  Codecs are stateless and shared.
+class AudioCodec {
+public:
+
+    /// Returns the codec of the given type, or NULL if we don't know it.
+    static const AudioCodec* getCodec(AudioCodecType_t type);
+
+    /// Writes the codec type followed by the samples encoded with that codec (or with PCM, if the type is unknown).
+    /// \return the number of bytes written
+    static int encodeWithType(AudioCodecType_t type, const int16_t* samples, int numFrames, int numChannels,
+        char* destination);
+
+    virtual ~AudioCodec();
+
+    virtual AudioCodecType_t getType() const = 0;
+
+    /// Returns the largest number of bytes that encode will write for the given number of sample frames.
+    virtual int getMaxEncodedSize(int numFrames, int numChannels) const = 0;
+
+    /// Encodes the given number of sample frames (one sample per channel each).
+    /// \return the number of bytes written
+    virtual int encode(const int16_t* samples, int numFrames, int numChannels, char* destination) const = 0;
+
+    /// Decodes a block written by encode.
+    /// \return the number of samples written, or -1 if the block is malformed or won't fit in maxSamples
+    virtual int decode(const char* data, int size, int16_t* destination, int maxSamples) const = 0;
+};
+
+/// Raw 16-bit PCM, for peers on fast links (and those that don't know any other codec).
+class PCMAudioCodec : public AudioCodec {
+public:
+
+    virtual AudioCodecType_t getType() const { return AudioCodecType::PCM; }
+    virtual int getMaxEncodedSize(int numFrames, int numChannels) const;
+    virtual int encode(const int16_t* samples, int numFrames, int numChannels, char* destination) const;
+    virtual int decode(const char* data, int size, int16_t* destination, int maxSamples) const;
+};
+
+/// IMA ADPCM: four bits per sample plus a small per-channel header, so roughly a quarter the size of PCM for about a
+/// dozen integer operations per sample each way.
+class ADPCMAudioCodec : public AudioCodec {
+public:
+
+    virtual AudioCodecType_t getType() const { return AudioCodecType::ADPCM; }
+    virtual int getMaxEncodedSize(int numFrames, int numChannels) const;
+    virtual int encode(const int16_t* samples, int numFrames, int numChannels, char* destination) const;
+    virtual int decode(const char* data, int size, int16_t* destination, int maxSamples) const;
+};
+
+#endif // hifi_AudioCodec_h
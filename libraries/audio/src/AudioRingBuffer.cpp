@@ -55,8 +55,16 @@ void AudioRingBuffer::resizeForFrameSize(qint64 numFrameSamples) {
 }
 
 int AudioRingBuffer::parseData(const QByteArray& packet) {
-    int numBytesPacketHeader = numBytesForPacketHeader(packet);
-    return writeData(packet.data() + numBytesPacketHeader, packet.size() - numBytesPacketHeader);
+    int readBytes = numBytesForPacketHeader(packet);
+    if (readBytes >= packet.size()) {
+        return readBytes;
+    }
+    
+    // the audio is preceded by the type of codec it was encoded with
+    AudioCodecType_t codecType = packet.at(readBytes);
+    readBytes += sizeof(AudioCodecType_t);
+    
+    return readBytes + writeEncodedData(codecType, packet.data() + readBytes, packet.size() - readBytes);
 }
 
 qint64 AudioRingBuffer::readSamples(int16_t* destination, qint64 maxSamples) {
@@ -124,6 +132,25 @@ qint64 AudioRingBuffer::writeData(const char* data, qint64 maxSize) {
     return samplesToCopy * sizeof(int16_t);
 }
 
+qint64 AudioRingBuffer::writeEncodedData(AudioCodecType_t codecType, const char* data, qint64 size) {
+    if (codecType == AudioCodecType::PCM) {
+        return writeData(data, size);
+    }
+    const AudioCodec* codec = AudioCodec::getCodec(codecType);
+    if (!codec) {
+        qDebug() << "Dropping audio encoded with unknown codec" << codecType;
+        return size;
+    }
+    int16_t decodedSamples[MAX_DECODED_SAMPLES_PER_PACKET];
+    int numDecodedSamples = codec->decode(data, size, decodedSamples, MAX_DECODED_SAMPLES_PER_PACKET);
+    if (numDecodedSamples < 0) {
+        qDebug() << "Dropping malformed audio encoded with codec" << codecType;
+        return size;
+    }
+    writeSamples(decodedSamples, numDecodedSamples);
+    return size;
+}
+
 int16_t& AudioRingBuffer::operator[](const int index) {
     return *shiftedPositionAccomodatingWrap(_nextOutput, index);
 }
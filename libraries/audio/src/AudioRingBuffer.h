@@ -21,6 +21,8 @@
 
 #include "NodeData.h"
 
+#include "AudioCodec.h"
+
 const int SAMPLE_RATE = 24000;
 
 const int NETWORK_BUFFER_LENGTH_BYTES_STEREO = 1024;
@@ -58,6 +60,10 @@ public:
     
     qint64 readData(char* data, qint64 maxSize);
     qint64 writeData(const char* data, qint64 maxSize);
+
+    /// Decodes audio encoded with the given codec and writes the samples.  Audio that can't be decoded is dropped.
+    /// \return the number of bytes read
+    qint64 writeEncodedData(AudioCodecType_t codecType, const char* data, qint64 size);
     
     int16_t& operator[](const int index);
     
@@ -21,6 +21,10 @@ public:
     
     float getLastReadFrameAverageLoudness() const { return _lastReadFrameAverageLoudness; }
     
+    /// Empties the buffer and takes the last frame read to have been silent, for when the mixer says that the stream
+    /// has gone silent (rather than sending mixes of zeros).
+    void resetToSilence() { reset(); _lastReadFrameAverageLoudness = 0.0f; }
+    
     qint64 readSamples(int16_t* destination, qint64 maxSamples);    
 private:
      float _lastReadFrameAverageLoudness;
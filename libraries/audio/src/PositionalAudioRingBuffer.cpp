@@ -27,7 +27,8 @@ PositionalAudioRingBuffer::PositionalAudioRingBuffer(PositionalAudioRingBuffer::
     _orientation(0.0f, 0.0f, 0.0f, 0.0f),
     _willBeAddedToMix(false),
     _shouldLoopbackForNode(false),
-    _shouldOutputStarveDebug(true)
+    _shouldOutputStarveDebug(true),
+    _codecType(AudioCodecType::PCM)
 {
 
 }
@@ -41,6 +42,12 @@ int PositionalAudioRingBuffer::parseData(const QByteArray& packet) {
     int readBytes = numBytesForPacketHeader(packet);
     
     readBytes += parsePositionalData(packet.mid(readBytes));
+    
+    // the source tells us which codec it encodes with (even when it's silent), and we answer it in kind
+    if (readBytes < packet.size()) {
+        _codecType = packet.at(readBytes);
+        readBytes += sizeof(AudioCodecType_t);
+    }
    
     if (packetTypeForPacket(packet) == PacketTypeSilentAudioFrame) {
         // this source had no audio to send us, but this counts as a packet
@@ -54,7 +61,7 @@ int PositionalAudioRingBuffer::parseData(const QByteArray& packet) {
         addSilentFrame(numSilentSamples);
     } else {
         // there is audio data to read
-        readBytes += writeData(packet.data() + readBytes, packet.size() - readBytes);
+        readBytes += writeEncodedData(_codecType, packet.data() + readBytes, packet.size() - readBytes);
     }
     
     return readBytes;
@@ -45,6 +45,9 @@ public:
     const glm::vec3& getPosition() const { return _position; }
     const glm::quat& getOrientation() const { return _orientation; }
     
+    /// Returns the codec the source last told us it encodes with, which is also the one it expects its mix in.
+    AudioCodecType_t getCodecType() const { return _codecType; }
+    
 protected:
     // disallow copying of PositionalAudioRingBuffer objects
     PositionalAudioRingBuffer(const PositionalAudioRingBuffer&);
@@ -56,6 +59,7 @@ protected:
     bool _willBeAddedToMix;
     bool _shouldLoopbackForNode;
     bool _shouldOutputStarveDebug;
+    AudioCodecType_t _codecType;
     
     float _nextOutputTrailingLoudness;
 };
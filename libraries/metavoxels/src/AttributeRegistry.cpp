@@ -175,6 +175,46 @@ OwnedAttributeValue& OwnedAttributeValue::operator=(const OwnedAttributeValue& o
     return *this;
 }
 
+MetavoxelNodePool::MetavoxelNodePool() :
+    _blockSize(0),
+    _freeList(NULL),
+    _allocatedCount(0) {
+}
+
+MetavoxelNodePool::~MetavoxelNodePool() {
+    foreach (char* chunk, _chunks) {
+        delete[] chunk;
+    }
+}
+
+void* MetavoxelNodePool::allocate(size_t size) {
+    QMutexLocker locker(&_mutex);
+    if (!_freeList) {
+        // the block size is fixed by the first allocation; each free block stores the pointer to the next
+        if (_blockSize == 0) {
+            _blockSize = qMax(size, sizeof(void*));
+        }
+        char* chunk = new char[_blockSize * BLOCKS_PER_CHUNK];
+        _chunks.append(chunk);
+        for (int i = BLOCKS_PER_CHUNK - 1; i >= 0; i--) {
+            void* block = chunk + i * _blockSize;
+            *(void**)block = _freeList;
+            _freeList = block;
+        }
+    }
+    void* block = _freeList;
+    _freeList = *(void**)block;
+    _allocatedCount++;
+    return block;
+}
+
+void MetavoxelNodePool::release(void* block) {
+    QMutexLocker locker(&_mutex);
+    *(void**)block = _freeList;
+    _freeList = block;
+    _allocatedCount--;
+}
+
 Attribute::Attribute(const QString& name) :
         _lodThresholdMultiplier(1.0f) {
     setObjectName(name);
@@ -184,7 +224,7 @@ Attribute::~Attribute() {
 }
 
 MetavoxelNode* Attribute::createMetavoxelNode(const AttributeValue& value, const MetavoxelNode* original) const {
-    return new MetavoxelNode(value);
+    return new (value.getAttribute()) MetavoxelNode(value);
 }
 
 void Attribute::readMetavoxelRoot(MetavoxelData& data, MetavoxelStreamState& state) {
@@ -345,7 +385,7 @@ void SpannerQRgbAttribute::write(Bitstream& out, void* value, bool isLeaf) const
 
 MetavoxelNode* SpannerQRgbAttribute::createMetavoxelNode(
         const AttributeValue& value, const MetavoxelNode* original) const {
-    return new MetavoxelNode(value, original);
+    return new (value.getAttribute()) MetavoxelNode(value, original);
 }
 
 bool SpannerQRgbAttribute::merge(void*& parent, void* children[], bool postRead) const {
@@ -400,7 +440,7 @@ void SpannerPackedNormalAttribute::write(Bitstream& out, void* value, bool isLea
 
 MetavoxelNode* SpannerPackedNormalAttribute::createMetavoxelNode(
         const AttributeValue& value, const MetavoxelNode* original) const {
-    return new MetavoxelNode(value, original);
+    return new (value.getAttribute()) MetavoxelNode(value, original);
 }
 
 bool SpannerPackedNormalAttribute::merge(void*& parent, void* children[], bool postRead) const {
@@ -484,9 +524,20 @@ void SharedObjectSetAttribute::write(Bitstream& out, void* value, bool isLeaf) c
     out << decodeInline<SharedObjectSet>(value);
 }
 
+uint SharedObjectSetAttribute::hash(void* value) const {
+    // equal sets can hold their elements in different orders (and different shared data), so combine the elements'
+    // hashes in a way that doesn't depend on the order
+    uint hash = 0;
+    SharedObjectSet set = decodeInline<SharedObjectSet>(value);
+    for (SharedObjectSet::const_iterator it = set.constBegin(); it != set.constEnd(); it++) {
+        hash += qHash(*it);
+    }
+    return hash;
+}
+
 MetavoxelNode* SharedObjectSetAttribute::createMetavoxelNode(
         const AttributeValue& value, const MetavoxelNode* original) const {
-    return new MetavoxelNode(value, original);
+    return new (value.getAttribute()) MetavoxelNode(value, original);
 }
 
 bool SharedObjectSetAttribute::merge(void*& parent, void* children[], bool postRead) const {
@@ -13,6 +13,7 @@
 #define hifi_AttributeRegistry_h
 
 #include <QHash>
+#include <QMutex>
 #include <QObject>
 #include <QSharedPointer>
 #include <QString>
@@ -173,6 +174,38 @@ public:
 
 Q_DECLARE_METATYPE(OwnedAttributeValue)
 
+/// A pool of fixed-size blocks from which the nodes of a single attribute are allocated.  Blocks are carved out of larger
+/// chunks and recycled through a free list, which is protected by a mutex so that parallel tours may share the pool.
+class MetavoxelNodePool {
+public:
+    
+    MetavoxelNodePool();
+    ~MetavoxelNodePool();
+    
+    void* allocate(size_t size);
+    void release(void* block);
+    
+    /// Returns the number of blocks currently in use.
+    int getAllocatedCount() const { return _allocatedCount; }
+    
+    /// Returns the number of bytes occupied by the blocks currently in use.
+    qint64 getAllocatedBytes() const { return (qint64)_allocatedCount * _blockSize; }
+    
+    /// Returns the number of bytes reserved by the pool's chunks.
+    qint64 getReservedBytes() const { return (qint64)_chunks.size() * _blockSize * BLOCKS_PER_CHUNK; }
+    
+private:
+    Q_DISABLE_COPY(MetavoxelNodePool)
+    
+    static const int BLOCKS_PER_CHUNK = 1024;
+    
+    QMutex _mutex;
+    size_t _blockSize;
+    void* _freeList;
+    QVector<char*> _chunks;
+    int _allocatedCount;
+};
+
 /// Represents a registered attribute.
 class Attribute : public SharedObject {
     Q_OBJECT
@@ -190,6 +223,9 @@ public:
     float getLODThresholdMultiplier() const { return _lodThresholdMultiplier; }
     void setLODThresholdMultiplier(float multiplier) { _lodThresholdMultiplier = multiplier; }
 
+    /// Returns the pool from which this attribute's nodes are allocated.
+    MetavoxelNodePool& getNodePool() const { return _nodePool; }
+
     void* create() const { return create(getDefaultValue()); }
     virtual void* create(void* copy) const = 0;
     virtual void destroy(void* value) const = 0;
@@ -213,6 +249,10 @@ public:
 
     virtual bool equal(void* first, void* second) const = 0;
 
+    /// Returns a hash of the value that agrees with equal (values that are equal hash alike).  The default puts every
+    /// value in the same bucket, leaving equal to decide; attributes whose values can be hashed should override it.
+    virtual uint hash(void* value) const { return 0; }
+
     /// Merges the value of a parent and its children.
     /// \param postRead whether or not the merge is happening after a read
     /// \return whether or not the children and parent values are all equal
@@ -240,6 +280,7 @@ public:
 private:
     
     float _lodThresholdMultiplier;
+    mutable MetavoxelNodePool _nodePool;
 };
 
 /// A simple attribute class that stores its values inline.
@@ -256,6 +297,9 @@ public:
 
     virtual bool equal(void* first, void* second) const { return decodeInline<T>(first) == decodeInline<T>(second); }
 
+    /// Hashes the inline bits of the value, which agrees with equal for the bitwise-comparable types stored here.
+    virtual uint hash(void* value) const { return qHash(value); }
+
     virtual void* mix(void* first, void* second, float alpha) const { return create(alpha < 0.5f ? first : second); }
 
     virtual void* blend(void* source, void* dest) const { return create(source); }
@@ -432,6 +476,8 @@ public:
     virtual void read(Bitstream& in, void*& value, bool isLeaf) const;
     virtual void write(Bitstream& out, void* value, bool isLeaf) const;
     
+    virtual uint hash(void* value) const;
+    
     virtual MetavoxelNode* createMetavoxelNode(const AttributeValue& value, const MetavoxelNode* original) const;
     
     virtual bool merge(void*& parent, void* children[], bool postRead = false) const;
@@ -16,6 +16,7 @@
 #include <QMetaType>
 #include <QUrl>
 #include <QtDebug>
+#include <QtEndian>
 
 #include <RegisteredMetaTypes.h>
 #include <SharedUtil.h>
@@ -71,6 +72,10 @@ IDStreamer& IDStreamer::operator>>(int& value) {
     return *this;
 }
 
+BitstreamRecording::BitstreamRecording() :
+    _bitCount(0) {
+}
+
 int Bitstream::registerMetaObject(const char* className, const QMetaObject* metaObject) {
     getMetaObjects().insert(className, metaObject);
     
@@ -102,9 +107,10 @@ QList<const QMetaObject*> Bitstream::getMetaObjectSubClasses(const QMetaObject*
 Bitstream::Bitstream(QDataStream& underlying, MetadataType metadataType, QObject* parent) :
     QObject(parent),
     _underlying(underlying),
-    _byte(0),
+    _word(0),
     _position(0),
     _metadataType(metadataType),
+    _recording(NULL),
     _metaObjectStreamer(*this),
     _typeStreamerStreamer(*this),
     _attributeStreamer(*this),
@@ -122,54 +128,182 @@ void Bitstream::addTypeSubstitution(const QByteArray& typeName, int type) {
 
 const int LAST_BIT_POSITION = BITS_IN_BYTE - 1;
 
+const int BITS_IN_WORD = 64;
+const int BYTES_IN_WORD = BITS_IN_WORD / BITS_IN_BYTE;
+
+const int BITS_IN_READ_CHUNK = 32;
+const int BYTES_IN_READ_CHUNK = BITS_IN_READ_CHUNK / BITS_IN_BYTE;
+
 Bitstream& Bitstream::write(const void* data, int bits, int offset) {
     const quint8* source = (const quint8*)data;
-    while (bits > 0) {
-        int bitsToWrite = qMin(BITS_IN_BYTE - _position, qMin(BITS_IN_BYTE - offset, bits));
-        _byte |= ((*source >> offset) & ((1 << bitsToWrite) - 1)) << _position;
-        if ((_position += bitsToWrite) == BITS_IN_BYTE) {
-            flush();
-        }
-        if ((offset += bitsToWrite) == BITS_IN_BYTE) {
-            source++;
-            offset = 0;
-        }
+    
+    // bring the source up to a byte boundary
+    if (offset != 0 && bits > 0) {
+        int bitsToWrite = qMin(BITS_IN_BYTE - offset, bits);
+        writeBits(*source++ >> offset, bitsToWrite);
         bits -= bitsToWrite;
     }
+    
+    // if we're at a byte boundary in the stream, long runs can bypass the accumulator
+    if (bits >= BITS_IN_WORD && (_position & LAST_BIT_POSITION) == 0) {
+        if (_position != 0) {
+            writeAccumulatedBytes();
+        }
+        int bytes = bits / BITS_IN_BYTE;
+        _underlying.writeRawData((const char*)source, bytes);
+        source += bytes;
+        bits &= LAST_BIT_POSITION;
+    }
+    
+    // otherwise, shift in a word at a time
+    for (; bits >= BITS_IN_WORD; bits -= BITS_IN_WORD, source += BYTES_IN_WORD) {
+        quint64 word;
+        memcpy(&word, source, BYTES_IN_WORD);
+        writeBits(qFromLittleEndian(word), BITS_IN_WORD);
+    }
+    
+    // and finish with whatever's left
+    if (bits > 0) {
+        quint64 word = 0;
+        memcpy(&word, source, (bits + LAST_BIT_POSITION) / BITS_IN_BYTE);
+        writeBits(qFromLittleEndian(word), bits);
+    }
     return *this;
 }
 
 Bitstream& Bitstream::read(void* data, int bits, int offset) {
     quint8* dest = (quint8*)data;
-    while (bits > 0) {
-        if (_position == 0) {
-            _underlying >> _byte;
-        }
-        int bitsToRead = qMin(BITS_IN_BYTE - _position, qMin(BITS_IN_BYTE - offset, bits));
+    
+    // bring the destination up to a byte boundary
+    if (offset != 0 && bits > 0) {
+        int bitsToRead = qMin(BITS_IN_BYTE - offset, bits);
         int mask = ((1 << bitsToRead) - 1) << offset;
-        *dest = (*dest & ~mask) | (((_byte >> _position) << offset) & mask);
-        _position = (_position + bitsToRead) & LAST_BIT_POSITION;
-        if ((offset += bitsToRead) == BITS_IN_BYTE) {
-            dest++;
-            offset = 0;
-        }
+        *dest = (*dest & ~mask) | (((int)readBits(bitsToRead) << offset) & mask);
+        dest++;
         bits -= bitsToRead;
     }
+    
+    // if we're at a byte boundary in the stream, long runs can be read directly
+    if (bits >= BITS_IN_WORD && _position == 0) {
+        int bytes = bits / BITS_IN_BYTE;
+        int bytesRead = qMax(_underlying.readRawData((char*)dest, bytes), 0);
+        if (bytesRead < bytes) {
+            // match the behavior of QDataStream, which reads zeros past the end
+            memset(dest + bytesRead, 0, bytes - bytesRead);
+        }
+        dest += bytes;
+        bits &= LAST_BIT_POSITION;
+    }
+    
+    // otherwise, read in chunks
+    for (; bits >= BITS_IN_READ_CHUNK; bits -= BITS_IN_READ_CHUNK, dest += BYTES_IN_READ_CHUNK) {
+        quint32 chunk = qToLittleEndian((quint32)readBits(BITS_IN_READ_CHUNK));
+        memcpy(dest, &chunk, BYTES_IN_READ_CHUNK);
+    }
+    for (; bits >= BITS_IN_BYTE; bits -= BITS_IN_BYTE) {
+        *dest++ = readBits(BITS_IN_BYTE);
+    }
+    
+    // preserve the bits beyond the end of the range
+    if (bits > 0) {
+        int mask = (1 << bits) - 1;
+        *dest = (*dest & ~mask) | (readBits(bits) & mask);
+    }
     return *this;
 }
 
 void Bitstream::flush() {
     if (_position != 0) {
-        _underlying << _byte;
+        writeAccumulatedBytes();
         reset();
     }
 }
 
 void Bitstream::reset() {
-    _byte = 0;
+    _word = 0;
     _position = 0;
 }
 
+void Bitstream::startRecording(BitstreamRecording& recording) {
+    _recording = &recording;
+    _recording->_data.clear();
+    _recording->_bitCount = 0;
+    _recording->_references.clear();
+}
+
+void Bitstream::stopRecording(const QByteArray& data) {
+    _recording->_bitCount = _underlying.device()->pos() * BITS_IN_BYTE + _position;
+    flush();
+    _recording->_data = data;
+    _recording = NULL;
+}
+
+void Bitstream::writeBits(quint64 value, int bits) {
+    if (bits < BITS_IN_WORD) {
+        value &= (Q_UINT64_C(1) << bits) - 1;
+    }
+    _word |= value << _position;
+    if ((_position += bits) >= BITS_IN_WORD) {
+        quint64 word = qToLittleEndian(_word);
+        _underlying.writeRawData((const char*)&word, BYTES_IN_WORD);
+        
+        // carry over the bits that didn't fit
+        _position -= BITS_IN_WORD;
+        _word = (_position == 0) ? 0 : value >> (bits - _position);
+    }
+}
+
+void Bitstream::writeAccumulatedBytes() {
+    quint64 word = qToLittleEndian(_word);
+    _underlying.writeRawData((const char*)&word, (_position + LAST_BIT_POSITION) / BITS_IN_BYTE);
+    reset();
+}
+
+void Bitstream::recordReference(const QMetaObject* metaObject) {
+    appendReference(BitstreamRecording::META_OBJECT).metaObject = metaObject;
+}
+
+void Bitstream::recordReference(const TypeStreamer* streamer) {
+    appendReference(BitstreamRecording::TYPE_STREAMER).typeStreamer = streamer;
+}
+
+void Bitstream::recordReference(const AttributePointer& attribute) {
+    appendReference(BitstreamRecording::ATTRIBUTE).attribute = attribute;
+}
+
+void Bitstream::recordReference(const QScriptString& string) {
+    appendReference(BitstreamRecording::SCRIPT_STRING).scriptString = string;
+}
+
+void Bitstream::recordReference(const SharedObjectPointer& object) {
+    appendReference(BitstreamRecording::SHARED_OBJECT).sharedObject = object;
+}
+
+BitstreamRecording::Reference& Bitstream::appendReference(BitstreamRecording::ReferenceType type) {
+    BitstreamRecording::Reference reference;
+    reference.type = type;
+    reference.position = _underlying.device()->pos() * BITS_IN_BYTE + _position;
+    reference.metaObject = NULL;
+    reference.typeStreamer = NULL;
+    _recording->_references.append(reference);
+    return _recording->_references.last();
+}
+
+quint64 Bitstream::readBits(int bits) {
+    if (_position < bits) {
+        // fetch only as many bytes as we need, so that we never consume more of the underlying stream than we use
+        int bytes = (bits - _position + LAST_BIT_POSITION) / BITS_IN_BYTE;
+        quint64 word = 0;
+        _underlying.readRawData((char*)&word, bytes);
+        _word |= qFromLittleEndian(word) << _position;
+        _position += bytes * BITS_IN_BYTE;
+    }
+    quint64 value = _word & ((Q_UINT64_C(1) << bits) - 1);
+    _word >>= bits;
+    _position -= bits;
+    return value;
+}
+
 Bitstream::WriteMappings Bitstream::getAndResetWriteMappings() {
     WriteMappings mappings = { _metaObjectStreamer.getAndResetTransientOffsets(),
         _typeStreamerStreamer.getAndResetTransientOffsets(),
@@ -301,20 +435,16 @@ void Bitstream::readRawDelta(QObject*& value, const QObject* reference) {
 
 Bitstream& Bitstream::operator<<(bool value) {
     if (value) {
-        _byte |= (1 << _position);
+        _word |= (Q_UINT64_C(1) << _position);
     }
-    if (++_position == BITS_IN_BYTE) {
-        flush();
+    if (++_position == BITS_IN_WORD) {
+        writeAccumulatedBytes();
     }
     return *this;
 }
 
 Bitstream& Bitstream::operator>>(bool& value) {
-    if (_position == 0) {
-        _underlying >> _byte;
-    }
-    value = _byte & (1 << _position);
-    _position = (_position + 1) & LAST_BIT_POSITION;
+    value = readBits(1);
     return *this;
 }
 
@@ -891,6 +1021,38 @@ Bitstream& Bitstream::operator>(SharedObjectPointer& object) {
     return *this;
 }
 
+Bitstream& Bitstream::operator<<(const BitstreamRecording& recording) {
+    const char* data = recording._data.constData();
+    int position = 0;
+    foreach (const BitstreamRecording::Reference& reference, recording._references) {
+        write(data + position / BITS_IN_BYTE, reference.position - position, position & LAST_BIT_POSITION);
+        position = reference.position;
+        
+        switch (reference.type) {
+            case BitstreamRecording::META_OBJECT:
+                _metaObjectStreamer << reference.metaObject;
+                break;
+                
+            case BitstreamRecording::TYPE_STREAMER:
+                _typeStreamerStreamer << reference.typeStreamer;
+                break;
+                
+            case BitstreamRecording::ATTRIBUTE:
+                _attributeStreamer << reference.attribute;
+                break;
+                
+            case BitstreamRecording::SCRIPT_STRING:
+                _scriptStringStreamer << reference.scriptString;
+                break;
+                
+            case BitstreamRecording::SHARED_OBJECT:
+                _sharedObjectStreamer << reference.sharedObject;
+                break;
+        }
+    }
+    return write(data + position / BITS_IN_BYTE, recording._bitCount - position, position & LAST_BIT_POSITION);
+}
+
 void Bitstream::clearSharedObject(QObject* object) {
     SharedObject* sharedObject = static_cast<SharedObject*>(object);
     _sharedObjectReferences.remove(sharedObject->getID());
@@ -144,24 +144,6 @@ template<class K, class P, class V> inline void RepeatedValueStreamer<K, P, V>::
     _idStreamer.setBitsFromValue(_lastPersistentID);
 }
 
-template<class K, class P, class V> inline RepeatedValueStreamer<K, P, V>&
-        RepeatedValueStreamer<K, P, V>::operator<<(K value) {
-    int id = _persistentIDs.value(value);
-    if (id == 0) {
-        int& offset = _transientOffsets[value];
-        if (offset == 0) {
-            _idStreamer << (_lastPersistentID + (offset = ++_lastTransientOffset));
-            _stream < value;
-            
-        } else {
-            _idStreamer << (_lastPersistentID + offset);
-        }
-    } else {
-        _idStreamer << id;
-    }
-    return *this;
-}
-
 template<class K, class P, class V> inline RepeatedValueStreamer<K, P, V>&
         RepeatedValueStreamer<K, P, V>::operator>>(V& value) {
     int id;
@@ -183,6 +165,39 @@ template<class K, class P, class V> inline RepeatedValueStreamer<K, P, V>&
     return *this;
 }
 
+/// A sequence of writes recorded from a bitstream, which may be replayed into any number of other streams.  Raw bits are
+/// stored as-is, whereas repeated values (attributes, shared objects, etc.) are stored by reference and written through the
+/// destination stream's own mappings on replay, so that the replayed bits match exactly what a direct write would produce.
+class BitstreamRecording {
+public:
+    
+    BitstreamRecording();
+    
+    /// Returns the number of raw bits recorded.
+    int getBitCount() const { return _bitCount; }
+    
+private:
+    
+    friend class Bitstream;
+    
+    enum ReferenceType { META_OBJECT, TYPE_STREAMER, ATTRIBUTE, SCRIPT_STRING, SHARED_OBJECT };
+    
+    class Reference {
+    public:
+        ReferenceType type;
+        int position;
+        const QMetaObject* metaObject;
+        const TypeStreamer* typeStreamer;
+        AttributePointer attribute;
+        QScriptString scriptString;
+        SharedObjectPointer sharedObject;
+    };
+    
+    QByteArray _data;
+    int _bitCount;
+    QVector<Reference> _references;
+};
+
 /// A stream for bit-aligned data.
 class Bitstream : public QObject {
     Q_OBJECT
@@ -235,12 +250,14 @@ public:
     /// Substitutes the supplied type for the given type name's default mapping.
     void addTypeSubstitution(const QByteArray& typeName, int type);
 
-    /// Writes a set of bits to the underlying stream.
+    /// Writes a set of bits to the underlying stream.  Bits are accumulated into a 64-bit word that is handed to the
+    /// underlying stream whenever it fills; byte-aligned runs bypass the accumulator entirely.
     /// \param bits the number of bits to write
     /// \param offset the offset of the first bit
     Bitstream& write(const void* data, int bits, int offset = 0);
     
-    /// Reads a set of bits from the underlying stream.
+    /// Reads a set of bits from the underlying stream.  Only the bytes needed to satisfy the request are consumed from the
+    /// underlying stream, so callers may continue to interleave direct reads on byte boundaries.
     /// \param bits the number of bits to read
     /// \param offset the offset of the first bit
     Bitstream& read(void* data, int bits, int offset = 0);    
@@ -248,6 +265,14 @@ public:
     /// Flushes any unwritten bits to the underlying stream.
     void flush();
 
+    /// Starts recording writes into the supplied object.  While recording, repeated values are noted in the recording
+    /// rather than written.  The stream should be newly created over an empty buffer.
+    void startRecording(BitstreamRecording& recording);
+    
+    /// Stops recording, flushing the stream and storing the contents of its buffer in the recording.
+    /// \param data the buffer underlying the stream
+    void stopRecording(const QByteArray& data);
+
     /// Resets to the initial state.
     void reset();
 
@@ -380,6 +405,9 @@ public:
     Bitstream& operator<(const SharedObjectPointer& object);
     Bitstream& operator>(SharedObjectPointer& object);
 
+    /// Replays a recorded sequence of writes, using our own mappings for the recorded references.
+    Bitstream& operator<<(const BitstreamRecording& recording);
+
 signals:
 
     void sharedObjectCleared(int id);
@@ -390,11 +418,31 @@ private slots:
 
 private:
     
+    template<class K, class P, class V> friend class RepeatedValueStreamer;
+    
+    void recordReference(const QMetaObject* metaObject);
+    void recordReference(const TypeStreamer* streamer);
+    void recordReference(const AttributePointer& attribute);
+    void recordReference(const QScriptString& string);
+    void recordReference(const SharedObjectPointer& object);
+    BitstreamRecording::Reference& appendReference(BitstreamRecording::ReferenceType type);
+    
+    /// Appends up to 64 bits (masked to the given width) to the write accumulator.
+    void writeBits(quint64 value, int bits);
+    
+    /// Writes the whole bytes currently in the accumulator to the underlying stream.
+    void writeAccumulatedBytes();
+    
+    /// Reads up to 32 bits from the read accumulator, refilling it from the underlying stream as necessary.
+    quint64 readBits(int bits);
+    
     QDataStream& _underlying;
-    quint8 _byte;
+    quint64 _word;
     int _position;
 
     MetadataType _metadataType;
+    
+    BitstreamRecording* _recording;
 
     RepeatedValueStreamer<const QMetaObject*, const QMetaObject*, ObjectReader> _metaObjectStreamer;
     RepeatedValueStreamer<const TypeStreamer*, const TypeStreamer*, TypeReader> _typeStreamerStreamer;
@@ -415,6 +463,29 @@ private:
     static QVector<PropertyReader> getPropertyReaders(const QMetaObject* metaObject);
 };
 
+template<class K, class P, class V> inline RepeatedValueStreamer<K, P, V>&
+        RepeatedValueStreamer<K, P, V>::operator<<(K value) {
+    if (_stream._recording) {
+        // the id depends on our mappings, so the recording notes the value itself and the id is written on replay
+        _stream.recordReference(value);
+        return *this;
+    }
+    int id = _persistentIDs.value(value);
+    if (id == 0) {
+        int& offset = _transientOffsets[value];
+        if (offset == 0) {
+            _idStreamer << (_lastPersistentID + (offset = ++_lastTransientOffset));
+            _stream < value;
+            
+        } else {
+            _idStreamer << (_lastPersistentID + offset);
+        }
+    } else {
+        _idStreamer << id;
+    }
+    return *this;
+}
+
 template<class T> inline void Bitstream::writeDelta(const T& value, const T& reference) {
     if (value == reference) {
         *this << false;
@@ -10,7 +10,12 @@
 //
 
 #include <QDateTime>
+#include <QMutexLocker>
+#include <QRunnable>
 #include <QScriptEngine>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QThreadStorage>
 #include <QtDebug>
 
 #include <GeometryUtil.h>
@@ -82,6 +87,108 @@ Box MetavoxelData::getBounds() const {
     return Box(glm::vec3(-halfSize, -halfSize, -halfSize), glm::vec3(halfSize, halfSize, halfSize));
 }
 
+/// Per-thread scratch storage for visitations, so that guides can reuse the same vectors rather than allocating new
+/// ones for every node visited.  Vectors are lent and reclaimed in stack order, following the recursion.
+class VisitationArena {
+public:
+    
+    VisitationArena();
+    ~VisitationArena();
+    
+    void lend(MetavoxelVisitation& visitation, int inputCount, int outputCount);
+    void reclaim(MetavoxelVisitation& visitation);
+    
+private:
+    
+    class Vectors {
+    public:
+        QVector<MetavoxelNode*> inputNodes;
+        QVector<MetavoxelNode*> outputNodes;
+        QVector<AttributeValue> inputValues;
+        QVector<OwnedAttributeValue> outputValues;
+    };
+    
+    QVector<Vectors*> _vectors;
+    int _used;
+};
+
+VisitationArena::VisitationArena() :
+    _used(0) {
+}
+
+VisitationArena::~VisitationArena() {
+    qDeleteAll(_vectors);
+}
+
+void VisitationArena::lend(MetavoxelVisitation& visitation, int inputCount, int outputCount) {
+    if (_used == _vectors.size()) {
+        _vectors.append(new Vectors());
+    }
+    Vectors* vectors = _vectors.at(_used++);
+    
+    // resizing downwards (or upwards within capacity) doesn't reallocate
+    vectors->inputNodes.resize(inputCount);
+    vectors->outputNodes.resize(outputCount);
+    vectors->inputValues.resize(inputCount);
+    vectors->outputValues.resize(outputCount);
+    
+    visitation.inputNodes.swap(vectors->inputNodes);
+    visitation.outputNodes.swap(vectors->outputNodes);
+    visitation.info.inputValues.swap(vectors->inputValues);
+    visitation.info.outputValues.swap(vectors->outputValues);
+}
+
+void VisitationArena::reclaim(MetavoxelVisitation& visitation) {
+    Vectors* vectors = _vectors.at(--_used);
+    
+    // release any output values left over from a short-circuited tour
+    for (int i = 0; i < visitation.info.outputValues.size(); i++) {
+        OwnedAttributeValue& value = visitation.info.outputValues[i];
+        if (value.getAttribute()) {
+            value = AttributeValue();
+        }
+    }
+    visitation.inputNodes.swap(vectors->inputNodes);
+    visitation.outputNodes.swap(vectors->outputNodes);
+    visitation.info.inputValues.swap(vectors->inputValues);
+    visitation.info.outputValues.swap(vectors->outputValues);
+}
+
+static QThreadStorage<VisitationArena*> visitationArenas;
+
+/// Lends a visitation vectors from the current thread's arena for as long as it remains in scope.
+class VisitationScratch {
+public:
+    
+    VisitationScratch(MetavoxelVisitation& visitation, int inputCount, int outputCount);
+    ~VisitationScratch();
+
+private:
+    
+    MetavoxelVisitation& _visitation;
+    VisitationArena* _arena;
+};
+
+VisitationScratch::VisitationScratch(MetavoxelVisitation& visitation, int inputCount, int outputCount) :
+    _visitation(visitation) {
+    
+    if (!visitationArenas.hasLocalData()) {
+        visitationArenas.setLocalData(new VisitationArena());
+    }
+    _arena = visitationArenas.localData();
+    _arena->lend(visitation, inputCount, outputCount);
+}
+
+VisitationScratch::~VisitationScratch() {
+    _arena->reclaim(_visitation);
+}
+
+/// Returns the pool used to run the subtrees of parallel tours.
+static QThreadPool* getGuidePool() {
+    static QThreadPool pool;
+    return &pool;
+}
+
 void MetavoxelData::guide(MetavoxelVisitor& visitor) {
     // let the visitor know we're about to begin a tour
     visitor.prepare();
@@ -89,9 +196,9 @@ void MetavoxelData::guide(MetavoxelVisitor& visitor) {
     // start with the root values/defaults (plus the guide attribute)
     const QVector<AttributePointer>& inputs = visitor.getInputs();
     const QVector<AttributePointer>& outputs = visitor.getOutputs();
-    MetavoxelVisitation firstVisitation = { NULL, visitor, QVector<MetavoxelNode*>(inputs.size() + 1),
-        QVector<MetavoxelNode*>(outputs.size()), { NULL, getMinimum(), _size,
-            QVector<AttributeValue>(inputs.size() + 1), QVector<OwnedAttributeValue>(outputs.size()) } };
+    MetavoxelVisitation firstVisitation = { NULL, visitor, QVector<MetavoxelNode*>(), QVector<MetavoxelNode*>(),
+        { NULL, getMinimum(), _size }, false };
+    VisitationScratch scratch(firstVisitation, inputs.size() + 1, outputs.size());
     for (int i = 0; i < inputs.size(); i++) {
         MetavoxelNode* node = _roots.value(inputs.at(i));
         firstVisitation.inputNodes[i] = node;
@@ -105,8 +212,14 @@ void MetavoxelData::guide(MetavoxelVisitor& visitor) {
         MetavoxelNode* node = _roots.value(outputs.at(i));
         firstVisitation.outputNodes[i] = node;
     }
-    static_cast<MetavoxelGuide*>(firstVisitation.info.inputValues.last().getInlineValue<
-        SharedObjectPointer>().data())->guide(firstVisitation);
+    MetavoxelGuide* guide = static_cast<MetavoxelGuide*>(firstVisitation.info.inputValues.last().getInlineValue<
+        SharedObjectPointer>().data());
+    
+    // we can only fan out if the default guide applies everywhere, since other guides may keep state
+    firstVisitation.parallel = visitor.isParallelSafe() && (!node || node->isLeaf()) &&
+        guide->metaObject() == &DefaultMetavoxelGuide::staticMetaObject && getGuidePool()->maxThreadCount() > 1;
+    guide->guide(firstVisitation);
+    
     for (int i = 0; i < outputs.size(); i++) {
         OwnedAttributeValue& value = firstVisitation.info.outputValues[i];
         if (!value.getAttribute()) {
@@ -148,6 +261,7 @@ public:
     SpannerUpdateVisitor(const AttributePointer& attribute, const Box& bounds,
         float granularity, const SharedObjectPointer& object);
     
+    virtual bool isParallelSafe() const;
     virtual int visit(MetavoxelInfo& info);
 
 private:
@@ -167,6 +281,10 @@ template<SpannerUpdateFunction F> SpannerUpdateVisitor<F>::SpannerUpdateVisitor(
     _object(object) {
 }
 
+template<SpannerUpdateFunction F> bool SpannerUpdateVisitor<F>::isParallelSafe() const {
+    return true;
+}
+
 template<SpannerUpdateFunction F> int SpannerUpdateVisitor<F>::visit(MetavoxelInfo& info) {
     if (!info.getBounds().intersects(_bounds)) {
         return STOP_RECURSION;
@@ -229,6 +347,7 @@ public:
     SpannerReplaceVisitor(const AttributePointer& attribute, const Box& bounds,
         float granularity, const SharedObjectPointer& oldObject, const SharedObjectPointer& newObject);
     
+    virtual bool isParallelSafe() const;
     virtual int visit(MetavoxelInfo& info);
 
 private:
@@ -250,6 +369,10 @@ SpannerReplaceVisitor::SpannerReplaceVisitor(const AttributePointer& attribute,
     _newObject(newObject) {
 }
 
+bool SpannerReplaceVisitor::isParallelSafe() const {
+    return true;
+}
+
 int SpannerReplaceVisitor::visit(MetavoxelInfo& info) {
     if (!info.getBounds().intersects(_bounds)) {
         return STOP_RECURSION;
@@ -294,10 +417,12 @@ public:
     Spanner* getSpanner() const { return _spanner; }
     float getDistance() const { return _distance; }
     
+    virtual bool isParallelSafe() const;
     virtual bool visitSpanner(Spanner* spanner, float distance);
 
 private:
     
+    QMutex _mutex;
     Spanner* _spanner;
     float _distance;
 };
@@ -309,9 +434,17 @@ FirstRaySpannerIntersectionVisitor::FirstRaySpannerIntersectionVisitor(
     _spanner(NULL) {
 }
 
+bool FirstRaySpannerIntersectionVisitor::isParallelSafe() const {
+    return true;
+}
+
 bool FirstRaySpannerIntersectionVisitor::visitSpanner(Spanner* spanner, float distance) {
-    _spanner = spanner;
-    _distance = distance;
+    // subtrees visited in parallel may each find a candidate; keep the closest
+    QMutexLocker locker(&_mutex);
+    if (!_spanner || distance < _distance) {
+        _spanner = spanner;
+        _distance = distance;
+    }
     return false;
 }
 
@@ -350,11 +483,11 @@ static void setNode(const AttributeValue& value, MetavoxelNode*& node, Metavoxel
     }
     if (node) {
         MetavoxelNode* oldNode = node;
-        node = new MetavoxelNode(value.getAttribute(), oldNode);
+        node = new (value.getAttribute()) MetavoxelNode(value.getAttribute(), oldNode);
         oldNode->decrementReferenceCount(value.getAttribute());
         
     } else {
-        node = new MetavoxelNode(value);
+        node = new (value.getAttribute()) MetavoxelNode(value);
     }
     OwnedAttributeValue oldValue = node->getAttributeValue(value.getAttribute());
     node->blendAttributeValues(other->getAttributeValue(value.getAttribute()), oldValue);
@@ -376,11 +509,11 @@ static void setNode(const AttributeValue& value, MetavoxelNode*& node, const glm
     }
     if (node) {
         MetavoxelNode* oldNode = node;
-        node = new MetavoxelNode(value.getAttribute(), oldNode);
+        node = new (value.getAttribute()) MetavoxelNode(value.getAttribute(), oldNode);
         oldNode->decrementReferenceCount(value.getAttribute());
         
     } else {
-        node = new MetavoxelNode(value);
+        node = new (value.getAttribute()) MetavoxelNode(value);
     }
     int index = 0;
     float otherHalfSize = otherSize * 0.5f;
@@ -396,8 +529,8 @@ static void setNode(const AttributeValue& value, MetavoxelNode*& node, const glm
     }
     if (node->isLeaf()) {
         for (int i = 1; i < MetavoxelNode::CHILD_COUNT; i++) {
-            node->setChild((index + i) % MetavoxelNode::CHILD_COUNT, new MetavoxelNode(
-                node->getAttributeValue(value.getAttribute())));
+            node->setChild((index + i) % MetavoxelNode::CHILD_COUNT, new (value.getAttribute())
+                MetavoxelNode(node->getAttributeValue(value.getAttribute())));
         }
     }
     MetavoxelNode* nextNode = node->getChild(index);
@@ -432,20 +565,21 @@ static int getOppositeIndex(int index) {
 
 void MetavoxelData::expand() {
     for (QHash<AttributePointer, MetavoxelNode*>::iterator it = _roots.begin(); it != _roots.end(); it++) {
-        MetavoxelNode* newParent = new MetavoxelNode(it.key());
+        MetavoxelNode* newParent = new (it.key()) MetavoxelNode(it.key());
         for (int i = 0; i < MetavoxelNode::CHILD_COUNT; i++) {
-            MetavoxelNode* newChild = new MetavoxelNode(it.key());
+            MetavoxelNode* newChild = new (it.key()) MetavoxelNode(it.key());
             newParent->setChild(i, newChild);
             int index = getOppositeIndex(i);
             if (it.value()->isLeaf()) {
-                newChild->setChild(index, new MetavoxelNode(it.value()->getAttributeValue(it.key())));               
+                newChild->setChild(index, new (it.key()) MetavoxelNode(
+                    it.value()->getAttributeValue(it.key())));               
             } else {
                 MetavoxelNode* grandchild = it.value()->getChild(i);
                 grandchild->incrementReferenceCount();
                 newChild->setChild(index, grandchild);
             }
             for (int j = 1; j < MetavoxelNode::CHILD_COUNT; j++) {
-                MetavoxelNode* newGrandchild = new MetavoxelNode(it.key());
+                MetavoxelNode* newGrandchild = new (it.key()) MetavoxelNode(it.key());
                 newChild->setChild((index + j) % MetavoxelNode::CHILD_COUNT, newGrandchild);
             }
             newChild->mergeChildren(it.key());
@@ -607,7 +741,62 @@ MetavoxelNode* MetavoxelData::createRoot(const AttributePointer& attribute) {
     if (root) {
         root->decrementReferenceCount(attribute);
     }
-    return root = new MetavoxelNode(attribute);
+    return root = new (attribute) MetavoxelNode(attribute);
+}
+
+static uint getNodeHash(const AttributePointer& attribute, const MetavoxelNode* node) {
+    uint hash = attribute->hash(node->getAttributeValue());
+    for (int i = 0; i < MetavoxelNode::CHILD_COUNT; i++) {
+        hash = hash * 31 + qHash(node->getChild(i));
+    }
+    return hash;
+}
+
+static bool areNodesEquivalent(const AttributePointer& attribute, const MetavoxelNode* first,
+        const MetavoxelNode* second) {
+    for (int i = 0; i < MetavoxelNode::CHILD_COUNT; i++) {
+        if (first->getChild(i) != second->getChild(i)) {
+            return false;
+        }
+    }
+    return attribute->equal(first->getAttributeValue(), second->getAttributeValue());
+}
+
+/// Consolidates the children of the supplied node (if we're its sole owner), then returns the first node encountered
+/// that's equivalent to it.  Children are compared by pointer, so equivalent subtrees collapse from the leaves up.
+static MetavoxelNode* consolidateNode(const AttributePointer& attribute, MetavoxelNode* node,
+        QMultiHash<uint, MetavoxelNode*>& nodes) {
+    if (node->getReferenceCount() == 1) {
+        for (int i = 0; i < MetavoxelNode::CHILD_COUNT; i++) {
+            MetavoxelNode* child = node->getChild(i);
+            if (!child) {
+                continue;
+            }
+            MetavoxelNode* equivalent = consolidateNode(attribute, child, nodes);
+            if (equivalent != child) {
+                // the equivalent has the same children, so releasing this one won't release anything in the table
+                equivalent->incrementReferenceCount();
+                child->decrementReferenceCount(attribute);
+                node->setChild(i, equivalent);
+            }
+        }
+    }
+    uint hash = getNodeHash(attribute, node);
+    for (QMultiHash<uint, MetavoxelNode*>::const_iterator it = nodes.constFind(hash);
+            it != nodes.constEnd() && it.key() == hash; it++) {
+        if (areNodesEquivalent(attribute, node, it.value())) {
+            return it.value();
+        }
+    }
+    nodes.insert(hash, node);
+    return node;
+}
+
+void MetavoxelData::consolidate() {
+    for (QHash<AttributePointer, MetavoxelNode*>::const_iterator it = _roots.constBegin(); it != _roots.constEnd(); it++) {
+        QMultiHash<uint, MetavoxelNode*> nodes;
+        consolidateNode(it.key(), it.value(), nodes);
+    }
 }
 
 bool MetavoxelData::operator==(const MetavoxelData& other) const {
@@ -664,6 +853,14 @@ void MetavoxelStreamState::setMinimum(const glm::vec3& lastMinimum, int index) {
     minimum = getNextMinimum(lastMinimum, size, index);
 }
 
+void* MetavoxelNode::operator new(size_t size, const AttributePointer& attribute) {
+    return attribute->getNodePool().allocate(size);
+}
+
+void MetavoxelNode::operator delete(void* block, const AttributePointer& attribute) {
+    attribute->getNodePool().release(block);
+}
+
 MetavoxelNode::MetavoxelNode(const AttributeValue& attributeValue, const MetavoxelNode* copyChildren) :
         _referenceCount(1) {
 
@@ -745,7 +942,7 @@ void MetavoxelNode::read(MetavoxelStreamState& state) {
             state.stream, state.lod, state.referenceLOD };
         for (int i = 0; i < CHILD_COUNT; i++) {
             nextState.setMinimum(state.minimum, i);
-            _children[i] = new MetavoxelNode(state.attribute);
+            _children[i] = new (state.attribute) MetavoxelNode(state.attribute);
             _children[i]->read(nextState);
         }
         mergeChildren(state.attribute, true);
@@ -786,7 +983,7 @@ void MetavoxelNode::readDelta(const MetavoxelNode& reference, MetavoxelStreamSta
         if (reference.isLeaf() || !state.shouldSubdivideReference()) {
             for (int i = 0; i < CHILD_COUNT; i++) {
                 nextState.setMinimum(state.minimum, i);
-                _children[i] = new MetavoxelNode(state.attribute);
+                _children[i] = new (state.attribute) MetavoxelNode(state.attribute);
                 _children[i]->read(nextState);
             }
         } else {
@@ -795,7 +992,7 @@ void MetavoxelNode::readDelta(const MetavoxelNode& reference, MetavoxelStreamSta
                 bool changed;
                 state.stream >> changed;
                 if (changed) {    
-                    _children[i] = new MetavoxelNode(state.attribute);
+                    _children[i] = new (state.attribute) MetavoxelNode(state.attribute);
                     _children[i]->readDelta(*reference._children[i], nextState);
                 } else {
                     _children[i] = reference._children[i];
@@ -861,7 +1058,7 @@ void MetavoxelNode::readSubdivision(MetavoxelStreamState& state) {
             clearChildren(state.attribute);
             for (int i = 0; i < CHILD_COUNT; i++) {
                 nextState.setMinimum(state.minimum, i);
-                _children[i] = new MetavoxelNode(state.attribute);
+                _children[i] = new (state.attribute) MetavoxelNode(state.attribute);
                 _children[i]->read(nextState);
             }
         } else {
@@ -982,9 +1179,10 @@ void MetavoxelNode::writeSpannerSubdivision(MetavoxelStreamState& state) const {
 }
 
 void MetavoxelNode::decrementReferenceCount(const AttributePointer& attribute) {
-    if (--_referenceCount == 0) {
+    if (!_referenceCount.deref()) {
         destroy(attribute);
-        delete this;
+        this->~MetavoxelNode();
+        attribute->getNodePool().release(this);
     }
 }
 
@@ -1057,6 +1255,10 @@ MetavoxelVisitor::MetavoxelVisitor(const QVector<AttributePointer>& inputs,
 MetavoxelVisitor::~MetavoxelVisitor() {
 }
 
+bool MetavoxelVisitor::isParallelSafe() const {
+    return false;
+}
+
 void MetavoxelVisitor::prepare() {
     // nothing by default
 }
@@ -1192,6 +1394,126 @@ int RaySpannerIntersectionVisitor::visit(MetavoxelInfo& info, float distance) {
     return STOP_RECURSION;
 }
 
+/// Sets up the visitation of the child at the specified index.
+static void prepareChildVisitation(MetavoxelVisitation& visitation, MetavoxelVisitation& nextVisitation,
+        int index, float lodBase) {
+    for (int j = 0; j < visitation.inputNodes.size(); j++) {
+        MetavoxelNode* node = visitation.inputNodes.at(j);
+        const AttributeValue& parentValue = visitation.info.inputValues.at(j);
+        MetavoxelNode* child = (node && (visitation.info.size >= lodBase *
+            parentValue.getAttribute()->getLODThresholdMultiplier())) ? node->getChild(index) : NULL;
+        nextVisitation.info.inputValues[j] = ((nextVisitation.inputNodes[j] = child)) ?
+            child->getAttributeValue(parentValue.getAttribute()) : parentValue.getAttribute()->inherit(parentValue);
+    }
+    for (int j = 0; j < visitation.outputNodes.size(); j++) {
+        MetavoxelNode* node = visitation.outputNodes.at(j);
+        MetavoxelNode* child = (node && (visitation.info.size >= lodBase *
+            visitation.visitor.getOutputs().at(j)->getLODThresholdMultiplier())) ? node->getChild(index) : NULL;
+        nextVisitation.outputNodes[j] = child;
+    }
+    nextVisitation.info.minimum = getNextMinimum(visitation.info.minimum, nextVisitation.info.size, index);
+}
+
+static bool guideChildVisitation(MetavoxelVisitation& nextVisitation) {
+    return static_cast<MetavoxelGuide*>(nextVisitation.info.inputValues.last().getInlineValue<
+        SharedObjectPointer>().data())->guide(nextVisitation);
+}
+
+/// Replaces the child at the specified index with the outputs of its visitation.
+static void mergeChildVisitation(MetavoxelVisitation& visitation, MetavoxelVisitation& nextVisitation, int index) {
+    for (int j = 0; j < nextVisitation.outputNodes.size(); j++) {
+        OwnedAttributeValue& value = nextVisitation.info.outputValues[j];
+        if (!value.getAttribute()) {
+            continue;
+        }
+        // replace the child
+        OwnedAttributeValue& parentValue = visitation.info.outputValues[j];
+        if (!parentValue.getAttribute()) {
+            // shallow-copy the parent node on first change
+            parentValue = value;
+            MetavoxelNode*& node = visitation.outputNodes[j];
+            if (node) {
+                node = new (value.getAttribute()) MetavoxelNode(value.getAttribute(), node);
+            } else {
+                // create leaf with inherited value
+                node = new (value.getAttribute()) MetavoxelNode(value.getAttribute()->inherit(
+                    visitation.getInheritedOutputValue(j)));
+            }
+        }
+        MetavoxelNode* node = visitation.outputNodes.at(j);
+        MetavoxelNode* child = node->getChild(index);
+        if (child) {
+            child->decrementReferenceCount(value.getAttribute());
+        } else {
+            // it's a leaf; we need to split it up
+            AttributeValue nodeValue = value.getAttribute()->inherit(node->getAttributeValue(value.getAttribute()));
+            for (int k = 1; k < MetavoxelNode::CHILD_COUNT; k++) {
+                node->setChild((index + k) % MetavoxelNode::CHILD_COUNT,
+                    new (value.getAttribute()) MetavoxelNode(nodeValue));
+            }
+        }
+        node->setChild(index, nextVisitation.outputNodes.at(j));
+        value = AttributeValue();
+    }
+}
+
+/// Releases the output nodes that the visitation of a child created, for when they won't be merged.
+static void releaseChildVisitation(MetavoxelVisitation& nextVisitation) {
+    for (int j = 0; j < nextVisitation.outputNodes.size(); j++) {
+        OwnedAttributeValue& value = nextVisitation.info.outputValues[j];
+        if (!value.getAttribute()) {
+            continue; // the node (if any) is still the original child, which we don't own
+        }
+        MetavoxelNode* node = nextVisitation.outputNodes.at(j);
+        if (node) {
+            node->decrementReferenceCount(value.getAttribute());
+        }
+        value = AttributeValue();
+    }
+}
+
+/// Guides the visitation of a single child on the guide pool.
+class ChildGuideTask : public QRunnable {
+public:
+    
+    ChildGuideTask(MetavoxelVisitation& visitation, int index, QSemaphore& semaphore);
+    
+    int getIndex() const { return _index; }
+    MetavoxelVisitation& getVisitation() { return _visitation; }
+    bool getResult() const { return _result; }
+    
+    virtual void run();
+
+private:
+    
+    int _index;
+    MetavoxelVisitation _visitation;
+    QSemaphore& _semaphore;
+    bool _result;
+};
+
+static MetavoxelVisitation createChildVisitation(MetavoxelVisitation& visitation) {
+    MetavoxelVisitation nextVisitation = { &visitation, visitation.visitor,
+        QVector<MetavoxelNode*>(visitation.inputNodes.size()), QVector<MetavoxelNode*>(visitation.outputNodes.size()),
+        { &visitation.info, glm::vec3(), visitation.info.size * 0.5f, QVector<AttributeValue>(visitation.inputNodes.size()),
+            QVector<OwnedAttributeValue>(visitation.outputNodes.size()) }, false };
+    return nextVisitation;
+}
+
+ChildGuideTask::ChildGuideTask(MetavoxelVisitation& visitation, int index, QSemaphore& semaphore) :
+    _index(index),
+    _visitation(createChildVisitation(visitation)),
+    _semaphore(semaphore),
+    _result(true) {
+    
+    setAutoDelete(false);
+}
+
+void ChildGuideTask::run() {
+    _result = guideChildVisitation(_visitation);
+    _semaphore.release();
+}
+
 DefaultMetavoxelGuide::DefaultMetavoxelGuide() {
 }
 
@@ -1221,66 +1543,57 @@ bool DefaultMetavoxelGuide::guide(MetavoxelVisitation& visitation) {
     if (encodedOrder == MetavoxelVisitor::STOP_RECURSION) {
         return true;
     }
-    MetavoxelVisitation nextVisitation = { &visitation, visitation.visitor,
-        QVector<MetavoxelNode*>(visitation.inputNodes.size()), QVector<MetavoxelNode*>(visitation.outputNodes.size()),
-        { &visitation.info, glm::vec3(), visitation.info.size * 0.5f, QVector<AttributeValue>(visitation.inputNodes.size()),
-            QVector<OwnedAttributeValue>(visitation.outputNodes.size()) } };
-    for (int i = 0; i < MetavoxelNode::CHILD_COUNT; i++) {
-        // the encoded order tells us the child indices for each iteration
-        const int ORDER_ELEMENT_BITS = 3;
-        const int ORDER_ELEMENT_MASK = (1 << ORDER_ELEMENT_BITS) - 1;
-        int index = encodedOrder & ORDER_ELEMENT_MASK;
-        encodedOrder >>= ORDER_ELEMENT_BITS;
-        for (int j = 0; j < visitation.inputNodes.size(); j++) {
-            MetavoxelNode* node = visitation.inputNodes.at(j);
-            const AttributeValue& parentValue = visitation.info.inputValues.at(j);
-            MetavoxelNode* child = (node && (visitation.info.size >= lodBase *
-                parentValue.getAttribute()->getLODThresholdMultiplier())) ? node->getChild(index) : NULL;
-            nextVisitation.info.inputValues[j] = ((nextVisitation.inputNodes[j] = child)) ?
-                child->getAttributeValue(parentValue.getAttribute()) : parentValue.getAttribute()->inherit(parentValue);
-        }
-        for (int j = 0; j < visitation.outputNodes.size(); j++) {
-            MetavoxelNode* node = visitation.outputNodes.at(j);
-            MetavoxelNode* child = (node && (visitation.info.size >= lodBase *
-                visitation.visitor.getOutputs().at(j)->getLODThresholdMultiplier())) ? node->getChild(index) : NULL;
-            nextVisitation.outputNodes[j] = child;
-        }
-        nextVisitation.info.minimum = getNextMinimum(visitation.info.minimum, nextVisitation.info.size, index);
-        if (!static_cast<MetavoxelGuide*>(nextVisitation.info.inputValues.last().getInlineValue<
-                SharedObjectPointer>().data())->guide(nextVisitation)) {
-            return false;
-        }
-        for (int j = 0; j < nextVisitation.outputNodes.size(); j++) {
-            OwnedAttributeValue& value = nextVisitation.info.outputValues[j];
-            if (!value.getAttribute()) {
-                continue;
-            }
-            // replace the child
-            OwnedAttributeValue& parentValue = visitation.info.outputValues[j];
-            if (!parentValue.getAttribute()) {
-                // shallow-copy the parent node on first change
-                parentValue = value;
-                MetavoxelNode*& node = visitation.outputNodes[j];
-                if (node) {
-                    node = new MetavoxelNode(value.getAttribute(), node);
-                } else {
-                    // create leaf with inherited value
-                    node = new MetavoxelNode(value.getAttribute()->inherit(visitation.getInheritedOutputValue(j)));
-                }
+    const int ORDER_ELEMENT_BITS = 3;
+    const int ORDER_ELEMENT_MASK = (1 << ORDER_ELEMENT_BITS) - 1;
+    if (visitation.parallel) {
+        // set up and start all of the children, then merge their outputs in order once they've all finished
+        QSemaphore semaphore;
+        QVector<ChildGuideTask*> tasks;
+        QVector<ChildGuideTask*> unstartedTasks;
+        for (int i = 0; i < MetavoxelNode::CHILD_COUNT; i++) {
+            int index = encodedOrder & ORDER_ELEMENT_MASK;
+            encodedOrder >>= ORDER_ELEMENT_BITS;
+            ChildGuideTask* task = new ChildGuideTask(visitation, index, semaphore);
+            prepareChildVisitation(visitation, task->getVisitation(), index, lodBase);
+            tasks.append(task);
+            if (!getGuidePool()->tryStart(task)) {
+                unstartedTasks.append(task);
             }
-            MetavoxelNode* node = visitation.outputNodes.at(j);
-            MetavoxelNode* child = node->getChild(i);
-            if (child) {
-                child->decrementReferenceCount(value.getAttribute());
+        }
+        // if the pool is busy (for instance, if we're already on one of its threads), do the rest ourselves
+        foreach (ChildGuideTask* task, unstartedTasks) {
+            task->run();
+        }
+        semaphore.acquire(MetavoxelNode::CHILD_COUNT);
+        
+        // merge the children up to the first that short-circuited, as the sequential tour would have, and release the
+        // outputs of that child and those after it
+        bool result = true;
+        foreach (ChildGuideTask* task, tasks) {
+            if (result && task->getResult()) {
+                mergeChildVisitation(visitation, task->getVisitation(), task->getIndex());
             } else {
-                // it's a leaf; we need to split it up
-                AttributeValue nodeValue = value.getAttribute()->inherit(node->getAttributeValue(value.getAttribute()));
-                for (int k = 1; k < MetavoxelNode::CHILD_COUNT; k++) {
-                    node->setChild((index + k) % MetavoxelNode::CHILD_COUNT, new MetavoxelNode(nodeValue));
-                }
+                result = false;
+                releaseChildVisitation(task->getVisitation());
             }
-            node->setChild(index, nextVisitation.outputNodes.at(j));
-            value = AttributeValue();
+        }
+        qDeleteAll(tasks);
+        if (!result) {
+            return false;
+        }
+    } else {
+        MetavoxelVisitation nextVisitation = { &visitation, visitation.visitor, QVector<MetavoxelNode*>(),
+            QVector<MetavoxelNode*>(), { &visitation.info, glm::vec3(), visitation.info.size * 0.5f }, false };
+        VisitationScratch scratch(nextVisitation, visitation.inputNodes.size(), visitation.outputNodes.size());
+        for (int i = 0; i < MetavoxelNode::CHILD_COUNT; i++) {
+            // the encoded order tells us the child indices for each iteration
+            int index = encodedOrder & ORDER_ELEMENT_MASK;
+            encodedOrder >>= ORDER_ELEMENT_BITS;
+            prepareChildVisitation(visitation, nextVisitation, index, lodBase);
+            if (!guideChildVisitation(nextVisitation)) {
+                return false;
+            }
+            mergeChildVisitation(visitation, nextVisitation, index);
         }
     }
     for (int i = 0; i < visitation.outputNodes.size(); i++) {
@@ -1486,11 +1799,8 @@ bool Spanner::blendAttributeValues(MetavoxelInfo& info, bool force) const {
 }
 
 bool Spanner::testAndSetVisited() {
-    if (_lastVisit == _visit) {
-        return false;
-    }
-    _lastVisit = _visit;
-    return true;
+    int lastVisit = _lastVisit.load();
+    return lastVisit != _visit && _lastVisit.testAndSetOrdered(lastVisit, _visit);
 }
 
 SpannerRenderer* Spanner::getRenderer() {
@@ -12,6 +12,7 @@
 #ifndef hifi_MetavoxelData_h
 #define hifi_MetavoxelData_h
 
+#include <QAtomicInt>
 #include <QBitArray>
 #include <QHash>
 #include <QSharedData>
@@ -108,6 +109,11 @@ public:
         Bitstream& out, const MetavoxelLOD& lod) const;
 
     MetavoxelNode* getRoot(const AttributePointer& attribute) const { return _roots.value(attribute); }
+    
+    /// Replaces identical subtrees with references to a single copy ("hash-consing"), so that uniform regions and
+    /// repeated values are stored once and compare equal by pointer.  Only subtrees not shared with other data are
+    /// rewritten.
+    void consolidate();
     MetavoxelNode* createRoot(const AttributePointer& attribute);
 
     bool operator==(const MetavoxelData& other) const;
@@ -157,6 +163,13 @@ public:
 
     static const int CHILD_COUNT = 8;
 
+    /// Allocates the node from the attribute's pool.  Nodes must be created with this form, e.g.,
+    /// new (attribute) MetavoxelNode(attribute), and released through decrementReferenceCount.
+    static void* operator new(size_t size, const AttributePointer& attribute);
+    
+    /// Returns the node to the attribute's pool if its constructor throws.
+    static void operator delete(void* block, const AttributePointer& attribute);
+
     MetavoxelNode(const AttributeValue& attributeValue, const MetavoxelNode* copyChildren = NULL);
     MetavoxelNode(const AttributePointer& attribute, const MetavoxelNode* copy);
     
@@ -188,7 +201,7 @@ public:
     void writeSpannerSubdivision(MetavoxelStreamState& state) const;
 
     /// Increments the node's reference count.
-    void incrementReferenceCount() { _referenceCount++; }
+    void incrementReferenceCount() { _referenceCount.ref(); }
 
     /// Decrements the node's reference count.  If the resulting reference count is zero, destroys the node
     /// and calls delete this.
@@ -198,12 +211,15 @@ public:
 
     void clearChildren(const AttributePointer& attribute);
     
+    /// Returns the node's reference count.
+    int getReferenceCount() const { return _referenceCount.load(); }
+    
 private:
     Q_DISABLE_COPY(MetavoxelNode)
     
     friend class MetavoxelVisitation;
     
-    int _referenceCount;
+    QAtomicInt _referenceCount;
     void* _attributeValue;
     MetavoxelNode* _children[CHILD_COUNT];
 };
@@ -261,6 +277,12 @@ public:
     
     float getMinimumLODThresholdMultiplier() const { return _minimumLODThresholdMultiplier; }
     
+    /// Checks whether this visitor may be guided through separate subtrees concurrently.  Parallel-safe visitors must
+    /// synchronize any state they modify in visit().  In a parallel tour, a short circuit stops the traversal of the
+    /// subtree in which it occurs immediately, and that of its siblings once they complete; the outputs of the siblings
+    /// before it are kept, as in a sequential tour, and those of the siblings after it are discarded.
+    virtual bool isParallelSafe() const;
+    
     /// Prepares for a new tour of the metavoxel data.
     virtual void prepare();
     
@@ -433,6 +455,7 @@ public:
     QVector<MetavoxelNode*> inputNodes;
     QVector<MetavoxelNode*> outputNodes;
     MetavoxelInfo info;
+    bool parallel; ///< if true, the children of this visitation may be guided concurrently
     
     bool allInputNodesLeaves() const;
     AttributeValue getInheritedOutputValue(int index) const;
@@ -482,6 +505,7 @@ public:
     
     /// Checks whether we've visited this object on the current traversal.  If we have, returns false.
     /// If we haven't, sets the last visit identifier and returns true.
+    /// Safe to call from concurrent visits.
     bool testAndSetVisited();
 
     /// Returns a pointer to the renderer, creating it if necessary.
@@ -510,7 +534,7 @@ private:
     float _placementGranularity;
     float _voxelizationGranularity;
     bool _masked;
-    int _lastVisit; ///< the identifier of the last visit
+    QAtomicInt _lastVisit; ///< the identifier of the last visit
     
     static int _visit; ///< the global visit counter
 };
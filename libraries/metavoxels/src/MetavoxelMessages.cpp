@@ -27,6 +27,7 @@ public:
     
     BoxSetEditVisitor(const BoxSetEdit& edit);
     
+    virtual bool isParallelSafe() const;
     virtual int visit(MetavoxelInfo& info);
 
 private:
@@ -40,6 +41,10 @@ BoxSetEditVisitor::BoxSetEditVisitor(const BoxSetEdit& edit) :
     _edit(edit) {
 }
 
+bool BoxSetEditVisitor::isParallelSafe() const {
+    return true;
+}
+
 int BoxSetEditVisitor::visit(MetavoxelInfo& info) {
     // find the intersection between volume and voxel
     glm::vec3 minimum = glm::max(info.minimum, _edit.region.minimum);
@@ -124,6 +129,7 @@ public:
     
     GlobalSetEditVisitor(const GlobalSetEdit& edit);
     
+    virtual bool isParallelSafe() const;
     virtual int visit(MetavoxelInfo& info);
 
 private:
@@ -136,6 +142,10 @@ GlobalSetEditVisitor::GlobalSetEditVisitor(const GlobalSetEdit& edit) :
     _edit(edit) {
 }
 
+bool GlobalSetEditVisitor::isParallelSafe() const {
+    return true;
+}
+
 int GlobalSetEditVisitor::visit(MetavoxelInfo& info) {
     info.outputValues[0] = _edit.value;
     return STOP_RECURSION; // entirely contained
@@ -156,6 +166,7 @@ public:
     
     UpdateSpannerVisitor(const QVector<AttributePointer>& attributes, Spanner* spanner);
     
+    virtual bool isParallelSafe() const;
     virtual int visit(MetavoxelInfo& info);
 
 private:
@@ -175,6 +186,10 @@ UpdateSpannerVisitor::UpdateSpannerVisitor(const QVector<AttributePointer>& attr
         logf(2.0f) - 2.0f)) {
 }
 
+bool UpdateSpannerVisitor::isParallelSafe() const {
+    return true;
+}
+
 int UpdateSpannerVisitor::visit(MetavoxelInfo& info) {
     if (!info.getBounds().intersects(_spanner->getBounds())) {
         return STOP_RECURSION;
@@ -272,6 +287,7 @@ public:
     
     SetSpannerEditVisitor(const QVector<AttributePointer>& attributes, Spanner* spanner);
     
+    virtual bool isParallelSafe() const;
     virtual int visit(MetavoxelInfo& info);
 
 private:
@@ -285,6 +301,10 @@ SetSpannerEditVisitor::SetSpannerEditVisitor(const QVector<AttributePointer>& at
     _spanner(spanner) {
 }
 
+bool SetSpannerEditVisitor::isParallelSafe() const {
+    return true;
+}
+
 int SetSpannerEditVisitor::visit(MetavoxelInfo& info) {
     if (_spanner->blendAttributeValues(info)) {
         return DEFAULT_ORDER;
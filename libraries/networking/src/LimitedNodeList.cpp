@@ -16,14 +16,17 @@
 #include <QtCore/QDataStream>
 #include <QtCore/QDebug>
 #include <QtCore/QJsonDocument>
+#include <QtCore/QThreadStorage>
 #include <QtCore/QUrl>
 #include <QtNetwork/QHostInfo>
+#include <QtNetwork/QNetworkInterface>
 
 #include "AccountManager.h"
 #include "Assignment.h"
 #include "HifiSockAddr.h"
 #include "Logging.h"
 #include "LimitedNodeList.h"
+#include "PacketBuffer.h"
 #include "PacketHeaders.h"
 #include "SharedUtil.h"
 #include "UUID.h"
@@ -52,7 +55,30 @@ LimitedNodeList* LimitedNodeList::createInstance(unsigned short socketListenPort
     return _sharedInstance;
 }
 
+/// Holds the instance bound to a thread by value, so that the thread storage doesn't try to delete it.
+class ThreadInstanceBinding {
+public:
+    ThreadInstanceBinding() : instance(NULL) { }
+    
+    LimitedNodeList* instance;
+};
+
+static QThreadStorage<ThreadInstanceBinding> threadInstanceBindings;
+
+void LimitedNodeList::setThreadInstance(LimitedNodeList* threadInstance) {
+    threadInstanceBindings.localData().instance = threadInstance;
+}
+
+LimitedNodeList* LimitedNodeList::getThreadInstance() {
+    return threadInstanceBindings.hasLocalData() ? threadInstanceBindings.localData().instance : NULL;
+}
+
 LimitedNodeList* LimitedNodeList::getInstance() {
+    LimitedNodeList* threadInstance = getThreadInstance();
+    if (threadInstance) {
+        return threadInstance;
+    }
+    
     if (!_sharedInstance) {
         qDebug("LimitedNodeList getInstance called before call to createInstance. Returning NULL pointer.");
     }
@@ -69,7 +95,10 @@ LimitedNodeList::LimitedNodeList(unsigned short socketListenPort, unsigned short
     _dtlsSocket(NULL),
     _numCollectedPackets(0),
     _numCollectedBytes(0),
-    _packetStatTimer()
+    _packetStatTimer(),
+    _trafficStats(),
+    _localRing(NULL),
+    _localRingWatcher(NULL)
 {
     _nodeSocket.bind(QHostAddress::AnyIPv4, socketListenPort);
     qDebug() << "NodeList socket is listening on" << _nodeSocket.localPort();
@@ -88,6 +117,10 @@ LimitedNodeList::LimitedNodeList(unsigned short socketListenPort, unsigned short
     _packetStatTimer.start();
 }
 
+LimitedNodeList::~LimitedNodeList() {
+    setLocalTransportEnabled(false);
+}
+
 void LimitedNodeList::setSessionUUID(const QUuid& sessionUUID) {
     QUuid oldUUID = _sessionUUID;
     _sessionUUID = sessionUUID;
@@ -133,6 +166,9 @@ void LimitedNodeList::changeSendSocketBufferSize(int numSendBytes) {
 }
 
 bool LimitedNodeList::packetVersionAndHashMatch(const QByteArray& packet) {
+    // every packet we process passes through here, so this is where we count what we receive
+    _trafficStats.recordReceived(packet);
+    
     PacketType checkType = packetTypeForPacket(packet);
     if (packet[1] != versionForPacketType(checkType)
         && checkType != PacketTypeStunResponse) {
@@ -154,11 +190,18 @@ bool LimitedNodeList::packetVersionAndHashMatch(const QByteArray& packet) {
     }
     
     if (!NON_VERIFIED_PACKETS.contains(checkType)) {
+        // read the sender and hash in place, since this runs for every packet we receive
+        PacketView packetView(packet);
+        if (!packetView.isValid()) {
+            qDebug() << "Packet of type" << checkType << "is shorter than its header";
+            return false;
+        }
+        
         // figure out which node this is from
-        SharedNodePointer sendingNode = sendingNodeForPacket(packet);
+        SharedNodePointer sendingNode = nodeWithUUID(packetView.getSenderUUID());
         if (sendingNode) {
             // check if the md5 hash in the header matches the hash we would expect
-            if (hashFromPacketHeader(packet) == hashForPacketAndConnectionUUID(packet, sendingNode->getConnectionSecret())) {
+            if (packetView.hashMatches(sendingNode->getConnectionSecret())) {
                 return true;
             } else {
                 qDebug() << "Packet hash mismatch on" << checkType << "- Sender"
@@ -177,18 +220,46 @@ bool LimitedNodeList::packetVersionAndHashMatch(const QByteArray& packet) {
 
 qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr,
                                       const QUuid& connectionSecret) {
-    QByteArray datagramCopy = datagram;
+    return writeDatagram(datagram.constData(), datagram.size(), destinationSockAddr, connectionSecret);
+}
+
+qint64 LimitedNodeList::writeDatagram(const char* data, qint64 size, const HifiSockAddr& destinationSockAddr,
+                                      const QUuid& connectionSecret) {
+    const char* datagram = data;
     
     if (!connectionSecret.isNull()) {
-        // setup the MD5 hash for source verification in the header
-        replaceHashInPacketGivenConnectionUUID(datagramCopy, connectionSecret);
+        // setup the MD5 hash for source verification in the header; the caller's data is const (and may be shared),
+        // so the hashed copy goes in a buffer that this thread keeps for the purpose
+        static QThreadStorage<QByteArray> threadHashedDatagrams;
+        QByteArray& hashedDatagram = threadHashedDatagrams.localData();
+        if (hashedDatagram.capacity() < size) {
+            hashedDatagram.reserve(qMax((int)size, MAX_PACKET_SIZE));
+        }
+        hashedDatagram.resize(size);
+        memcpy(hashedDatagram.data(), data, size);
+        replaceHashInPacketGivenConnectionUUID(hashedDatagram.data(), size, connectionSecret);
+        datagram = hashedDatagram.constData();
     }
     
     // stat collection for packets
-    ++_numCollectedPackets;
-    _numCollectedBytes += datagram.size();
+    _numCollectedPackets.ref();
+    _numCollectedBytes.fetchAndAddRelaxed(size);
+    
+    if (_localRing) {
+        QSharedPointer<SharedMemoryRing> peerRing = getPeerRing(destinationSockAddr);
+        if (peerRing) {
+            // the peer would have seen the datagram come from the address it was sent to, on our port
+            HifiSockAddr senderSockAddr(destinationSockAddr.getAddress(), _nodeSocket.localPort());
+            if (peerRing->write(datagram, size, senderSockAddr)) {
+                _numLocalDatagramsSent.ref();
+                return size;
+            }
+            // full, or closed by a peer that's gone; either way, UDP it is until we try the ring again
+            dropPeerRing(destinationSockAddr.getPort());
+        }
+    }
     
-    qint64 bytesWritten = _nodeSocket.writeDatagram(datagramCopy,
+    qint64 bytesWritten = _nodeSocket.writeDatagram(datagram, size,
                                                     destinationSockAddr.getAddress(), destinationSockAddr.getPort());
     
     if (bytesWritten < 0) {
@@ -198,8 +269,83 @@ qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const HifiSock
     return bytesWritten;
 }
 
+void LimitedNodeList::setLocalTransportEnabled(bool enabled) {
+    if (enabled == isLocalTransportEnabled()) {
+        return;
+    }
+    if (enabled) {
+        SharedMemoryRing* ring = new SharedMemoryRing();
+        if (!ring->create(_nodeSocket.localPort())) {
+            delete ring;
+            return;
+        }
+        _localAddresses = QNetworkInterface::allAddresses();
+        _localRing = ring;
+        _localRingWatcher = new SharedMemoryRingWatcher(_localRing);
+        connect(_localRingWatcher, SIGNAL(datagramsAvailable()), SIGNAL(localDatagramsAvailable()));
+        _localRingWatcher->initialize(true);
+        qDebug() << "Local transport enabled on port" << _nodeSocket.localPort();
+        
+    } else {
+        _localRingWatcher->terminate();
+        delete _localRingWatcher;
+        _localRingWatcher = NULL;
+        
+        // clearing the flag first means the senders stop looking for peer rings before we let go of them
+        SharedMemoryRing* ring = _localRing;
+        _localRing = NULL;
+        delete ring;
+        
+        QMutexLocker locker(&_peerRingsMutex);
+        _peerRings.clear();
+    }
+}
+
+bool LimitedNodeList::readLocalDatagram(QByteArray& datagram, HifiSockAddr& senderSockAddr) {
+    return _localRing && _localRing->read(datagram, senderSockAddr);
+}
+
+QSharedPointer<SharedMemoryRing> LimitedNodeList::getPeerRing(const HifiSockAddr& sockAddr) {
+    const QHostAddress& address = sockAddr.getAddress();
+    if (sockAddr.getPort() == _nodeSocket.localPort() || !(address.isLoopback() || _localAddresses.contains(address))) {
+        return QSharedPointer<SharedMemoryRing>();
+    }
+    QMutexLocker locker(&_peerRingsMutex);
+    PeerRing& peer = _peerRings[sockAddr.getPort()];
+    if (!peer.ring) {
+        quint64 now = usecTimestampNow();
+        if (now - peer.lastAttachAttempt < LOCAL_TRANSPORT_ATTACH_RETRY_USECS) {
+            return peer.ring;
+        }
+        peer.lastAttachAttempt = now;
+        QSharedPointer<SharedMemoryRing> ring(new SharedMemoryRing());
+        if (ring->attach(sockAddr.getPort())) {
+            qDebug() << "Sending to" << sockAddr << "through local transport.";
+            peer.ring = ring;
+        }
+    }
+    return peer.ring;
+}
+
+void LimitedNodeList::dropPeerRing(quint16 port) {
+    QMutexLocker locker(&_peerRingsMutex);
+    PeerRing& peer = _peerRings[port];
+    peer.ring.clear();
+    peer.lastAttachAttempt = usecTimestampNow();
+}
+
 qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const SharedNodePointer& destinationNode,
                                const HifiSockAddr& overridenSockAddr) {
+    return writeDatagram(datagram.constData(), datagram.size(), destinationNode, overridenSockAddr);
+}
+
+qint64 LimitedNodeList::writeUnverifiedDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr) {
+    _trafficStats.recordSent(QUuid(), datagram.constData(), datagram.size());
+    return writeDatagram(datagram, destinationSockAddr, QUuid());
+}
+
+qint64 LimitedNodeList::writeDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
+                               const HifiSockAddr& overridenSockAddr) {
     if (destinationNode) {
         // if we don't have an ovveriden address, assume they want to send to the node's active socket
         const HifiSockAddr* destinationSockAddr = &overridenSockAddr;
@@ -213,22 +359,14 @@ qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const SharedNo
             }
         }
         
-        writeDatagram(datagram, *destinationSockAddr, destinationNode->getConnectionSecret());
+        _trafficStats.recordSent(destinationNode->getUUID(), data, size);
+        writeDatagram(data, size, *destinationSockAddr, destinationNode->getConnectionSecret());
     }
     
     // didn't have a destinationNode to send to, return 0
     return 0;
 }
 
-qint64 LimitedNodeList::writeUnverifiedDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr) {
-    return writeDatagram(datagram, destinationSockAddr, QUuid());
-}
-
-qint64 LimitedNodeList::writeDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
-                               const HifiSockAddr& overridenSockAddr) {
-    return writeDatagram(QByteArray(data, size), destinationNode, overridenSockAddr);
-}
-
 void LimitedNodeList::processNodeData(const HifiSockAddr& senderSockAddr, const QByteArray& packet) {
     // the node decided not to do anything with this packet
     // if it comes from a known source we should keep that node alive
@@ -408,13 +546,13 @@ SharedNodePointer LimitedNodeList::soloNodeOfType(char nodeType) {
 }
 
 void LimitedNodeList::getPacketStats(float& packetsPerSecond, float& bytesPerSecond) {
-    packetsPerSecond = (float) _numCollectedPackets / ((float) _packetStatTimer.elapsed() / 1000.0f);
-    bytesPerSecond = (float) _numCollectedBytes / ((float) _packetStatTimer.elapsed() / 1000.0f);
+    packetsPerSecond = (float) _numCollectedPackets.load() / ((float) _packetStatTimer.elapsed() / 1000.0f);
+    bytesPerSecond = (float) _numCollectedBytes.load() / ((float) _packetStatTimer.elapsed() / 1000.0f);
 }
 
 void LimitedNodeList::resetPacketStats() {
-    _numCollectedPackets = 0;
-    _numCollectedBytes = 0;
+    _numCollectedPackets.store(0);
+    _numCollectedBytes.store(0);
     _packetStatTimer.restart();
 }
 
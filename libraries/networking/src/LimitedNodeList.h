@@ -19,7 +19,9 @@
 #include <unistd.h> // not on windows, not needed for mac or windows
 #endif
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
 #include <QtCore/QMutex>
 #include <QtCore/QSet>
 #include <QtCore/QSettings>
@@ -31,6 +33,8 @@
 
 #include "DomainHandler.h"
 #include "Node.h"
+#include "SharedMemoryRing.h"
+#include "TrafficStats.h"
 
 const int MAX_PACKET_SIZE = 1500;
 
@@ -42,6 +46,9 @@ extern const QUrl DEFAULT_NODE_AUTH_URL;
 
 const char DEFAULT_ASSIGNMENT_SERVER_HOSTNAME[] = "localhost";
 
+/// How long we wait before trying again to attach to the ring of a peer on this host that didn't have one.
+const quint64 LOCAL_TRANSPORT_ATTACH_RETRY_USECS = 5 * 1000 * 1000;
+
 class HifiSockAddr;
 
 typedef QSet<NodeType_t> NodeSet;
@@ -55,6 +62,14 @@ class LimitedNodeList : public QObject {
 public:
     static LimitedNodeList* createInstance(unsigned short socketListenPort = 0, unsigned short dtlsPort = 0);
     static LimitedNodeList* getInstance();
+    
+    /// Binds an instance to the calling thread, so that getInstance returns it (rather than the shared instance) there.
+    /// Used by assignments hosted alongside others in one process, each of which has its own list and socket.  The
+    /// binding does not take ownership; pass NULL to remove it before the instance is deleted.
+    static void setThreadInstance(LimitedNodeList* threadInstance);
+    static LimitedNodeList* getThreadInstance();
+    
+    virtual ~LimitedNodeList();
 
     const QUuid& getSessionUUID() const { return _sessionUUID; }
     void setSessionUUID(const QUuid& sessionUUID);
@@ -94,6 +109,25 @@ public:
 
     void getPacketStats(float &packetsPerSecond, float &bytesPerSecond);
     void resetPacketStats();
+    
+    /// Returns the per-node, per-type breakdown of our traffic.
+    TrafficStats& getTrafficStats() { return _trafficStats; }
+    
+    /// Switches the local transport on or off.  While it's on, we receive from peers on this host that have it on
+    /// through a shared memory ring rather than the UDP loopback, and send to those peers through theirs.  Peers are
+    /// told apart only by their port, and anything we can't deliver through a ring goes out over UDP as before.
+    void setLocalTransportEnabled(bool enabled);
+    bool isLocalTransportEnabled() const { return _localRing != NULL; }
+    
+    /// Reads the next datagram delivered through our ring into a buffer from the PacketBufferPool.
+    /// \return false if there was none (or the local transport is off)
+    bool readLocalDatagram(QByteArray& datagram, HifiSockAddr& senderSockAddr);
+    
+    /// Returns the number of datagrams we sent through rings rather than UDP, and restarts the count.
+    int takeNumLocalDatagramsSent() { return _numLocalDatagramsSent.fetchAndStoreRelaxed(0); }
+    
+    /// Returns the number of datagrams peers dropped because our ring was full, and restarts the count.
+    int takeNumLocalDatagramsDropped() { return _localRing ? _localRing->takeDropCount() : 0; }
 public slots:
     void reset();
     void eraseAllNodes();
@@ -105,6 +139,9 @@ signals:
     void uuidChanged(const QUuid& ownerUUID);
     void nodeAdded(SharedNodePointer);
     void nodeKilled(SharedNodePointer);
+    
+    /// Emitted (from the ring's watcher thread) when datagrams arrive through our ring.
+    void localDatagramsAvailable();
 protected:
     static LimitedNodeList* _sharedInstance;
 
@@ -114,20 +151,42 @@ protected:
     
     qint64 writeDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr,
                          const QUuid& connectionSecret);
+    qint64 writeDatagram(const char* data, qint64 size, const HifiSockAddr& destinationSockAddr,
+                         const QUuid& connectionSecret);
 
     NodeHash::iterator killNodeAtHashIterator(NodeHash::iterator& nodeItemToKill);
 
     
     void changeSendSocketBufferSize(int numSendBytes);
+    
+    /// Returns the ring of the peer at the given address, if it's on this host and has the local transport on.
+    QSharedPointer<SharedMemoryRing> getPeerRing(const HifiSockAddr& sockAddr);
+    void dropPeerRing(quint16 port);
 
     QUuid _sessionUUID;
     NodeHash _nodeHash;
     QMutex _nodeHashMutex;
     QUdpSocket _nodeSocket;
     QUdpSocket* _dtlsSocket;
-    int _numCollectedPackets;
-    int _numCollectedBytes;
+    QAtomicInt _numCollectedPackets; ///< atomic, since the send path is used from several threads
+    QAtomicInt _numCollectedBytes;
     QElapsedTimer _packetStatTimer;
+    TrafficStats _trafficStats;
+    
+    class PeerRing {
+    public:
+        PeerRing() : lastAttachAttempt(0) { }
+        
+        QSharedPointer<SharedMemoryRing> ring;
+        quint64 lastAttachAttempt;
+    };
+    
+    SharedMemoryRing* _localRing;
+    SharedMemoryRingWatcher* _localRingWatcher;
+    QList<QHostAddress> _localAddresses;
+    QHash<quint16, PeerRing> _peerRings;
+    QMutex _peerRingsMutex;
+    QAtomicInt _numLocalDatagramsSent;
 };
 
 #endif // hifi_LimitedNodeList_h
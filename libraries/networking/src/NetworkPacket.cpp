@@ -40,6 +40,11 @@ NetworkPacket& NetworkPacket::operator=(NetworkPacket const& other) {
     return *this;
 }
 
+void NetworkPacket::swap(NetworkPacket& other) {
+    _destinationNode.swap(other._destinationNode);
+    _byteArray.swap(other._byteArray);
+}
+
 #ifdef HAS_MOVE_SEMANTICS
 // move, same as copy, but other packet won't be used further
 NetworkPacket::NetworkPacket(NetworkPacket && packet) {
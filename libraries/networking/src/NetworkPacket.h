@@ -26,6 +26,7 @@
 /// Storage of not-yet processed inbound, or not yet sent outbound generic UDP network packet
 class NetworkPacket {
 public:
+    NetworkPacket() { }
     NetworkPacket(const NetworkPacket& packet); // copy constructor
     NetworkPacket& operator= (const NetworkPacket& other);    // copy assignment
 
@@ -38,6 +39,11 @@ public:
 
     const SharedNodePointer& getDestinationNode() const { return _destinationNode; }
     const QByteArray& getByteArray() const { return _byteArray; }
+    QByteArray& getByteArray() { return _byteArray; }
+
+    /// Exchanges contents with another packet without touching the reference counts.  Used to move packets in and out of
+    /// queues.
+    void swap(NetworkPacket& other);
 
 private:
     void copyContents(const SharedNodePointer& destinationNode, const QByteArray& byteArray);
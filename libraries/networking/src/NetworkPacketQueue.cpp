@@ -0,0 +1,72 @@
+//
+//  NetworkPacketQueue.cpp
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "NetworkPacketQueue.h"
+
+NetworkPacketQueue::NetworkPacketQueue(int capacity) :
+    _woken(false),
+    _packets(qMax(capacity, 1)),
+    _head(0),
+    _size(0),
+    _highWaterMark(0),
+    _dropCount(0)
+{
+}
+
+bool NetworkPacketQueue::push(NetworkPacket& packet) {
+    QMutexLocker locker(&_mutex);
+    int size = _size.load();
+    if (size == _packets.size()) {
+        _dropCount.ref();
+        return false;
+    }
+    _packets[(_head + size) % _packets.size()].swap(packet);
+    _size.store(++size);
+    if (size > _highWaterMark.load()) {
+        _highWaterMark.store(size);
+    }
+    _hasPackets.wakeAll();
+    return true;
+}
+
+bool NetworkPacketQueue::pop(NetworkPacket& packet) {
+    // swap out an empty packet, so that releasing whatever the caller's packet held happens outside the lock
+    NetworkPacket emptyPacket;
+    emptyPacket.swap(packet);
+
+    QMutexLocker locker(&_mutex);
+    if (_size.load() == 0) {
+        return false;
+    }
+    _packets[_head].swap(packet);
+    _head = (_head + 1) % _packets.size();
+    _size.deref();
+    return true;
+}
+
+void NetworkPacketQueue::waitForPackets() {
+    QMutexLocker locker(&_mutex);
+    while (_size.load() == 0 && !_woken) {
+        _hasPackets.wait(&_mutex);
+    }
+    _woken = false;
+}
+
+void NetworkPacketQueue::wake() {
+    QMutexLocker locker(&_mutex);
+    _woken = true;
+    _hasPackets.wakeAll();
+}
+
+void NetworkPacketQueue::resetStats() {
+    _highWaterMark.store(_size.load());
+    _dropCount.store(0);
+}
@@ -0,0 +1,76 @@
+//
+//  NetworkPacketQueue.h
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_NetworkPacketQueue_h
+#define hifi_NetworkPacketQueue_h
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+
+#include "NetworkPacket.h"
+
+const int DEFAULT_NETWORK_PACKET_QUEUE_CAPACITY = 8192;
+
+/// A bounded ring of packets that any number of threads may add to and one thread takes from.  Packets are swapped in
+/// and out rather than copied, and the lock is only held for the swap.  When the ring is full, new packets are dropped
+/// (and counted).
+class NetworkPacketQueue {
+public:
+
+    NetworkPacketQueue(int capacity = DEFAULT_NETWORK_PACKET_QUEUE_CAPACITY);
+
+    /// Adds a packet to the end of the queue, taking its contents (the packet passed in is left empty).
+    /// \return false if the queue was full and the packet was dropped
+    /// \thread any thread
+    bool push(NetworkPacket& packet);
+
+    /// Takes the packet at the front of the queue.
+    /// \return false if the queue was empty
+    /// \thread the consuming thread
+    bool pop(NetworkPacket& packet);
+
+    /// Blocks until there are packets in the queue or wake is called.
+    /// \thread the consuming thread
+    void waitForPackets();
+
+    /// Releases the consumer from waitForPackets (or from its next call, if it isn't waiting).
+    void wake();
+
+    /// Returns the number of packets in the queue (a hint, unless called by the consumer when it's the only thread).
+    int size() const { return _size.load(); }
+
+    int getCapacity() const { return _packets.size(); }
+
+    /// Returns the largest number of packets that have been in the queue since the stats were last reset.
+    int getHighWaterMark() const { return _highWaterMark.load(); }
+
+    /// Returns the number of packets dropped because the queue was full since the stats were last reset.
+    int getDropCount() const { return _dropCount.load(); }
+
+    void resetStats();
+
+private:
+
+    QMutex _mutex;
+    QWaitCondition _hasPackets;
+    bool _woken;
+
+    QVector<NetworkPacket> _packets;
+    int _head;
+    QAtomicInt _size;
+
+    QAtomicInt _highWaterMark;
+    QAtomicInt _dropCount;
+};
+
+#endif // hifi_NetworkPacketQueue_h
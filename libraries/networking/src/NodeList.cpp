@@ -44,7 +44,25 @@ NodeList* NodeList::createInstance(char ownerType, unsigned short socketListenPo
     return _sharedInstance;
 }
 
+NodeList* NodeList::createThreadInstance(char ownerType, unsigned short socketListenPort, unsigned short dtlsPort) {
+    if (!_sharedInstance) {
+        // the node type names and meta-types are registered along with the shared instance
+        qDebug("NodeList createThreadInstance called before call to createInstance. Returning NULL pointer.");
+        return NULL;
+    }
+    
+    NodeList* threadInstance = new NodeList(ownerType, socketListenPort, dtlsPort);
+    LimitedNodeList::setThreadInstance(threadInstance);
+    
+    return threadInstance;
+}
+
 NodeList* NodeList::getInstance() {
+    LimitedNodeList* threadInstance = getThreadInstance();
+    if (threadInstance) {
+        return qobject_cast<NodeList*>(threadInstance);
+    }
+    
     if (!_sharedInstance) {
         qDebug("NodeList getInstance called before call to createInstance. Returning NULL pointer.");
     }
@@ -61,7 +79,11 @@ NodeList::NodeList(char newOwnerType, unsigned short socketListenPort, unsigned
     _assignmentServerSocket(),
     _publicSockAddr(),
     _hasCompletedInitialSTUNFailure(false),
-    _stunRequestsSinceSuccess(0)
+    _stunRequestsSinceSuccess(0),
+    _domainListVersion(0),
+    _pendingDomainListBaseVersion(0),
+    _pendingDomainListVersion(0),
+    _pendingDomainListPackets()
 {
     // clear our NodeList when the domain changes
     connect(&_domainHandler, &DomainHandler::hostnameChanged, this, &NodeList::reset);
@@ -102,6 +124,7 @@ void NodeList::timePingReply(const QByteArray& packet, const SharedNodePointer&
     
     sendingNode->setPingMs(pingTime / 1000);
     sendingNode->setClockSkewUsec(clockSkew);
+    _trafficStats.recordPingTime(sendingNode->getUUID(), pingTime);
     
     const bool wantDebug = false;
     
@@ -202,6 +225,11 @@ void NodeList::reset() {
     LimitedNodeList::reset();
     
     _numNoReplyDomainCheckIns = 0;
+    
+    // we'll need the full list from the next domain
+    _domainListVersion = 0;
+    _pendingDomainListPackets.clear();
+    _pendingDomainListNodeUUIDs.clear();
 
     // refresh the owner UUID to the NULL UUID
     setSessionUUID(QUuid());
@@ -392,6 +420,9 @@ void NodeList::sendDomainServerCheckIn() {
             packetStream << nodeTypeOfInterest;
         }
         
+        // tell the domain-server which version of the list we have so that it only sends what's changed since
+        packetStream << _domainListVersion;
+        
         if (!isUsingDTLS) {
             writeDatagram(domainServerPacket, _domainHandler.getSockAddr(), QUuid());
         } else {
@@ -443,8 +474,31 @@ int NodeList::processDomainServerList(const QByteArray& packet) {
     packetStream >> newUUID;
     setSessionUUID(newUUID);
     
-    // pull each node in the packet
+    // then the version of the list we're being brought up to, the version it's relative to (zero for the full list),
+    // and the position of this packet among those making up the list
+    quint32 baseVersion, version;
+    quint16 packetIndex, packetCount;
+    packetStream >> baseVersion >> version >> packetIndex >> packetCount;
+    
+    // a packet of a different list than the one we were gathering starts a new one
+    if (baseVersion != _pendingDomainListBaseVersion || version != _pendingDomainListVersion) {
+        _pendingDomainListBaseVersion = baseVersion;
+        _pendingDomainListVersion = version;
+        _pendingDomainListPackets.clear();
+        _pendingDomainListNodeUUIDs.clear();
+    }
+    
+    // pull each record in the packet
     while(packetStream.device()->pos() < packet.size()) {
+        DomainListRecord_t recordType;
+        packetStream >> recordType;
+        
+        if (recordType == DomainListRecord::NodeRemoved) {
+            packetStream >> nodeUUID;
+            killNodeWithUUID(nodeUUID);
+            continue;
+        }
+        
         packetStream >> nodeType >> nodeUUID >> nodePublicSocket >> nodeLocalSocket;
 
         // if the public socket address is 0 then it's reachable at the same IP
@@ -457,6 +511,26 @@ int NodeList::processDomainServerList(const QByteArray& packet) {
         
         packetStream >> connectionUUID;
         node->setConnectionSecret(connectionUUID);
+        
+        if (baseVersion == 0) {
+            _pendingDomainListNodeUUIDs.insert(nodeUUID);
+        }
+        readNodes++;
+    }
+    
+    // we can only acknowledge the new version once we have every packet of the list
+    _pendingDomainListPackets.insert(packetIndex);
+    if (_pendingDomainListPackets.size() == packetCount) {
+        _domainListVersion = version;
+        
+        if (baseVersion == 0) {
+            // the full list doesn't say which nodes went away since whatever we had before it, so any it left out did
+            foreach (const SharedNodePointer& node, getNodeHash()) {
+                if (!_pendingDomainListNodeUUIDs.contains(node->getUUID())) {
+                    killNodeWithUUID(node->getUUID());
+                }
+            }
+        }
     }
     
     // ping inactive nodes in conjunction with receipt of list from domain-server
@@ -47,11 +47,27 @@ namespace PingType {
     const PingType_t Symmetric = 3;
 }
 
+/// The record types in a PacketTypeDomainList.  Each record is either a node (with its connection secret) that was added
+/// or changed since the acknowledged list version, or the UUID of a node that was removed.
+typedef quint8 DomainListRecord_t;
+namespace DomainListRecord {
+    const DomainListRecord_t NodeUpdated = 0;
+    const DomainListRecord_t NodeRemoved = 1;
+}
+
 class NodeList : public LimitedNodeList {
     Q_OBJECT
 public:
     static NodeList* createInstance(char ownerType, unsigned short socketListenPort = 0, unsigned short dtlsPort = 0);
     static NodeList* getInstance();
+    
+    /// Creates a list (with its own socket) that is returned by getInstance on the calling thread only.  The caller owns
+    /// the list and must unbind it with LimitedNodeList::setThreadInstance(NULL) before deleting it.
+    static NodeList* createThreadInstance(char ownerType, unsigned short socketListenPort = 0, unsigned short dtlsPort = 0);
+    
+    /// Checks whether the list returned by getInstance on the calling thread is the process-wide one.
+    static bool isUsingSharedInstance() { return !getThreadInstance(); }
+    
     NodeType_t getOwnerType() const { return _ownerType; }
     void setOwnerType(NodeType_t ownerType) { _ownerType = ownerType; }
 
@@ -109,6 +125,12 @@ private:
     HifiSockAddr _publicSockAddr;
     bool _hasCompletedInitialSTUNFailure;
     unsigned int _stunRequestsSinceSuccess;
+    
+    quint32 _domainListVersion;
+    quint32 _pendingDomainListBaseVersion;
+    quint32 _pendingDomainListVersion;
+    QSet<quint16> _pendingDomainListPackets;
+    QSet<QUuid> _pendingDomainListNodeUUIDs; ///< the nodes in the full list being gathered, if it's a full one
 };
 
 #endif // hifi_NodeList_h
@@ -0,0 +1,131 @@
+//
+//  PacketBuffer.cpp
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+
+#include <QtCore/QMutexLocker>
+
+#include "PacketBuffer.h"
+
+PacketBufferPool& PacketBufferPool::getInstance() {
+    static PacketBufferPool instance;
+    return instance;
+}
+
+PacketBufferPool::PacketBufferPool(int maxBuffers) :
+    _maxBuffers(maxBuffers),
+    _numAllocated(0),
+    _numReused(0),
+    _numOversized(0),
+    _numStillShared(0),
+    _numDiscarded(0)
+{
+    // reserve the free list up front, so that recycling never has to grow it
+    _freeBuffers.reserve(maxBuffers);
+}
+
+QByteArray PacketBufferPool::take(int size) {
+    if (size > PACKET_BUFFER_CAPACITY) {
+        _numOversized.ref();
+        return QByteArray(size, Qt::Uninitialized);
+    }
+    QByteArray buffer;
+    {
+        QMutexLocker locker(&_mutex);
+        if (!_freeBuffers.isEmpty()) {
+            buffer.swap(_freeBuffers.last());
+            _freeBuffers.removeLast();
+        }
+    }
+    if (buffer.capacity() == PACKET_BUFFER_CAPACITY) {
+        _numReused.ref();
+    } else {
+        _numAllocated.ref();
+
+        // reserving (rather than just resizing) keeps later resizes from reallocating, even when they shrink
+        buffer.reserve(PACKET_BUFFER_CAPACITY);
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+void PacketBufferPool::recycle(QByteArray& buffer) {
+    if (buffer.capacity() != PACKET_BUFFER_CAPACITY) {
+        // not one of ours (or an empty array)
+        buffer = QByteArray();
+        return;
+    }
+    if (!buffer.isDetached()) {
+        _numStillShared.ref();
+        buffer = QByteArray();
+        return;
+    }
+    {
+        QMutexLocker locker(&_mutex);
+        if (_freeBuffers.size() < _maxBuffers) {
+            _freeBuffers.append(QByteArray());
+            _freeBuffers.last().swap(buffer);
+            return;
+        }
+    }
+    _numDiscarded.ref();
+    buffer = QByteArray();
+}
+
+int PacketBufferPool::getNumFree() {
+    QMutexLocker locker(&_mutex);
+    return _freeBuffers.size();
+}
+
+QJsonObject PacketBufferPool::getStats() {
+    QJsonObject statsObject;
+    statsObject["packet_buffers_allocated"] = _numAllocated.load();
+    statsObject["packet_buffers_reused"] = _numReused.load();
+    statsObject["packet_buffers_oversized"] = _numOversized.load();
+    statsObject["packet_buffers_still_shared"] = _numStillShared.load();
+    statsObject["packet_buffers_discarded"] = _numDiscarded.load();
+    statsObject["packet_buffers_free"] = getNumFree();
+    return statsObject;
+}
+
+PacketView::PacketView(const QByteArray& packet) {
+    init(packet.constData(), packet.size());
+}
+
+PacketView::PacketView(const char* data, int size) {
+    init(data, size);
+}
+
+bool PacketView::hashMatches(const QUuid& connectionSecret) const {
+    if (!_hasHash || !isValid()) {
+        return false;
+    }
+    char expectedHash[NUM_BYTES_MD5_HASH];
+    hashForPacketAndConnectionUUID(_data, _size, connectionSecret, expectedHash);
+    return memcmp(expectedHash, getHash(), NUM_BYTES_MD5_HASH) == 0;
+}
+
+void PacketView::init(const char* data, int size) {
+    _data = data;
+    _size = size;
+    if (size <= 0) {
+        // leave the header longer than the packet, so that the view is invalid
+        _type = PacketTypeUnknown;
+        _numTypeBytes = 1;
+        _hasHash = false;
+        _headerSize = _numTypeBytes + NUM_STATIC_HEADER_BYTES;
+        return;
+    }
+    _type = packetTypeForPacket(data);
+    _numTypeBytes = numBytesArithmeticCodingFromBuffer(data);
+    _hasHash = !NON_VERIFIED_PACKETS.contains(_type);
+    _headerSize = _numTypeBytes + NUM_STATIC_HEADER_BYTES + (_hasHash ? NUM_BYTES_MD5_HASH : 0);
+}
@@ -0,0 +1,113 @@
+//
+//  PacketBuffer.h
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PacketBuffer_h
+#define hifi_PacketBuffer_h
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+
+#include "PacketHeaders.h"
+
+/// The capacity of each pooled buffer: comfortably more than MAX_PACKET_SIZE, so that the odd larger datagram (from the
+/// metavoxel server, say) still fits.
+const int PACKET_BUFFER_CAPACITY = 4096;
+
+/// The most free buffers the pool holds on to.
+const int MAX_POOLED_PACKET_BUFFERS = 1024;
+
+/// A pool of datagram buffers, so that the receive path doesn't go to the heap for every packet.  The buffers are plain
+/// QByteArrays, whose implicit sharing is their reference count: a buffer taken from the pool can be passed on by value
+/// (to a queue, a processing thread, a sender) without copying, and goes back to the pool when the last holder recycles
+/// it.  Safe to use from any thread.
+class PacketBufferPool {
+public:
+
+    /// Returns the pool shared by the whole process.
+    static PacketBufferPool& getInstance();
+
+    PacketBufferPool(int maxBuffers = MAX_POOLED_PACKET_BUFFERS);
+
+    /// Returns an unshared buffer of the given size, whose contents are undefined.  Sizes over PACKET_BUFFER_CAPACITY
+    /// are allocated on the spot (and counted as oversized).
+    QByteArray take(int size);
+
+    /// Hands a buffer back to the pool, leaving the argument empty.  If somebody else still holds a copy, we only let
+    /// go of ours and the last holder frees it.  Buffers that didn't come from the pool are simply released.
+    void recycle(QByteArray& buffer);
+
+    /// Returns the number of free buffers held.
+    int getNumFree();
+
+    /// Returns the allocation counters (totals since startup, since the pool is shared by every assignment in the
+    /// process): once traffic is steady, the number of buffers allocated should stop growing.
+    QJsonObject getStats();
+
+private:
+
+    QMutex _mutex;
+    QVector<QByteArray> _freeBuffers;
+    int _maxBuffers;
+
+    QAtomicInt _numAllocated; ///< buffers allocated because the pool was empty
+    QAtomicInt _numReused; ///< buffers taken from the pool
+    QAtomicInt _numOversized; ///< buffers allocated because they were too big for the pool
+    QAtomicInt _numStillShared; ///< buffers recycled while somebody else held a copy
+    QAtomicInt _numDiscarded; ///< buffers freed because the pool was full
+};
+
+/// A read-only view of a packet's header, hash, and payload, which reads them in place rather than copying them out as
+/// the QByteArray-returning header functions do.  The view is only good for as long as the packet it looks at.
+class PacketView {
+public:
+
+    PacketView(const QByteArray& packet);
+    PacketView(const char* data, int size);
+
+    /// Checks that the packet is at least as long as its header.
+    bool isValid() const { return _headerSize <= _size; }
+
+    PacketType getType() const { return _type; }
+    PacketVersion getVersion() const { return _data[_numTypeBytes]; }
+    QUuid getSenderUUID() const { return uuidFromRfc4122(_data + _numTypeBytes + sizeof(PacketVersion)); }
+
+    const char* getHeader() const { return _data; }
+    int getHeaderSize() const { return _headerSize; }
+
+    /// Checks whether the packet's type carries a hash (see NON_VERIFIED_PACKETS).
+    bool hasHash() const { return _hasHash; }
+    const char* getHash() const { return _data + _headerSize - NUM_BYTES_MD5_HASH; }
+
+    /// Checks the packet's hash against the one expected for the given connection secret.
+    bool hashMatches(const QUuid& connectionSecret) const;
+
+    const char* getPayload() const { return _data + _headerSize; }
+    int getPayloadSize() const { return _size - _headerSize; }
+
+    const char* getData() const { return _data; }
+    int getSize() const { return _size; }
+
+private:
+
+    void init(const char* data, int size);
+
+    const char* _data;
+    int _size;
+    PacketType _type;
+    int _numTypeBytes;
+    bool _hasHash;
+    int _headerSize;
+};
+
+#endif // hifi_PacketBuffer_h
@@ -12,6 +12,7 @@
 #include <math.h>
 
 #include <QtCore/QDebug>
+#include <QtCore/QThreadStorage>
 
 #include "NodeList.h"
 
@@ -47,6 +48,11 @@ int packArithmeticallyCodedValue(int value, char* destination) {
 
 PacketVersion versionForPacketType(PacketType type) {
     switch (type) {
+        case PacketTypeMixedAudio:
+        case PacketTypeMicrophoneAudioNoEcho:
+        case PacketTypeMicrophoneAudioWithEcho:
+        case PacketTypeSilentAudioFrame:
+            return 1;
         case PacketTypeAvatarData:
             return 3;
         case PacketTypeEnvironmentData:
@@ -55,7 +61,7 @@ PacketVersion versionForPacketType(PacketType type) {
             return 1;
         case PacketTypeDomainList:
         case PacketTypeDomainListRequest:
-            return 2;
+            return 3;
         case PacketTypeCreateAssignment:
         case PacketTypeRequestAssignment:
             return 2;
@@ -89,8 +95,7 @@ int populatePacketHeader(char* packet, PacketType type, const QUuid& connectionU
     
     QUuid packUUID = connectionUUID.isNull() ? LimitedNodeList::getInstance()->getSessionUUID() : connectionUUID;
     
-    QByteArray rfcUUID = packUUID.toRfc4122();
-    memcpy(position, rfcUUID.constData(), NUM_BYTES_RFC4122_UUID);
+    writeRfc4122(packUUID, position);
     position += NUM_BYTES_RFC4122_UUID;
     
     if (!NON_VERIFIED_PACKETS.contains(type)) {
@@ -128,8 +133,8 @@ int numHashBytesInPacketHeaderGivenPacketType(PacketType type) {
 }
 
 QUuid uuidFromPacketHeader(const QByteArray& packet) {
-    return QUuid::fromRfc4122(packet.mid(numBytesArithmeticCodingFromBuffer(packet.data()) + sizeof(PacketVersion),
-                                         NUM_BYTES_RFC4122_UUID));
+    return uuidFromRfc4122(packet.constData() + numBytesArithmeticCodingFromBuffer(packet.constData())
+        + sizeof(PacketVersion));
 }
 
 QByteArray hashFromPacketHeader(const QByteArray& packet) {
@@ -137,13 +142,37 @@ QByteArray hashFromPacketHeader(const QByteArray& packet) {
 }
 
 QByteArray hashForPacketAndConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID) {
-    return QCryptographicHash::hash(packet.mid(numBytesForPacketHeader(packet)) + connectionUUID.toRfc4122(),
-                                    QCryptographicHash::Md5);
+    QByteArray hash(NUM_BYTES_MD5_HASH, 0);
+    hashForPacketAndConnectionUUID(packet.constData(), packet.size(), connectionUUID, hash.data());
+    return hash;
+}
+
+void hashForPacketAndConnectionUUID(const char* packet, int size, const QUuid& connectionUUID, char* hash) {
+    // each thread keeps its own hasher, rather than setting one up (on the heap) for every packet
+    static QThreadStorage<QCryptographicHash*> threadHashers;
+    if (!threadHashers.hasLocalData()) {
+        threadHashers.setLocalData(new QCryptographicHash(QCryptographicHash::Md5));
+    }
+    QCryptographicHash* hasher = threadHashers.localData();
+    hasher->reset();
+    
+    int numHeaderBytes = numBytesForPacketHeader(packet);
+    hasher->addData(packet + numHeaderBytes, size - numHeaderBytes);
+    
+    char rfcUUID[NUM_BYTES_RFC4122_UUID];
+    writeRfc4122(connectionUUID, rfcUUID);
+    hasher->addData(rfcUUID, NUM_BYTES_RFC4122_UUID);
+    
+    memcpy(hash, hasher->result().constData(), NUM_BYTES_MD5_HASH);
 }
 
 void replaceHashInPacketGivenConnectionUUID(QByteArray& packet, const QUuid& connectionUUID) {
-    packet.replace(numBytesForPacketHeader(packet) - NUM_BYTES_MD5_HASH, NUM_BYTES_MD5_HASH,
-                   hashForPacketAndConnectionUUID(packet, connectionUUID));
+    replaceHashInPacketGivenConnectionUUID(packet.data(), packet.size(), connectionUUID);
+}
+
+void replaceHashInPacketGivenConnectionUUID(char* packet, int size, const QUuid& connectionUUID) {
+    hashForPacketAndConnectionUUID(packet, size, connectionUUID,
+        packet + numBytesForPacketHeader(packet) - NUM_BYTES_MD5_HASH);
 }
 
 PacketType packetTypeForPacket(const QByteArray& packet) {
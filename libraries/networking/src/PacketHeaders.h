@@ -94,6 +94,11 @@ QByteArray hashFromPacketHeader(const QByteArray& packet);
 QByteArray hashForPacketAndConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID);
 void replaceHashInPacketGivenConnectionUUID(QByteArray& packet, const QUuid& connectionUUID);
 
+/// Writes the hash of the packet's payload and the connection UUID to the given NUM_BYTES_MD5_HASH bytes.  Unlike the
+/// QByteArray versions, copies nothing out of the packet.
+void hashForPacketAndConnectionUUID(const char* packet, int size, const QUuid& connectionUUID, char* hash);
+void replaceHashInPacketGivenConnectionUUID(char* packet, int size, const QUuid& connectionUUID);
+
 PacketType packetTypeForPacket(const QByteArray& packet);
 PacketType packetTypeForPacket(const char* packet);
 
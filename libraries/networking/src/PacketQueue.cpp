@@ -0,0 +1,74 @@
+//
+//  PacketQueue.cpp
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "PacketQueue.h"
+
+PacketQueue::PacketQueue(int capacity) :
+    _slots(qMax(capacity, 1) + 1),
+    _head(0),
+    _tail(0),
+    _maxDepth(0),
+    _dropCount(0)
+{
+}
+
+bool PacketQueue::push(const QByteArray& packet, const HifiSockAddr& senderSockAddr, quint64 receivedUsecs) {
+    int tail = _tail.load();
+    int nextTail = (tail + 1) % _slots.size();
+
+    // the acquire pairs with the consumer's release, so that it's done with the slot before we reuse it
+    int head = _head.loadAcquire();
+    if (nextTail == head) {
+        _dropCount.ref();
+        return false;
+    }
+    ReceivedDatagram& slot = _slots[tail];
+    slot.packet = packet;
+    slot.senderSockAddr = senderSockAddr;
+    slot.receivedUsecs = receivedUsecs;
+
+    // publish the slot
+    _tail.storeRelease(nextTail);
+
+    int depth = getDepth(head, nextTail);
+    if (depth > _maxDepth.load()) {
+        _maxDepth.store(depth);
+    }
+    return true;
+}
+
+bool PacketQueue::pop(QByteArray& packet, HifiSockAddr& senderSockAddr, quint64* receivedUsecs) {
+    int head = _head.load();
+    if (head == _tail.loadAcquire()) {
+        return false;
+    }
+    ReceivedDatagram& slot = _slots[head];
+
+    // leave the slot empty so that it doesn't hold on to the packet's data until it's reused
+    packet = slot.packet;
+    slot.packet = QByteArray();
+    senderSockAddr = slot.senderSockAddr;
+    if (receivedUsecs) {
+        *receivedUsecs = slot.receivedUsecs;
+    }
+
+    // hand the slot back
+    _head.storeRelease((head + 1) % _slots.size());
+    return true;
+}
+
+int PacketQueue::getDepth() const {
+    return getDepth(_head.loadAcquire(), _tail.loadAcquire());
+}
+
+int PacketQueue::getDepth(int head, int tail) const {
+    return (tail - head + _slots.size()) % _slots.size();
+}
@@ -0,0 +1,72 @@
+//
+//  PacketQueue.h
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PacketQueue_h
+#define hifi_PacketQueue_h
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QVector>
+
+#include "HifiSockAddr.h"
+
+/// A datagram as read from the socket, along with the address it came from and when it arrived.
+class ReceivedDatagram {
+public:
+    QByteArray packet;
+    HifiSockAddr senderSockAddr;
+    quint64 receivedUsecs;
+};
+
+/// A bounded, lock-free queue of received datagrams with exactly one thread pushing and one thread popping.  When the
+/// queue is full, new datagrams are dropped (and counted) rather than blocking the receiving thread.
+class PacketQueue {
+public:
+
+    PacketQueue(int capacity);
+
+    /// Adds a datagram to the queue.
+    /// \return false if the queue was full and the datagram was dropped
+    /// \thread the producing thread only
+    bool push(const QByteArray& packet, const HifiSockAddr& senderSockAddr, quint64 receivedUsecs);
+
+    /// Removes the oldest datagram from the queue.
+    /// \param receivedUsecs if non-NULL, set to the time the datagram was pushed
+    /// \return false if the queue was empty
+    /// \thread the consuming thread only
+    bool pop(QByteArray& packet, HifiSockAddr& senderSockAddr, quint64* receivedUsecs = NULL);
+
+    int getCapacity() const { return _slots.size() - 1; }
+
+    /// Returns the number of datagrams waiting (exact on either thread, approximate elsewhere).
+    int getDepth() const;
+
+    /// Returns the largest depth reached since the last call, and starts tracking it anew.
+    int takeMaxDepth() { return _maxDepth.fetchAndStoreRelaxed(0); }
+
+    /// Returns the number of datagrams dropped since the last call, and restarts the count.
+    int takeDropCount() { return _dropCount.fetchAndStoreRelaxed(0); }
+
+private:
+
+    int getDepth(int head, int tail) const;
+
+    // one more slot than the capacity, so that a full queue can be told from an empty one
+    QVector<ReceivedDatagram> _slots;
+
+    QAtomicInt _head; ///< the next slot to pop, advanced by the consumer
+    QAtomicInt _tail; ///< the next slot to push, advanced by the producer
+
+    QAtomicInt _maxDepth;
+    QAtomicInt _dropCount;
+};
+
+#endif // hifi_PacketQueue_h
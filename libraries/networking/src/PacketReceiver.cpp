@@ -0,0 +1,132 @@
+//
+//  PacketReceiver.cpp
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifdef WIN32
+#include <winsock2.h>
+#include <WS2tcpip.h>
+#else
+#include <sys/select.h>
+#include <sys/socket.h>
+#endif
+
+#include <cstring>
+
+#include "PacketBuffer.h"
+#include "SharedUtil.h"
+
+#include "PacketReceiver.h"
+
+/// How long to wait for a datagram before checking whether we've been asked to stop.
+const int RECEIVE_POLL_USECS = 10 * 1000;
+
+/// The largest datagram we can receive.
+const int MAX_DATAGRAM_SIZE = 65536;
+
+/// The number of packet types that fit in the header's first byte.  Types past those take more bytes (the type is
+/// arithmetic coded), and go to the default queue unless given a queue of their own.
+const int NUM_PACKET_TYPE_VALUES = 255;
+
+PacketReceiver::PacketReceiver(int defaultCapacity) :
+    _socketDescriptor(-1),
+    _queuesByType(NUM_PACKET_TYPE_VALUES),
+    _defaultQueue(new PacketQueue(defaultCapacity)),
+    _receiveBuffer(MAX_DATAGRAM_SIZE, 0)
+{
+    _queuesByType.fill(_defaultQueue);
+}
+
+PacketReceiver::~PacketReceiver() {
+    if (isStillRunning() && isThreaded()) {
+        terminate();
+    }
+    foreach (const NamedQueue& namedQueue, _queues) {
+        delete namedQueue.queue;
+    }
+    delete _defaultQueue;
+}
+
+void PacketReceiver::addQueue(const QString& name, const QList<PacketType>& packetTypes, int capacity) {
+    NamedQueue namedQueue = { name, new PacketQueue(capacity) };
+    _queues.append(namedQueue);
+    foreach (PacketType packetType, packetTypes) {
+        while ((int)packetType >= _queuesByType.size()) {
+            _queuesByType.append(_defaultQueue);
+        }
+        _queuesByType[(int)packetType] = namedQueue.queue;
+    }
+}
+
+void PacketReceiver::start(qintptr socketDescriptor) {
+    _socketDescriptor = socketDescriptor;
+    initialize(true);
+}
+
+bool PacketReceiver::popDatagram(QByteArray& packet, HifiSockAddr& senderSockAddr, quint64* receivedUsecs) {
+    foreach (const NamedQueue& namedQueue, _queues) {
+        if (namedQueue.queue->pop(packet, senderSockAddr, receivedUsecs)) {
+            return true;
+        }
+    }
+    return _defaultQueue->pop(packet, senderSockAddr, receivedUsecs);
+}
+
+static void addQueueStats(QJsonObject& statsObject, const QString& name, PacketQueue* queue) {
+    QString prefix = "receive_queue_" + name;
+    statsObject[prefix + "_depth"] = queue->getDepth();
+    statsObject[prefix + "_max_depth"] = queue->takeMaxDepth();
+    statsObject[prefix + "_drops"] = queue->takeDropCount();
+}
+
+QJsonObject PacketReceiver::getStats() {
+    QJsonObject statsObject;
+    foreach (const NamedQueue& namedQueue, _queues) {
+        addQueueStats(statsObject, namedQueue.name, namedQueue.queue);
+    }
+    addQueueStats(statsObject, "other", _defaultQueue);
+    return statsObject;
+}
+
+bool PacketReceiver::process() {
+    // wait (briefly, so that we notice when we're asked to stop) for the socket to become readable
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(_socketDescriptor, &readSet);
+    timeval timeout = { 0, RECEIVE_POLL_USECS };
+    if (select(_socketDescriptor + 1, &readSet, NULL, NULL, &timeout) <= 0) {
+        return isStillRunning();
+    }
+
+    // the socket is non-blocking, so read until it's empty (everything we read now arrived by now)
+    quint64 receivedUsecs = usecTimestampNow();
+    PacketBufferPool& bufferPool = PacketBufferPool::getInstance();
+    while (true) {
+        sockaddr_storage senderAddress;
+        socklen_t senderAddressLength = sizeof(senderAddress);
+        int bytesReceived = recvfrom(_socketDescriptor, _receiveBuffer.data(), _receiveBuffer.size(), 0,
+            (sockaddr*)&senderAddress, &senderAddressLength);
+        if (bytesReceived <= 0) {
+            break;
+        }
+        // the consumer hands the buffer back to the pool once it's done with it
+        QByteArray packet = bufferPool.take(bytesReceived);
+        memcpy(packet.data(), _receiveBuffer.constData(), bytesReceived);
+        HifiSockAddr senderSockAddr((const sockaddr*)&senderAddress);
+
+        // the type is arithmetic coded, so it may take more than the first byte
+        int packetType = (int)packetTypeForPacket(packet);
+        PacketQueue* queue = (packetType >= 0 && packetType < _queuesByType.size()) ?
+            _queuesByType.at(packetType) : _defaultQueue;
+        if (!queue->push(packet, senderSockAddr, receivedUsecs)) {
+            bufferPool.recycle(packet);
+        }
+    }
+    return isStillRunning();
+}
@@ -0,0 +1,70 @@
+//
+//  PacketReceiver.h
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PacketReceiver_h
+#define hifi_PacketReceiver_h
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "GenericThread.h"
+#include "PacketHeaders.h"
+#include "PacketQueue.h"
+
+/// Reads datagrams from a socket on its own thread as soon as they arrive, and routes them by packet type into bounded
+/// queues that the owner drains at its own pace.  Keeps the kernel's receive buffer from overflowing while the owner's
+/// thread is busy (mixing a frame, say).
+class PacketReceiver : public GenericThread {
+    Q_OBJECT
+public:
+
+    /// \param defaultCapacity the capacity of the queue for packets of types that weren't given a queue of their own
+    PacketReceiver(int defaultCapacity);
+    virtual ~PacketReceiver();
+
+    /// Adds a queue for packets of the specified types.  Queues are drained in the order they're added, ahead of the
+    /// default queue.  Must be called before the thread is started.
+    void addQueue(const QString& name, const QList<PacketType>& packetTypes, int capacity);
+
+    /// Starts reading from the socket with the specified descriptor, which must be non-blocking.  Whatever else owns the
+    /// socket should stop reading from it.
+    void start(qintptr socketDescriptor);
+
+    /// Pops the next datagram, taking the queues in order.
+    /// \param receivedUsecs if non-NULL, set to the time the datagram was read from the socket
+    /// \thread the consuming thread only
+    bool popDatagram(QByteArray& packet, HifiSockAddr& senderSockAddr, quint64* receivedUsecs = NULL);
+
+    /// Returns the queue names along with their current depths, maximum depths, and drop counts since the last call.
+    QJsonObject getStats();
+
+protected:
+
+    virtual bool process();
+
+private:
+
+    class NamedQueue {
+    public:
+        QString name;
+        PacketQueue* queue;
+    };
+
+    qintptr _socketDescriptor;
+    QList<NamedQueue> _queues; ///< the typed queues in drain order, then the default queue
+    QVector<PacketQueue*> _queuesByType;
+    PacketQueue* _defaultQueue;
+    QByteArray _receiveBuffer;
+};
+
+#endif // hifi_PacketReceiver_h
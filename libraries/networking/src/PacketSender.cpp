@@ -48,16 +48,15 @@ PacketSender::~PacketSender() {
 }
 
 
-void PacketSender::queuePacketForSending(const SharedNodePointer& destinationNode, const QByteArray& packet) {
+bool PacketSender::queuePacketForSending(const SharedNodePointer& destinationNode, const QByteArray& packet) {
+    // the queue wakes our processing thread if it's waiting for packets, and counts the packet if it's turned away
     NetworkPacket networkPacket(destinationNode, packet);
-    lock();
-    _packets.push_back(networkPacket);
-    unlock();
+    if (!_packets.push(networkPacket)) {
+        return false;
+    }
     _totalPacketsQueued++;
     _totalBytesQueued += packet.size();
-
-    // Make sure to  wake our actual processing thread because we  now have packets for it to process.
-    _hasPackets.wakeAll();
+    return true;
 }
 
 void PacketSender::setPacketsPerSecond(int packetsPerSecond) {
@@ -73,7 +72,7 @@ bool PacketSender::process() {
 }
 
 void PacketSender::terminating() {
-    _hasPackets.wakeAll();
+    _packets.wake();
 }
 
 bool PacketSender::threadedProcess() {
@@ -118,10 +117,8 @@ bool PacketSender::threadedProcess() {
 
     // if threaded and we haven't slept? We want to wait for our consumer to signal us with new packets
     if (!hasSlept) {
-        // wait till we have packets        
-        _waitingOnPacketsMutex.lock();
-        _hasPackets.wait(&_waitingOnPacketsMutex);
-        _waitingOnPacketsMutex.unlock();
+        // wait till we have packets
+        _packets.waitForPackets();
     }
 
     return isStillRunning();
@@ -259,25 +256,17 @@ bool PacketSender::nonThreadedProcess() {
         }
     }
 
-    int packetsLeft = _packets.size();
-
     // Now that we know how many packets to send this call to process, just send them.
-    while ((packetsSentThisCall < packetsToSendThisCall) && (packetsLeft > 0)) {
-        lock();
-        NetworkPacket& packet = _packets.front();
-        NetworkPacket temporary = packet; // make a copy
-        _packets.erase(_packets.begin());
-        packetsLeft = _packets.size();
-        unlock();
-
+    NetworkPacket packet;
+    while ((packetsSentThisCall < packetsToSendThisCall) && _packets.pop(packet)) {
         // send the packet through the NodeList...
-        NodeList::getInstance()->writeDatagram(temporary.getByteArray(), temporary.getDestinationNode());
+        NodeList::getInstance()->writeDatagram(packet.getByteArray(), packet.getDestinationNode());
         packetsSentThisCall++;
         _packetsOverCheckInterval++;
         _totalPacketsSent++;
-        _totalBytesSent += temporary.getByteArray().size();
+        _totalBytesSent += packet.getByteArray().size();
         
-        emit packetSent(temporary.getByteArray().size());
+        emit packetSent(packet.getByteArray().size());
         
         _lastSendTime = now;
     }
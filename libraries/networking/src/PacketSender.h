@@ -14,10 +14,8 @@
 #ifndef hifi_PacketSender_h
 #define hifi_PacketSender_h
 
-#include <QWaitCondition>
-
 #include "GenericThread.h"
-#include "NetworkPacket.h"
+#include "NetworkPacketQueue.h"
 #include "NodeList.h"
 #include "SharedUtil.h"
 
@@ -42,8 +40,10 @@ public:
     /// \param HifiSockAddr& address the destination address
     /// \param packetData pointer to data
     /// \param ssize_t packetLength size of data
+    /// \return false if the queue was full and the packet wasn't queued, in which case the caller should hold on to it
+    /// and try again once we've caught up
     /// \thread any thread, typically the application thread
-    void queuePacketForSending(const SharedNodePointer& destinationNode, const QByteArray& packet);
+    bool queuePacketForSending(const SharedNodePointer& destinationNode, const QByteArray& packet);
 
     void setPacketsPerSecond(int packetsPerSecond);
     int getPacketsPerSecond() const { return _packetsPerSecond; }
@@ -57,6 +57,9 @@ public:
     /// how many packets are there in the send queue waiting to be sent
     int packetsToSendCount() const { return _packets.size(); }
 
+    /// the send queue, for its capacity, high-water mark, and count of packets turned away because it was full
+    NetworkPacketQueue& getPacketQueue() { return _packets; }
+
     /// If you're running in non-threaded mode, call this to give us a hint as to how frequently you will call process.
     /// This has no effect in threaded mode. This is only considered a hint in non-threaded mode.
     /// \param int usecsPerProcessCall expected number of usecs between calls to process in non-threaded mode.
@@ -104,7 +107,7 @@ protected:
     SimpleMovingAverage _averageProcessCallTime;
 
 private:
-    std::vector<NetworkPacket> _packets;
+    NetworkPacketQueue _packets;
     quint64 _lastSendTime;
 
     bool threadedProcess();
@@ -119,9 +122,6 @@ private:
 
     quint64 _totalPacketsQueued;
     quint64 _totalBytesQueued;
-
-    QWaitCondition _hasPackets;
-    QMutex _waitingOnPacketsMutex;
 };
 
 #endif // hifi_PacketSender_h
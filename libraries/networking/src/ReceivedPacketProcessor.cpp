@@ -10,40 +10,36 @@
 //
 
 #include "NodeList.h"
+#include "PacketBuffer.h"
 #include "ReceivedPacketProcessor.h"
 #include "SharedUtil.h"
 
 void ReceivedPacketProcessor::terminating() {
-    _hasPackets.wakeAll();
+    _packets.wake();
 }
 
 void ReceivedPacketProcessor::queueReceivedPacket(const SharedNodePointer& destinationNode, const QByteArray& packet) {
     // Make sure our Node and NodeList knows we've heard from this node.
     destinationNode->setLastHeardMicrostamp(usecTimestampNow());
 
+    // the queue wakes our processing thread if it's waiting for packets, and counts the packet as dropped if it's full
     NetworkPacket networkPacket(destinationNode, packet);
-    lock();
-    _packets.push_back(networkPacket);
-    unlock();
-    
-    // Make sure to  wake our actual processing thread because we  now have packets for it to process.
-    _hasPackets.wakeAll();
+    _packets.push(networkPacket);
 }
 
 bool ReceivedPacketProcessor::process() {
 
     if (_packets.size() == 0) {
-        _waitingOnPacketsMutex.lock();
-        _hasPackets.wait(&_waitingOnPacketsMutex);
-        _waitingOnPacketsMutex.unlock();
+        _packets.waitForPackets();
     }
-    while (_packets.size() > 0) {
-        lock(); // lock to make sure nothing changes on us
-        NetworkPacket& packet = _packets.front(); // get the oldest packet
-        NetworkPacket temporary = packet; // make a copy of the packet in case the vector is resized on us
-        _packets.erase(_packets.begin()); // remove the oldest packet
-        unlock(); // let others add to the packets
-        processPacket(temporary.getDestinationNode(), temporary.getByteArray()); // process our temporary copy
+    NetworkPacket packet;
+    PacketBufferPool& bufferPool = PacketBufferPool::getInstance();
+    while (_packets.pop(packet)) {
+        processPacket(packet.getDestinationNode(), packet.getByteArray());
+
+        // the reader recycled its copy when it read the next datagram, so ours is likely the last one; whichever of us
+        // lets go last puts the buffer back in the pool
+        bufferPool.recycle(packet.getByteArray());
     }
     return isStillRunning();  // keep running till they terminate us
 }
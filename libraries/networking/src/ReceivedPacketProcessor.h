@@ -12,10 +12,8 @@
 #ifndef hifi_ReceivedPacketProcessor_h
 #define hifi_ReceivedPacketProcessor_h
 
-#include <QWaitCondition>
-
 #include "GenericThread.h"
-#include "NetworkPacket.h"
+#include "NetworkPacketQueue.h"
 
 /// Generalized threaded processor for handling received inbound packets. 
 class ReceivedPacketProcessor : public GenericThread {
@@ -36,6 +34,9 @@ public:
     /// How many received packets waiting are to be processed
     int packetsToProcessCount() const { return _packets.size(); }
 
+    /// The queue of received packets, for its capacity, high-water mark, and drop count
+    NetworkPacketQueue& getPacketQueue() { return _packets; }
+
 protected:
     /// Callback for processing of recieved packets. Implement this to process the incoming packets.
     /// \param sockaddr& senderAddress the address of the sender
@@ -51,9 +52,7 @@ protected:
 
 private:
 
-    std::vector<NetworkPacket> _packets;
-    QWaitCondition _hasPackets;
-    QMutex _waitingOnPacketsMutex;
+    NetworkPacketQueue _packets;
 };
 
 #endif // hifi_ReceivedPacketProcessor_h
@@ -0,0 +1,244 @@
+//
+//  SharedMemoryRing.cpp
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+
+#include <QtCore/QDebug>
+
+#include "PacketBuffer.h"
+
+#include "SharedMemoryRing.h"
+
+const quint32 SHARED_MEMORY_RING_MAGIC = 0x48464452; // "HFDR"
+
+/// Marks a record that doesn't fit before the end of the ring, so the reader skips to the start.
+const quint32 WRAP_MARKER = 0xFFFFFFFF;
+
+/// Records are aligned to this many bytes, so that their headers can be read in place.
+const int RECORD_ALIGNMENT = 4;
+
+class SharedMemoryRing::Header {
+public:
+    quint32 magic;
+    quint32 capacity;
+    quint32 head; ///< the offset of the next record to read
+    quint32 tail; ///< the offset at which to write the next record
+    quint32 isDoorbellArmed;
+    quint32 isOpen; ///< cleared when the owner closes the ring, so that writers know to stop
+    quint32 dropCount;
+};
+
+/// What precedes each datagram in the ring.
+class RecordHeader {
+public:
+    quint32 size;
+    quint32 senderIPv4Address;
+    quint16 senderPort;
+    quint16 padding;
+};
+
+static int recordSize(int datagramSize) {
+    int size = sizeof(RecordHeader) + datagramSize;
+    return (size + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+}
+
+QString SharedMemoryRing::keyForPort(quint16 port) {
+    return QString("hifi-datagrams-%1").arg(port);
+}
+
+/// Returns the key of the doorbell for the given port.  QSharedMemory makes its own lock from the memory's key, so the
+/// doorbell can't share that key without resetting (and, when rung, unlocking) the memory's lock.
+static QString doorbellKeyForPort(quint16 port) {
+    return SharedMemoryRing::keyForPort(port) + "-doorbell";
+}
+
+SharedMemoryRing::SharedMemoryRing() :
+    _writeMutex(),
+    _doorbell(NULL),
+    _isOwner(false)
+{
+}
+
+SharedMemoryRing::~SharedMemoryRing() {
+    if (_isOwner && _memory.isAttached()) {
+        _memory.lock();
+        getHeader()->isOpen = 0;
+        _memory.unlock();
+    }
+    delete _doorbell;
+}
+
+bool SharedMemoryRing::create(quint16 port, int size) {
+    _memory.setKey(keyForPort(port));
+    int totalSize = sizeof(Header) + size;
+    if (!_memory.create(totalSize)) {
+        // an owner that crashed leaves its ring behind; the port is ours now, so take the ring over
+        if (_memory.error() != QSharedMemory::AlreadyExists || !_memory.attach() || _memory.size() < totalSize) {
+            qDebug() << "Failed to create shared memory ring for port" << port << "-" << _memory.errorString();
+            return false;
+        }
+    }
+    _isOwner = true;
+
+    _memory.lock();
+    Header* header = getHeader();
+    header->magic = SHARED_MEMORY_RING_MAGIC;
+    header->capacity = size;
+    header->head = 0;
+    header->tail = 0;
+    header->isDoorbellArmed = 1;
+    header->isOpen = 1;
+    header->dropCount = 0;
+    _memory.unlock();
+
+    _doorbell = new QSystemSemaphore(doorbellKeyForPort(port), 0, QSystemSemaphore::Create);
+    return true;
+}
+
+bool SharedMemoryRing::attach(quint16 port) {
+    _memory.setKey(keyForPort(port));
+    if (!_memory.attach()) {
+        return false;
+    }
+    _memory.lock();
+    Header* header = getHeader();
+    bool isValid = header->magic == SHARED_MEMORY_RING_MAGIC && header->isOpen
+        && (int)(sizeof(Header) + header->capacity) <= _memory.size();
+    _memory.unlock();
+    if (!isValid) {
+        _memory.detach();
+        return false;
+    }
+    _doorbell = new QSystemSemaphore(doorbellKeyForPort(port), 0, QSystemSemaphore::Open);
+    return true;
+}
+
+bool SharedMemoryRing::write(const char* data, int size, const HifiSockAddr& senderSockAddr) {
+    int length = recordSize(size);
+
+    QMutexLocker locker(&_writeMutex);
+    _memory.lock();
+    Header* header = getHeader();
+    if (!header->isOpen) {
+        _memory.unlock();
+        return false;
+    }
+    quint32 tail = header->tail;
+    quint32 head = header->head;
+
+    // if the record won't fit before the end, it goes at the start (and the space at the end is wasted)
+    quint32 start = tail;
+    quint32 needed = length;
+    if (tail + length > header->capacity) {
+        start = 0;
+        needed += header->capacity - tail;
+    }
+    // leave a gap between the tail and the head, so that a full ring can be told from an empty one
+    quint32 used = (tail >= head) ? tail - head : header->capacity - head + tail;
+    if (used + needed >= header->capacity) {
+        header->dropCount++;
+        _memory.unlock();
+        return false;
+    }
+    char* ringData = getData();
+    if (start != tail && header->capacity - tail >= sizeof(quint32)) {
+        *reinterpret_cast<quint32*>(ringData + tail) = WRAP_MARKER;
+    }
+    RecordHeader* record = reinterpret_cast<RecordHeader*>(ringData + start);
+    record->size = size;
+    record->senderIPv4Address = senderSockAddr.getAddress().toIPv4Address();
+    record->senderPort = senderSockAddr.getPort();
+    record->padding = 0;
+    memcpy(ringData + start + sizeof(RecordHeader), data, size);
+    header->tail = (start + length) % header->capacity;
+
+    bool shouldRing = header->isDoorbellArmed;
+    header->isDoorbellArmed = 0;
+    _memory.unlock();
+
+    if (shouldRing) {
+        _doorbell->release();
+    }
+    return true;
+}
+
+bool SharedMemoryRing::read(QByteArray& packet, HifiSockAddr& senderSockAddr) {
+    _memory.lock();
+    Header* header = getHeader();
+    if (header->head == header->tail) {
+        // the next write will tell us
+        header->isDoorbellArmed = 1;
+        _memory.unlock();
+        return false;
+    }
+    char* ringData = getData();
+    quint32 head = header->head;
+    if (header->capacity - head < sizeof(RecordHeader)
+            || *reinterpret_cast<const quint32*>(ringData + head) == WRAP_MARKER) {
+        head = 0;
+    }
+    const RecordHeader* record = reinterpret_cast<const RecordHeader*>(ringData + head);
+    if (head + recordSize(record->size) > header->capacity) {
+        // a writer has scribbled on the ring; all we can do is drop what's in it
+        qDebug() << "Dropping corrupt shared memory ring contents.";
+        header->head = header->tail;
+        header->isDoorbellArmed = 1;
+        _memory.unlock();
+        return false;
+    }
+    packet = PacketBufferPool::getInstance().take(record->size);
+    memcpy(packet.data(), ringData + head + sizeof(RecordHeader), record->size);
+    senderSockAddr = HifiSockAddr(QHostAddress(record->senderIPv4Address), record->senderPort);
+    header->head = (head + recordSize(record->size)) % header->capacity;
+    _memory.unlock();
+    return true;
+}
+
+void SharedMemoryRing::waitForDoorbell() {
+    _doorbell->acquire();
+}
+
+void SharedMemoryRing::wakeWaiter() {
+    _doorbell->release();
+}
+
+int SharedMemoryRing::takeDropCount() {
+    _memory.lock();
+    int dropCount = getHeader()->dropCount;
+    getHeader()->dropCount = 0;
+    _memory.unlock();
+    return dropCount;
+}
+
+SharedMemoryRing::Header* SharedMemoryRing::getHeader() {
+    return reinterpret_cast<Header*>(_memory.data());
+}
+
+char* SharedMemoryRing::getData() {
+    return reinterpret_cast<char*>(_memory.data()) + sizeof(Header);
+}
+
+SharedMemoryRingWatcher::SharedMemoryRingWatcher(SharedMemoryRing* ring) :
+    _ring(ring)
+{
+}
+
+bool SharedMemoryRingWatcher::process() {
+    _ring->waitForDoorbell();
+    if (isStillRunning()) {
+        emit datagramsAvailable();
+    }
+    return isStillRunning();
+}
+
+void SharedMemoryRingWatcher::terminating() {
+    _ring->wakeWaiter();
+}
@@ -0,0 +1,100 @@
+//
+//  SharedMemoryRing.h
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_SharedMemoryRing_h
+#define hifi_SharedMemoryRing_h
+
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedMemory>
+#include <QtCore/QSystemSemaphore>
+
+#include "GenericThread.h"
+#include "HifiSockAddr.h"
+
+/// The size of the datagram area of each ring.
+const int DEFAULT_SHARED_MEMORY_RING_BYTES = 1024 * 1024;
+
+/// A ring of datagrams in shared memory, through which processes on the same host deliver datagrams to the one that
+/// created it without going through the kernel's UDP loopback.  Each ring belongs to the UDP port its owner receives
+/// on, so a sender can find it from nothing more than the destination address.  Any number of processes may write;
+/// only the owner reads.  When the owner finds the ring empty, it arms a doorbell that the next write rings, so that a
+/// burst of datagrams costs a single wake-up.
+class SharedMemoryRing {
+public:
+
+    /// Returns the key of the ring for the given port.
+    static QString keyForPort(quint16 port);
+
+    SharedMemoryRing();
+    ~SharedMemoryRing();
+
+    /// Creates (and owns) the ring for the given port, replacing any left behind by an owner that crashed.
+    bool create(quint16 port, int size = DEFAULT_SHARED_MEMORY_RING_BYTES);
+
+    /// Attaches to the ring that another process created for the given port.
+    bool attach(quint16 port);
+
+    bool isOwner() const { return _isOwner; }
+
+    /// Adds a datagram to the ring.
+    /// \param senderSockAddr the address the owner should take the datagram to have come from
+    /// \return false if the ring was full (or closed) and the datagram was not added
+    /// \thread any
+    bool write(const char* data, int size, const HifiSockAddr& senderSockAddr);
+
+    /// Removes the oldest datagram from the ring into a buffer taken from the PacketBufferPool.  When the ring is
+    /// empty, arms the doorbell.
+    /// \return false if the ring was empty
+    /// \thread the owner only
+    bool read(QByteArray& packet, HifiSockAddr& senderSockAddr);
+
+    /// Blocks until a writer rings the doorbell (or wakeWaiter is called).
+    void waitForDoorbell();
+
+    /// Wakes whoever is blocked in waitForDoorbell.
+    void wakeWaiter();
+
+    /// Returns the number of datagrams dropped because the ring was full, and restarts the count.
+    int takeDropCount();
+
+private:
+
+    class Header;
+
+    Header* getHeader();
+    char* getData();
+
+    QSharedMemory _memory;
+    QMutex _writeMutex; ///< the memory's lock keeps out other processes, but not our other threads
+    QSystemSemaphore* _doorbell;
+    bool _isOwner;
+};
+
+/// Waits on a ring's doorbell on its own thread, and signals whenever it rings.
+class SharedMemoryRingWatcher : public GenericThread {
+    Q_OBJECT
+public:
+
+    SharedMemoryRingWatcher(SharedMemoryRing* ring);
+
+    virtual bool process();
+    virtual void terminating();
+
+signals:
+    void datagramsAvailable();
+
+private:
+
+    SharedMemoryRing* _ring;
+};
+
+#endif // hifi_SharedMemoryRing_h
@@ -14,15 +14,29 @@
 #include <QtCore/QTimer>
 
 #include "Logging.h"
+#include "PacketBuffer.h"
+#include "PacketReceiver.h"
+#include "SharedUtil.h"
 #include "ThreadedAssignment.h"
 
+QAtomicInt ThreadedAssignment::_runningCount;
+
 ThreadedAssignment::ThreadedAssignment(const QByteArray& packet) :
     Assignment(packet),
-    _isFinished(false)
+    _isFinished(false),
+    _isRunning(false),
+    _lastStatsCPUUsecs(0),
+    _lastStatsUsecs(0),
+    _otherThreadsCPUUsecs(0),
+    _packetReceiver(NULL)
 {
     
 }
 
+ThreadedAssignment::~ThreadedAssignment() {
+    delete _packetReceiver;
+}
+
 void ThreadedAssignment::setFinished(bool isFinished) {
     _isFinished = isFinished;
 
@@ -30,8 +44,23 @@ void ThreadedAssignment::setFinished(bool isFinished) {
         aboutToFinish();
         emit finished();
         
-        // move the NodeList back to the QCoreApplication instance's thread
-        NodeList::getInstance()->moveToThread(QCoreApplication::instance()->thread());
+        if (_isRunning) {
+            _isRunning = false;
+            _runningCount.deref();
+        }
+        
+        // stop receiving; whoever drains the queues may still be running, so the receiver goes when we do
+        if (_packetReceiver) {
+            _packetReceiver->terminate();
+        }
+        
+        // peers on this host go back to UDP, which the assignment client reads between assignments
+        NodeList::getInstance()->setLocalTransportEnabled(false);
+        
+        // move the NodeList back to the QCoreApplication instance's thread, unless it's only ours
+        if (NodeList::isUsingSharedInstance()) {
+            NodeList::getInstance()->moveToThread(QCoreApplication::instance()->thread());
+        }
     }
 }
 
@@ -42,6 +71,15 @@ void ThreadedAssignment::commonInit(const QString& targetName, NodeType_t nodeTy
     NodeList* nodeList = NodeList::getInstance();
     nodeList->setOwnerType(nodeType);
     
+    if (!_isRunning) {
+        _isRunning = true;
+        _runningCount.ref();
+    }
+    
+    // our CPU usage is measured on this thread from here on
+    _lastStatsCPUUsecs = usecThreadCPUTime();
+    _lastStatsUsecs = usecTimestampNow();
+    
     QTimer* domainServerTimer = new QTimer(this);
     connect(domainServerTimer, SIGNAL(timeout()), this, SLOT(checkInWithDomainServerOrExit()));
     domainServerTimer->start(DOMAIN_SERVER_CHECK_IN_MSECS);
@@ -56,6 +94,34 @@ void ThreadedAssignment::commonInit(const QString& targetName, NodeType_t nodeTy
         connect(statsTimer, &QTimer::timeout, this, &ThreadedAssignment::sendStatsPacket);
         statsTimer->start(1000);
     }
+    
+    if (isLocalTransportRequested()) {
+        nodeList->setLocalTransportEnabled(true);
+        connect(nodeList, SIGNAL(localDatagramsAvailable()), this, SLOT(readPendingDatagrams()));
+    }
+}
+
+bool ThreadedAssignment::isReceiveThreadRequested() const {
+    const QString RECEIVE_THREAD_OPTION = "--receiveThread";
+    return QString(_payload).split(" ").contains(RECEIVE_THREAD_OPTION);
+}
+
+bool ThreadedAssignment::isLocalTransportRequested() const {
+    const QString LOCAL_TRANSPORT_OPTION = "--localTransport";
+    return QString(_payload).split(" ").contains(LOCAL_TRANSPORT_OPTION);
+}
+
+void ThreadedAssignment::startReceiveThread(PacketReceiver* receiver) {
+    NodeList* nodeList = NodeList::getInstance();
+    QUdpSocket& nodeSocket = nodeList->getNodeSocket();
+    
+    // the receive thread reads the socket from here on (and the assignment drains the local ring when it drains the
+    // queues)
+    disconnect(&nodeSocket, SIGNAL(readyRead()), this, 0);
+    disconnect(nodeList, SIGNAL(localDatagramsAvailable()), this, 0);
+    
+    _packetReceiver = receiver;
+    _packetReceiver->start(nodeSocket.socketDescriptor());
 }
 
 void ThreadedAssignment::addPacketStatsAndSendStatsPacket(QJsonObject &statsObject) {
@@ -68,6 +134,46 @@ void ThreadedAssignment::addPacketStatsAndSendStatsPacket(QJsonObject &statsObje
     statsObject["packets_per_second"] = packetsPerSecond;
     statsObject["bytes_per_second"] = bytesPerSecond;
     
+    // the share of a core used by the assignment's threads since the last stats, which (unlike the process figures)
+    // is still ours alone when several assignments are hosted in one process: our own thread, the receive thread if
+    // we have one, and whatever the subclass counted for its workers
+    quint64 cpuUsecs = usecThreadCPUTime();
+    quint64 eventThreadUsecs = cpuUsecs - _lastStatsCPUUsecs;
+    quint64 otherThreadsUsecs = _otherThreadsCPUUsecs.fetchAndStoreRelaxed(0);
+    if (_packetReceiver) {
+        otherThreadsUsecs += _packetReceiver->takeCPUUsecs();
+    }
+    quint64 now = usecTimestampNow();
+    if (now > _lastStatsUsecs) {
+        statsObject["cpu_usage_percent"] = 100.0 * (eventThreadUsecs + otherThreadsUsecs) / (now - _lastStatsUsecs);
+        statsObject["event_thread_cpu_usage_percent"] = 100.0 * eventThreadUsecs / (now - _lastStatsUsecs);
+    }
+    _lastStatsCPUUsecs = cpuUsecs;
+    _lastStatsUsecs = now;
+    
+    // heap use can't be attributed to a thread, so report the process total along with how many assignments share it
+    statsObject["process_memory_bytes"] = (double) processResidentMemoryBytes();
+    statsObject["process_assignments"] = _runningCount.load();
+    
+    statsObject[TRAFFIC_STATS_KEY] = nodeList->getTrafficStats().takeStats(nodeList->getNodeHash());
+    
+    if (nodeList->isLocalTransportEnabled()) {
+        statsObject["local_transport_datagrams_sent"] = nodeList->takeNumLocalDatagramsSent();
+        statsObject["local_transport_datagrams_dropped"] = nodeList->takeNumLocalDatagramsDropped();
+    }
+    
+    QJsonObject bufferStats = PacketBufferPool::getInstance().getStats();
+    for (QJsonObject::const_iterator it = bufferStats.constBegin(); it != bufferStats.constEnd(); it++) {
+        statsObject[it.key()] = it.value();
+    }
+    
+    if (_packetReceiver) {
+        QJsonObject receiverStats = _packetReceiver->getStats();
+        for (QJsonObject::const_iterator it = receiverStats.constBegin(); it != receiverStats.constEnd(); it++) {
+            statsObject[it.key()] = it.value();
+        }
+    }
+    
     nodeList->sendStatsToDomainServer(statsObject);
 }
 
@@ -85,10 +191,29 @@ void ThreadedAssignment::checkInWithDomainServerOrExit() {
 }
 
 bool ThreadedAssignment::readAvailableDatagram(QByteArray& destinationByteArray, HifiSockAddr& senderSockAddr) {
+    // the last datagram goes back to the pool (unless whoever processed it kept a copy), and once there are no more, so
+    // does the destination, so that the steady state allocates nothing
+    PacketBufferPool& bufferPool = PacketBufferPool::getInstance();
+    bufferPool.recycle(destinationByteArray);
+    
+    // peers on this host that use the local transport write to our ring instead of the socket
+    if (NodeList::getInstance()->readLocalDatagram(destinationByteArray, senderSockAddr)) {
+        return true;
+    }
+    
+    if (_packetReceiver) {
+        quint64 receivedUsecs;
+        if (!_packetReceiver->popDatagram(destinationByteArray, senderSockAddr, &receivedUsecs)) {
+            return false;
+        }
+        NodeList::getInstance()->getTrafficStats().recordQueueDelay(destinationByteArray,
+            usecTimestampNow() - receivedUsecs);
+        return true;
+    }
     NodeList* nodeList = NodeList::getInstance();
     
     if (nodeList->getNodeSocket().hasPendingDatagrams()) {
-        destinationByteArray.resize(nodeList->getNodeSocket().pendingDatagramSize());
+        destinationByteArray = bufferPool.take(nodeList->getNodeSocket().pendingDatagramSize());
         nodeList->getNodeSocket().readDatagram(destinationByteArray.data(), destinationByteArray.size(),
                                                senderSockAddr.getAddressPointer(), senderSockAddr.getPortPointer());
         return true;
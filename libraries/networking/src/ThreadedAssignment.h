@@ -12,17 +12,25 @@
 #ifndef hifi_ThreadedAssignment_h
 #define hifi_ThreadedAssignment_h
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QSharedPointer>
 
 #include "Assignment.h"
 
+class PacketReceiver;
+
 class ThreadedAssignment : public Assignment {
     Q_OBJECT
 public:
     ThreadedAssignment(const QByteArray& packet);
+    virtual ~ThreadedAssignment();
     void setFinished(bool isFinished);
     virtual void aboutToFinish() { };
     void addPacketStatsAndSendStatsPacket(QJsonObject& statsObject);
+    
+    /// Adds CPU time spent on the assignment's behalf by a thread other than its own (a worker, say, or a dedicated
+    /// sending thread), to be counted in the next stats.  Safe to call from any thread.
+    void addThreadCPUUsecs(quint64 usecs) { _otherThreadsCPUUsecs.fetchAndAddRelaxed((int)usecs); }
 
 public slots:
     /// threaded run of assignment
@@ -33,7 +41,34 @@ public slots:
 protected:
     bool readAvailableDatagram(QByteArray& destinationByteArray, HifiSockAddr& senderSockAddr);
     void commonInit(const QString& targetName, NodeType_t nodeType, bool shouldSendStats = true);
+    
+    /// Checks whether the assignment's payload asks for datagrams to be received on a dedicated thread.
+    bool isReceiveThreadRequested() const;
+    
+    /// Checks whether the assignment's payload asks for the local transport (see LimitedNodeList), which commonInit
+    /// then switches on.
+    bool isLocalTransportRequested() const;
+    
+    /// Has the given receiver (which we take over) read datagrams on its own thread from now on.  readPendingDatagrams is
+    /// then no longer called when the socket is readable; instead, the assignment calls it when it's ready to process
+    /// what's queued, from one thread only, and readAvailableDatagram pops from the queues.  The NodeList's own datagrams
+    /// (pings, domain lists, kills) are queued along with the rest and still processed on the assignment's thread, but
+    /// only as often as the assignment drains the queues (once a frame, for the audio mixer), rather than as they
+    /// arrive.
+    void startReceiveThread(PacketReceiver* receiver);
+    
+    bool hasReceiveThread() const { return _packetReceiver != NULL; }
+    
     bool _isFinished;
+private:
+    static QAtomicInt _runningCount;
+    
+    bool _isRunning;
+    quint64 _lastStatsCPUUsecs;
+    quint64 _lastStatsUsecs;
+    QAtomicInt _otherThreadsCPUUsecs;
+    
+    PacketReceiver* _packetReceiver;
 private slots:
     void checkInWithDomainServerOrExit();
 signals:
@@ -0,0 +1,257 @@
+//
+//  TrafficStats.cpp
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include <QtCore/QMutexLocker>
+
+#include "Node.h"
+#include "UUID.h"
+
+#include "TrafficStats.h"
+
+/// The most timing samples to keep for each node over an interval.
+const int MAX_INTERVAL_TIMING_SAMPLES = 1000;
+
+/// The number of ping times to keep for each node; pings are sent about once a second.
+const int MAX_PING_HISTORY_SAMPLES = 60;
+
+void TimingSamples::add(int sample, int maxSamples) {
+    if (samples.size() < maxSamples) {
+        samples.append(sample);
+    } else {
+        samples[numSamples % maxSamples] = sample;
+    }
+    numSamples++;
+}
+
+void TimingSamples::addAll(const TimingSamples& other, int maxSamples) {
+    foreach (int sample, other.samples) {
+        add(sample, maxSamples);
+    }
+}
+
+int TimingSamples::getPercentile(int percentile) const {
+    if (samples.isEmpty()) {
+        return 0;
+    }
+    QVector<int> sortedSamples = samples;
+    int index = qMin(sortedSamples.size() * percentile / 100, sortedSamples.size() - 1);
+    std::nth_element(sortedSamples.begin(), sortedSamples.begin() + index, sortedSamples.end());
+    return sortedSamples.at(index);
+}
+
+static void addCounts(QHash<int, TrafficCount>& destination, const QHash<int, TrafficCount>& source) {
+    for (QHash<int, TrafficCount>::const_iterator it = source.constBegin(); it != source.constEnd(); it++) {
+        TrafficCount& count = destination[it.key()];
+        count.packets += it.value().packets;
+        count.bytes += it.value().bytes;
+    }
+}
+
+void NodeTraffic::addAll(const NodeTraffic& other) {
+    addCounts(received, other.received);
+    addCounts(sent, other.sent);
+    pingUsecs.addAll(other.pingUsecs, MAX_INTERVAL_TIMING_SAMPLES);
+    queueDelayUsecs.addAll(other.queueDelayUsecs, MAX_INTERVAL_TIMING_SAMPLES);
+}
+
+static quint64 getTotalBytes(const QHash<int, TrafficCount>& counts) {
+    quint64 totalBytes = 0;
+    foreach (const TrafficCount& count, counts) {
+        totalBytes += count.bytes;
+    }
+    return totalBytes;
+}
+
+quint64 NodeTraffic::getTotalBytes() const {
+    return ::getTotalBytes(received) + ::getTotalBytes(sent);
+}
+
+TrafficStats::TrafficStats() {
+    _intervalTimer.start();
+}
+
+void TrafficStats::recordReceived(const QByteArray& packet) {
+    ThreadTraffic& threadTraffic = getThreadTraffic();
+    QUuid senderUUID = senderUUIDForPacket(packet);
+
+    QMutexLocker locker(&threadTraffic.mutex);
+    TrafficCount& count = threadTraffic.nodes[senderUUID].received[packetTypeForPacket(packet)];
+    count.packets++;
+    count.bytes += packet.size();
+}
+
+void TrafficStats::recordSent(const QUuid& nodeUUID, const char* packet, int size) {
+    ThreadTraffic& threadTraffic = getThreadTraffic();
+
+    QMutexLocker locker(&threadTraffic.mutex);
+    TrafficCount& count = threadTraffic.nodes[nodeUUID].sent[packetTypeForPacket(packet)];
+    count.packets++;
+    count.bytes += size;
+}
+
+void TrafficStats::recordPingTime(const QUuid& nodeUUID, int pingUsecs) {
+    ThreadTraffic& threadTraffic = getThreadTraffic();
+
+    QMutexLocker locker(&threadTraffic.mutex);
+    threadTraffic.nodes[nodeUUID].pingUsecs.add(pingUsecs, MAX_INTERVAL_TIMING_SAMPLES);
+}
+
+void TrafficStats::recordQueueDelay(const QByteArray& packet, int delayUsecs) {
+    ThreadTraffic& threadTraffic = getThreadTraffic();
+    QUuid senderUUID = senderUUIDForPacket(packet);
+
+    QMutexLocker locker(&threadTraffic.mutex);
+    threadTraffic.nodes[senderUUID].queueDelayUsecs.add(delayUsecs, MAX_INTERVAL_TIMING_SAMPLES);
+}
+
+static QJsonObject jsonForCounts(const QHash<int, TrafficCount>& counts, float intervalSeconds) {
+    QJsonObject countsObject;
+    for (QHash<int, TrafficCount>::const_iterator it = counts.constBegin(); it != counts.constEnd(); it++) {
+        QJsonObject countObject;
+        countObject["pps"] = it.value().packets / intervalSeconds;
+        countObject["kbps"] = it.value().bytes * 8 / 1000.0f / intervalSeconds;
+        countsObject[QString("packet_type_%1").arg(it.key())] = countObject;
+    }
+    return countsObject;
+}
+
+static void addTimingPercentiles(QJsonObject& object, const QString& prefix, const TimingSamples& timings,
+        float scale) {
+    if (timings.samples.isEmpty()) {
+        return;
+    }
+    object[prefix + "_p50"] = timings.getPercentile(50) * scale;
+    object[prefix + "_p90"] = timings.getPercentile(90) * scale;
+    object[prefix + "_p99"] = timings.getPercentile(99) * scale;
+}
+
+static QJsonObject jsonForTraffic(const NodeTraffic& traffic, float intervalSeconds) {
+    QJsonObject trafficObject;
+
+    TrafficCount totalReceived, totalSent;
+    foreach (const TrafficCount& count, traffic.received) {
+        totalReceived.packets += count.packets;
+        totalReceived.bytes += count.bytes;
+    }
+    foreach (const TrafficCount& count, traffic.sent) {
+        totalSent.packets += count.packets;
+        totalSent.bytes += count.bytes;
+    }
+    trafficObject["in_pps"] = totalReceived.packets / intervalSeconds;
+    trafficObject["in_kbps"] = totalReceived.bytes * 8 / 1000.0f / intervalSeconds;
+    trafficObject["out_pps"] = totalSent.packets / intervalSeconds;
+    trafficObject["out_kbps"] = totalSent.bytes * 8 / 1000.0f / intervalSeconds;
+
+    trafficObject["in"] = jsonForCounts(traffic.received, intervalSeconds);
+    trafficObject["out"] = jsonForCounts(traffic.sent, intervalSeconds);
+
+    const float USECS_PER_MSEC = 1000.0f;
+    addTimingPercentiles(trafficObject, "ping_ms", traffic.pingUsecs, 1.0f / USECS_PER_MSEC);
+    addTimingPercentiles(trafficObject, "queue_delay_usecs", traffic.queueDelayUsecs, 1.0f);
+
+    return trafficObject;
+}
+
+static bool busierThan(const QPair<quint64, QUuid>& first, const QPair<quint64, QUuid>& second) {
+    return first.first > second.first;
+}
+
+QJsonObject TrafficStats::takeStats(const QHash<QUuid, QSharedPointer<Node> >& nodes) {
+    // swap out each thread's counts, holding its lock only for the swap
+    NodeTrafficHash intervalTraffic;
+    {
+        QMutexLocker threadsLocker(&_threadsMutex);
+        for (QList<QWeakPointer<ThreadTraffic> >::iterator thread = _threads.begin(); thread != _threads.end(); ) {
+            ThreadTrafficPointer threadTraffic = thread->toStrongRef();
+            if (!threadTraffic) {
+                // the thread has finished (and whatever it counted since the last collection went with it)
+                thread = _threads.erase(thread);
+                continue;
+            }
+            thread++;
+            
+            NodeTrafficHash threadNodes;
+            {
+                QMutexLocker locker(&threadTraffic->mutex);
+                threadNodes.swap(threadTraffic->nodes);
+            }
+            for (NodeTrafficHash::const_iterator it = threadNodes.constBegin(); it != threadNodes.constEnd(); it++) {
+                intervalTraffic[it.key()].addAll(it.value());
+            }
+        }
+    }
+
+    const float MSECS_PER_SECOND = 1000.0f;
+    float intervalSeconds = qMax(_intervalTimer.restart(), (qint64)1) / MSECS_PER_SECOND;
+
+    // pings come too rarely for one interval's worth to say much, so they're reported over a longer history
+    for (NodeTrafficHash::iterator it = intervalTraffic.begin(); it != intervalTraffic.end(); it++) {
+        if (!it.value().pingUsecs.samples.isEmpty()) {
+            _pingHistory[it.key()].addAll(it.value().pingUsecs, MAX_PING_HISTORY_SAMPLES);
+        }
+    }
+    for (QHash<QUuid, TimingSamples>::iterator it = _pingHistory.begin(); it != _pingHistory.end(); ) {
+        if (nodes.contains(it.key())) {
+            intervalTraffic[it.key()].pingUsecs = it.value();
+            it++;
+        } else {
+            it = _pingHistory.erase(it);
+        }
+    }
+
+    // sum up the totals, and find the busiest nodes
+    NodeTraffic totalTraffic;
+    QList<QPair<quint64, QUuid> > nodesByBytes;
+    for (NodeTrafficHash::const_iterator it = intervalTraffic.constBegin(); it != intervalTraffic.constEnd(); it++) {
+        totalTraffic.addAll(it.value());
+        nodesByBytes.append(QPair<quint64, QUuid>(it.value().getTotalBytes(), it.key()));
+    }
+    std::sort(nodesByBytes.begin(), nodesByBytes.end(), busierThan);
+
+    QJsonObject statsObject;
+
+    // the totals don't include pings, whose percentiles only make sense per node
+    totalTraffic.pingUsecs = TimingSamples();
+    statsObject["all"] = jsonForTraffic(totalTraffic, intervalSeconds);
+
+    for (int i = 0; i < nodesByBytes.size() && i < MAX_TRAFFIC_STATS_NODES; i++) {
+        const QUuid& nodeUUID = nodesByBytes.at(i).second;
+        QSharedPointer<Node> node = nodes.value(nodeUUID);
+        QString nodeName = node ? NodeType::getNodeTypeName(node->getType()).toLower().replace(' ', '-') : "unknown";
+        if (!nodeUUID.isNull()) {
+            nodeName += " " + uuidStringWithoutCurlyBraces(nodeUUID);
+        }
+        statsObject[nodeName] = jsonForTraffic(intervalTraffic.value(nodeUUID), intervalSeconds);
+    }
+
+    return statsObject;
+}
+
+TrafficStats::ThreadTraffic& TrafficStats::getThreadTraffic() {
+    if (!_threadTraffic.hasLocalData()) {
+        ThreadTrafficPointer threadTraffic(new ThreadTraffic());
+        _threadTraffic.setLocalData(threadTraffic);
+
+        QMutexLocker locker(&_threadsMutex);
+        _threads.append(threadTraffic);
+    }
+    return *_threadTraffic.localData();
+}
+
+QUuid TrafficStats::senderUUIDForPacket(const QByteArray& packet) {
+    int uuidOffset = numBytesArithmeticCodingFromBuffer(packet.constData()) + sizeof(PacketVersion);
+    if (packet.size() < uuidOffset + NUM_BYTES_RFC4122_UUID) {
+        return QUuid();
+    }
+    return uuidFromRfc4122(packet.constData() + uuidOffset);
+}
@@ -0,0 +1,115 @@
+//
+//  TrafficStats.h
+//  libraries/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_TrafficStats_h
+#define hifi_TrafficStats_h
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QUuid>
+#include <QtCore/QVector>
+#include <QtCore/QWeakPointer>
+
+#include "PacketHeaders.h"
+
+class Node;
+
+/// The key under which the traffic stats are published in a node's JSON stats.
+const QString TRAFFIC_STATS_KEY = "traffic";
+
+/// The most nodes (by bytes moved) to break the traffic down for.
+const int MAX_TRAFFIC_STATS_NODES = 16;
+
+/// A count of packets and their total size.
+class TrafficCount {
+public:
+    TrafficCount() : packets(0), bytes(0) { }
+
+    quint32 packets;
+    quint64 bytes;
+};
+
+/// A bounded set of timing samples, of which we keep the most recent.
+class TimingSamples {
+public:
+    TimingSamples() : numSamples(0) { }
+
+    void add(int sample, int maxSamples);
+    void addAll(const TimingSamples& other, int maxSamples);
+
+    /// Returns the sample at the given percentile (0 to 100) of those we hold, or zero if we hold none.
+    int getPercentile(int percentile) const;
+
+    QVector<int> samples;
+    int numSamples; ///< the total ever added, so that we know where to put the next one once we're full
+};
+
+/// The traffic exchanged with one node (or with unknown senders) over one interval.
+class NodeTraffic {
+public:
+    QHash<int, TrafficCount> received; ///< by packet type
+    QHash<int, TrafficCount> sent; ///< by packet type
+    TimingSamples pingUsecs;
+    TimingSamples queueDelayUsecs;
+
+    void addAll(const NodeTraffic& other);
+    quint64 getTotalBytes() const;
+};
+
+typedef QHash<QUuid, NodeTraffic> NodeTrafficHash;
+
+/// Counts the packets and bytes exchanged with each node by packet type, along with ping times and the time packets
+/// wait in receive queues.  Each thread records into its own counters, whose lock is only ever contended when the stats
+/// are collected, so recording stays cheap enough for every packet.
+class TrafficStats {
+public:
+
+    TrafficStats();
+
+    void recordReceived(const QByteArray& packet);
+    void recordSent(const QUuid& nodeUUID, const char* packet, int size);
+    void recordPingTime(const QUuid& nodeUUID, int pingUsecs);
+    void recordQueueDelay(const QByteArray& packet, int delayUsecs);
+
+    /// Returns the rates since the last call (and the percentiles of the timings) as JSON, and starts a new interval.
+    /// \param nodes the nodes whose types and names should label their traffic
+    QJsonObject takeStats(const QHash<QUuid, QSharedPointer<Node> >& nodes);
+
+private:
+
+    class ThreadTraffic {
+    public:
+        QMutex mutex;
+        NodeTrafficHash nodes;
+    };
+
+    typedef QSharedPointer<ThreadTraffic> ThreadTrafficPointer;
+
+    /// Returns the calling thread's counters, creating them on its first call.
+    ThreadTraffic& getThreadTraffic();
+
+    static QUuid senderUUIDForPacket(const QByteArray& packet);
+
+    QThreadStorage<ThreadTrafficPointer> _threadTraffic;
+
+    QMutex _threadsMutex;
+    QList<QWeakPointer<ThreadTraffic> > _threads; ///< the thread storage owns the counts, so they go with the thread
+
+    QHash<QUuid, TimingSamples> _pingHistory; ///< ping times kept across intervals, since they're only once a second
+    QElapsedTimer _intervalTimer;
+};
+
+#endif // hifi_TrafficStats_h
@@ -0,0 +1,110 @@
+//
+//  CoverageMapV3.cpp
+//  libraries/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include "CoverageMapV3.h"
+
+/// Returns the index of the first cell of the given level: the number of cells in all the coarser levels.
+static int levelOffset(int level) {
+    return ((1 << (2 * level)) - 1) / 3;
+}
+
+CoverageMapV3::CoverageMapV3() :
+    _coveredDistances(levelOffset(MAX_LEVEL + 1), CoverageMapV2::NOT_COVERED),
+    _occludedCount(0)
+{
+}
+
+void CoverageMapV3::erase() {
+    _coveredDistances.fill(CoverageMapV2::NOT_COVERED);
+    _occludedCount = 0;
+}
+
+CoverageMapV2StorageResult CoverageMapV3::checkMap(const OctreeProjectedPolygon& polygon, bool storeIt) {
+    // the whole view is covered in front of the polygon
+    if (_coveredDistances.at(0) < polygon.getDistance()) {
+        _occludedCount++;
+        return V2_OCCLUDED;
+    }
+    if (!polygon.getAllInView()) {
+        return V2_DOESNT_FIT;
+    }
+
+    // as in CoverageMapV2, the polygon is occluded if every cell it fully covers was already covered in front of it
+    bool seenOccludedCells = false;
+    bool allOccludedCellsCovered = false;
+    recurseMap(polygon, polygon.getBoundingBox(), storeIt, 0, 0, 0, CoverageMapV2::NOT_COVERED,
+        seenOccludedCells, allOccludedCellsCovered);
+
+    if (allOccludedCellsCovered) {
+        _occludedCount++;
+        return V2_OCCLUDED;
+    }
+    return storeIt ? V2_STORED : V2_NOT_STORED;
+}
+
+void CoverageMapV3::recurseMap(const OctreeProjectedPolygon& polygon, const BoundingBox& polygonBox, bool storeIt,
+        int level, int x, int y, float inheritedDistance, bool& seenOccludedCells, bool& allOccludedCellsCovered) {
+    float cellSize = CoverageMapV2::ROOT_BOUNDING_BOX.size.x / (1 << level);
+    BoundingBox cellBox(CoverageMapV2::ROOT_BOUNDING_BOX.corner + glm::vec2(x * cellSize, y * cellSize),
+        glm::vec2(cellSize, cellSize));
+
+    // the bounding boxes rule most cells out before we test against the polygon itself
+    if (level > 0 && (cellBox.getMinX() > polygonBox.getMaxX() || cellBox.getMaxX() < polygonBox.getMinX() ||
+            cellBox.getMinY() > polygonBox.getMaxY() || cellBox.getMaxY() < polygonBox.getMinY())) {
+        return;
+    }
+    bool cellIsCoveredByPolygon = polygonBox.contains(cellBox) && polygon.occludes(cellBox);
+    if (!(cellIsCoveredByPolygon || level == 0 || polygon.intersects(cellBox))) {
+        return;
+    }
+
+    // a cell is covered wherever it or any of its ancestors is
+    int index = levelOffset(level) + y * (1 << level) + x;
+    float& cellDistance = _coveredDistances[index];
+    float coveredDistance = std::min(cellDistance, inheritedDistance);
+    bool isCoveredInFront = coveredDistance < polygon.getDistance();
+
+    if (cellIsCoveredByPolygon || isCoveredInFront) {
+        allOccludedCellsCovered = (seenOccludedCells ? allOccludedCellsCovered : true) && isCoveredInFront;
+        seenOccludedCells = true;
+        if (storeIt && cellIsCoveredByPolygon) {
+            cellDistance = std::min(cellDistance, polygon.getDistance());
+        }
+        return;
+    }
+
+    // past the finest level, like past CoverageMapV2's smallest, the polygon only partly covering a cell counts for
+    // nothing either way
+    if (level == MAX_LEVEL) {
+        return;
+    }
+    const int RIGHT_BIT = 1;
+    const int TOP_BIT = 2;
+    float furthestChildDistance = 0.0f;
+    int childOffset = levelOffset(level + 1);
+    int childRowSize = 1 << (level + 1);
+    for (int i = 0; i < CoverageMapV2::NUMBER_OF_CHILDREN; i++) {
+        int childX = x * 2 + ((i & RIGHT_BIT) ? 1 : 0);
+        int childY = y * 2 + ((i & TOP_BIT) ? 1 : 0);
+        recurseMap(polygon, polygonBox, storeIt, level + 1, childX, childY, coveredDistance,
+            seenOccludedCells, allOccludedCellsCovered);
+        float childDistance = std::min(_coveredDistances.at(childOffset + childY * childRowSize + childX),
+            coveredDistance);
+        furthestChildDistance = std::max(furthestChildDistance, childDistance);
+    }
+
+    // once all our children are covered, we're covered as far out as the furthest of them
+    if (storeIt && furthestChildDistance < cellDistance) {
+        cellDistance = furthestChildDistance;
+    }
+}
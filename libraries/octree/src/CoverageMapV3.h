@@ -0,0 +1,51 @@
+//
+//  CoverageMapV3.h
+//  libraries/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_CoverageMapV3_h
+#define hifi_CoverageMapV3_h
+
+#include <QtCore/QVector>
+
+#include "CoverageMapV2.h"
+#include "OctreeProjectedPolygon.h"
+
+/// A flat form of CoverageMapV2: the same quad tree over the view plane, recording the distance at which each cell is
+/// known to be covered, but complete to a fixed depth and laid out level by level in a single array.  It's allocated
+/// once, erased in place, and walked by index rather than by chasing pointers.  Nothing of a stored polygon is kept but
+/// the distances, so callers can project their polygons on the stack.
+class CoverageMapV3 {
+public:
+
+    /// The depth of the finest cells, which are 1/128th of the view across.
+    static const int MAX_LEVEL = 7;
+
+    CoverageMapV3();
+
+    /// Checks whether the polygon lies behind those already stored and, if asked to and it doesn't, stores it.
+    CoverageMapV2StorageResult checkMap(const OctreeProjectedPolygon& polygon, bool storeIt = true);
+
+    /// Marks every cell uncovered.
+    void erase();
+
+    /// Returns the number of polygons found occluded since the last erase.
+    int getOccludedCount() const { return _occludedCount; }
+
+private:
+
+    void recurseMap(const OctreeProjectedPolygon& polygon, const BoundingBox& polygonBox, bool storeIt,
+        int level, int x, int y, float inheritedDistance, bool& seenOccludedCells, bool& allOccludedCellsCovered);
+
+    /// Returns the distance at which each cell is covered (NOT_COVERED if it isn't), coarsest level first.
+    QVector<float> _coveredDistances;
+    int _occludedCount;
+};
+
+#endif // hifi_CoverageMapV3_h
@@ -0,0 +1,75 @@
+//
+//  JurisdictionIndex.cpp
+//  libraries/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "JurisdictionIndex.h"
+
+JurisdictionIndex::JurisdictionIndex() :
+    _levels(0)
+{
+}
+
+void JurisdictionIndex::clear() {
+    _boundaries.clear();
+    _levels = 0;
+}
+
+void JurisdictionIndex::add(int owner, const MortonKey& rootKey, const QVector<MortonKey>& endNodeKeys) {
+    addBoundary(rootKey, owner, false);
+    foreach (const MortonKey& endNodeKey, endNodeKeys) {
+        addBoundary(endNodeKey, owner, true);
+    }
+}
+
+void JurisdictionIndex::findOwners(const MortonKey& nodeKey, JurisdictionOwners& owners) const {
+    int firstOwner = owners.size();
+    JurisdictionOwners endedOwners;
+    int nodeLevel = nodeKey.getLevel();
+    for (int level = 0; level <= nodeLevel; level++) {
+        if (!(_levels & (1 << level))) {
+            continue;
+        }
+        QHash<MortonKey, QVarLengthArray<Boundary, 1> >::const_iterator boundaries =
+            _boundaries.constFind(nodeKey.getAncestor(level));
+        if (boundaries == _boundaries.constEnd()) {
+            continue;
+        }
+        for (int i = 0; i < boundaries->size(); i++) {
+            const Boundary& boundary = boundaries->at(i);
+            if (boundary.isEndNode) {
+                endedOwners.append(boundary.owner);
+
+            } else if (level < nodeLevel) {
+                owners.append(boundary.owner);
+            }
+        }
+    }
+    // an end node anywhere above us takes us out, whatever the order of the levels
+    for (int i = owners.size() - 1; i >= firstOwner; i--) {
+        for (int j = 0; j < endedOwners.size(); j++) {
+            if (owners.at(i) == endedOwners.at(j)) {
+                owners.remove(i);
+                break;
+            }
+        }
+    }
+}
+
+bool JurisdictionIndex::contains(const MortonKey& nodeKey) const {
+    JurisdictionOwners owners;
+    findOwners(nodeKey, owners);
+    return !owners.isEmpty();
+}
+
+void JurisdictionIndex::addBoundary(const MortonKey& key, int owner, bool isEndNode) {
+    Boundary boundary = { owner, isEndNode };
+    _boundaries[key].append(boundary);
+    _levels |= (1 << key.getLevel());
+}
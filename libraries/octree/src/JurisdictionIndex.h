@@ -0,0 +1,61 @@
+//
+//  JurisdictionIndex.h
+//  libraries/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_JurisdictionIndex_h
+#define hifi_JurisdictionIndex_h
+
+#include <QtCore/QHash>
+#include <QtCore/QVarLengthArray>
+#include <QtCore/QVector>
+
+#include <MortonKey.h>
+
+/// The owners a node lies within: seldom more than one, so kept on the stack.
+typedef QVarLengthArray<int, 4> JurisdictionOwners;
+
+/// A prefix table over any number of jurisdictions, each tagged with an owner.  As JurisdictionMap has it, a node lies
+/// within a jurisdiction if it's below the root (the root itself counts as above), and isn't one of the end nodes or
+/// below one.  The roots and end nodes are hashed by key, so that finding the jurisdictions a node lies within is a
+/// lookup of each of its ancestors--and only at the levels where some root or end node lies, which are seldom more than
+/// two or three--however many end nodes there are.
+class JurisdictionIndex {
+public:
+
+    JurisdictionIndex();
+
+    void clear();
+
+    bool isEmpty() const { return _boundaries.isEmpty(); }
+
+    /// Adds a jurisdiction.
+    void add(int owner, const MortonKey& rootKey, const QVector<MortonKey>& endNodeKeys);
+
+    /// Appends the owners of the jurisdictions the node lies within.
+    void findOwners(const MortonKey& nodeKey, JurisdictionOwners& owners) const;
+
+    /// Checks whether the node lies within any of the jurisdictions.
+    bool contains(const MortonKey& nodeKey) const;
+
+private:
+
+    class Boundary {
+    public:
+        int owner;
+        bool isEndNode;
+    };
+
+    void addBoundary(const MortonKey& key, int owner, bool isEndNode);
+
+    QHash<MortonKey, QVarLengthArray<Boundary, 1> > _boundaries;
+    quint32 _levels; ///< bit n is set if a root or end node lies at level n
+};
+
+#endif // hifi_JurisdictionIndex_h
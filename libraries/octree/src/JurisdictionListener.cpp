@@ -40,9 +40,14 @@ bool JurisdictionListener::queueJurisdictionRequest() {
 
     NodeList* nodeList = NodeList::getInstance();
     
+    bool isQueueFull = false;
     foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
         if (node->getType() == getNodeType() && node->getActiveSocket()) {
-            _packetSender.queuePacketForSending(node, QByteArray(reinterpret_cast<char*>(bufferOut), sizeOut));
+            // if the queue's full, the rest of the servers wait for the next round of requests
+            if (!isQueueFull && !_packetSender.queuePacketForSending(node,
+                    QByteArray(reinterpret_cast<char*>(bufferOut), sizeOut))) {
+                isQueueFull = true;
+            }
             nodeCount++;
         }
     }
@@ -18,7 +18,9 @@
 #include <OctalCode.h>
 
 #include "JurisdictionMap.h"
+#include "OctreeElement.h"
 
+QAtomicInt JurisdictionMap::_nextRevision;
 
 // standard assignment
 // copy assignment 
@@ -29,10 +31,11 @@ JurisdictionMap& JurisdictionMap::operator=(const JurisdictionMap& other) {
 
 #ifdef HAS_MOVE_SEMANTICS
 // Move constructor
-JurisdictionMap::JurisdictionMap(JurisdictionMap&& other) : _rootOctalCode(NULL) {
+JurisdictionMap::JurisdictionMap(JurisdictionMap&& other) : _rootOctalCode(NULL), _hasKeys(false) {
     init(other._rootOctalCode, other._endNodes);
     other._rootOctalCode = NULL;
     other._endNodes.clear();
+    other.updateKeys();
 }
 
 // move assignment
@@ -40,12 +43,13 @@ JurisdictionMap& JurisdictionMap::operator=(JurisdictionMap&& other) {
     init(other._rootOctalCode, other._endNodes);
     other._rootOctalCode = NULL;
     other._endNodes.clear();
+    other.updateKeys();
     return *this;
 }
 #endif
 
 // Copy constructor
-JurisdictionMap::JurisdictionMap(const JurisdictionMap& other) : _rootOctalCode(NULL) {
+JurisdictionMap::JurisdictionMap(const JurisdictionMap& other) : _rootOctalCode(NULL), _hasKeys(false) {
     copyContents(other);
 }
 
@@ -93,9 +97,10 @@ void JurisdictionMap::clear() {
         }
     }
     _endNodes.clear();
+    updateKeys();
 }
 
-JurisdictionMap::JurisdictionMap(NodeType_t type) : _rootOctalCode(NULL) {
+JurisdictionMap::JurisdictionMap(NodeType_t type) : _rootOctalCode(NULL), _hasKeys(false) {
     _nodeType = type;
     unsigned char* rootCode = new unsigned char[1];
     *rootCode = 0;
@@ -104,13 +109,13 @@ JurisdictionMap::JurisdictionMap(NodeType_t type) : _rootOctalCode(NULL) {
     init(rootCode, emptyEndNodes);
 }
 
-JurisdictionMap::JurisdictionMap(const char* filename) : _rootOctalCode(NULL) {
+JurisdictionMap::JurisdictionMap(const char* filename) : _rootOctalCode(NULL), _hasKeys(false) {
     clear(); // clean up our own memory
     readFromFile(filename);
 }
 
 JurisdictionMap::JurisdictionMap(unsigned char* rootOctalCode, const std::vector<unsigned char*>& endNodes)  
-    : _rootOctalCode(NULL) {
+    : _rootOctalCode(NULL), _hasKeys(false) {
     init(rootOctalCode, endNodes);
 }
 
@@ -146,7 +151,7 @@ void myDebugPrintOctalCode(const unsigned char* octalCode, bool withNewLine) {
 }
 
 
-JurisdictionMap::JurisdictionMap(const char* rootHexCode, const char* endNodesHexCodes) {
+JurisdictionMap::JurisdictionMap(const char* rootHexCode, const char* endNodesHexCodes) : _hasKeys(false) {
 
     qDebug("JurisdictionMap::JurisdictionMap(const char* rootHexCode=[%p] %s, const char* endNodesHexCodes=[%p] %s)",
         rootHexCode, rootHexCode, endNodesHexCodes, endNodesHexCodes);
@@ -175,6 +180,7 @@ JurisdictionMap::JurisdictionMap(const char* rootHexCode, const char* endNodesHe
         myDebugPrintOctalCode(endNodeOctcode, true);
 
     }    
+    updateKeys();
 }
 
 
@@ -182,9 +188,47 @@ void JurisdictionMap::init(unsigned char* rootOctalCode, const std::vector<unsig
     clear(); // clean up our own memory
     _rootOctalCode = rootOctalCode;
     _endNodes = endNodes;
+    updateKeys();
+}
+
+void JurisdictionMap::updateKeys() {
+    _endNodeKeys.clear();
+    _index.clear();
+    _rootKey = MortonKey(_rootOctalCode);
+    _hasKeys = _rootOctalCode && _rootKey.isValid();
+    for (size_t i = 0; _hasKeys && i < _endNodes.size(); i++) {
+        // a code that failed to parse is under nothing, so it has no key
+        if (_endNodes[i]) {
+            MortonKey endNodeKey(_endNodes[i]);
+            _hasKeys = endNodeKey.isValid();
+            _endNodeKeys.append(endNodeKey);
+        }
+    }
+    if (_hasKeys) {
+        _index.add(0, _rootKey, _endNodeKeys);
+    }
+    _revision = _nextRevision.fetchAndAddRelaxed(1) + 1;
+}
+
+JurisdictionMap::Area JurisdictionMap::isMyJurisdiction(const OctreeElement* element, int childIndex) const {
+    return isMyJurisdiction(element->getMortonKey(), element->getOctalCode(), childIndex);
 }
 
 JurisdictionMap::Area JurisdictionMap::isMyJurisdiction(const unsigned char* nodeOctalCode, int childIndex) const {
+    return isMyJurisdiction(_hasKeys ? MortonKey(nodeOctalCode) : MortonKey::invalid(), nodeOctalCode, childIndex);
+}
+
+JurisdictionMap::Area JurisdictionMap::isMyJurisdiction(const MortonKey& nodeKey, const unsigned char* nodeOctalCode,
+                                                        int childIndex) const {
+    if (_hasKeys && nodeKey.isValid()) {
+        if (nodeKey.isAncestorOf(_rootKey)) {
+            return ABOVE;
+        }
+        // now that the node isn't above the root, the root is above the node's child just when it's above the
+        // node, so the child needn't be looked up on its own
+        return _index.contains(nodeKey) ? WITHIN : BELOW;
+    }
+
     // to be in our jurisdiction, we must be under the root...
 
     // if the node is an ancestor of my root, then we return ABOVE
@@ -231,6 +275,7 @@ bool JurisdictionMap::readFromFile(const char* filename) {
         _endNodes.push_back(octcode);
     }
     settings.endGroup();
+    updateKeys();
     return true;
 }
 
@@ -372,5 +417,6 @@ int JurisdictionMap::unpackFromMessage(const unsigned char* sourceBuffer, int av
         }
     }
     
+    updateKeys();
     return sourceBuffer - startPosition; // includes header!
 }
@@ -17,10 +17,17 @@
 #include <vector>
 
 #include <QtCore/QString>
+#include <QtCore/QAtomicInt>
 #include <QtCore/QUuid>
+#include <QtCore/QVector>
 
+#include <MortonKey.h>
 #include <Node.h>
 
+#include "JurisdictionIndex.h"
+
+class OctreeElement;
+
 class JurisdictionMap {
 public:
     enum Area {
@@ -49,6 +56,9 @@ public:
     ~JurisdictionMap();
 
     Area isMyJurisdiction(const unsigned char* nodeOctalCode, int childIndex) const;
+    
+    /// Like the octal code version, but goes by the element's key when it can.
+    Area isMyJurisdiction(const OctreeElement* element, int childIndex) const;
 
     bool writeToFile(const char* filename);
     bool readFromFile(const char* filename);
@@ -57,6 +67,15 @@ public:
     unsigned char* getEndNodeOctalCode(int index) const { return _endNodes[index]; }
     int getEndNodeCount() const { return _endNodes.size(); }
 
+    /// Checks whether the root and end nodes all have keys, which they do unless they're too deep.
+    bool hasKeys() const { return _hasKeys; }
+    const MortonKey& getRootKey() const { return _rootKey; }
+    const QVector<MortonKey>& getEndNodeKeys() const { return _endNodeKeys; }
+
+    /// Returns a number, unique among maps, that changes whenever the contents of this map change, so that those who
+    /// index a set of maps know when to rebuild.
+    int getRevision() const { return _revision; }
+
     void copyContents(unsigned char* rootCodeIn, const std::vector<unsigned char*>& endNodesIn);
 
     int unpackFromMessage(const unsigned char* sourceBuffer, int availableBytes);
@@ -74,10 +93,24 @@ private:
     void copyContents(const JurisdictionMap& other); // use assignment instead
     void clear();
     void init(unsigned char* rootOctalCode, const std::vector<unsigned char*>& endNodes);
+    
+    /// Recomputes the keys from the octal codes, which must be done whenever they change.
+    void updateKeys();
+    
+    Area isMyJurisdiction(const MortonKey& nodeKey, const unsigned char* nodeOctalCode, int childIndex) const;
 
     unsigned char* _rootOctalCode;
     std::vector<unsigned char*> _endNodes;
     NodeType_t _nodeType;
+    
+    /// The codes as keys, which the checks use when they're all valid (and the node's is).
+    bool _hasKeys;
+    MortonKey _rootKey;
+    QVector<MortonKey> _endNodeKeys;
+    JurisdictionIndex _index;
+    int _revision;
+
+    static QAtomicInt _nextRevision;
 };
 
 /// Map between node IDs and their reported JurisdictionMap. Typically used by classes that need to know which nodes are 
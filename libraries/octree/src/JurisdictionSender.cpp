@@ -60,13 +60,17 @@ bool JurisdictionSender::process() {
         while (!_nodesRequestingJurisdictions.empty()) {
 
             QUuid nodeUUID = _nodesRequestingJurisdictions.front();
-            _nodesRequestingJurisdictions.pop();
             SharedNodePointer node = NodeList::getInstance()->nodeWithUUID(nodeUUID);
 
             if (node && node->getActiveSocket()) {
-                _packetSender.queuePacketForSending(node, QByteArray(reinterpret_cast<char *>(bufferOut), sizeOut));
+                if (!_packetSender.queuePacketForSending(node,
+                        QByteArray(reinterpret_cast<char *>(bufferOut), sizeOut))) {
+                    // the queue's full: the rest of the requests wait their turn until it's drained some
+                    break;
+                }
                 nodeCount++;
             }
+            _nodesRequestingJurisdictions.pop();
         }
         unlockRequestingNodes();
 
@@ -37,6 +37,9 @@ public:
     NodeType_t getNodeType() const { return _nodeType; }
     void setNodeType(NodeType_t type) { _nodeType = type; }
 
+    /// The sender of our replies, for its queue's stats.
+    PacketSender& getPacketSender() { return _packetSender; }
+
 protected:
     virtual void processPacket(const SharedNodePointer& sendingNode, const QByteArray& packet);
 
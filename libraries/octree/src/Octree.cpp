@@ -13,6 +13,7 @@
 #define _USE_MATH_DEFINES
 #endif
 
+#include <cfloat>
 #include <cstring>
 #include <cstdio>
 #include <cmath>
@@ -20,7 +21,7 @@
 
 #include <QDebug>
 
-#include "CoverageMap.h"
+#include "CoverageMapV3.h"
 #include <GeometryUtil.h>
 #include "OctalCode.h"
 #include <PacketHeaders.h>
@@ -29,6 +30,7 @@
 //#include "Tags.h"
 
 #include "ViewFrustum.h"
+#include "OctreeChangeJournal.h"
 #include "OctreeConstants.h"
 #include "OctreeElementBag.h"
 #include "Octree.h"
@@ -41,18 +43,28 @@ Octree::Octree(bool shouldReaverage) :
     _rootNode(NULL),
     _isDirty(true),
     _shouldReaverage(shouldReaverage),
+    _defersReaveraging(false),
     _stopImport(false),
     _lock(),
+    _changeJournal(NULL),
     _isViewing(false) 
 {
 }
 
 Octree::~Octree() {
+    delete _changeJournal;
+
     // delete the children of the root node
     // this recursively deletes the tree
     delete _rootNode;
 }
 
+void Octree::enableChangeJournal(int maxEntries) {
+    if (!_changeJournal) {
+        _changeJournal = new OctreeChangeJournal(maxEntries);
+    }
+}
+
 // Recurses voxel tree calling the RecurseOctreeOperation function for each node.
 // stops recursion if operation function returns false.
 void Octree::recurseTreeWithOperation(RecurseOctreeOperation operation, void* extraData) {
@@ -155,6 +167,27 @@ OctreeElement* Octree::nodeForOctalCode(OctreeElement* ancestorNode,
         return _rootNode;
     }
 
+    // with a key, the walk down is a shift per level rather than a decode of the code's bytes
+    MortonKey needleKey(needleCode);
+    if (needleKey.isValid()) {
+        int needleLength = needleKey.getLevel();
+        OctreeElement* node = ancestorNode;
+        while (node->getOctalCodeLength() < needleLength) {
+            OctreeElement* childNode = node->getChildAtIndex(node->getMortonKey().getBranchIndexToward(needleKey));
+            if (!childNode) {
+                break;
+            }
+            if (childNode->getOctalCodeLength() == needleLength) {
+                if (parentOfFoundNode) {
+                    *parentOfFoundNode = node;
+                }
+                return childNode;
+            }
+            node = childNode;
+        }
+        return node;
+    }
+
     // find the appropriate branch index based on this ancestorNode
     if (*needleCode > 0) {
         int branchForNeedle = branchIndexWithDescendant(ancestorNode->getOctalCode(), needleCode);
@@ -185,21 +218,27 @@ OctreeElement* Octree::nodeForOctalCode(OctreeElement* ancestorNode,
 
 // returns the node created!
 OctreeElement* Octree::createMissingNode(OctreeElement* lastParentNode, const unsigned char* codeToReach) {
-    int indexOfNewChild = branchIndexWithDescendant(lastParentNode->getOctalCode(), codeToReach);
-    // If this parent node is a leaf, then you know the child path doesn't exist, so deal with
-    // breaking up the leaf first, which will also create a child path
-    if (lastParentNode->requiresSplit()) {
-        lastParentNode->splitChildren();
-    } else if (!lastParentNode->getChildAtIndex(indexOfNewChild)) {
-        // we could be coming down a branch that was already created, so don't stomp on it.
-        lastParentNode->addChildAtIndex(indexOfNewChild);
-    }
-
-    // This works because we know we traversed down the same tree so if the length is the same, then the whole code is the same
-    if (*lastParentNode->getChildAtIndex(indexOfNewChild)->getOctalCode() == *codeToReach) {
-        return lastParentNode->getChildAtIndex(indexOfNewChild);
-    } else {
-        return createMissingNode(lastParentNode->getChildAtIndex(indexOfNewChild), codeToReach);
+    MortonKey keyToReach(codeToReach);
+    int lengthToReach = numberOfThreeBitSectionsInCode(codeToReach);
+    OctreeElement* node = lastParentNode;
+    while (true) {
+        int indexOfNewChild = node->getBranchIndexToward(keyToReach, codeToReach);
+        // If this parent node is a leaf, then you know the child path doesn't exist, so deal with
+        // breaking up the leaf first, which will also create a child path
+        if (node->requiresSplit()) {
+            node->splitChildren();
+        } else if (!node->getChildAtIndex(indexOfNewChild)) {
+            // we could be coming down a branch that was already created, so don't stomp on it.
+            node->addChildAtIndex(indexOfNewChild);
+        }
+
+        // This works because we know we traversed down the same tree so if the length is the same, then the whole
+        // code is the same
+        OctreeElement* childNode = node->getChildAtIndex(indexOfNewChild);
+        if (childNode->getOctalCodeLength() == lengthToReach) {
+            return childNode;
+        }
+        node = childNode;
     }
 }
 
@@ -339,6 +378,7 @@ class DeleteOctalCodeFromTreeArgs {
 public:
     bool collapseEmptyTrees;
     const unsigned char* codeBuffer;
+    MortonKey key;
     int lengthOfCode;
     bool deleteLastChild;
     bool pathChanged;
@@ -352,6 +392,7 @@ void Octree::deleteOctalCodeFromTree(const unsigned char* codeBuffer, bool colla
     DeleteOctalCodeFromTreeArgs args;
     args.collapseEmptyTrees = collapseEmptyTrees;
     args.codeBuffer         = codeBuffer;
+    args.key                = MortonKey(codeBuffer);
     args.lengthOfCode       = numberOfThreeBitSectionsInCode(codeBuffer);
     args.deleteLastChild    = false;
     args.pathChanged        = false;
@@ -364,7 +405,7 @@ void Octree::deleteOctalCodeFromTree(const unsigned char* codeBuffer, bool colla
 void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraData) {
     DeleteOctalCodeFromTreeArgs* args = (DeleteOctalCodeFromTreeArgs*)extraData;
 
-    int lengthOfNodeCode = numberOfThreeBitSectionsInCode(node->getOctalCode());
+    int lengthOfNodeCode = node->getOctalCodeLength();
 
     // Since we traverse the tree in code order, we know that if our code
     // matches, then we've reached  our target node.
@@ -376,8 +417,11 @@ void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraDa
         return;
     }
 
+    // reaching into a packed subtree means turning it back into elements first
+    node->unpackChildren();
+
     // Ok, we know we haven't reached our target node yet, so keep looking
-    int childIndex = branchIndexWithDescendant(node->getOctalCode(), args->codeBuffer);
+    int childIndex = node->getBranchIndexToward(args->key, args->codeBuffer);
     OctreeElement* childNode = node->getChildAtIndex(childIndex);
 
     // If there is no child at the target location, and the current parent node is a colored leaf,
@@ -387,12 +431,12 @@ void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraDa
         // we need to break up ancestors until we get to the right level
         OctreeElement* ancestorNode = node;
         while (true) {
-            int index = branchIndexWithDescendant(ancestorNode->getOctalCode(), args->codeBuffer);
+            int index = ancestorNode->getBranchIndexToward(args->key, args->codeBuffer);
 
             // we end up with all the children, even the one we want to delete
             ancestorNode->splitChildren();
 
-            int lengthOfAncestorNode = numberOfThreeBitSectionsInCode(ancestorNode->getOctalCode());
+            int lengthOfAncestorNode = ancestorNode->getOctalCodeLength();
 
             // If we've reached the parent of the target, then stop breaking up children
             if (lengthOfAncestorNode == (args->lengthOfCode - 1)) {
@@ -525,6 +569,30 @@ void Octree::reaverageOctreeElements(OctreeElement* startNode) {
     }
 }
 
+/// Reaverages the stale elements below and including the given one, deepest first, journaling each (if there's a
+/// journal) so that senders that sent it with its old average send it again.
+static void reaverageStaleElements(OctreeElement* element, OctreeChangeJournal* changeJournal) {
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        OctreeElement* child = element->getChildAtIndex(i);
+        if (child && child->isAverageStale()) {
+            reaverageStaleElements(child, changeJournal);
+        }
+    }
+    element->calculateAverageFromChildren();
+    element->clearAverageStaleBit();
+    if (changeJournal) {
+        changeJournal->subtreeChanged(element);
+    }
+}
+
+void Octree::reaverageChangedElements() {
+    // a change marks every element on the path down to it, so an element that isn't stale has nothing stale below
+    if (_rootNode->isAverageStale()) {
+        reaverageStaleElements(_rootNode, _changeJournal);
+        _isDirty = true;
+    }
+}
+
 OctreeElement* Octree::getOctreeElementAt(float x, float y, float z, float s) const {
     unsigned char* octalCode = pointToOctalCode(x,y,z,s);
     OctreeElement* node = nodeForOctalCode(_rootNode, octalCode, NULL);
@@ -546,42 +614,158 @@ OctreeElement* Octree::getOrCreateChildElementAt(float x, float y, float z, floa
 }
 
 
-// combines the ray cast arguments into a single object
-class RayArgs {
+OctreeRayCast::OctreeRayCast(const glm::vec3& origin, const glm::vec3& direction) :
+    origin(origin),
+    direction(direction),
+    intersects(false),
+    element(NULL),
+    distance(0.0f),
+    face(MIN_X_FACE)
+{
+}
+
+/// The state of a ray cast through the tree, in tree units.
+class RayTraversal {
 public:
     glm::vec3 origin;
     glm::vec3 direction;
-    OctreeElement*& node;
-    float& distance;
-    BoxFace& face;
+    glm::vec3 inverseDirection;
+    OctreeElement* element;
+    float distance;
+    BoxFace face;
     bool found;
 };
 
-bool findRayIntersectionOp(OctreeElement* node, void* extraData) {
-    RayArgs* args = static_cast<RayArgs*>(extraData);
-    AABox box = node->getAABox();
-    float distance;
-    BoxFace face;
-    if (!box.findRayIntersection(args->origin, args->direction, distance, face)) {
-        return false;
+/// Finds the distances along the ray at which it enters and leaves the box (the slab test).
+/// \param entryAxis set to the axis whose face the ray enters through
+static bool findRayEntryAndExit(const RayTraversal& ray, const AABox& box, float& entry, float& exit, int& entryAxis) {
+    entry = -FLT_MAX;
+    exit = FLT_MAX;
+    entryAxis = 0;
+    const glm::vec3& corner = box.getCorner();
+    float scale = box.getScale();
+    for (int i = 0; i < 3; i++) {
+        if (ray.direction[i] == 0.0f) {
+            // parallel to the slab, so either always within it or never
+            if (ray.origin[i] < corner[i] || ray.origin[i] > corner[i] + scale) {
+                return false;
+            }
+            continue;
+        }
+        float slabEntry = (corner[i] - ray.origin[i]) * ray.inverseDirection[i];
+        float slabExit = (corner[i] + scale - ray.origin[i]) * ray.inverseDirection[i];
+        if (slabEntry > slabExit) {
+            qSwap(slabEntry, slabExit);
+        }
+        if (slabEntry > entry) {
+            entry = slabEntry;
+            entryAxis = i;
+        }
+        exit = qMin(exit, slabExit);
     }
-    if (!node->isLeaf()) {
-        return true; // recurse on children
+    return entry <= exit && exit >= 0.0f;
+}
+
+static BoxFace faceForEntryAxis(const RayTraversal& ray, int entryAxis) {
+    const BoxFace MIN_FACES[] = { MIN_X_FACE, MIN_Y_FACE, MIN_Z_FACE };
+    const BoxFace MAX_FACES[] = { MAX_X_FACE, MAX_Y_FACE, MAX_Z_FACE };
+    return ray.direction[entryAxis] > 0.0f ? MIN_FACES[entryAxis] : MAX_FACES[entryAxis];
+}
+
+/// Visits the children the ray passes through nearest first, and stops as soon as what it has hit is nearer than the
+/// next child's entry, since nothing in that child (or any after it) can be nearer.  The caller has checked that the
+/// ray passes through the element, entering at the given distance.
+static void findRayIntersectionRecursion(OctreeElement* element, float entry, int entryAxis, RayTraversal& ray,
+                                         int recursionCount = 0) {
+    if (element->isLeaf()) {
+        if (element->hasContent()) {
+            ray.element = element;
+            ray.distance = qMax(entry, 0.0f);
+            ray.face = faceForEntryAxis(ray, entryAxis);
+            ray.found = true;
+        }
+        return;
     }
-    distance *= TREE_SCALE;
-    if (node->hasContent() && (!args->found || distance < args->distance)) {
-        args->node = node;
-        args->distance = distance;
-        args->face = face;
-        args->found = true;
+    if (recursionCount > DANGEROUSLY_DEEP_RECURSION) {
+        qDebug() << "findRayIntersectionRecursion() reached DANGEROUSLY_DEEP_RECURSION, bailing!";
+        return;
     }
-    return false;
+
+    // insertion sort the children we pass through by where we enter them; there are at most eight
+    OctreeElement* children[NUMBER_OF_CHILDREN];
+    float childEntries[NUMBER_OF_CHILDREN];
+    int childEntryAxes[NUMBER_OF_CHILDREN];
+    int numChildren = 0;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        OctreeElement* child = element->getChildAtIndex(i);
+        float childEntry, childExit;
+        int childEntryAxis;
+        if (!child || !findRayEntryAndExit(ray, child->getAABox(), childEntry, childExit, childEntryAxis)) {
+            continue;
+        }
+        int index = numChildren++;
+        for (; index > 0 && childEntries[index - 1] > childEntry; index--) {
+            children[index] = children[index - 1];
+            childEntries[index] = childEntries[index - 1];
+            childEntryAxes[index] = childEntryAxes[index - 1];
+        }
+        children[index] = child;
+        childEntries[index] = childEntry;
+        childEntryAxes[index] = childEntryAxis;
+    }
+    for (int i = 0; i < numChildren; i++) {
+        if (ray.found && childEntries[i] >= ray.distance) {
+            return;
+        }
+        findRayIntersectionRecursion(children[i], childEntries[i], childEntryAxes[i], ray, recursionCount + 1);
+    }
+}
+
+static bool findRayIntersectionInTree(OctreeElement* root, const glm::vec3& origin, const glm::vec3& direction,
+                                      OctreeElement*& element, float& distance, BoxFace& face) {
+    RayTraversal ray;
+    ray.origin = origin / (float)TREE_SCALE;
+    ray.direction = direction;
+    ray.inverseDirection = glm::vec3(1.0f) / direction;
+    ray.element = NULL;
+    ray.found = false;
+
+    float entry, exit;
+    int entryAxis;
+    if (root && findRayEntryAndExit(ray, root->getAABox(), entry, exit, entryAxis)) {
+        findRayIntersectionRecursion(root, entry, entryAxis, ray);
+    }
+    if (ray.found) {
+        element = ray.element;
+        distance = ray.distance * TREE_SCALE;
+        face = ray.face;
+    }
+    return ray.found;
 }
 
 bool Octree::findRayIntersection(const glm::vec3& origin, const glm::vec3& direction,
                                     OctreeElement*& node, float& distance, BoxFace& face, Octree::lockType lockType) {
-    RayArgs args = { origin / (float)(TREE_SCALE), direction, node, distance, face };
+    bool gotLock = false;
+    if (lockType == Octree::Lock) {
+        lockForRead();
+        gotLock = true;
+    } else if (lockType == Octree::TryLock) {
+        gotLock = tryLockForRead();
+        if (!gotLock) {
+            return false; // if we wanted to tryLock, and we couldn't then just bail...
+        }
+    }
+
+    bool found = findRayIntersectionInTree(_rootNode, origin, direction, node, distance, face);
+
+    if (gotLock) {
+        unlock();
+    }
 
+    return found;
+}
+
+int Octree::findRayIntersections(QVector<OctreeRayCast>& rays, Octree::lockType lockType) {
     bool gotLock = false;
     if (lockType == Octree::Lock) {
         lockForRead();
@@ -589,17 +773,28 @@ bool Octree::findRayIntersection(const glm::vec3& origin, const glm::vec3& direc
     } else if (lockType == Octree::TryLock) {
         gotLock = tryLockForRead();
         if (!gotLock) {
-            return args.found; // if we wanted to tryLock, and we couldn't then just bail...
+            for (int i = 0; i < rays.size(); i++) {
+                rays[i].intersects = false;
+            }
+            return 0;
         }
     }
 
-    recurseTreeWithOperation(findRayIntersectionOp, &args);
+    int numIntersecting = 0;
+    for (int i = 0; i < rays.size(); i++) {
+        OctreeRayCast& ray = rays[i];
+        ray.intersects = findRayIntersectionInTree(_rootNode, ray.origin, ray.direction, ray.element, ray.distance,
+            ray.face);
+        if (ray.intersects) {
+            numIntersecting++;
+        }
+    }
 
     if (gotLock) {
         unlock();
     }
 
-    return args.found;
+    return numIntersecting;
 }
 
 class SphereArgs {
@@ -894,7 +1089,7 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
     if (params.jurisdictionMap) {
         // here's how it works... if we're currently above our root jurisdiction, then we proceed normally.
         // but once we're in our own jurisdiction, then we need to make sure we're not below it.
-        if (JurisdictionMap::BELOW == params.jurisdictionMap->isMyJurisdiction(node->getOctalCode(), CHECK_NODE_ONLY)) {
+        if (JurisdictionMap::BELOW == params.jurisdictionMap->isMyJurisdiction(node, CHECK_NODE_ONLY)) {
             params.stopReason = EncodeBitstreamParams::OUT_OF_JURISDICTION;
             return bytesAtThisLevel;
         }
@@ -943,7 +1138,7 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
             ViewFrustum::location location = node->inFrustum(*params.lastViewFrustum);
 
             // If we're a leaf, then either intersect or inside is considered "formerly in view"
-            if (node->isLeaf()) {
+            if (node->isLeaf() && !node->hasPackedChildren()) {
                 wasInView = location != ViewFrustum::OUTSIDE;
             } else {
                 wasInView = location == ViewFrustum::INSIDE;
@@ -976,9 +1171,10 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
         }
 
         // If we're not in delta sending mode, and we weren't asked to do a force send, and the voxel hasn't changed,
-        // then we can also bail early and save bits
-        if (!params.forceSendScene && !params.deltaViewFrustum &&
-            !node->hasChangedSince(params.lastViewFrustumSent - CHANGE_FUDGE)) {
+        // then we can also bail early and save bits. A change set, where we have one, tells us exactly what changed.
+        if (!params.forceSendScene && !params.deltaViewFrustum && !(params.changes
+                ? params.changes->contains(node->getMortonKey())
+                : node->hasChangedSince(params.lastViewFrustumSent - CHANGE_FUDGE))) {
             if (params.stats) {
                 params.stats->skippedNoChange(node);
             }
@@ -988,31 +1184,39 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
 
         // If the user also asked for occlusion culling, check if this node is occluded, but only if it's not a leaf.
         // leaf occlusion is handled down below when we check child nodes
-        if (params.wantOcclusionCulling && !node->isLeaf()) {
+        if (params.wantOcclusionCulling && (!node->isLeaf() || node->hasPackedChildren())) {
             AABox voxelBox = node->getAABox();
             voxelBox.scale(TREE_SCALE);
-            OctreeProjectedPolygon* voxelPolygon = new OctreeProjectedPolygon(params.viewFrustum->getProjectedPolygon(voxelBox));
+            OctreeProjectedPolygon voxelPolygon = params.viewFrustum->getProjectedPolygon(voxelBox);
 
             // In order to check occlusion culling, the shadow has to be "all in view" otherwise, we will ignore occlusion
             // culling and proceed as normal
-            if (voxelPolygon->getAllInView()) {
-                CoverageMapStorageResult result = params.map->checkMap(voxelPolygon, false);
-                delete voxelPolygon; // cleanup
-                if (result == OCCLUDED) {
+            if (voxelPolygon.getAllInView()) {
+                CoverageMapV2StorageResult result = params.map->checkMap(voxelPolygon, false);
+                if (result == V2_OCCLUDED) {
                     if (params.stats) {
                         params.stats->skippedOccluded(node);
                     }
                     params.stopReason = EncodeBitstreamParams::OCCLUDED;
                     return bytesAtThisLevel;
                 }
-            } else {
-                // If this shadow wasn't "all in view" then we ignored it for occlusion culling, but
-                // we do need to clean up memory and proceed as normal...
-                delete voxelPolygon;
             }
         }
     }
 
+    // a packed subtree writes all of its levels itself, and goes in the bag as a whole if they don't fit
+    if (node->hasPackedChildren()) {
+        bytesAtThisLevel = node->appendPackedChildren(packetData, params, currentEncodeLevel, nodeLocationThisView);
+        if (!bytesAtThisLevel) {
+            bag.insert(node);
+            if (params.stats) {
+                params.stats->didntFit(node);
+            }
+            params.stopReason = EncodeBitstreamParams::DIDNT_FIT;
+        }
+        return bytesAtThisLevel;
+    }
+
     bool keepDiggingDeeper = true; // Assuming we're in view we have a great work ethic, we're always ready for more!
 
     // At any given point in writing the bitstream, the largest minimum we might need to flesh out the current level
@@ -1036,6 +1240,17 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
     int indexOfChildren[NUMBER_OF_CHILDREN] = { 0, 0, 0, 0, 0, 0, 0, 0 };
     int currentCount = 0;
 
+    // classify all of the children against the view frustum (and the last one, in delta mode) in one go, rather than
+    // testing each child's box against each frustum on its own
+    ViewFrustum::ChildLocations childLocationsThisView;
+    ViewFrustum::ChildLocations childLocationsLastView;
+    if (params.viewFrustum) {
+        node->childrenInFrustum(*params.viewFrustum, childLocationsThisView);
+    }
+    if (params.deltaViewFrustum && params.lastViewFrustum) {
+        node->childrenInFrustum(*params.lastViewFrustum, childLocationsLastView);
+    }
+
     for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
         OctreeElement* childNode = node->getChildAtIndex(i);
 
@@ -1044,7 +1259,7 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
         // even if they don't in our local tree
         bool notMyJurisdiction = false;
         if (params.jurisdictionMap) {
-            notMyJurisdiction = (JurisdictionMap::WITHIN != params.jurisdictionMap->isMyJurisdiction(node->getOctalCode(), i));
+            notMyJurisdiction = (JurisdictionMap::WITHIN != params.jurisdictionMap->isMyJurisdiction(node, i));
         }
         if (params.includeExistsBits) {
             // If the child is known to exist, OR, it's not my jurisdiction, then we mark the bit as existing
@@ -1055,7 +1270,7 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
 
         if (params.wantOcclusionCulling) {
             if (childNode) {
-                float distance = params.viewFrustum ? childNode->distanceToCamera(*params.viewFrustum) : 0;
+                float distance = params.viewFrustum ? childLocationsThisView.distances[i] : 0;
 
                 currentCount = insertIntoSortedArrays((void*)childNode, distance, i,
                                                       (void**)&sortedChildren, (float*)&distancesToChildren,
@@ -1084,7 +1299,8 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
         bool childIsInView  = (childNode && 
                 ( !params.viewFrustum || // no view frustum was given, everything is assumed in view
                   (nodeLocationThisView == ViewFrustum::INSIDE) || // the parent was fully in view, we can assume ALL children are
-                  (nodeLocationThisView == ViewFrustum::INTERSECT && childNode->isInView(*params.viewFrustum)) // the parent intersects and the child is in view
+                  (nodeLocationThisView == ViewFrustum::INTERSECT &&
+                    childLocationsThisView.getLocation(originalIndex) != ViewFrustum::OUTSIDE) // the child is in view
                 ));
 
         if (!childIsInView) {
@@ -1109,8 +1325,8 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
 
                 // track children in view as existing and not a leaf, if they're a leaf,
                 // we don't care about recursing deeper on them, and we don't consider their
-                // subtree to exist
-                if (!(childNode && childNode->isLeaf())) {
+                // subtree to exist (a packed subtree isn't a leaf, although it has no child elements)
+                if (!(childNode && childNode->isLeaf() && !childNode->hasPackedChildren())) {
                     childrenExistInPacketBits += (1 << (7 - originalIndex));
                     inViewNotLeafCount++;
                 }
@@ -1118,39 +1334,31 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
                 bool childIsOccluded = false; // assume it's not occluded
 
                 // If the user also asked for occlusion culling, check if this node is occluded
-                if (params.wantOcclusionCulling && childNode->isLeaf()) {
+                if (params.wantOcclusionCulling && childNode->isLeaf() && !childNode->hasPackedChildren()) {
                     // Don't check occlusion here, just add them to our distance ordered array...
 
                     AABox voxelBox = childNode->getAABox();
                     voxelBox.scale(TREE_SCALE);
-                    OctreeProjectedPolygon* voxelPolygon = new OctreeProjectedPolygon(
-                                params.viewFrustum->getProjectedPolygon(voxelBox));
+                    OctreeProjectedPolygon voxelPolygon = params.viewFrustum->getProjectedPolygon(voxelBox);
 
                     // In order to check occlusion culling, the shadow has to be "all in view" otherwise, we will ignore occlusion
                     // culling and proceed as normal
-                    if (voxelPolygon->getAllInView()) {
-                        CoverageMapStorageResult result = params.map->checkMap(voxelPolygon, true);
-
-                        // In all cases where the shadow wasn't stored, we need to free our own memory.
-                        // In the case where it is stored, the CoverageMap will free memory for us later.
-                        if (result != STORED) {
-                            delete voxelPolygon;
-                        }
+                    if (voxelPolygon.getAllInView()) {
+                        CoverageMapV2StorageResult result = params.map->checkMap(voxelPolygon, true);
 
                         // If while attempting to add this voxel's shadow, we determined it was occluded, then
                         // we don't need to process it further and we can exit early.
-                        if (result == OCCLUDED) {
+                        if (result == V2_OCCLUDED) {
                             childIsOccluded = true;
                         }
-                    } else {
-                        delete voxelPolygon;
                     }
                 } // wants occlusion culling & isLeaf()
 
 
                 bool shouldRender = !params.viewFrustum
                                     ? true
-                                    : childNode->calculateShouldRender(params.viewFrustum,
+                                    : childNode->calculateShouldRenderAtDistance(
+                                                    childLocationsThisView.furthestDistances[originalIndex],
                                                     params.octreeElementSizeScale, params.boundaryLevelAdjust);
 
                 // track some stats
@@ -1170,10 +1378,10 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
                     bool childWasInView = false;
 
                     if (childNode && params.deltaViewFrustum && params.lastViewFrustum) {
-                        ViewFrustum::location location = childNode->inFrustum(*params.lastViewFrustum);
+                        ViewFrustum::location location = childLocationsLastView.getLocation(originalIndex);
 
                         // If we're a leaf, then either intersect or inside is considered "formerly in view"
-                        if (childNode->isLeaf()) {
+                        if (childNode->isLeaf() && !childNode->hasPackedChildren()) {
                             childWasInView = location != ViewFrustum::OUTSIDE;
                         } else {
                             childWasInView = location == ViewFrustum::INSIDE;
@@ -1312,8 +1520,11 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
                 // This only applies in the view frustum case, in other cases, like file save and copy/past where
                 // no viewFrustum was requested, we still want to recurse the child tree.
                 if (!params.viewFrustum || !oneAtBit(childrenColoredBits, originalIndex)) {
+                    // we already know where the child is, so pass that down in place of our own location
+                    ViewFrustum::location childLocationThisView = (nodeLocationThisView == ViewFrustum::INSIDE)
+                        ? nodeLocationThisView : childLocationsThisView.getLocation(originalIndex);
                     childTreeBytesOut = encodeTreeBitstreamRecursion(childNode, packetData, bag, params, 
-                                                                            thisLevel, nodeLocationThisView);
+                                                                            thisLevel, childLocationThisView);
                 }
 
                 // remember this for reshuffling
@@ -1514,7 +1725,8 @@ void Octree::writeToSVOFile(const char* fileName, OctreeElement* node) {
             nodeBag.insert(_rootNode);
         }
 
-        static OctreePacketData packetData;
+        // not static, so that several trees can be written at once
+        OctreePacketData packetData;
         int bytesWritten = 0;
         bool lastPacketWritten = false;
 
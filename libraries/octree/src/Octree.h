@@ -15,7 +15,7 @@
 #include <set>
 #include <SimpleMovingAverage.h>
 
-class CoverageMap;
+class CoverageMapV3;
 class ReadBitstreamToTreeParams;
 class Octree;
 class OctreeElement;
@@ -25,6 +25,7 @@ class OctreePacketData;
 
 #include "JurisdictionMap.h"
 #include "ViewFrustum.h"
+#include "OctreeChangeJournal.h"
 #include "OctreeElement.h"
 #include "OctreeElementBag.h"
 #include "OctreePacketData.h"
@@ -32,6 +33,21 @@ class OctreePacketData;
 
 #include <QObject>
 #include <QReadWriteLock>
+#include <QVector>
+
+/// One ray of a batch cast with Octree::findRayIntersections, along with what it hit.
+class OctreeRayCast {
+public:
+    OctreeRayCast(const glm::vec3& origin = glm::vec3(), const glm::vec3& direction = glm::vec3());
+
+    glm::vec3 origin;
+    glm::vec3 direction;
+
+    bool intersects;
+    OctreeElement* element;
+    float distance;
+    BoxFace face;
+};
 
 // Callback function, for recuseTreeWithOperation
 typedef bool (*RecurseOctreeOperation)(OctreeElement* node, void* extraData);
@@ -55,6 +71,7 @@ const quint64 IGNORE_LAST_SENT  = 0;
 #define IGNORE_VIEW_FRUSTUM      NULL
 #define IGNORE_COVERAGE_MAP      NULL
 #define IGNORE_JURISDICTION_MAP  NULL
+#define IGNORE_CHANGE_SET        NULL
 
 class EncodeBitstreamParams {
 public:
@@ -72,8 +89,9 @@ public:
     quint64 lastViewFrustumSent;
     bool forceSendScene;
     OctreeSceneStats* stats;
-    CoverageMap* map;
+    CoverageMapV3* map;
     JurisdictionMap* jurisdictionMap;
+    const OctreeChangeSet* changes; ///< if given, decides what has changed in place of lastViewFrustumSent
 
     // output hints from the encode process
     typedef enum {
@@ -99,13 +117,14 @@ public:
         bool deltaViewFrustum = false,
         const ViewFrustum* lastViewFrustum = IGNORE_VIEW_FRUSTUM,
         bool wantOcclusionCulling = NO_OCCLUSION_CULLING,
-        CoverageMap* map = IGNORE_COVERAGE_MAP,
+        CoverageMapV3* map = IGNORE_COVERAGE_MAP,
         int boundaryLevelAdjust = NO_BOUNDARY_ADJUST,
         float octreeElementSizeScale = DEFAULT_OCTREE_SIZE_SCALE,
         quint64 lastViewFrustumSent = IGNORE_LAST_SENT,
         bool forceSendScene = true,
         OctreeSceneStats* stats = IGNORE_SCENE_STATS,
-        JurisdictionMap* jurisdictionMap = IGNORE_JURISDICTION_MAP) :
+        JurisdictionMap* jurisdictionMap = IGNORE_JURISDICTION_MAP,
+        const OctreeChangeSet* changes = IGNORE_CHANGE_SET) :
             maxEncodeLevel(maxEncodeLevel),
             maxLevelReached(0),
             viewFrustum(viewFrustum),
@@ -122,6 +141,7 @@ public:
             stats(stats),
             map(map),
             jurisdictionMap(jurisdictionMap),
+            changes(changes),
             stopReason(UNKNOWN)
     {}
 
@@ -206,6 +226,12 @@ public:
     void deleteOctalCodeFromTree(const unsigned char* codeBuffer, bool collapseEmptyTrees = DONT_COLLAPSE);
     void reaverageOctreeElements(OctreeElement* startNode = NULL);
 
+    /// Recalculates the averages of the elements whose subtrees changed since they were last averaged (as they are
+    /// in trees that don't reaverage, or defer it), visiting only the paths down to the changes rather than the
+    /// whole tree.  Unlike reaverageOctreeElements, this works whether or not the tree reaverages, and leaves
+    /// identical children uncollapsed, just as reaveraging as each change unwound would have.
+    void reaverageChangedElements();
+
     void deleteOctreeElementAt(float x, float y, float z, float s);
     OctreeElement* getOctreeElementAt(float x, float y, float z, float s) const;
     OctreeElement* getOrCreateChildElementAt(float x, float y, float z, float s);
@@ -237,9 +263,15 @@ public:
         NoLock
     } lockType;
 
+    /// Finds the nearest element with content that the ray passes through.  Children are visited front to back, so the
+    /// search stops at the first hit rather than testing every leaf along the ray.
     bool findRayIntersection(const glm::vec3& origin, const glm::vec3& direction,
                              OctreeElement*& node, float& distance, BoxFace& face, Octree::lockType lockType = Octree::TryLock);
 
+    /// Casts a batch of rays under a single lock, filling in what each hit.
+    /// \return the number of rays that hit something
+    int findRayIntersections(QVector<OctreeRayCast>& rays, Octree::lockType lockType = Octree::Lock);
+
     bool findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration,
                                     void** penetratedObject = NULL, Octree::lockType lockType = Octree::TryLock);
 
@@ -263,6 +295,16 @@ public:
 
     bool getShouldReaverage() const { return _shouldReaverage; }
 
+    /// Sets whether a reaveraging tree leaves the averages along the paths that edits change for a later call to
+    /// reaverageChangedElements, so that a burst of edits averages each element once rather than once per edit
+    /// below it.
+    void setDefersReaveraging(bool defersReaveraging) { _defersReaveraging = defersReaveraging; }
+    bool getDefersReaveraging() const { return _defersReaveraging; }
+
+    /// Starts keeping a journal of the subtrees that change, so that senders can tell what changed since a version.
+    void enableChangeJournal(int maxEntries = DEFAULT_MAX_CHANGE_JOURNAL_ENTRIES);
+    OctreeChangeJournal* getChangeJournal() { return _changeJournal; }
+
     void recurseNodeWithOperation(OctreeElement* node, RecurseOctreeOperation operation,
                 void* extraData, int recursionCount = 0);
 
@@ -304,9 +346,12 @@ protected:
 
     bool _isDirty;
     bool _shouldReaverage;
+    bool _defersReaveraging;
     bool _stopImport;
 
     QReadWriteLock _lock;
+
+    OctreeChangeJournal* _changeJournal;
     
     /// This tree is receiving inbound viewer datagrams.
     bool _isViewing;
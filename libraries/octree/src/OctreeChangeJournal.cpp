@@ -0,0 +1,101 @@
+//
+//  OctreeChangeJournal.cpp
+//  libraries/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "OctreeChangeJournal.h"
+
+OctreeChangeSet::OctreeChangeSet() :
+    _levels(0),
+    _isEverything(false)
+{
+}
+
+void OctreeChangeSet::clear() {
+    _subtrees.clear();
+    _paths.clear();
+    _levels = 0;
+    _isEverything = false;
+}
+
+void OctreeChangeSet::addSubtree(const MortonKey& key) {
+    if (!key.isValid()) {
+        _isEverything = true;
+        return;
+    }
+    _subtrees.insert(key);
+    _levels |= (1 << key.getLevel());
+
+    // the paths of earlier subtrees often share our ancestors, so stop at the first we already have
+    for (MortonKey ancestor = key; ancestor.getLevel() > 0; ) {
+        ancestor = ancestor.getParent();
+        if (_paths.contains(ancestor)) {
+            break;
+        }
+        _paths.insert(ancestor);
+    }
+}
+
+bool OctreeChangeSet::contains(const MortonKey& key) const {
+    if (_isEverything || !key.isValid() || _paths.contains(key)) {
+        return true;
+    }
+    // look for a subtree rooted at the key or above it, but only at the levels that have one
+    for (int level = key.getLevel(); level >= 0; level--) {
+        if ((_levels & (1 << level)) && _subtrees.contains(key.getAncestor(level))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+OctreeChangeJournal::OctreeChangeJournal(int maxEntries) :
+    _mutex(),
+    _maxEntries(maxEntries),
+    _version(0),
+    _oldestVersion(0),
+    _pathKey(MortonKey::invalid())
+{
+}
+
+quint64 OctreeChangeJournal::getVersion() {
+    QMutexLocker locker(&_mutex);
+    return _version;
+}
+
+bool OctreeChangeJournal::getChangesSince(quint64 version, OctreeChangeSet& changes) {
+    QMutexLocker locker(&_mutex);
+    if (version < _oldestVersion) {
+        return false;
+    }
+    // the entries are in version order, so only the newest need looking at
+    for (int i = _entries.size() - 1; i >= 0 && _entries.at(i).version > version; i--) {
+        changes.addSubtree(_entries.at(i).key);
+    }
+    return true;
+}
+
+void OctreeChangeJournal::subtreeChanged(OctreeElement* element) {
+    const MortonKey& key = element->getMortonKey();
+    QMutexLocker locker(&_mutex);
+    _version++;
+
+    // an edit marks its element and then each ancestor in turn as it unwinds; those are the path to the element
+    if (!_entries.isEmpty() && key.isValid() && (key == _pathKey || key == _pathKey.getParent())) {
+        _entries.last().version = _version;
+        _pathKey = key;
+        return;
+    }
+    Entry entry = { _version, key };
+    _entries.enqueue(entry);
+    _pathKey = key;
+    if (_entries.size() > _maxEntries) {
+        _oldestVersion = _entries.dequeue().version;
+    }
+}
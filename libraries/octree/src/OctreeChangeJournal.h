@@ -0,0 +1,91 @@
+//
+//  OctreeChangeJournal.h
+//  libraries/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeChangeJournal_h
+#define hifi_OctreeChangeJournal_h
+
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QSet>
+
+#include <MortonKey.h>
+
+#include "OctreeElement.h"
+
+/// The most changes the journal remembers; clients further behind than this get a full walk.
+const int DEFAULT_MAX_CHANGE_JOURNAL_ENTRIES = 4096;
+
+/// The subtrees of an octree that changed between two versions.  An element has changed if it lies within one of the
+/// subtrees, or on the path down to one (where the averaged colors and child bits changed with it).
+class OctreeChangeSet {
+public:
+
+    OctreeChangeSet();
+
+    void clear();
+
+    bool isEmpty() const { return _subtrees.isEmpty() && !_isEverything; }
+
+    /// Adds a changed subtree.  An invalid key (for an element too deep for one) marks everything as changed.
+    void addSubtree(const MortonKey& key);
+
+    /// Checks whether the element with the given key has changed.
+    bool contains(const MortonKey& key) const;
+
+private:
+
+    QSet<MortonKey> _subtrees;
+    QSet<MortonKey> _paths; ///< the strict ancestors of the subtrees
+    quint32 _levels; ///< bit n is set if a subtree is rooted at level n
+    bool _isEverything;
+};
+
+/// Records which subtrees of an octree change, against a version counter that every change advances, so that a sender
+/// can tell at a glance whether anything changed since the version a client last received, and if so, visit only what
+/// did.  Only the deepest change of each edit is kept: the elements marked after it, one level at a time as the edit
+/// unwinds, are the path down to it.  The tree that owns the journal tells it of each element whose subtree changes
+/// (see OctreeElement::handleSubtreeChanged) and of each it reaverages later, so the changes of other trees in the
+/// process don't reach it.
+class OctreeChangeJournal {
+public:
+
+    OctreeChangeJournal(int maxEntries = DEFAULT_MAX_CHANGE_JOURNAL_ENTRIES);
+
+    /// Returns the current version.
+    /// \thread any
+    quint64 getVersion();
+
+    /// Fills in the subtrees that changed after the given version.
+    /// \return false if the journal no longer reaches back that far
+    /// \thread any
+    bool getChangesSince(quint64 version, OctreeChangeSet& changes);
+
+    /// Records that the subtree below the element (and so the element itself) changed.
+    /// \thread any
+    void subtreeChanged(OctreeElement* element);
+
+private:
+
+    class Entry {
+    public:
+        quint64 version; ///< the last version in which the subtree (or the path down to it) changed
+        MortonKey key;
+    };
+
+    QMutex _mutex;
+    QQueue<Entry> _entries;
+    int _maxEntries;
+    quint64 _version;
+    quint64 _oldestVersion; ///< the earliest version we can report the changes since
+    MortonKey _pathKey; ///< the highest element marked on the way up from the last entry
+};
+
+#endif // hifi_OctreeChangeJournal_h
@@ -27,6 +27,7 @@ EditPacketBuffer::EditPacketBuffer(PacketType type, unsigned char* buffer, ssize
 };
 
 const int OctreeEditPacketSender::DEFAULT_MAX_PENDING_MESSAGES = PacketSender::DEFAULT_PACKETS_PER_SECOND;
+const int OctreeEditPacketSender::DEFAULT_MAX_UNSENT_PACKETS = PacketSender::DEFAULT_PACKETS_PER_SECOND;
 
 
 OctreeEditPacketSender::OctreeEditPacketSender() :
@@ -34,7 +35,11 @@ OctreeEditPacketSender::OctreeEditPacketSender() :
     _shouldSend(true),
     _maxPendingMessages(DEFAULT_MAX_PENDING_MESSAGES),
     _releaseQueuedMessagesPending(false),
+    _maxUnsentPackets(DEFAULT_MAX_UNSENT_PACKETS),
+    _droppedUnsentPacketCount(0),
     _serverJurisdictions(NULL),
+    _indexedJurisdictions(NULL),
+    _isServerIndexUsable(false),
     _sequenceNumber(0),
     _maxPacketSize(MAX_PACKET_SIZE) {
     //printf("OctreeEditPacketSender::OctreeEditPacketSender() [%p] created... \n", this);
@@ -94,7 +99,19 @@ void OctreeEditPacketSender::queuePacketToNode(const QUuid& nodeUUID, unsigned c
         if (node->getType() == getMyNodeType() &&
             ((node->getUUID() == nodeUUID) || (nodeUUID.isNull()))) {
             if (node->getActiveSocket()) {
-                queuePacketForSending(node, QByteArray(reinterpret_cast<char*>(buffer), length));
+                // packets that are already waiting go first, and if the queue's full, this one waits with them
+                QByteArray packet(reinterpret_cast<char*>(buffer), length);
+                if (!retryUnsentPackets() || !queuePacketForSending(node, packet)) {
+                    QMutexLocker locker(&_unsentPacketsLock);
+                    _unsentPackets.append(NetworkPacket(node, packet));
+
+                    // if we're that far behind, the oldest edits are the ones least worth sending
+                    int numDropped = _unsentPackets.size() - _maxUnsentPackets;
+                    if (numDropped > 0) {
+                        _unsentPackets.remove(0, numDropped);
+                        _droppedUnsentPacketCount += numDropped;
+                    }
+                }
 
                 // debugging output...
                 bool wantDebugging = false;
@@ -177,6 +194,18 @@ void OctreeEditPacketSender::queuePacketToNodes(unsigned char* buffer, ssize_t l
     // for a different server... So we need to actually manage multiple queued packets... one
     // for each server
 
+    QVarLengthArray<QUuid, 4> serverUUIDs;
+    if (findServersForCode(octCode, serverUUIDs)) {
+        NodeList* nodeList = NodeList::getInstance();
+        for (int i = 0; i < serverUUIDs.size(); i++) {
+            SharedNodePointer node = nodeList->nodeWithUUID(serverUUIDs.at(i));
+            if (node && node->getActiveSocket() && node->getType() == getMyNodeType()) {
+                queuePacketToNode(node->getUUID(), buffer, length);
+            }
+        }
+        return;
+    }
+
     foreach (const SharedNodePointer& node, NodeList::getInstance()->getNodeHash()) {
         // only send to the NodeTypes that are getMyNodeType()
         if (node->getActiveSocket() && node->getType() == getMyNodeType()) {
@@ -226,6 +255,18 @@ void OctreeEditPacketSender::queueOctreeEditMessage(PacketType type, unsigned ch
     // for a different server... So we need to actually manage multiple queued packets... one
     // for each server
 
+    QVarLengthArray<QUuid, 4> serverUUIDs;
+    if (findServersForCode(codeColorBuffer, serverUUIDs)) {
+        NodeList* nodeList = NodeList::getInstance();
+        for (int i = 0; i < serverUUIDs.size(); i++) {
+            SharedNodePointer node = nodeList->nodeWithUUID(serverUUIDs.at(i));
+            if (node && node->getActiveSocket() && node->getType() == getMyNodeType()) {
+                queueOctreeEditMessageToNode(node, type, codeColorBuffer, length);
+            }
+        }
+        return;
+    }
+
     foreach (const SharedNodePointer& node, NodeList::getInstance()->getNodeHash()) {
         // only send to the NodeTypes that are getMyNodeType()
         if (node->getActiveSocket() && node->getType() == getMyNodeType()) {
@@ -243,34 +284,98 @@ void OctreeEditPacketSender::queueOctreeEditMessage(PacketType type, unsigned ch
                 }
             }
             if (isMyJurisdiction) {
-                EditPacketBuffer& packetBuffer = _pendingEditPackets[nodeUUID];
-                packetBuffer._nodeUUID = nodeUUID;
-
-                // If we're switching type, then we send the last one and start over
-                if ((type != packetBuffer._currentType && packetBuffer._currentSize > 0) ||
-                    (packetBuffer._currentSize + length >= _maxPacketSize)) {
-                    releaseQueuedPacket(packetBuffer);
-                    initializePacket(packetBuffer, type);
-                }
+                queueOctreeEditMessageToNode(node, type, codeColorBuffer, length);
+            }
+        }
+    }
+}
 
-                // If the buffer is empty and not correctly initialized for our type...
-                if (type != packetBuffer._currentType && packetBuffer._currentSize == 0) {
-                    initializePacket(packetBuffer, type);
-                }
+void OctreeEditPacketSender::queueOctreeEditMessageToNode(const SharedNodePointer& node, PacketType type,
+        unsigned char* codeColorBuffer, ssize_t length) {
+    QUuid nodeUUID = node->getUUID();
+    EditPacketBuffer& packetBuffer = _pendingEditPackets[nodeUUID];
+    packetBuffer._nodeUUID = nodeUUID;
+
+    // If we're switching type, then we send the last one and start over
+    if ((type != packetBuffer._currentType && packetBuffer._currentSize > 0) ||
+        (packetBuffer._currentSize + length >= _maxPacketSize)) {
+        releaseQueuedPacket(packetBuffer);
+        initializePacket(packetBuffer, type);
+    }
 
-                // This is really the first time we know which server/node this particular edit message
-                // is going to, so we couldn't adjust for clock skew till now. But here's our chance.
-                // We call this virtual function that allows our specific type of EditPacketSender to
-                // fixup the buffer for any clock skew
-                if (node->getClockSkewUsec() != 0) {
-                    adjustEditPacketForClockSkew(codeColorBuffer, length, node->getClockSkewUsec());
-                }
+    // If the buffer is empty and not correctly initialized for our type...
+    if (type != packetBuffer._currentType && packetBuffer._currentSize == 0) {
+        initializePacket(packetBuffer, type);
+    }
 
-                memcpy(&packetBuffer._currentBuffer[packetBuffer._currentSize], codeColorBuffer, length);
-                packetBuffer._currentSize += length;
-            }
+    // This is really the first time we know which server/node this particular edit message
+    // is going to, so we couldn't adjust for clock skew till now. But here's our chance.
+    // We call this virtual function that allows our specific type of EditPacketSender to
+    // fixup the buffer for any clock skew
+    if (node->getClockSkewUsec() != 0) {
+        adjustEditPacketForClockSkew(codeColorBuffer, length, node->getClockSkewUsec());
+    }
+
+    memcpy(&packetBuffer._currentBuffer[packetBuffer._currentSize], codeColorBuffer, length);
+    packetBuffer._currentSize += length;
+}
+
+bool OctreeEditPacketSender::findServersForCode(const unsigned char* octalCode,
+        QVarLengthArray<QUuid, 4>& serverUUIDs) {
+    if (!_serverJurisdictions) {
+        return false;
+    }
+    if (!isServerIndexCurrent()) {
+        updateServerIndex();
+    }
+    MortonKey key(octalCode);
+    if (!(_isServerIndexUsable && key.isValid())) {
+        return false;
+    }
+    JurisdictionOwners owners;
+    _serverIndex.findOwners(key, owners);
+    for (int i = 0; i < owners.size(); i++) {
+        serverUUIDs.append(_serverIndexUUIDs.at(owners.at(i)));
+    }
+    return true;
+}
+
+bool OctreeEditPacketSender::isServerIndexCurrent() const {
+    if (_serverJurisdictions != _indexedJurisdictions || _serverJurisdictions->size() != _indexedRevisions.size()) {
+        return false;
+    }
+    int index = 0;
+    for (NodeToJurisdictionMap::const_iterator i = _serverJurisdictions->constBegin();
+            i != _serverJurisdictions->constEnd(); i++) {
+        if (i.value().getRevision() != _indexedRevisions.at(index++)) {
+            return false;
         }
     }
+    return true;
+}
+
+void OctreeEditPacketSender::updateServerIndex() {
+    // take the revisions first, so that a change made while we're at it shows up next time
+    _indexedJurisdictions = _serverJurisdictions;
+    _indexedRevisions.clear();
+    for (NodeToJurisdictionMap::const_iterator i = _serverJurisdictions->constBegin();
+            i != _serverJurisdictions->constEnd(); i++) {
+        _indexedRevisions.append(i.value().getRevision());
+    }
+    _serverIndex.clear();
+    _serverIndexUUIDs.clear();
+    _isServerIndexUsable = true;
+
+    for (NodeToJurisdictionMap::const_iterator i = _serverJurisdictions->constBegin();
+            i != _serverJurisdictions->constEnd(); i++) {
+        const JurisdictionMap& map = i.value();
+        if (!map.hasKeys()) {
+            _isServerIndexUsable = false;
+            return;
+        }
+        _serverIndex.add(_serverIndexUUIDs.size(), map.getRootKey(), map.getEndNodeKeys());
+        _serverIndexUUIDs.append(i.key());
+    }
 }
 
 void OctreeEditPacketSender::releaseQueuedMessages() {
@@ -312,6 +417,25 @@ void OctreeEditPacketSender::initializePacket(EditPacketBuffer& packetBuffer, Pa
     packetBuffer._currentType = type;
 }
 
+bool OctreeEditPacketSender::retryUnsentPackets() {
+    QMutexLocker locker(&_unsentPacketsLock);
+    int numQueued = 0;
+    while (numQueued < _unsentPackets.size()) {
+        const NetworkPacket& packet = _unsentPackets.at(numQueued);
+        if (!queuePacketForSending(packet.getDestinationNode(), packet.getByteArray())) {
+            break;
+        }
+        numQueued++;
+    }
+    _unsentPackets.remove(0, numQueued);
+    return _unsentPackets.isEmpty();
+}
+
+int OctreeEditPacketSender::getUnsentPacketCount() {
+    QMutexLocker locker(&_unsentPacketsLock);
+    return _unsentPackets.size();
+}
+
 bool OctreeEditPacketSender::process() {
     // if we have server jurisdiction details, and we have pending pre-jurisdiction packets, then process those
     // before doing our normal process step. This processPreJurisdictionPackets()
@@ -319,6 +443,9 @@ bool OctreeEditPacketSender::process() {
         processPreServerExistsPackets();
     }
 
+    // the send queue has drained some since the last time, so whatever it turned away may fit now
+    retryUnsentPackets();
+
     // base class does most of the work.
     return PacketSender::process();
 }
@@ -12,8 +12,11 @@
 #ifndef hifi_OctreeEditPacketSender_h
 #define hifi_OctreeEditPacketSender_h
 
+#include <QtCore/QVarLengthArray>
+
 #include <PacketSender.h>
 #include <PacketHeaders.h>
+#include "JurisdictionIndex.h"
 #include "JurisdictionMap.h"
 
 /// Used for construction of edit packets
@@ -67,6 +70,16 @@ public:
     /// if you're running in non-threaded mode, you must call this method regularly
     virtual bool process();
 
+    /// Returns the number of finished packets waiting for room in the send queue.
+    int getUnsentPacketCount();
+
+    /// Sets the most finished packets to hold on to while the send queue is full; past that, the oldest are dropped.
+    void setMaxUnsentPackets(int maxUnsentPackets) { _maxUnsentPackets = maxUnsentPackets; }
+    int getMaxUnsentPackets() const { return _maxUnsentPackets; }
+
+    /// Returns the number of finished packets dropped because too many were waiting for room in the send queue.
+    quint64 getDroppedUnsentPacketCount() const { return _droppedUnsentPacketCount; }
+
     /// Set the desired number of pending messages that the OctreeEditPacketSender should attempt to queue even if
     /// servers are not present. This only applies to how the OctreeEditPacketSender will manage messages when no 
     /// servers are present. By default, this value is the same as the default packets that will be sent in one second.
@@ -77,6 +90,9 @@ public:
     // the default number of pending messages we will store if no servers are available
     static const int DEFAULT_MAX_PENDING_MESSAGES;
 
+    // the default number of finished packets we will hold on to while the send queue is full
+    static const int DEFAULT_MAX_UNSENT_PACKETS;
+
     // is there an octree server available to send packets to    
     bool serversExist() const;
 
@@ -97,9 +113,24 @@ protected:
     void queuePacketToNodes(unsigned char* buffer, ssize_t length);
     void initializePacket(EditPacketBuffer& packetBuffer, PacketType type);
     void releaseQueuedPacket(EditPacketBuffer& packetBuffer); // releases specific queued packet
+    void queueOctreeEditMessageToNode(const SharedNodePointer& node, PacketType type, unsigned char* codeColorBuffer,
+        ssize_t length);
+
+    /// Looks up the servers whose jurisdictions the code lies within, all at once.
+    /// \return false if the lookup can't be made (if a code is too deep to have a key, say), in which case the caller
+    /// must try each server's map
+    bool findServersForCode(const unsigned char* octalCode, QVarLengthArray<QUuid, 4>& serverUUIDs);
+
+    /// Checks whether the index was built from the servers' maps as they are now, by their revisions.
+    bool isServerIndexCurrent() const;
+    void updateServerIndex();
     
     void processPreServerExistsPackets();
 
+    /// Moves the packets that the send queue turned away onto it, in order, for as long as it has room.
+    /// \return true if none are left waiting
+    bool retryUnsentPackets();
+
     // These are packets which are destined from know servers but haven't been released because they're still too small
     std::map<QUuid, EditPacketBuffer> _pendingEditPackets;
     
@@ -110,7 +141,21 @@ protected:
     QVector<EditPacketBuffer*> _preServerPackets; // these will get packed into other larger packets
     QVector<EditPacketBuffer*> _preServerSingleMessagePackets; // these will go out as is
 
+    // These are finished packets that the send queue was too full to take; we hold on to them (up to a limit, past
+    // which the oldest are dropped) and retry each time we process
+    QMutex _unsentPacketsLock;
+    QVector<NetworkPacket> _unsentPackets;
+    int _maxUnsentPackets;
+    quint64 _droppedUnsentPacketCount;
+
     NodeToJurisdictionMap* _serverJurisdictions;
+
+    /// All the servers' jurisdictions in one index, rebuilt whenever any jurisdiction changes.
+    JurisdictionIndex _serverIndex;
+    QVector<QUuid> _serverIndexUUIDs; ///< the servers, by their owner numbers in the index
+    const NodeToJurisdictionMap* _indexedJurisdictions;
+    QVector<int> _indexedRevisions; ///< the revisions of the servers' maps when indexed, in the order of the map
+    bool _isServerIndexUsable;
     
     unsigned short int _sequenceNumber;
     int _maxPacketSize;
@@ -14,6 +14,8 @@
 #include <stdio.h>
 
 #include <QtCore/QDebug>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QThreadStorage>
 
 #include <NodeList.h>
 #include <PerfStat.h>
@@ -25,16 +27,69 @@
 #include "OctreeConstants.h"
 #include "OctreeElement.h"
 #include "Octree.h"
+#include "OctreeChangeJournal.h"
 
-quint64 OctreeElement::_voxelMemoryUsage = 0;
-quint64 OctreeElement::_octcodeMemoryUsage = 0;
-quint64 OctreeElement::_externalChildrenMemoryUsage = 0;
-quint64 OctreeElement::_voxelNodeCount = 0;
-quint64 OctreeElement::_voxelNodeLeafCount = 0;
+OctreeElementStats::OctreeElementStats() {
+    memset(this, 0, sizeof(OctreeElementStats));
+}
+
+void OctreeElementStats::add(const OctreeElementStats& other) {
+    // a thread's totals may have gone "below zero" (it deleted more than it created), which the unsigned arithmetic
+    // takes care of
+    nodeCount += other.nodeCount;
+    leafCount += other.leafCount;
+    voxelMemoryUsage += other.voxelMemoryUsage;
+    octcodeMemoryUsage += other.octcodeMemoryUsage;
+    externalChildrenMemoryUsage += other.externalChildrenMemoryUsage;
+    externalChildrenCount += other.externalChildrenCount;
+    for (int i = 0; i < NUMBER_OF_CHILDREN + 1; i++) {
+        childrenCount[i] += other.childrenCount[i];
+    }
+    packedChildrenCount += other.packedChildrenCount;
+    packedChildrenMemoryUsage += other.packedChildrenMemoryUsage;
+}
+
+OctreeElementStats OctreeElement::_stats;
+
+/// The running totals that a thread keeps in place of the shared ones, if any (see OctreeElement::setThreadStats).
+class ThreadStats {
+public:
+    ThreadStats() : stats(NULL) { }
+    OctreeElementStats* stats;
+};
+
+static QThreadStorage<ThreadStats> threadStats;
+
+/// The number of threads keeping their own totals, so that the others needn't look for theirs when there are none.
+static QAtomicInt threadStatsCount;
+
+void OctreeElement::setThreadStats(OctreeElementStats* stats) {
+    ThreadStats& ourStats = threadStats.localData();
+    if (stats && !ourStats.stats) {
+        threadStatsCount.ref();
+    } else if (!stats && ourStats.stats) {
+        threadStatsCount.deref();
+    }
+    ourStats.stats = stats;
+}
+
+void OctreeElement::mergeStats(const OctreeElementStats& stats) {
+    getStats().add(stats);
+}
+
+OctreeElementStats& OctreeElement::getStats() {
+    if (threadStatsCount.load() != 0) {
+        OctreeElementStats* ourStats = threadStats.localData().stats;
+        if (ourStats) {
+            return *ourStats;
+        }
+    }
+    return _stats;
+}
 
 void OctreeElement::resetPopulationStatistics() {
-    _voxelNodeCount = 0;
-    _voxelNodeLeafCount = 0;
+    _stats.nodeCount = 0;
+    _stats.leafCount = 0;
 }
 
 OctreeElement::OctreeElement() {
@@ -48,15 +103,16 @@ void OctreeElement::init(unsigned char * octalCode) {
         octalCode = new unsigned char[1];
         *octalCode = 0;
     }
-    _voxelNodeCount++;
-    _voxelNodeLeafCount++; // all nodes start as leaf nodes
-
+    OctreeElementStats& stats = getStats();
+    stats.nodeCount++;
+    stats.leafCount++; // all nodes start as leaf nodes
 
+    _mortonKey = MortonKey(octalCode);
     size_t octalCodeLength = bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(octalCode));
     if (octalCodeLength > sizeof(_octalCode)) {
         _octalCode.pointer = octalCode;
         _octcodePointer = true;
-        _octcodeMemoryUsage += octalCodeLength;
+        stats.octcodeMemoryUsage += octalCodeLength;
     } else {
         _octcodePointer = false;
         memcpy(_octalCode.buffer, octalCode, octalCodeLength);
@@ -71,7 +127,7 @@ void OctreeElement::init(unsigned char * octalCode) {
     _children.external = NULL;
     _singleChildrenCount++;
 #endif
-    _childrenCount[0]++;
+    stats.childrenCount[0]++;
 
     // default pointers to child nodes to NULL
 #ifdef HAS_AUDIT_CHILDREN
@@ -91,6 +147,7 @@ void OctreeElement::init(unsigned char * octalCode) {
 #endif
 
     _isDirty = true;
+    _isAverageStale = false;
     _shouldRender = false;
     _sourceUUIDKey = 0;
     calculateAABox();
@@ -99,13 +156,14 @@ void OctreeElement::init(unsigned char * octalCode) {
 
 OctreeElement::~OctreeElement() {
     notifyDeleteHooks();
-    _voxelNodeCount--;
+    OctreeElementStats& stats = getStats();
+    stats.nodeCount--;
     if (isLeaf()) {
-        _voxelNodeLeafCount--;
+        stats.leafCount--;
     }
 
     if (_octcodePointer) {
-        _octcodeMemoryUsage -= bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(getOctalCode()));
+        stats.octcodeMemoryUsage -= bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(getOctalCode()));
         delete[] _octalCode.pointer;
     }
 
@@ -125,12 +183,20 @@ void OctreeElement::markWithChangedTime() {
 // localized, because this method will get called for every node in an
 // recursive unwinding case like delete or add voxel
 void OctreeElement::handleSubtreeChanged(Octree* myTree) {
-    // here's a good place to do color re-averaging...
-    if (myTree->getShouldReaverage()) {
+    // here's a good place to do color re-averaging... unless the tree leaves it for reaverageChangedElements (but not
+    // for an element that just lost its last child, which would otherwise pass for a colored leaf until then)
+    if (myTree->getShouldReaverage() && (!myTree->getDefersReaveraging() || isLeaf())) {
         calculateAverageFromChildren();
+    } else {
+        _isAverageStale = true;
     }
 
     markWithChangedTime();
+
+    OctreeChangeJournal* changeJournal = myTree->getChangeJournal();
+    if (changeJournal) {
+        changeJournal->subtreeChanged(this);
+    }
 }
 
 const uint16_t KEY_FOR_NULL = 0;
@@ -191,6 +257,10 @@ void OctreeElement::setShouldRender(bool shouldRender) {
 }
 
 void OctreeElement::calculateAABox() {
+    if (_mortonKey.isValid()) {
+        _box.setBox(_mortonKey.getCorner(), _mortonKey.getScale());
+        return;
+    }
     glm::vec3 corner;
 
     // copy corner into box
@@ -212,7 +282,7 @@ void OctreeElement::deleteChildAtIndex(int childIndex) {
 
         // after deleting the child, check to see if we're a leaf
         if (isLeaf()) {
-            _voxelNodeLeafCount++;
+            getStats().leafCount++;
         }
     }
 #ifdef HAS_AUDIT_CHILDREN
@@ -230,7 +300,7 @@ OctreeElement* OctreeElement::removeChildAtIndex(int childIndex) {
 
         // after removing the child, check to see if we're a leaf
         if (isLeaf()) {
-            _voxelNodeLeafCount++;
+            getStats().leafCount++;
         }
     }
 
@@ -293,8 +363,6 @@ quint64 OctreeElement::_couldStoreFourChildrenInternally = 0;
 quint64 OctreeElement::_couldNotStoreFourChildrenInternally = 0;
 #endif
 
-quint64 OctreeElement::_externalChildrenCount = 0;
-quint64 OctreeElement::_childrenCount[NUMBER_OF_CHILDREN + 1] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 OctreeElement* OctreeElement::getChildAtIndex(int childIndex) const {
 #ifdef SIMPLE_CHILD_ARRAY
@@ -453,7 +521,7 @@ void OctreeElement::storeTwoChildren(OctreeElement* childOne, OctreeElement* chi
         if (_childrenExternal) {
             //assert(_children.external);
             const int previousChildCount = 2;
-            _externalChildrenMemoryUsage -= previousChildCount * sizeof(OctreeElement*);
+            getStats().externalChildrenMemoryUsage -= previousChildCount * sizeof(OctreeElement*);
             delete[] _children.external;
             _children.external = NULL; // probably not needed!
             _childrenExternal = false;
@@ -471,7 +539,7 @@ void OctreeElement::storeTwoChildren(OctreeElement* childOne, OctreeElement* chi
         if (!_childrenExternal) {
             _childrenExternal = true;
             const int newChildCount = 2;
-            _externalChildrenMemoryUsage += newChildCount * sizeof(OctreeElement*);
+            getStats().externalChildrenMemoryUsage += newChildCount * sizeof(OctreeElement*);
             _children.external = new OctreeElement*[newChildCount];
             memset(_children.external, 0, sizeof(OctreeElement*) * newChildCount);
         }
@@ -491,7 +559,7 @@ void OctreeElement::retrieveTwoChildren(OctreeElement*& childOne, OctreeElement*
         _childrenExternal = false;
         _twoChildrenExternalCount--;
         const int newChildCount = 2;
-        _externalChildrenMemoryUsage -= newChildCount * sizeof(OctreeElement*);
+        getStats().externalChildrenMemoryUsage -= newChildCount * sizeof(OctreeElement*);
     } else {
         int64_t offsetOne = _children.offsetsTwoChildren[0];
         int64_t offsetTwo = _children.offsetsTwoChildren[1];
@@ -570,7 +638,7 @@ void OctreeElement::storeThreeChildren(OctreeElement* childOne, OctreeElement* c
             _children.external = NULL; // probably not needed!
             _childrenExternal = false;
             const int previousChildCount = 3;
-            _externalChildrenMemoryUsage -= previousChildCount * sizeof(OctreeElement*);
+            getStats().externalChildrenMemoryUsage -= previousChildCount * sizeof(OctreeElement*);
         }
         // encode in union
         encodeThreeOffsets(offsetOne, offsetTwo, offsetThree);
@@ -582,7 +650,7 @@ void OctreeElement::storeThreeChildren(OctreeElement* childOne, OctreeElement* c
         if (!_childrenExternal) {
             _childrenExternal = true;
             const int newChildCount = 3;
-            _externalChildrenMemoryUsage += newChildCount * sizeof(OctreeElement*);
+            getStats().externalChildrenMemoryUsage += newChildCount * sizeof(OctreeElement*);
             _children.external = new OctreeElement*[newChildCount];
             memset(_children.external, 0, sizeof(OctreeElement*) * newChildCount);
         }
@@ -603,7 +671,7 @@ void OctreeElement::retrieveThreeChildren(OctreeElement*& childOne, OctreeElemen
         _children.external = NULL; // probably not needed!
         _childrenExternal = false;
         _threeChildrenExternalCount--;
-        _externalChildrenMemoryUsage -= 3 * sizeof(OctreeElement*);
+        getStats().externalChildrenMemoryUsage -= 3 * sizeof(OctreeElement*);
     } else {
         int64_t offsetOne, offsetTwo, offsetThree;
         decodeThreeOffsets(offsetOne, offsetTwo, offsetThree);
@@ -653,11 +721,11 @@ void OctreeElement::deleteAllChildren() {
     switch (childCount) {
         case 0: {
             _singleChildrenCount--;
-            _childrenCount[0]--;
+            getStats().childrenCount[0]--;
         } break;
         case 1: {
             _singleChildrenCount--;
-            _childrenCount[1]--;
+            getStats().childrenCount[1]--;
         } break;
 
         case 2: {
@@ -666,7 +734,7 @@ void OctreeElement::deleteAllChildren() {
             } else {
                 _twoChildrenOffsetCount--;
             }
-            _childrenCount[2]--;
+            getStats().childrenCount[2]--;
         } break;
 
         case 3: {
@@ -675,12 +743,12 @@ void OctreeElement::deleteAllChildren() {
             } else {
                 _threeChildrenOffsetCount--;
             }
-            _childrenCount[3]--;
+            getStats().childrenCount[3]--;
         } break;
 
         default: {
-            _externalChildrenCount--;
-            _childrenCount[childCount]--;
+            getStats().externalChildrenCount--;
+            getStats().childrenCount[childCount]--;
         } break;
 
 
@@ -709,8 +777,9 @@ void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
 
     // track our population data
     if (previousChildCount != newChildCount) {
-        _childrenCount[previousChildCount]--;
-        _childrenCount[newChildCount]++;
+        OctreeElementStats& stats = getStats();
+        stats.childrenCount[previousChildCount]--;
+        stats.childrenCount[newChildCount]++;
     }
 #endif
 
@@ -729,8 +798,9 @@ void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
 
     // track our population data
     if (previousChildCount != newChildCount) {
-        _childrenCount[previousChildCount]--;
-        _childrenCount[newChildCount]++;
+        OctreeElementStats& stats = getStats();
+        stats.childrenCount[previousChildCount]--;
+        stats.childrenCount[newChildCount]++;
     }
 
     if ((previousChildCount == 0 || previousChildCount == 1) && newChildCount == 0) {
@@ -744,14 +814,14 @@ void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
         _children.external[firstIndex] = previousChild;
         _children.external[childIndex] = child;
 
-        _externalChildrenMemoryUsage += NUMBER_OF_CHILDREN * sizeof(OctreeElement*);
+        getStats().externalChildrenMemoryUsage += NUMBER_OF_CHILDREN * sizeof(OctreeElement*);
 
     } else if (previousChildCount == 2 && newChildCount == 1) {
         assert(!child); // we are removing a child, so this must be true!
         OctreeElement* previousFirstChild = _children.external[firstIndex];
         OctreeElement* previousSecondChild = _children.external[secondIndex];
         delete[] _children.external;
-        _externalChildrenMemoryUsage -= NUMBER_OF_CHILDREN * sizeof(OctreeElement*);
+        getStats().externalChildrenMemoryUsage -= NUMBER_OF_CHILDREN * sizeof(OctreeElement*);
         if (childIndex == firstIndex) {
             _children.single = previousSecondChild;
         } else {
@@ -784,8 +854,9 @@ void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
 
     // track our population data
     if (previousChildCount != newChildCount) {
-        _childrenCount[previousChildCount]--;
-        _childrenCount[newChildCount]++;
+        OctreeElementStats& stats = getStats();
+        stats.childrenCount[previousChildCount]--;
+        stats.childrenCount[newChildCount]++;
     }
 
     // If we had 0 children and we still have 0 children, then there is nothing to do.
@@ -971,13 +1042,13 @@ void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
         _children.external = new OctreeElement*[newChildCount];
         memset(_children.external, 0, sizeof(OctreeElement*) * newChildCount);
 
-        _externalChildrenMemoryUsage += newChildCount * sizeof(OctreeElement*);
+        getStats().externalChildrenMemoryUsage += newChildCount * sizeof(OctreeElement*);
 
         _children.external[0] = childOne;
         _children.external[1] = childTwo;
         _children.external[2] = childThree;
         _children.external[3] = childFour;
-        _externalChildrenCount++;
+        getStats().externalChildrenCount++;
     } else if (previousChildCount == 4 && newChildCount == 3) {
         // If we had 4 children, and now have 3, then we know we are going from an external case to a potential internal case
         //assert(_children.external && _childrenExternal && previousChildCount == 4);
@@ -1013,8 +1084,8 @@ void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
         _childrenExternal = false;
         delete[] _children.external;
         _children.external = NULL;
-        _externalChildrenCount--;
-        _externalChildrenMemoryUsage -= previousChildCount * sizeof(OctreeElement*);
+        getStats().externalChildrenCount--;
+        getStats().externalChildrenMemoryUsage -= previousChildCount * sizeof(OctreeElement*);
         storeThreeChildren(childOne, childTwo, childThree);
     } else if (previousChildCount == newChildCount) {
         //assert(_children.external && _childrenExternal && previousChildCount >= 4);
@@ -1064,8 +1135,8 @@ void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
         }
         delete[] _children.external;
         _children.external = newExternalList;
-        _externalChildrenMemoryUsage -= previousChildCount * sizeof(OctreeElement*);
-        _externalChildrenMemoryUsage += newChildCount * sizeof(OctreeElement*);
+        getStats().externalChildrenMemoryUsage -= previousChildCount * sizeof(OctreeElement*);
+        getStats().externalChildrenMemoryUsage += newChildCount * sizeof(OctreeElement*);
 
     } else if (previousChildCount > newChildCount) {
         //assert(_children.external && _childrenExternal && previousChildCount >= 4);
@@ -1090,8 +1161,8 @@ void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
         }
         delete[] _children.external;
         _children.external = newExternalList;
-        _externalChildrenMemoryUsage -= previousChildCount * sizeof(OctreeElement*);
-        _externalChildrenMemoryUsage += newChildCount * sizeof(OctreeElement*);
+        getStats().externalChildrenMemoryUsage -= previousChildCount * sizeof(OctreeElement*);
+        getStats().externalChildrenMemoryUsage += newChildCount * sizeof(OctreeElement*);
     } else {
         //assert(false);
         qDebug("THIS SHOULD NOT HAPPEN previousChildCount == %d && newChildCount == %d",previousChildCount, newChildCount);
@@ -1117,7 +1188,7 @@ OctreeElement* OctreeElement::addChildAtIndex(int childIndex) {
     if (!childAt) {
         // before adding a child, see if we're currently a leaf
         if (isLeaf()) {
-            _voxelNodeLeafCount--;
+            getStats().leafCount--;
         }
 
         unsigned char* newChildCode = childOctalCode(getOctalCode(), childIndex);
@@ -1207,12 +1278,24 @@ ViewFrustum::location OctreeElement::inFrustum(const ViewFrustum& viewFrustum) c
 //    corner. We can use we can use this corner as our "voxel position" to do our distance calculations off of.
 //    By doing this, we don't need to test each child voxel's position vs the LOD boundary
 bool OctreeElement::calculateShouldRender(const ViewFrustum* viewFrustum, float voxelScaleSize, int boundaryLevelAdjust) const {
+    return hasContent() && calculateShouldRenderAtDistance(furthestDistanceToCamera(*viewFrustum), voxelScaleSize,
+        boundaryLevelAdjust);
+}
+
+bool OctreeElement::calculateShouldRenderAtDistance(float furthestDistance, float voxelScaleSize,
+                                                    int boundaryLevelAdjust) const {
+    // a packed subtree goes on below us, so we render as any other parent would
+    return shouldRenderAtDistance(hasContent(), isLeaf() && !hasPackedChildren(), getLevel(), furthestDistance,
+        voxelScaleSize, boundaryLevelAdjust);
+}
+
+bool OctreeElement::shouldRenderAtDistance(bool hasContent, bool isLeaf, int level, float furthestDistance,
+                                           float voxelScaleSize, int boundaryLevelAdjust) {
     bool shouldRender = false;
-    if (hasContent()) {
-        float furthestDistance = furthestDistanceToCamera(*viewFrustum);
-        float childBoundary = boundaryDistanceForRenderLevel(getLevel() + 1 + boundaryLevelAdjust, voxelScaleSize);
+    if (hasContent) {
+        float childBoundary = boundaryDistanceForRenderLevel(level + 1 + boundaryLevelAdjust, voxelScaleSize);
         bool inChildBoundary = (furthestDistance <= childBoundary);
-        if (isLeaf() && inChildBoundary) {
+        if (isLeaf && inChildBoundary) {
             shouldRender = true;
         } else {
             float boundary = childBoundary * 2.0f; // the boundary is always twice the distance of the child boundary
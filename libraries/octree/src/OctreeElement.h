@@ -18,6 +18,8 @@
 
 #include <QReadWriteLock>
 
+#include <MortonKey.h>
+#include <OctalCode.h>
 #include <SharedUtil.h>
 #include "AABox.h"
 #include "ViewFrustum.h"
@@ -26,6 +28,7 @@
 
 class Octree;
 class OctreeElement;
+class EncodeBitstreamParams;
 class OctreeElementDeleteHook;
 class OctreePacketData;
 class VoxelSystem;
@@ -44,6 +47,27 @@ public:
 };
 
 
+/// The running totals that elements keep of themselves: how many there are, how they hold their children, and the
+/// memory they take.  Threads that create or delete elements at once (the workers of VoxelTree::createVoxels, or
+/// voxel-edit's end node builds) must each keep their own, which the thread waiting for them merges, so that only one
+/// thread changes the shared ones at a time.  A thread that doesn't changes the shared ones.
+class OctreeElementStats {
+public:
+    OctreeElementStats();
+
+    void add(const OctreeElementStats& other);
+
+    quint64 nodeCount;
+    quint64 leafCount;
+    quint64 voxelMemoryUsage;
+    quint64 octcodeMemoryUsage;
+    quint64 externalChildrenMemoryUsage;
+    quint64 externalChildrenCount;
+    quint64 childrenCount[NUMBER_OF_CHILDREN + 1];
+    quint64 packedChildrenCount; ///< the packs (such as VoxelBricks) that stand in for elements' children
+    quint64 packedChildrenMemoryUsage;
+};
+
 class OctreeElement {
 
 protected:
@@ -95,12 +119,41 @@ public:
     
     virtual bool deleteApproved() const { return true; }
 
+    /// Override to indicate that this element holds its subtree in packed form, so that it has no child elements even
+    /// though the tree goes on below it.  Edits must unpackChildren before reaching into such a subtree, and encoding
+    /// writes it with appendPackedChildren.
+    virtual bool hasPackedChildren() const { return false; }
+
+    /// Override to turn a packed subtree back into child elements.
+    virtual void unpackChildren() { }
+
+    /// Override to write a packed subtree as the levels that encoding its elements would write, all at once (so a
+    /// packed subtree must always fit in an empty packet).
+    /// \param location where we lie with respect to the params' view frustum, if any
+    /// \return the number of bytes written, or zero if the subtree didn't fit
+    virtual int appendPackedChildren(OctreePacketData* packetData, EncodeBitstreamParams& params,
+        int currentEncodeLevel, ViewFrustum::location location) const { return 0; }
+
 
     virtual bool findSpherePenetration(const glm::vec3& center, float radius, 
                         glm::vec3& penetration, void** penetratedObject) const;
 
     // Base class methods you don't need to implement
     const unsigned char* getOctalCode() const { return (_octcodePointer) ? _octalCode.pointer : &_octalCode.buffer[0]; }
+    
+    /// Returns the fixed-width form of our octal code, which is invalid if we're deeper than MAX_MORTON_KEY_LEVELS.
+    const MortonKey& getMortonKey() const { return _mortonKey; }
+    
+    /// Returns the number of sections in our octal code.
+    int getOctalCodeLength() const {
+        return _mortonKey.isValid() ? _mortonKey.getLevel() : numberOfThreeBitSectionsInCode(getOctalCode());
+    }
+    
+    /// Returns the index of our child on the path to the given descendant, going by its key if that's valid.
+    int getBranchIndexToward(const MortonKey& descendantKey, const unsigned char* descendantOctalCode) const {
+        return descendantKey.isValid() ? _mortonKey.getBranchIndexToward(descendantKey)
+            : branchIndexWithDescendant(getOctalCode(), descendantOctalCode);
+    }
     OctreeElement* getChildAtIndex(int childIndex) const;
     void deleteChildAtIndex(int childIndex);
     OctreeElement* removeChildAtIndex(int childIndex);
@@ -112,7 +165,7 @@ public:
     const AABox& getAABox() const { return _box; }
     const glm::vec3& getCorner() const { return _box.getCorner(); }
     float getScale() const { return _box.getScale(); }
-    int getLevel() const { return numberOfThreeBitSectionsInCode(getOctalCode()) + 1; }
+    int getLevel() const { return getOctalCodeLength() + 1; }
     
     float getEnclosingRadius() const;
     bool isInView(const ViewFrustum& viewFrustum) const { return inFrustum(viewFrustum) != ViewFrustum::OUTSIDE; }
@@ -120,8 +173,20 @@ public:
     float distanceToCamera(const ViewFrustum& viewFrustum) const; 
     float furthestDistanceToCamera(const ViewFrustum& viewFrustum) const;
 
+    /// Classifies all of our children (present or not) at once; see ViewFrustum::childrenInFrustum.
+    void childrenInFrustum(const ViewFrustum& viewFrustum, ViewFrustum::ChildLocations& locations) const
+        { viewFrustum.childrenInFrustum(_box, locations); }
+
     bool calculateShouldRender(const ViewFrustum* viewFrustum, 
                 float voxelSizeScale = DEFAULT_OCTREE_SIZE_SCALE, int boundaryLevelAdjust = 0) const;
+
+    /// As calculateShouldRender, for when the furthest distance to the camera is already known.
+    bool calculateShouldRenderAtDistance(float furthestDistance,
+                float voxelSizeScale = DEFAULT_OCTREE_SIZE_SCALE, int boundaryLevelAdjust = 0) const;
+
+    /// The LOD rule behind calculateShouldRenderAtDistance, for cubes that aren't elements (those in packed subtrees).
+    static bool shouldRenderAtDistance(bool hasContent, bool isLeaf, int level, float furthestDistance,
+                float voxelSizeScale = DEFAULT_OCTREE_SIZE_SCALE, int boundaryLevelAdjust = 0);
     
     // points are assumed to be in Voxel Coordinates (not TREE_SCALE'd)
     float distanceSquareToPoint(const glm::vec3& point) const; // when you don't need the actual distance, use this.
@@ -137,6 +202,11 @@ public:
     void markWithChangedTime();
     quint64 getLastChanged() const { return _lastChanged; }
     void handleSubtreeChanged(Octree* myTree);
+
+    /// Checks whether the subtree below this element changed without its average being recalculated: see
+    /// Octree::reaverageChangedElements.
+    bool isAverageStale() const { return _isAverageStale; }
+    void clearAverageStaleBit() { _isAverageStale = false; }
     
     // Used by VoxelSystem for rendering in/out of view and LOD
     void setShouldRender(bool shouldRender);
@@ -155,15 +225,32 @@ public:
     static void addUpdateHook(OctreeElementUpdateHook* hook);
     static void removeUpdateHook(OctreeElementUpdateHook* hook);
     
+    /// Has the calling thread keep its running totals in the given set rather than the shared one, until it's called
+    /// again with NULL.
+    static void setThreadStats(OctreeElementStats* stats);
+
+    /// Adds totals that another thread kept to those that the calling thread changes (see getStats), so that a thread
+    /// that keeps its own totals and waits for others of its own (a createVoxels within an end node build, say) passes
+    /// theirs on with its own.  Call it once the other thread is done.
+    static void mergeStats(const OctreeElementStats& stats);
+
+    /// Returns the running totals that the calling thread changes: its own, if it keeps them, or else the shared ones.
+    static OctreeElementStats& getStats();
+
     static void resetPopulationStatistics();
-    static unsigned long getNodeCount() { return _voxelNodeCount; }
-    static unsigned long getInternalNodeCount() { return _voxelNodeCount - _voxelNodeLeafCount; }
-    static unsigned long getLeafNodeCount() { return _voxelNodeLeafCount; }
+    static unsigned long getNodeCount() { return _stats.nodeCount; }
+    static unsigned long getInternalNodeCount() { return _stats.nodeCount - _stats.leafCount; }
+    static unsigned long getLeafNodeCount() { return _stats.leafCount; }
+
+    static quint64 getVoxelMemoryUsage() { return _stats.voxelMemoryUsage; }
+    static quint64 getOctcodeMemoryUsage() { return _stats.octcodeMemoryUsage; }
+    static quint64 getExternalChildrenMemoryUsage() { return _stats.externalChildrenMemoryUsage; }
+    static quint64 getTotalMemoryUsage() {
+        return _stats.voxelMemoryUsage + _stats.octcodeMemoryUsage + _stats.externalChildrenMemoryUsage;
+    }
 
-    static quint64 getVoxelMemoryUsage() { return _voxelMemoryUsage; }
-    static quint64 getOctcodeMemoryUsage() { return _octcodeMemoryUsage; }
-    static quint64 getExternalChildrenMemoryUsage() { return _externalChildrenMemoryUsage; }
-    static quint64 getTotalMemoryUsage() { return _voxelMemoryUsage + _octcodeMemoryUsage + _externalChildrenMemoryUsage; }
+    static quint64 getPackedChildrenCount() { return _stats.packedChildrenCount; }
+    static quint64 getPackedChildrenMemoryUsage() { return _stats.packedChildrenMemoryUsage; }
 
     static quint64 getGetChildAtIndexTime() { return _getChildAtIndexTime; }
     static quint64 getGetChildAtIndexCalls() { return _getChildAtIndexCalls; }
@@ -180,8 +267,8 @@ public:
     static quint64 getCouldNotStoreFourChildrenInternally() { return _couldNotStoreFourChildrenInternally; }
 #endif
 
-    static quint64 getExternalChildrenCount() { return _externalChildrenCount; }
-    static quint64 getChildrenCount(int childCount) { return _childrenCount[childCount]; }
+    static quint64 getExternalChildrenCount() { return _stats.externalChildrenCount; }
+    static quint64 getChildrenCount(int childCount) { return _stats.childrenCount[childCount]; }
     
 #ifdef BLENDED_UNION_CHILDREN
 #ifdef HAS_AUDIT_CHILDREN
@@ -243,6 +330,8 @@ protected:
       unsigned char* pointer;
     } _octalCode;  
 
+    MortonKey _mortonKey; /// Client and server, the octal code as a fixed-width key for level and ancestry, 8 bytes
+
     quint64 _lastChanged; /// Client and server, timestamp this node was last changed, 8 bytes
 
     /// Client and server, pointers to child nodes, various encodings
@@ -283,6 +372,7 @@ protected:
 
     bool _falseColored : 1, /// Client only, is this voxel false colored, 1 bit
          _isDirty : 1, /// Client only, has this voxel changed since being rendered, 1 bit
+         _isAverageStale : 1, /// has the subtree below changed since this voxel was last averaged, 1 bit
          _shouldRender : 1, /// Client only, should this voxel render at this time, 1 bit
          _octcodePointer : 1, /// Client and Server only, is this voxel's octal code a pointer or buffer, 1 bit
          _unknownBufferIndex : 1,
@@ -294,12 +384,7 @@ protected:
     //static QReadWriteLock _updateHooksLock;
     static std::vector<OctreeElementUpdateHook*> _updateHooks;
 
-    static quint64 _voxelNodeCount;
-    static quint64 _voxelNodeLeafCount;
-
-    static quint64 _voxelMemoryUsage;
-    static quint64 _octcodeMemoryUsage;
-    static quint64 _externalChildrenMemoryUsage;
+    static OctreeElementStats _stats;
 
     static quint64 _getChildAtIndexTime;
     static quint64 _getChildAtIndexCalls;
@@ -315,8 +400,6 @@ protected:
     static quint64 _couldStoreFourChildrenInternally;
     static quint64 _couldNotStoreFourChildrenInternally;
 #endif
-    static quint64 _externalChildrenCount;
-    static quint64 _childrenCount[NUMBER_OF_CHILDREN + 1];
 };
 
 #endif // hifi_OctreeElement_h
@@ -11,6 +11,11 @@
 
 #include <algorithm>
 
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#define VIEW_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/transform.hpp>
@@ -352,6 +357,165 @@ ViewFrustum::location ViewFrustum::boxInFrustum(const AABox& box) const {
     return regularResult;
 }
 
+#ifdef VIEW_FRUSTUM_SSE
+
+// Sets the corners of the eight children of a cube, in two halves of four lanes: bit 2 of a child's index picks its
+// half (and x offset), bit 1 its y offset, and bit 0 its z offset.  The sums are exact, so the corners match the
+// children's own boxes.
+static void getChildCorners(const glm::vec3& corner, float childScale, __m128 x[2], __m128 y[2], __m128 z[2]) {
+    x[0] = _mm_set1_ps(corner.x);
+    x[1] = _mm_set1_ps(corner.x + childScale);
+    y[0] = y[1] = _mm_setr_ps(corner.y, corner.y, corner.y + childScale, corner.y + childScale);
+    z[0] = z[1] = _mm_setr_ps(corner.z, corner.z + childScale, corner.z, corner.z + childScale);
+}
+
+// Returns the lengths of four vectors, summing the squares in the same order as glm::dot.
+static inline __m128 lengths(__m128 x, __m128 y, __m128 z) {
+    return _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+}
+
+// Returns the distances of four points from a plane, in the same order of operations as Plane::distance.
+static inline __m128 planeDistances(const ::Plane& plane, __m128 x, __m128 y, __m128 z) {
+    const glm::vec3& normal = plane.getNormal();
+    __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(normal.x), x), _mm_mul_ps(_mm_set1_ps(normal.y), y)),
+        _mm_mul_ps(_mm_set1_ps(normal.z), z));
+    return _mm_add_ps(_mm_set1_ps(plane.getDCoefficient()), dot);
+}
+
+void ViewFrustum::childrenInFrustum(const AABox& box, ChildLocations& locations) const {
+    const int HALVES = 2;
+    const int LANES = 4;
+    float childScaleVoxelScale = box.getScale() * 0.5f;
+    glm::vec3 corner = box.getCorner() * (float)TREE_SCALE;
+    float childScale = childScaleVoxelScale * (float)TREE_SCALE;
+
+    __m128 nearX[HALVES], nearY[HALVES], nearZ[HALVES];
+    getChildCorners(corner, childScale, nearX, nearY, nearZ);
+    __m128 scale = _mm_set1_ps(childScale);
+    __m128 farX[HALVES], farY[HALVES], farZ[HALVES];
+    for (int h = 0; h < HALVES; h++) {
+        farX[h] = _mm_add_ps(nearX[h], scale);
+        farY[h] = _mm_add_ps(nearY[h], scale);
+        farZ[h] = _mm_add_ps(nearZ[h], scale);
+    }
+
+    // the same plane tests as boxInFrustum, on the P and N vertices of four children at a time
+    __m128 zero = _mm_setzero_ps();
+    int outsideBits = 0;
+    int intersectBits = 0;
+    for (int h = 0; h < HALVES; h++) {
+        __m128 outside = zero;
+        __m128 intersect = zero;
+        for (int i = 0; i < 6; i++) {
+            const glm::vec3& normal = _planes[i].getNormal();
+            __m128 vertexPDistances = planeDistances(_planes[i], normal.x > 0 ? farX[h] : nearX[h],
+                normal.y > 0 ? farY[h] : nearY[h], normal.z > 0 ? farZ[h] : nearZ[h]);
+            __m128 vertexNDistances = planeDistances(_planes[i], normal.x < 0 ? farX[h] : nearX[h],
+                normal.y < 0 ? farY[h] : nearY[h], normal.z < 0 ? farZ[h] : nearZ[h]);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(vertexPDistances, zero));
+            intersect = _mm_or_ps(intersect, _mm_cmplt_ps(vertexNDistances, zero));
+        }
+        outsideBits |= _mm_movemask_ps(outside) << (h * LANES);
+        intersectBits |= _mm_movemask_ps(intersect) << (h * LANES);
+    }
+    int regularInsideBits = ~(outsideBits | intersectBits) & 0xFF;
+    int regularIntersectBits = intersectBits & ~outsideBits;
+
+    // the keyhole is small, so few parents come near it; the children of those that do are tested one at a time
+    int keyholeInsideBits = 0;
+    int keyholeIntersectBits = 0;
+    if (_keyholeRadius >= 0.0f) {
+        const glm::vec3& keyholeCorner = _keyholeBoundingBox.getCorner();
+        float keyholeScale = _keyholeBoundingBox.getScale();
+        glm::vec3 farCorner = corner + glm::vec3(childScale * 2.0f);
+        if (corner.x <= keyholeCorner.x + keyholeScale && corner.y <= keyholeCorner.y + keyholeScale &&
+                corner.z <= keyholeCorner.z + keyholeScale && farCorner.x >= keyholeCorner.x &&
+                farCorner.y >= keyholeCorner.y && farCorner.z >= keyholeCorner.z) {
+            for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+                glm::vec3 childCorner(corner.x + ((i & 4) ? childScale : 0.0f),
+                    corner.y + ((i & 2) ? childScale : 0.0f), corner.z + ((i & 1) ? childScale : 0.0f));
+                ViewFrustum::location keyholeResult = boxInKeyhole(AABox(childCorner, childScale));
+                if (keyholeResult == INSIDE) {
+                    keyholeInsideBits |= (1 << i);
+                } else if (keyholeResult == INTERSECT) {
+                    keyholeIntersectBits |= (1 << i);
+                }
+            }
+        }
+    }
+
+    // as in boxInFrustum, inside the keyhole is inside, and outside the planes is wherever the keyhole says
+    locations.insideBits = keyholeInsideBits | regularInsideBits;
+    locations.intersectBits = ~keyholeInsideBits & (regularIntersectBits | (outsideBits & keyholeIntersectBits));
+
+    // distances to the centers, computed in TREE_SCALE as OctreeElement::distanceToCamera does
+    __m128 halfScale = _mm_set1_ps(childScale * 0.5f);
+    for (int h = 0; h < HALVES; h++) {
+        __m128 deltaX = _mm_sub_ps(_mm_set1_ps(_position.x), _mm_add_ps(nearX[h], halfScale));
+        __m128 deltaY = _mm_sub_ps(_mm_set1_ps(_position.y), _mm_add_ps(nearY[h], halfScale));
+        __m128 deltaZ = _mm_sub_ps(_mm_set1_ps(_position.z), _mm_add_ps(nearZ[h], halfScale));
+        _mm_storeu_ps(locations.distances + h * LANES, lengths(deltaX, deltaY, deltaZ));
+    }
+
+    // distances to the furthest corners, computed in voxel scale as OctreeElement::furthestDistanceToCamera does
+    getChildCorners(box.getCorner(), childScaleVoxelScale, nearX, nearY, nearZ);
+    __m128 scaleVoxelScale = _mm_set1_ps(childScaleVoxelScale);
+    __m128 halfScaleVoxelScale = _mm_set1_ps(childScaleVoxelScale * 0.5f);
+    __m128 positionX = _mm_set1_ps(_positionVoxelScale.x);
+    __m128 positionY = _mm_set1_ps(_positionVoxelScale.y);
+    __m128 positionZ = _mm_set1_ps(_positionVoxelScale.z);
+    __m128 treeScale = _mm_set1_ps((float)TREE_SCALE);
+    for (int h = 0; h < HALVES; h++) {
+        // where we're below the center on an axis, the far edge is furthest
+        __m128 belowX = _mm_cmplt_ps(positionX, _mm_add_ps(nearX[h], halfScaleVoxelScale));
+        __m128 belowY = _mm_cmplt_ps(positionY, _mm_add_ps(nearY[h], halfScaleVoxelScale));
+        __m128 belowZ = _mm_cmplt_ps(positionZ, _mm_add_ps(nearZ[h], halfScaleVoxelScale));
+        __m128 furthestX = _mm_or_ps(_mm_and_ps(belowX, _mm_add_ps(nearX[h], scaleVoxelScale)),
+            _mm_andnot_ps(belowX, nearX[h]));
+        __m128 furthestY = _mm_or_ps(_mm_and_ps(belowY, _mm_add_ps(nearY[h], scaleVoxelScale)),
+            _mm_andnot_ps(belowY, nearY[h]));
+        __m128 furthestZ = _mm_or_ps(_mm_and_ps(belowZ, _mm_add_ps(nearZ[h], scaleVoxelScale)),
+            _mm_andnot_ps(belowZ, nearZ[h]));
+        __m128 furthestDistances = lengths(_mm_sub_ps(positionX, furthestX), _mm_sub_ps(positionY, furthestY),
+            _mm_sub_ps(positionZ, furthestZ));
+        _mm_storeu_ps(locations.furthestDistances + h * LANES, _mm_mul_ps(furthestDistances, treeScale));
+    }
+}
+
+#else
+
+void ViewFrustum::childrenInFrustum(const AABox& box, ChildLocations& locations) const {
+    // without SSE, each child goes through the same functions the elements would use for themselves
+    float childScaleVoxelScale = box.getScale() * 0.5f;
+    const glm::vec3& cornerVoxelScale = box.getCorner();
+    glm::vec3 corner = cornerVoxelScale * (float)TREE_SCALE;
+    float childScale = childScaleVoxelScale * (float)TREE_SCALE;
+    locations.insideBits = 0;
+    locations.intersectBits = 0;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        AABox childBox(glm::vec3(corner.x + ((i & 4) ? childScale : 0.0f), corner.y + ((i & 2) ? childScale : 0.0f),
+            corner.z + ((i & 1) ? childScale : 0.0f)), childScale);
+        ViewFrustum::location result = boxInFrustum(childBox);
+        if (result == INSIDE) {
+            locations.insideBits |= (1 << i);
+        } else if (result == INTERSECT) {
+            locations.intersectBits |= (1 << i);
+        }
+        glm::vec3 delta = _position - childBox.calcCenter();
+        locations.distances[i] = sqrtf(glm::dot(delta, delta));
+
+        AABox childBoxVoxelScale(glm::vec3(cornerVoxelScale.x + ((i & 4) ? childScaleVoxelScale : 0.0f),
+            cornerVoxelScale.y + ((i & 2) ? childScaleVoxelScale : 0.0f),
+            cornerVoxelScale.z + ((i & 1) ? childScaleVoxelScale : 0.0f)), childScaleVoxelScale);
+        glm::vec3 furthestPoint;
+        getFurthestPointFromCameraVoxelScale(childBoxVoxelScale, furthestPoint);
+        delta = _positionVoxelScale - furthestPoint;
+        locations.furthestDistances[i] = sqrtf(glm::dot(delta, delta)) * (float)TREE_SCALE;
+    }
+}
+
+#endif // VIEW_FRUSTUM_SSE
+
 bool testMatches(glm::quat lhs, glm::quat rhs, float epsilon = EPSILON) {
     return (fabs(lhs.x - rhs.x) <= epsilon && fabs(lhs.y - rhs.y) <= epsilon && fabs(lhs.z - rhs.z) <= epsilon
             && fabs(lhs.w - rhs.w) <= epsilon);
@@ -96,6 +96,26 @@ public:
     ViewFrustum::location sphereInFrustum(const glm::vec3& center, float radius) const;
     ViewFrustum::location boxInFrustum(const AABox& box) const;
 
+    /// Where each of the eight children of a cube lies with respect to the frustum, along with the distances that the
+    /// LOD checks need.  Bit i of each mask stands for child i; children in neither mask are outside.
+    class ChildLocations {
+    public:
+        unsigned char insideBits;
+        unsigned char intersectBits;
+        float distances[NUMBER_OF_CHILDREN]; ///< from the camera to each child's center, in TREE_SCALE
+        float furthestDistances[NUMBER_OF_CHILDREN]; ///< from the camera to each child's furthest corner, in TREE_SCALE
+
+        ViewFrustum::location getLocation(int childIndex) const {
+            return (insideBits & (1 << childIndex)) ? INSIDE :
+                ((intersectBits & (1 << childIndex)) ? INTERSECT : OUTSIDE);
+        }
+    };
+
+    /// Classifies all eight children of a cube at once, four at a time with SSE (or one at a time where SSE isn't
+    /// available), giving exactly the answers that boxInFrustum and the element distance functions give for each child.
+    /// \param box the parent cube, in voxel scale rather than TREE_SCALE
+    void childrenInFrustum(const AABox& box, ChildLocations& locations) const;
+
     // some frustum comparisons
     bool matches(const ViewFrustum& compareTo, bool debug = false) const;
     bool matches(const ViewFrustum* compareTo, bool debug = false) const { return matches(*compareTo, debug); }
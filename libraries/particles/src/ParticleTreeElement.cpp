@@ -19,7 +19,7 @@ ParticleTreeElement::ParticleTreeElement(unsigned char* octalCode) : OctreeEleme
 };
 
 ParticleTreeElement::~ParticleTreeElement() {
-    _voxelMemoryUsage -= sizeof(ParticleTreeElement);
+    getStats().voxelMemoryUsage -= sizeof(ParticleTreeElement);
     delete _particles;
     _particles = NULL;
 }
@@ -37,7 +37,7 @@ OctreeElement* ParticleTreeElement::createNewElement(unsigned char* octalCode) {
 void ParticleTreeElement::init(unsigned char* octalCode) {
     OctreeElement::init(octalCode);
     _particles = new QList<Particle>;
-    _voxelMemoryUsage += sizeof(ParticleTreeElement);
+    getStats().voxelMemoryUsage += sizeof(ParticleTreeElement);
 }
 
 ParticleTreeElement* ParticleTreeElement::addChildAtIndex(int index) {
@@ -17,6 +17,7 @@
 #include <QtNetwork/QNetworkRequest>
 #include <QtNetwork/QNetworkReply>
 
+#include <AudioCodec.h>
 #include <AudioRingBuffer.h>
 #include <AvatarData.h>
 #include <NodeList.h>
@@ -361,6 +362,9 @@ void ScriptEngine::run() {
                 glm::quat headOrientation = _avatarData->getHeadOrientation();
                 packetStream.writeRawData(reinterpret_cast<const char*>(&headOrientation), sizeof(glm::quat));
 
+                // agents are usually on the mixer's network, so they send (and are sent) uncompressed audio
+                packetStream << AudioCodecType::PCM;
+
                 if (silentFrame) {
                     if (!_isListeningToAudioStream) {
                         // if we have a silent frame and we're not listening then just send nothing and break out of here
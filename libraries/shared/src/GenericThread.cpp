@@ -12,11 +12,13 @@
 #include <QDebug>
 
 #include "GenericThread.h"
+#include "SharedUtil.h"
 
 
 GenericThread::GenericThread() :
     _stopThread(false),
-    _isThreaded(false) // assume non-threaded, must call initialize()
+    _isThreaded(false), // assume non-threaded, must call initialize()
+    _cpuUsecs(0)
 {
 }
 
@@ -57,6 +59,8 @@ void GenericThread::terminate() {
 }
 
 void GenericThread::threadRoutine() {
+    // keep a running count of the thread's CPU time, so that whoever owns us can report it
+    quint64 lastCPUUsecs = _isThreaded ? usecThreadCPUTime() : 0;
     while (!_stopThread) {
 
         // override this function to do whatever your class actually does, return false to exit thread early
@@ -69,6 +73,10 @@ void GenericThread::threadRoutine() {
         if (!_isThreaded) {
             break;
         }
+
+        quint64 cpuUsecs = usecThreadCPUTime();
+        _cpuUsecs.fetchAndAddRelaxed((int)(cpuUsecs - lastCPUUsecs));
+        lastCPUUsecs = cpuUsecs;
     }
 
     // If we were on a thread, then quit our thread
@@ -14,6 +14,7 @@
 #ifndef hifi_GenericThread_h
 #define hifi_GenericThread_h
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QObject>
 #include <QMutex>
 #include <QThread>
@@ -40,6 +41,10 @@ public:
 
     bool isThreaded() const { return _isThreaded; }
 
+    /// Returns the CPU time used by the thread since the last call, in microseconds.  Only counted in threaded mode;
+    /// otherwise the work is done on (and counted against) the caller's thread.  Safe to call from any thread.
+    int takeCPUUsecs() { return _cpuUsecs.fetchAndStoreRelaxed(0); }
+
 public slots:
     /// If you're running in non-threaded mode, you must call this regularly
     void threadRoutine();
@@ -63,6 +68,7 @@ private:
     bool _stopThread;
     bool _isThreaded;
     QThread* _thread;
+    QAtomicInt _cpuUsecs;
 };
 
 #endif // hifi_GenericThread_h
@@ -0,0 +1,135 @@
+//
+//  MortonKey.cpp
+//  libraries/shared/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cmath>
+#include <cstring>
+
+#include "MortonKey.h"
+#include "OctalCode.h"
+#include "SharedUtil.h"
+
+MortonKey::MortonKey(const unsigned char* octalCode) :
+    _bits(1)
+{
+    if (!octalCode) {
+        return;
+    }
+    int length = numberOfThreeBitSectionsInCode(octalCode);
+    if (length > MAX_MORTON_KEY_LEVELS) {
+        _bits = 0;
+        return;
+    }
+    // the sections are packed big end first after the length byte, so read them as one big-endian number
+    const unsigned char* sections = octalCode + 1;
+    int numBits = length * BITS_IN_OCTAL;
+    int numBytes = (numBits + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+    quint64 packed = 0;
+    for (int i = 0; i < numBytes; i++) {
+        packed = (packed << BITS_IN_BYTE) | sections[i];
+    }
+    packed >>= (numBytes * BITS_IN_BYTE - numBits);
+    _bits = (_bits << numBits) | packed;
+}
+
+/// Spreads the low 21 bits out to every third bit (starting with the lowest).
+static quint64 spreadToEveryThirdBit(quint32 value) {
+    quint64 bits = value & 0x1fffffULL;
+    bits = (bits | (bits << 32)) & 0x1f00000000ffffULL;
+    bits = (bits | (bits << 16)) & 0x1f0000ff0000ffULL;
+    bits = (bits | (bits << 8)) & 0x100f00f00f00f00fULL;
+    bits = (bits | (bits << 4)) & 0x10c30c30c30c30c3ULL;
+    bits = (bits | (bits << 2)) & 0x1249249249249249ULL;
+    return bits;
+}
+
+MortonKey MortonKey::forCoordinates(int level, quint32 x, quint32 y, quint32 z) {
+    if (level > MAX_MORTON_KEY_LEVELS) {
+        return invalid();
+    }
+    // each section is x, y, z from high bit to low
+    return MortonKey(((quint64)1 << (3 * level)) | (spreadToEveryThirdBit(x) << 2) |
+        (spreadToEveryThirdBit(y) << 1) | spreadToEveryThirdBit(z));
+}
+
+/// Returns the coordinate of the voxel of the given dimension (in voxels) holding the point, clamped to the tree.
+static quint32 voxelCoordinate(float value, int dimension) {
+    return (quint32)glm::clamp((int)floorf(value * dimension), 0, dimension - 1);
+}
+
+MortonKey MortonKey::forVoxel(float x, float y, float z, float s) {
+    // the level is that of the largest voxel no bigger than s
+    int level = 0;
+    for (float scale = 1.0f; scale > s && level <= MAX_MORTON_KEY_LEVELS; scale *= 0.5f) {
+        level++;
+    }
+    if (level > MAX_MORTON_KEY_LEVELS) {
+        return invalid();
+    }
+    int dimension = 1 << level;
+    return forCoordinates(level, voxelCoordinate(x, dimension), voxelCoordinate(y, dimension),
+        voxelCoordinate(z, dimension));
+}
+
+bool MortonKey::isAncestorOf(const MortonKey& other) const {
+    int levelDifference = other.getLevel() - getLevel();
+    return levelDifference >= 0 && (other._bits >> (3 * levelDifference)) == _bits;
+}
+
+bool MortonKey::precedes(const MortonKey& other) const {
+    // compare the two at the depth of the deeper; if one is then a prefix of the other, the shallower comes first
+    int levelDifference = other.getLevel() - getLevel();
+    if (levelDifference >= 0) {
+        quint64 bits = _bits << (3 * levelDifference);
+        return bits == other._bits ? levelDifference > 0 : bits < other._bits;
+    }
+    quint64 otherBits = other._bits << (-3 * levelDifference);
+    return _bits < otherBits;
+}
+
+/// Gathers every third bit (starting with the lowest) into the low 21 bits.
+static quint32 compactEveryThirdBit(quint64 bits) {
+    bits &= 0x1249249249249249ULL;
+    bits = (bits ^ (bits >> 2)) & 0x10c30c30c30c30c3ULL;
+    bits = (bits ^ (bits >> 4)) & 0x100f00f00f00f00fULL;
+    bits = (bits ^ (bits >> 8)) & 0x1f0000ff0000ffULL;
+    bits = (bits ^ (bits >> 16)) & 0x1f00000000ffffULL;
+    bits = (bits ^ (bits >> 32)) & 0x1fffffULL;
+    return (quint32)bits;
+}
+
+glm::vec3 MortonKey::getCorner() const {
+    // each section is x, y, z from high bit to low
+    int level = getLevel();
+    quint64 sections = _bits ^ ((quint64)1 << (3 * level));
+    float scale = getScale();
+    return glm::vec3(compactEveryThirdBit(sections >> 2) * scale, compactEveryThirdBit(sections >> 1) * scale,
+        compactEveryThirdBit(sections) * scale);
+}
+
+int MortonKey::writeOctalCode(unsigned char* octalCode) const {
+    int length = getLevel();
+    int numBytes = bytesRequiredForCodeLength(length);
+    octalCode[0] = length;
+    int numBits = length * BITS_IN_OCTAL;
+    int numSectionBytes = numBytes - 1;
+    quint64 sections = (_bits ^ ((quint64)1 << numBits)) << (numSectionBytes * BITS_IN_BYTE - numBits);
+    for (int i = numSectionBytes; i > 0; i--) {
+        octalCode[i] = (unsigned char)sections;
+        sections >>= BITS_IN_BYTE;
+    }
+    return numBytes;
+}
+
+unsigned char* MortonKey::createOctalCode() const {
+    unsigned char* octalCode = new unsigned char[bytesRequiredForCodeLength(getLevel())];
+    writeOctalCode(octalCode);
+    return octalCode;
+}
@@ -0,0 +1,118 @@
+//
+//  MortonKey.h
+//  libraries/shared/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_MortonKey_h
+#define hifi_MortonKey_h
+
+#include <QtCore/QHash>
+
+#include <glm/glm.hpp>
+
+/// The deepest level a MortonKey can hold: at TREE_SCALE, voxels of less than a centimeter.
+const int MAX_MORTON_KEY_LEVELS = 21;
+
+/// A fixed-width form of an octal code: its three bit sections in order, packed into the low bits of a 64-bit word
+/// below a single marker bit, so that the position of the marker gives the level.  Level, parent, child, and ancestry
+/// are then a shift and a compare rather than a walk over bytes, and keys need no allocation.  Codes deeper than
+/// MAX_MORTON_KEY_LEVELS don't fit, and give an invalid key; callers fall back to the octal code itself.  The
+/// byte-string form remains what goes over the wire and into files.
+class MortonKey {
+public:
+
+    /// Creates the key of the root.
+    MortonKey() : _bits(1) { }
+
+    /// Creates the key for an octal code (NULL meaning the root), which is invalid if the code is too deep.
+    explicit MortonKey(const unsigned char* octalCode);
+
+    static MortonKey invalid() { return MortonKey((quint64)0); }
+
+    /// Returns the key of the voxel at the given level whose integer coordinates (in voxels of that level) are given.
+    static MortonKey forCoordinates(int level, quint32 x, quint32 y, quint32 z);
+
+    /// Returns the key of the voxel of size s (in tree units) that holds the point, as pointToVoxel would code it,
+    /// which is invalid if the voxel is too small.
+    static MortonKey forVoxel(float x, float y, float z, float s);
+
+    bool isValid() const { return _bits != 0; }
+
+    /// Returns the number of sections in the code, which is zero for the root.
+    int getLevel() const { return highestSetBit(_bits) / 3; }
+
+    MortonKey getParent() const { return MortonKey(_bits >> 3); }
+    MortonKey getChild(int childIndex) const { return MortonKey((_bits << 3) | childIndex); }
+
+    /// Returns the index of this key among its parent's children.
+    int getChildIndex() const { return _bits & 7; }
+
+    /// Returns the ancestor at the given level, which must be no deeper than our own.
+    MortonKey getAncestor(int level) const { return MortonKey(_bits >> (3 * (getLevel() - level))); }
+
+    /// Checks whether this key is the given one or one of its ancestors.
+    bool isAncestorOf(const MortonKey& other) const;
+
+    /// Returns the index of our child on the path to the given descendant (which must be deeper than we are).
+    int getBranchIndexToward(const MortonKey& descendant) const {
+        return (descendant._bits >> (3 * (descendant.getLevel() - getLevel() - 1))) & 7;
+    }
+
+    /// Returns the minimum corner of the voxel, in tree units.
+    glm::vec3 getCorner() const;
+
+    /// Returns the size of the voxel, in tree units.
+    float getScale() const { return 1.0f / (1 << getLevel()); }
+
+    /// Writes the octal code for the key, returning the number of bytes written (see bytesRequiredForCodeLength).
+    int writeOctalCode(unsigned char* octalCode) const;
+
+    /// Returns the octal code for the key, which the caller must delete[].
+    unsigned char* createOctalCode() const;
+
+    quint64 getBits() const { return _bits; }
+
+    bool operator==(const MortonKey& other) const { return _bits == other._bits; }
+    bool operator!=(const MortonKey& other) const { return _bits != other._bits; }
+
+    /// Orders keys of the same level along the Z-order curve.
+    bool operator<(const MortonKey& other) const { return _bits < other._bits; }
+
+    /// Orders keys of any level depth first: each key comes before its descendants, and they before its next sibling.
+    bool precedes(const MortonKey& other) const;
+
+private:
+
+    explicit MortonKey(quint64 bits) : _bits(bits) { }
+
+    static int highestSetBit(quint64 bits);
+
+    quint64 _bits;
+};
+
+inline uint qHash(const MortonKey& key, uint seed = 0) {
+    return qHash(key.getBits(), seed);
+}
+
+inline int MortonKey::highestSetBit(quint64 bits) {
+#ifdef __GNUC__
+    return bits ? 63 - __builtin_clzll(bits) : 0;
+#else
+    int bit = 0;
+    for (int shift = 32; shift > 0; shift >>= 1) {
+        if (bits >> shift) {
+            bits >>= shift;
+            bit += shift;
+        }
+    }
+    return bit;
+#endif
+}
+
+#endif // hifi_MortonKey_h
@@ -17,6 +17,11 @@
 
 #ifdef __APPLE__
 #include <CoreFoundation/CoreFoundation.h>
+#include <mach/mach.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
 #endif
 
 #include <QtCore/QDebug>
@@ -39,6 +44,64 @@ quint64 usecTimestampNow() {
     return (now.tv_sec * 1000000 + now.tv_usec) + ::usecTimestampNowAdjust;
 }
 
+quint64 usecThreadCPUTime() {
+#if defined(_WIN32)
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+    // file times are in 100 nanosecond units
+    quint64 kernelUnits = ((quint64)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+    quint64 userUnits = ((quint64)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+    return (kernelUnits + userUnits) / 10;
+    
+#elif defined(__APPLE__)
+    mach_port_t thread = mach_thread_self();
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    kern_return_t result = thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info, &count);
+    mach_port_deallocate(mach_task_self(), thread);
+    if (result != KERN_SUCCESS) {
+        return 0;
+    }
+    return (quint64)(info.user_time.seconds + info.system_time.seconds) * USECS_PER_SECOND +
+        info.user_time.microseconds + info.system_time.microseconds;
+    
+#else
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+        return 0;
+    }
+    return (quint64)time.tv_sec * USECS_PER_SECOND + time.tv_nsec / 1000;
+#endif
+}
+
+quint64 processResidentMemoryBytes() {
+#if defined(_WIN32)
+    // would require linking against psapi
+    return 0;
+    
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+    
+#else
+    // the second field of statm is the resident set size in pages
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    unsigned long totalPages = 0, residentPages = 0;
+    int fieldsRead = fscanf(statm, "%lu %lu", &totalPages, &residentPages);
+    fclose(statm);
+    return fieldsRead == 2 ? (quint64)residentPages * sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
+
 float randFloat() {
     return (rand() % 10000)/10000.f;
 }
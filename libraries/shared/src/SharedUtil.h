@@ -70,6 +70,12 @@ quint64 usecTimestamp(const timeval *time);
 quint64 usecTimestampNow();
 void usecTimestampNowForceClockSkew(int clockSkew);
 
+/// Returns the CPU time used so far by the calling thread, in microseconds (zero where unsupported).
+quint64 usecThreadCPUTime();
+
+/// Returns the resident memory of the process, in bytes (zero where unsupported).
+quint64 processResidentMemoryBytes();
+
 float randFloat();
 int randIntInRange (int min, int max);
 float randFloatInRange (float min,float max);
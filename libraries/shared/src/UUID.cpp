@@ -9,9 +9,31 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <cstring>
+
+#include <QtCore/QtEndian>
+
 #include "UUID.h"
 
 QString uuidStringWithoutCurlyBraces(const QUuid& uuid) {
     QString uuidStringNoBraces = uuid.toString().mid(1, uuid.toString().length() - 2);
     return uuidStringNoBraces;
 }
+
+void writeRfc4122(const QUuid& uuid, char* destination) {
+    uchar* position = reinterpret_cast<uchar*>(destination);
+    qToBigEndian(uuid.data1, position);
+    qToBigEndian(uuid.data2, position + sizeof(uuid.data1));
+    qToBigEndian(uuid.data3, position + sizeof(uuid.data1) + sizeof(uuid.data2));
+    memcpy(position + sizeof(uuid.data1) + sizeof(uuid.data2) + sizeof(uuid.data3), uuid.data4, sizeof(uuid.data4));
+}
+
+QUuid uuidFromRfc4122(const char* source) {
+    const uchar* position = reinterpret_cast<const uchar*>(source);
+    QUuid uuid;
+    uuid.data1 = qFromBigEndian<quint32>(position);
+    uuid.data2 = qFromBigEndian<quint16>(position + sizeof(uuid.data1));
+    uuid.data3 = qFromBigEndian<quint16>(position + sizeof(uuid.data1) + sizeof(uuid.data2));
+    memcpy(uuid.data4, position + sizeof(uuid.data1) + sizeof(uuid.data2) + sizeof(uuid.data3), sizeof(uuid.data4));
+    return uuid;
+}
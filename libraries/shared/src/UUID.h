@@ -18,4 +18,10 @@ const int NUM_BYTES_RFC4122_UUID = 16;
 
 QString uuidStringWithoutCurlyBraces(const QUuid& uuid);
 
+/// Writes the UUID's RFC 4122 bytes (those toRfc4122 returns) without allocating.
+void writeRfc4122(const QUuid& uuid, char* destination);
+
+/// Reads RFC 4122 bytes in place, rather than from the copy that fromRfc4122 needs.
+QUuid uuidFromRfc4122(const char* source);
+
 #endif // hifi_UUID_h
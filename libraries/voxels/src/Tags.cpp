@@ -9,6 +9,7 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
 #include <iostream>
 
 #include <zconf.h>
@@ -262,6 +263,168 @@ int ungzip(std::ifstream &file, std::stringstream &ss) {
 }
 
 
+SchematicReader::SchematicReader() :
+    _file(NULL),
+    _idsFile(NULL),
+    _dataFile(NULL),
+    _width(0),
+    _height(0),
+    _length(0),
+    _idsOffset(-1),
+    _dataOffset(-1),
+    _blocksRead(0)
+{
+}
+
+SchematicReader::~SchematicReader() {
+    close();
+}
+
+bool SchematicReader::open(const char* fileName) {
+    close();
+
+    // gzopen reads uncompressed files as they are
+    if (!(_file = gzopen(fileName, "rb")) || gzgetc(_file) != TAG_Compound || !readRootCompound()) {
+        close();
+        return false;
+    }
+    gzclose(_file);
+    _file = NULL;
+
+    if (_width <= 0 || _height <= 0 || _length <= 0 || _idsOffset < 0 || _dataOffset < 0 ||
+            !(_idsFile = gzopen(fileName, "rb")) || gzseek(_idsFile, _idsOffset, SEEK_SET) != _idsOffset ||
+            !(_dataFile = gzopen(fileName, "rb")) || gzseek(_dataFile, _dataOffset, SEEK_SET) != _dataOffset) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+int SchematicReader::read(unsigned char* ids, unsigned char* data, int maxBlocks) {
+    int blocks = std::min(maxBlocks, getBlockCount() - _blocksRead);
+    if (blocks <= 0 || !_idsFile || gzread(_idsFile, ids, blocks) != blocks ||
+            gzread(_dataFile, data, blocks) != blocks) {
+        return 0;
+    }
+    _blocksRead += blocks;
+    return blocks;
+}
+
+bool SchematicReader::readShort(int& value) {
+    unsigned char bytes[2];
+    if (gzread(_file, bytes, sizeof(bytes)) != sizeof(bytes)) {
+        return false;
+    }
+    value = (int16_t)(bytes[0] << 8 | bytes[1]);
+    return true;
+}
+
+bool SchematicReader::readInt(int& value) {
+    unsigned char bytes[4];
+    if (gzread(_file, bytes, sizeof(bytes)) != sizeof(bytes)) {
+        return false;
+    }
+    value = (int32_t)(bytes[0] << 24 | bytes[1] << 16 | bytes[2] << 8 | bytes[3]);
+    return true;
+}
+
+bool SchematicReader::skip(int bytes) {
+    return bytes >= 0 && gzseek(_file, bytes, SEEK_CUR) != -1;
+}
+
+bool SchematicReader::skipPayload(int tagId) {
+    int size;
+    switch (tagId) {
+        case TAG_Byte:
+            return skip(1);
+        case TAG_Short:
+            return skip(2);
+        case TAG_Int:
+        case TAG_Float:
+            return skip(4);
+        case TAG_Long:
+        case TAG_Double:
+            return skip(8);
+        case TAG_Byte_Array:
+            return readInt(size) && skip(size);
+        case TAG_String:
+            return readShort(size) && skip((uint16_t)size);
+        case TAG_Int_Array:
+            return readInt(size) && size >= 0 && skip(size * 4);
+        case TAG_List: {
+            int elementTagId = gzgetc(_file);
+            if (elementTagId == -1 || !readInt(size)) {
+                return false;
+            }
+            for (int i = 0; i < size; i++) {
+                if (!skipPayload(elementTagId)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case TAG_Compound:
+            for (int childTagId; (childTagId = gzgetc(_file)) != TAG_End; ) {
+                if (childTagId == -1 || !readShort(size) || !skip((uint16_t)size) || !skipPayload(childTagId)) {
+                    return false;
+                }
+            }
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool SchematicReader::readRootCompound() {
+    int size;
+    if (!readShort(size) || !skip((uint16_t)size)) {
+        return false;
+    }
+    // note the dimensions and where the block arrays start, and skip everything else
+    int idsSize = -1, dataSize = -1;
+    for (int tagId; (tagId = gzgetc(_file)) != TAG_End; ) {
+        if (tagId == -1 || !readShort(size)) {
+            return false;
+        }
+        std::string name((uint16_t)size, '\0');
+        if (size != 0 && gzread(_file, &name[0], name.size()) != (int)name.size()) {
+            return false;
+        }
+        if (tagId == TAG_Short && (name == "Width" || name == "Height" || name == "Length")) {
+            int value;
+            if (!readShort(value)) {
+                return false;
+            }
+            (name == "Width" ? _width : (name == "Height" ? _height : _length)) = value;
+
+        } else if (tagId == TAG_Byte_Array && (name == "Blocks" || name == "Data")) {
+            if (!readInt(size)) {
+                return false;
+            }
+            (name == "Blocks" ? idsSize : dataSize) = size;
+            (name == "Blocks" ? _idsOffset : _dataOffset) = gztell(_file);
+            if (!skip(size)) {
+                return false;
+            }
+        } else if (!skipPayload(tagId)) {
+            return false;
+        }
+    }
+    return idsSize == getBlockCount() && dataSize == getBlockCount();
+}
+
+void SchematicReader::close() {
+    gzFile* files[] = { &_file, &_idsFile, &_dataFile };
+    for (unsigned int i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        if (*files[i]) {
+            gzclose(*files[i]);
+            *files[i] = NULL;
+        }
+    }
+    _blocksRead = 0;
+}
+
 void computeBlockColor(int id, int data, int& red, int& green, int& blue, int& create) {
 
     switch (id) {
@@ -21,6 +21,9 @@
 #include <sstream>
 #include <list>
 
+// zlib's handle type, declared here so that only Tags.cpp needs zlib's headers
+typedef struct gzFile_s* gzFile;
+
 #define TAG_End        0
 #define TAG_Byte       1
 #define TAG_Short      2
@@ -180,4 +183,44 @@ private:
     int* _data;
 };
 
+/// Streams the blocks of a (possibly gzipped) schematic file a chunk at a time, rather than decoding the whole file
+/// into tags: a first pass skips through the file for the dimensions and the offsets of the block id and data
+/// arrays, and then a reader at each array walks the two side by side.
+class SchematicReader {
+public:
+    SchematicReader();
+    ~SchematicReader();
+
+    /// Opens the file and finds its dimensions and block arrays.
+    /// \return false if the file couldn't be read or isn't a schematic
+    bool open(const char* fileName);
+
+    int getWidth() const { return _width; }
+    int getHeight() const { return _height; }
+    int getLength() const { return _length; }
+    int getBlockCount() const { return _width * _height * _length; }
+
+    /// Reads the ids and data of up to maxBlocks more blocks, in the schematic's order (x fastest, then z, then y).
+    /// \return the number of blocks read, which is zero at the end or on error
+    int read(unsigned char* ids, unsigned char* data, int maxBlocks);
+
+private:
+    bool readShort(int& value);
+    bool readInt(int& value);
+    bool skip(int bytes);
+    bool skipPayload(int tagId);
+    bool readRootCompound();
+    void close();
+
+    gzFile _file;
+    gzFile _idsFile;
+    gzFile _dataFile;
+    int _width;
+    int _height;
+    int _length;
+    long _idsOffset;
+    long _dataOffset;
+    int _blocksRead;
+};
+
 #endif // hifi_Tags_h
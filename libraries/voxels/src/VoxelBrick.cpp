@@ -0,0 +1,260 @@
+//
+//  VoxelBrick.cpp
+//  libraries/voxels/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cstring>
+
+#include <Octree.h>
+
+#include "VoxelBrick.h"
+#include "VoxelTreeElement.h"
+
+void VoxelBrickJournal::recordUnpacking(const MortonKey& key) {
+    QMutexLocker locker(&_mutex);
+    _unpackedKeys.insert(key);
+}
+
+QSet<MortonKey> VoxelBrickJournal::takeUnpackedKeys() {
+    QMutexLocker locker(&_mutex);
+    QSet<MortonKey> keys = _unpackedKeys;
+    _unpackedKeys.clear();
+    return keys;
+}
+
+VoxelBrick* VoxelBrick::pack(VoxelTreeElement* element, VoxelBrickJournal* journal, int minimumLeaves) {
+    // the cubes in a brick are found by key, so the leaves have to be within the keys' reach
+    const MortonKey& key = element->getMortonKey();
+    if (element->isLeaf() || !key.isValid() || key.getLevel() + VOXEL_BRICK_LEVELS > MAX_MORTON_KEY_LEVELS) {
+        return NULL;
+    }
+    quint64 leaves = 0;
+    int leafCount = 0;
+    for (int branch = 0; branch < NUMBER_OF_CHILDREN; branch++) {
+        VoxelTreeElement* branchElement = element->getChildAtIndex(branch);
+        if (!branchElement) {
+            continue;
+        }
+        // a brick keeps the branches' averages, so those have to be up to date
+        if (branchElement->isLeaf() || branchElement->hasPackedChildren() || branchElement->isAverageStale()) {
+            return NULL;
+        }
+        for (int leaf = 0; leaf < NUMBER_OF_CHILDREN; leaf++) {
+            VoxelTreeElement* leafElement = branchElement->getChildAtIndex(leaf);
+            if (!leafElement) {
+                continue;
+            }
+            if (!leafElement->isLeaf() || !leafElement->isColored() || leafElement->getDensity() != 1.0f) {
+                return NULL;
+            }
+            leaves |= (quint64)1 << (branch * NUMBER_OF_CHILDREN + leaf);
+            leafCount++;
+        }
+    }
+    if (leafCount < minimumLeaves) {
+        return NULL;
+    }
+
+    VoxelBrick* brick = new VoxelBrick(leaves, leafCount, journal);
+    unsigned char* leafColor = brick->_leafColors;
+    for (int branch = 0; branch < NUMBER_OF_CHILDREN; branch++) {
+        VoxelTreeElement* branchElement = element->getChildAtIndex(branch);
+        if (!branchElement) {
+            memset(brick->_branchColors[branch], 0, sizeof(nodeColor));
+            brick->_branchDensities[branch] = 0.0f;
+            continue;
+        }
+        memcpy(brick->_branchColors[branch], branchElement->getColor(), sizeof(nodeColor));
+        brick->_branchDensities[branch] = branchElement->getDensity();
+        for (int leaf = 0; leaf < NUMBER_OF_CHILDREN; leaf++) {
+            VoxelTreeElement* leafElement = branchElement->getChildAtIndex(leaf);
+            if (leafElement) {
+                memcpy(leafColor, leafElement->getColor(), BYTES_PER_COLOR);
+                leafColor += BYTES_PER_COLOR;
+            }
+        }
+    }
+    return brick;
+}
+
+VoxelBrick::VoxelBrick(quint64 leaves, int leafCount, VoxelBrickJournal* journal) :
+    _leaves(leaves),
+    _leafCount(leafCount),
+    _leafColors(new unsigned char[leafCount * BYTES_PER_COLOR]),
+    _journal(journal)
+{
+    OctreeElementStats& stats = OctreeElement::getStats();
+    stats.packedChildrenCount++;
+    stats.packedChildrenMemoryUsage += sizeof(VoxelBrick) + leafCount * BYTES_PER_COLOR;
+}
+
+VoxelBrick::~VoxelBrick() {
+    delete[] _leafColors;
+    OctreeElementStats& stats = OctreeElement::getStats();
+    stats.packedChildrenCount--;
+    stats.packedChildrenMemoryUsage -= sizeof(VoxelBrick) + _leafCount * BYTES_PER_COLOR;
+}
+
+void VoxelBrick::unpack(VoxelTreeElement* element) const {
+    const unsigned char* leafColor = _leafColors;
+    for (int branch = 0; branch < NUMBER_OF_CHILDREN; branch++) {
+        unsigned char leaves = getBranchLeaves(branch);
+        if (!leaves) {
+            continue;
+        }
+        VoxelTreeElement* branchElement = element->addChildAtIndex(branch);
+        for (int leaf = 0; leaf < NUMBER_OF_CHILDREN; leaf++) {
+            if (leaves & (1 << leaf)) {
+                nodeColor color = { leafColor[RED_INDEX], leafColor[GREEN_INDEX], leafColor[BLUE_INDEX], 1 };
+                restoreColor(branchElement->addChildAtIndex(leaf), color, 1.0f);
+                leafColor += BYTES_PER_COLOR;
+            }
+        }
+        restoreColor(branchElement, _branchColors[branch], _branchDensities[branch]);
+    }
+    if (_journal) {
+        _journal->recordUnpacking(element->getMortonKey());
+    }
+}
+
+int VoxelBrick::appendLevels(const VoxelTreeElement* element, OctreePacketData* packetData,
+        EncodeBitstreamParams& params, int currentEncodeLevel, ViewFrustum::location location) const {
+    // this follows encodeTreeBitstreamRecursion for our children and then theirs, except that the cubes aren't
+    // checked for occlusion or for having been in the last view (they're sent, as though they had changed)
+    const ViewFrustum* viewFrustum = params.viewFrustum;
+    ViewFrustum::ChildLocations branchLocations;
+    if (viewFrustum) {
+        element->childrenInFrustum(*viewFrustum, branchLocations);
+    }
+    int branchLevel = element->getLevel() + 1;
+    bool includesLeaves = currentEncodeLevel + 1 < params.maxEncodeLevel;
+
+    unsigned char branchesExistInTreeBits = 0;
+    unsigned char branchesExistInPacketBits = 0;
+    unsigned char branchesColoredBits = 0;
+    unsigned char leavesExistInTreeBits[NUMBER_OF_CHILDREN];
+    unsigned char leavesColoredBits[NUMBER_OF_CHILDREN];
+
+    for (int branch = 0; branch < NUMBER_OF_CHILDREN; branch++) {
+        unsigned char leaves = getBranchLeaves(branch);
+        leavesExistInTreeBits[branch] = leavesColoredBits[branch] = 0;
+        if (params.includeExistsBits && (leaves || (params.jurisdictionMap &&
+                JurisdictionMap::WITHIN != params.jurisdictionMap->isMyJurisdiction(element, branch)))) {
+            branchesExistInTreeBits |= (1 << (7 - branch));
+        }
+        ViewFrustum::location branchLocation = (location == ViewFrustum::INSIDE)
+            ? location : branchLocations.getLocation(branch);
+        if (!leaves || branchLocation == ViewFrustum::OUTSIDE) {
+            continue;
+        }
+        bool shouldRender = !viewFrustum || OctreeElement::shouldRenderAtDistance(_branchColors[branch][3] == 1,
+            false, branchLevel, branchLocations.furthestDistances[branch], params.octreeElementSizeScale,
+            params.boundaryLevelAdjust);
+        if (shouldRender) {
+            branchesColoredBits |= (1 << (7 - branch));
+        }
+
+        // as for elements, a viewer that gets the branch's color doesn't also get its leaves
+        if (!includesLeaves || (viewFrustum && shouldRender)) {
+            continue;
+        }
+        MortonKey branchKey = element->getMortonKey().getChild(branch);
+        unsigned char branchCode[1 + sizeof(quint64)]; // the length, and the sections of any valid key
+        if (params.jurisdictionMap) {
+            branchKey.writeOctalCode(branchCode);
+            if (JurisdictionMap::BELOW == params.jurisdictionMap->isMyJurisdiction(branchCode, CHECK_NODE_ONLY)) {
+                continue;
+            }
+        }
+        ViewFrustum::ChildLocations leafLocations;
+        if (viewFrustum) {
+            if (branchLocations.distances[branch] >= boundaryDistanceForRenderLevel(
+                    branchLevel + params.boundaryLevelAdjust, params.octreeElementSizeScale)) {
+                continue;
+            }
+            viewFrustum->childrenInFrustum(AABox(branchKey.getCorner(), branchKey.getScale()), leafLocations);
+        }
+        for (int leaf = 0; leaf < NUMBER_OF_CHILDREN; leaf++) {
+            bool exists = leaves & (1 << leaf);
+            if (params.includeExistsBits && (exists || (params.jurisdictionMap &&
+                    JurisdictionMap::WITHIN != params.jurisdictionMap->isMyJurisdiction(branchCode, leaf)))) {
+                leavesExistInTreeBits[branch] |= (1 << (7 - leaf));
+            }
+            if (!exists || (branchLocation != ViewFrustum::INSIDE &&
+                    leafLocations.getLocation(leaf) == ViewFrustum::OUTSIDE)) {
+                continue;
+            }
+            if (!viewFrustum || OctreeElement::shouldRenderAtDistance(true, true, branchLevel + 1,
+                    leafLocations.furthestDistances[leaf], params.octreeElementSizeScale, params.boundaryLevelAdjust)) {
+                leavesColoredBits[branch] |= (1 << (7 - leaf));
+            }
+        }
+        // as encodeTreeBitstreamRecursion leaves out a child tree with no colors and no children
+        if (leavesColoredBits[branch] || !params.includeColor || params.includeExistsBits) {
+            branchesExistInPacketBits |= (1 << (7 - branch));
+        }
+    }
+
+    int bytesBefore = packetData->getUncompressedSize();
+    LevelDetails levelKey = packetData->startLevel();
+    bool fits = packetData->appendBitMask(branchesColoredBits);
+    for (int branch = 0; fits && params.includeColor && branch < NUMBER_OF_CHILDREN; branch++) {
+        if (oneAtBit(branchesColoredBits, branch)) {
+            fits = packetData->appendColor(_branchColors[branch]);
+        }
+    }
+    if (fits && params.includeExistsBits) {
+        fits = packetData->appendBitMask(branchesExistInTreeBits);
+    }
+    fits = fits && packetData->appendBitMask(branchesExistInPacketBits);
+
+    const unsigned char* leafColor = _leafColors;
+    for (int branch = 0; fits && branch < NUMBER_OF_CHILDREN; branch++) {
+        unsigned char leaves = getBranchLeaves(branch);
+        if (!oneAtBit(branchesExistInPacketBits, branch)) {
+            leafColor += numberOfOnes(leaves) * BYTES_PER_COLOR;
+            continue;
+        }
+        fits = packetData->appendBitMask(leavesColoredBits[branch]);
+        for (int leaf = 0; fits && leaf < NUMBER_OF_CHILDREN; leaf++) {
+            if (leaves & (1 << leaf)) {
+                if (params.includeColor && oneAtBit(leavesColoredBits[branch], leaf)) {
+                    fits = packetData->appendColor(leafColor[RED_INDEX], leafColor[GREEN_INDEX], leafColor[BLUE_INDEX]);
+                }
+                leafColor += BYTES_PER_COLOR;
+            }
+        }
+        if (fits && params.includeExistsBits) {
+            fits = packetData->appendBitMask(leavesExistInTreeBits[branch]);
+        }
+        // leaves have no children of their own
+        fits = fits && packetData->appendBitMask(0);
+    }
+
+    if (fits) {
+        fits = packetData->endLevel(levelKey);
+    } else {
+        packetData->discardLevel(levelKey);
+    }
+    if (!fits) {
+        return 0;
+    }
+    if (branchesExistInPacketBits) {
+        params.maxLevelReached = std::max(currentEncodeLevel + 1, params.maxLevelReached);
+    }
+    return packetData->getUncompressedSize() - bytesBefore;
+}
+
+void VoxelBrick::restoreColor(VoxelTreeElement* element, const nodeColor& color, float density) {
+    memcpy(element->_color, color, sizeof(nodeColor));
+    element->_density = density;
+    element->_isDirty = true;
+    element->markWithChangedTime();
+}
@@ -0,0 +1,110 @@
+//
+//  VoxelBrick.h
+//  libraries/voxels/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_VoxelBrick_h
+#define hifi_VoxelBrick_h
+
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+#include <QtGlobal>
+
+#include <MortonKey.h>
+
+#include <OctreeConstants.h>
+#include <OctreeElement.h>
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+
+class EncodeBitstreamParams;
+class OctreePacketData;
+class VoxelTreeElement;
+
+/// The number of levels that a brick packs below its element: two, so that a brick holds at most 64 leaves and always
+/// fits in a packet of its own.
+const int VOXEL_BRICK_LEVELS = 2;
+
+/// The most leaves a brick can hold.
+const int MAX_VOXEL_BRICK_LEAVES = NUMBER_OF_CHILDREN * NUMBER_OF_CHILDREN;
+
+/// The fewest leaves worth packing: below this, the elements cost less than the 64-bit mask would save.
+const int MIN_VOXEL_BRICK_LEAVES = 16;
+
+/// Where the bricks of a tree record the elements whose bricks were unpacked (by edits reaching below them), so that
+/// the tree can repack those rather than walk the whole of itself.  Build workers can unpack bricks concurrently.
+class VoxelBrickJournal {
+public:
+
+    void recordUnpacking(const MortonKey& key);
+
+    /// Returns the keys of the elements whose bricks were unpacked since the last call, and forgets them.
+    QSet<MortonKey> takeUnpackedKeys();
+
+private:
+
+    QMutex _mutex;
+    QSet<MortonKey> _unpackedKeys;
+};
+
+/// The two levels of colored leaves below an element, packed into an occupancy mask and a color array in place of the
+/// 8 + 64 elements they would otherwise take.  A brick stands in for its element's children: the element keeps its own
+/// color, and the brick keeps those of the branches (the children) along with the leaves below them, so that it can
+/// be turned back into exactly the elements it came from.
+class VoxelBrick {
+public:
+
+    /// Packs the subtree below the element if it's a dense enough run of leaves two levels down (colored, and each
+    /// under an averaged branch), leaving the element's children alone.
+    /// \param journal if non-null, where to record the element's key when the brick is unpacked
+    /// \return the new brick, or NULL if the subtree isn't one we pack
+    static VoxelBrick* pack(VoxelTreeElement* element, VoxelBrickJournal* journal = NULL,
+        int minimumLeaves = MIN_VOXEL_BRICK_LEAVES);
+
+    ~VoxelBrick();
+
+    /// Adds the elements that the brick stands for below the (childless) element, and records as much in the journal.
+    void unpack(VoxelTreeElement* element) const;
+
+    /// Returns the leaves that exist below the given branch: bit i stands for child i.
+    unsigned char getBranchLeaves(int branch) const { return (_leaves >> (branch * NUMBER_OF_CHILDREN)) & 0xFF; }
+
+    const nodeColor& getBranchColor(int branch) const { return _branchColors[branch]; }
+    float getBranchDensity(int branch) const { return _branchDensities[branch]; }
+
+    int getLeafCount() const { return _leafCount; }
+
+    /// Returns the colors of the leaves that exist, in order of branch and then leaf.
+    const unsigned char* getLeafColors() const { return _leafColors; }
+
+    /// Writes the levels below the element as encoding its elements would; see OctreeElement::appendPackedChildren.
+    int appendLevels(const VoxelTreeElement* element, OctreePacketData* packetData, EncodeBitstreamParams& params,
+        int currentEncodeLevel, ViewFrustum::location location) const;
+
+    static quint64 getBrickCount() { return OctreeElement::getPackedChildrenCount(); }
+
+    /// Returns the memory held by bricks, which OctreeElement::getTotalMemoryUsage doesn't count.
+    static quint64 getMemoryUsage() { return OctreeElement::getPackedChildrenMemoryUsage(); }
+
+private:
+
+    VoxelBrick(quint64 leaves, int leafCount, VoxelBrickJournal* journal);
+
+    /// Gives an element a color and density as they were, which setColor won't do for a new black element.
+    static void restoreColor(VoxelTreeElement* element, const nodeColor& color, float density);
+
+    quint64 _leaves; ///< bit (NUMBER_OF_CHILDREN * branch + leaf) is set if the leaf exists
+    int _leafCount;
+    nodeColor _branchColors[NUMBER_OF_CHILDREN];
+    float _branchDensities[NUMBER_OF_CHILDREN];
+    unsigned char* _leafColors; ///< BYTES_PER_COLOR per leaf that exists
+    VoxelBrickJournal* _journal;
+};
+
+#endif // hifi_VoxelBrick_h
@@ -12,16 +12,26 @@
 #include <algorithm>
 
 #include <QtCore/QDebug>
+#include <QtCore/QtAlgorithms>
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QImage>
 #include <QRgb>
 
-
+#include "VoxelBrick.h"
 #include "VoxelTree.h"
 #include "Tags.h"
 
 // Voxel Specific operations....
 
-VoxelTree::VoxelTree(bool shouldReaverage) : Octree(shouldReaverage) 
+VoxelTree::VoxelTree(bool shouldReaverage) :
+    Octree(shouldReaverage),
+    _minimumBrickLevel(0),
+    _lastBrickPacking(0)
 {
     _rootNode = createNewElement();
 }
@@ -253,64 +263,93 @@ void VoxelTree::nudgeSubTree(VoxelTreeElement* elementToNudge, const glm::vec3&
 
 
 
+/// The number of image voxels or schematic blocks imported in each batch, which bounds what an import holds at once.
+const int IMPORT_BATCH_SIZE = 256 * 1024;
+
+/// Returns the level of the voxels that make up the given number of units across.
+static int getImportLevel(int units, int& scale) {
+    int level = 0;
+    for (scale = 1; units > scale; scale *= 2) {
+        level++;
+    }
+    return level;
+}
+
+static void addImportVoxel(QVector<BulkVoxel>& batch, int level, int x, int y, int z, int red, int green, int blue) {
+    BulkVoxel voxel;
+    voxel.key = MortonKey::forCoordinates(level, x, y, z);
+    voxel.color[0] = red;
+    voxel.color[1] = green;
+    voxel.color[2] = blue;
+    batch.append(voxel);
+}
+
+/// Creates and empties a batch of imported voxels.
+static void createImportBatch(VoxelTree* tree, QVector<BulkVoxel>& batch) {
+    VoxelTree::sortVoxels(batch);
+    tree->createVoxels(batch, true);
+    batch.clear();
+}
+
 bool VoxelTree::readFromSquareARGB32Pixels(const char* filename) {
     emit importProgress(0);
-    int minAlpha = INT_MAX;
 
-    QImage pngImage = QImage(filename);
+    // Qt decodes the image whole, but we read it in place a row at a time and build the voxels a band of rows at a
+    // time, so that no more than a batch of voxels is held alongside it
+    QImage pngImage = QImage(filename).convertToFormat(QImage::Format_ARGB32);
+    int width = pngImage.width();
+    int height = pngImage.height();
 
-    for (int i = 0; i < pngImage.width(); ++i) {
-        for (int j = 0; j < pngImage.height(); ++j) {
-            minAlpha = std::min(qAlpha(pngImage.pixel(i, j)) , minAlpha);
+    int minAlpha = INT_MAX;
+    for (int j = 0; j < height; ++j) {
+        const QRgb* row = reinterpret_cast<const QRgb*>(pngImage.constScanLine(j));
+        for (int i = 0; i < width; ++i) {
+            minAlpha = std::min(qAlpha(row[i]), minAlpha);
         }
     }
 
-    int maxSize = std::max(pngImage.width(), pngImage.height());
-
-    int scale = 1;
-    while (maxSize > scale) {scale *= 2;}
+    int scale;
+    int level = getImportLevel(std::max(width, height), scale);
     float size = 1.0f / scale;
 
-    emit importSize(size * pngImage.width(), 1.0f, size * pngImage.height());
-
-    QRgb pixel;
-    int minNeighborhoodAlpha;
+    emit importSize(size * width, 1.0f, size * height);
 
-    for (int i = 0; i < pngImage.width(); ++i) {
-        for (int j = 0; j < pngImage.height(); ++j) {
-            emit importProgress((100 * (i * pngImage.height() + j)) /
-                                (pngImage.width() * pngImage.height()));
+    QVector<BulkVoxel> batch;
+    for (int j = 0; j < height; ++j) {
+        const QRgb* previousRow = reinterpret_cast<const QRgb*>(pngImage.constScanLine(std::max(j - 1, 0)));
+        const QRgb* row = reinterpret_cast<const QRgb*>(pngImage.constScanLine(j));
+        const QRgb* nextRow = reinterpret_cast<const QRgb*>(pngImage.constScanLine(std::min(j + 1, height - 1)));
 
-            pixel = pngImage.pixel(i, j);
-            minNeighborhoodAlpha = qAlpha(pixel) - 1;
+        for (int i = 0; i < width; ++i) {
+            QRgb pixel = row[i];
+            int minNeighborhoodAlpha = qAlpha(pixel) - 1;
 
             if (i != 0) {
-                minNeighborhoodAlpha = std::min(minNeighborhoodAlpha, qAlpha(pngImage.pixel(i - 1, j)));
+                minNeighborhoodAlpha = std::min(minNeighborhoodAlpha, qAlpha(row[i - 1]));
             }
             if (j != 0) {
-                minNeighborhoodAlpha = std::min(minNeighborhoodAlpha, qAlpha(pngImage.pixel(i, j - 1)));
+                minNeighborhoodAlpha = std::min(minNeighborhoodAlpha, qAlpha(previousRow[i]));
             }
-            if (i < pngImage.width() - 1) {
-                minNeighborhoodAlpha = std::min(minNeighborhoodAlpha, qAlpha(pngImage.pixel(i + 1, j)));
+            if (i < width - 1) {
+                minNeighborhoodAlpha = std::min(minNeighborhoodAlpha, qAlpha(row[i + 1]));
             }
-            if (j < pngImage.height() - 1) {
-                minNeighborhoodAlpha = std::min(minNeighborhoodAlpha, qAlpha(pngImage.pixel(i, j + 1)));
+            if (j < height - 1) {
+                minNeighborhoodAlpha = std::min(minNeighborhoodAlpha, qAlpha(nextRow[i]));
             }
 
+            // columns taller than the tree pile up in its top voxel, as they did when created by position
             while (qAlpha(pixel) > minNeighborhoodAlpha) {
                 ++minNeighborhoodAlpha;
-                createVoxel(i * size,
-                            (minNeighborhoodAlpha - minAlpha) * size,
-                            j * size,
-                            size,
-                            qRed(pixel),
-                            qGreen(pixel),
-                            qBlue(pixel),
-                            true);
+                addImportVoxel(batch, level, i, std::min(minNeighborhoodAlpha - minAlpha, scale - 1), j,
+                    qRed(pixel), qGreen(pixel), qBlue(pixel));
             }
-
+        }
+        if (batch.size() >= IMPORT_BATCH_SIZE) {
+            createImportBatch(this, batch);
+            emit importProgress((100 * (j + 1)) / height);
         }
     }
+    createImportBatch(this, batch);
 
     emit importProgress(100);
     return true;
@@ -320,89 +359,86 @@ bool VoxelTree::readFromSchematicFile(const char *fileName) {
     _stopImport = false;
     emit importProgress(0);
 
-    std::stringstream ss;
-    int err = retrieveData(std::string(fileName), ss);
-    if (err && ss.get() != TAG_Compound) {
+    SchematicReader reader;
+    if (!reader.open(fileName)) {
         qDebug("[ERROR] Invalid schematic file.");
         return false;
     }
+    int width = reader.getWidth();
+    int height = reader.getHeight();
+    int length = reader.getLength();
 
-    ss.get();
-    TagCompound schematics(ss);
-    if (!schematics.getBlocksId() || !schematics.getBlocksData()) {
-        qDebug("[ERROR] Invalid schematic data.");
-        return false;
-    }
-
-    int max = (schematics.getWidth() > schematics.getLength()) ? schematics.getWidth() : schematics.getLength();
-    max = (max > schematics.getHeight()) ? max : schematics.getHeight();
-
-    int scale = 1;
-    while (max > scale) {scale *= 2;}
+    int scale;
+    int level = getImportLevel(std::max(std::max(width, length), height), scale);
     float size = 1.0f / scale;
 
-    emit importSize(size * schematics.getWidth(),
-                    size * schematics.getHeight(),
-                    size * schematics.getLength());
+    emit importSize(size * width, size * height, size * length);
 
-    int create = 1;
+    // slabs and stairs are made of voxels half the size, at the level below
+    int halfLevel = level + 1;
     int red = 128, green = 128, blue = 128;
     int count = 0;
 
-    for (int y = 0; y < schematics.getHeight(); ++y) {
-        for (int z = 0; z < schematics.getLength(); ++z) {
-            emit importProgress((int) 100 * (y * schematics.getLength() + z) / (schematics.getHeight() * schematics.getLength()));
-
-            for (int x = 0; x < schematics.getWidth(); ++x) {
-                if (_stopImport) {
-                    qDebug("[DEBUG] Canceled import at %d voxels.", count);
-                    _stopImport = false;
-                    return true;
-                }
-
-                int pos  = ((y * schematics.getLength()) + z) * schematics.getWidth() + x;
-                int id   = schematics.getBlocksId()[pos];
-                int data = schematics.getBlocksData()[pos];
-
-                create = 1;
-                computeBlockColor(id, data, red, green, blue, create);
-
-                switch (create) {
-                    case 1:
-                        createVoxel(size * x, size * y, size * z, size, red, green, blue, true);
-                        ++count;
-                        break;
-                    case 2:
-                        switch (data) {
-                            case 0:
-                                createVoxel(size * x + size / 2, size * y + size / 2, size * z           , size / 2, red, green, blue, true);
-                                createVoxel(size * x + size / 2, size * y + size / 2, size * z + size / 2, size / 2, red, green, blue, true);
-                                break;
-                            case 1:
-                                createVoxel(size * x           , size * y + size / 2, size * z           , size / 2, red, green, blue, true);
-                                createVoxel(size * x           , size * y + size / 2, size * z + size / 2, size / 2, red, green, blue, true);
-                                break;
-                            case 2:
-                                createVoxel(size * x           , size * y + size / 2, size * z + size / 2, size / 2, red, green, blue, true);
-                                createVoxel(size * x + size / 2, size * y + size / 2, size * z + size / 2, size / 2, red, green, blue, true);
-                                break;
-                            case 3:
-                                createVoxel(size * x           , size * y + size / 2, size * z           , size / 2, red, green, blue, true);
-                                createVoxel(size * x + size / 2, size * y + size / 2, size * z           , size / 2, red, green, blue, true);
-                                break;
-                        }
-                        count += 2;
-                        // There's no break on purpose.
-                    case 3:
-                        createVoxel(size * x           , size * y, size * z           , size / 2, red, green, blue, true);
-                        createVoxel(size * x + size / 2, size * y, size * z           , size / 2, red, green, blue, true);
-                        createVoxel(size * x           , size * y, size * z + size / 2, size / 2, red, green, blue, true);
-                        createVoxel(size * x + size / 2, size * y, size * z + size / 2, size / 2, red, green, blue, true);
-                        count += 4;
-                        break;
-                }
+    QVector<unsigned char> ids(IMPORT_BATCH_SIZE);
+    QVector<unsigned char> data(IMPORT_BATCH_SIZE);
+    QVector<BulkVoxel> batch;
+    int blockCount = reader.getBlockCount();
+    for (int pos = 0; pos < blockCount; ) {
+        if (_stopImport) {
+            qDebug("[DEBUG] Canceled import at %d voxels.", count);
+            _stopImport = false;
+            return true;
+        }
+        int blocksRead = reader.read(ids.data(), data.data(), IMPORT_BATCH_SIZE);
+        if (blocksRead == 0) {
+            qDebug("[ERROR] Invalid schematic data.");
+            return false;
+        }
+        for (int i = 0; i < blocksRead; i++, pos++) {
+            int x = pos % width;
+            int z = (pos / width) % length;
+            int y = pos / (width * length);
+
+            int create = 1;
+            computeBlockColor(ids.at(i), data.at(i), red, green, blue, create);
+
+            switch (create) {
+                case 1:
+                    addImportVoxel(batch, level, x, y, z, red, green, blue);
+                    ++count;
+                    break;
+                case 2:
+                    switch (data.at(i)) {
+                        case 0:
+                            addImportVoxel(batch, halfLevel, 2 * x + 1, 2 * y + 1, 2 * z, red, green, blue);
+                            addImportVoxel(batch, halfLevel, 2 * x + 1, 2 * y + 1, 2 * z + 1, red, green, blue);
+                            break;
+                        case 1:
+                            addImportVoxel(batch, halfLevel, 2 * x, 2 * y + 1, 2 * z, red, green, blue);
+                            addImportVoxel(batch, halfLevel, 2 * x, 2 * y + 1, 2 * z + 1, red, green, blue);
+                            break;
+                        case 2:
+                            addImportVoxel(batch, halfLevel, 2 * x, 2 * y + 1, 2 * z + 1, red, green, blue);
+                            addImportVoxel(batch, halfLevel, 2 * x + 1, 2 * y + 1, 2 * z + 1, red, green, blue);
+                            break;
+                        case 3:
+                            addImportVoxel(batch, halfLevel, 2 * x, 2 * y + 1, 2 * z, red, green, blue);
+                            addImportVoxel(batch, halfLevel, 2 * x + 1, 2 * y + 1, 2 * z, red, green, blue);
+                            break;
+                    }
+                    count += 2;
+                    // There's no break on purpose.
+                case 3:
+                    addImportVoxel(batch, halfLevel, 2 * x, 2 * y, 2 * z, red, green, blue);
+                    addImportVoxel(batch, halfLevel, 2 * x + 1, 2 * y, 2 * z, red, green, blue);
+                    addImportVoxel(batch, halfLevel, 2 * x, 2 * y, 2 * z + 1, red, green, blue);
+                    addImportVoxel(batch, halfLevel, 2 * x + 1, 2 * y, 2 * z + 1, red, green, blue);
+                    count += 4;
+                    break;
             }
         }
+        createImportBatch(this, batch);
+        emit importProgress((int)(100LL * pos / blockCount));
     }
 
     emit importProgress(100);
@@ -414,6 +450,7 @@ bool VoxelTree::readFromSchematicFile(const char *fileName) {
 class ReadCodeColorBufferToTreeArgs {
 public:
     const unsigned char* codeColorBuffer;
+    MortonKey key;
     int lengthOfCode;
     bool destructive;
     bool pathChanged;
@@ -422,6 +459,7 @@ public:
 void VoxelTree::readCodeColorBufferToTree(const unsigned char* codeColorBuffer, bool destructive) {
     ReadCodeColorBufferToTreeArgs args;
     args.codeColorBuffer = codeColorBuffer;
+    args.key = MortonKey(codeColorBuffer);
     args.lengthOfCode = numberOfThreeBitSectionsInCode(codeColorBuffer);
     args.destructive = destructive;
     args.pathChanged = false;
@@ -430,11 +468,14 @@ void VoxelTree::readCodeColorBufferToTree(const unsigned char* codeColorBuffer,
 }
 
 void VoxelTree::readCodeColorBufferToTreeRecursion(VoxelTreeElement* node, ReadCodeColorBufferToTreeArgs& args) {
-    int lengthOfNodeCode = numberOfThreeBitSectionsInCode(node->getOctalCode());
+    int lengthOfNodeCode = node->getOctalCodeLength();
 
     // Since we traverse the tree in code order, we know that if our code
     // matches, then we've reached  our target node.
     if (lengthOfNodeCode == args.lengthOfCode) {
+        // packed children count as children here
+        node->unpackChildren();
+
         // we've reached our target -- we might have found our node, but that node might have children.
         // in this case, we only allow you to set the color if you explicitly asked for a destructive
         // write.
@@ -474,7 +515,7 @@ void VoxelTree::readCodeColorBufferToTreeRecursion(VoxelTreeElement* node, ReadC
 
     // Ok, we know we haven't reached our target node yet, so keep looking
     //printOctalCode(args.codeColorBuffer);
-    int childIndex = branchIndexWithDescendant(node->getOctalCode(), args.codeColorBuffer);
+    int childIndex = node->getBranchIndexToward(args.key, args.codeColorBuffer);
     VoxelTreeElement* childNode = node->getChildAtIndex(childIndex);
 
     // If the branch we need to traverse does not exist, then create it on the way down...
@@ -494,6 +535,410 @@ void VoxelTree::readCodeColorBufferToTreeRecursion(VoxelTreeElement* node, ReadC
     }
 }
 
+/// The fewest voxels worth splitting across worker threads.
+const int MIN_PARALLEL_BULK_VOXELS = 4096;
+
+/// The deepest level at which a batch is split into subtrees for the workers.
+const int MAX_BULK_SPLIT_LEVEL = 6;
+
+/// The number of subtrees per thread we aim for when splitting, so that uneven subtrees still keep every thread busy.
+const int BULK_SUBTREES_PER_THREAD = 4;
+
+/// The most voxels (as a fraction of the batch) that we let fall above the split level, where they're created
+/// one at a time on the calling thread.
+const int MAX_SHALLOW_BULK_VOXELS_DIVISOR = 16;
+
+static bool voxelPrecedes(const BulkVoxel& first, const BulkVoxel& second) {
+    return first.key.precedes(second.key);
+}
+
+void VoxelTree::sortVoxels(QVector<BulkVoxel>& voxels) {
+    qStableSort(voxels.begin(), voxels.end(), voxelPrecedes);
+}
+
+/// Delete hooks (the send threads' bags, for instance) can't be called from several threads at once, so the workers
+/// take turns deleting.
+static QMutex bulkDeletionMutex;
+
+/// Leaves the last element on a bulk path, letting it (and its parent) know if anything below it changed.
+static void leaveBulkPathElement(VoxelTree* tree, VoxelTreeElement** path, bool* changedBelow, int depth) {
+    if (changedBelow[depth]) {
+        path[depth]->handleSubtreeChanged(tree);
+        changedBelow[depth - 1] = true;
+    }
+}
+
+/// Creates a sorted run of voxels at and below the given element.  The path to the last voxel is kept on a stack, so
+/// that each element is found once rather than once per voxel, and each gets its handleSubtreeChanged (and so its
+/// reaveraging) once, when the run leaves it.
+/// \return whether anything changed
+static bool createVoxelRun(VoxelTree* tree, VoxelTreeElement* root, const BulkVoxel* voxels, int count,
+        bool destructive) {
+    // the elements on the path to the last voxel, and whether anything below each has changed; the first slot
+    // stands for the root's parent
+    VoxelTreeElement* path[MAX_MORTON_KEY_LEVELS + 2];
+    bool changedBelow[MAX_MORTON_KEY_LEVELS + 2];
+    int depth = 1;
+    path[depth] = root;
+    changedBelow[0] = changedBelow[depth] = false;
+
+    for (const BulkVoxel* voxel = voxels, *end = voxels + count; voxel != end; voxel++) {
+        if (!voxel->key.isValid() || !root->getMortonKey().isAncestorOf(voxel->key)) {
+            continue;
+        }
+        // leave the subtrees that don't hold the voxel, then go down to it, adding the branches it needs
+        while (!path[depth]->getMortonKey().isAncestorOf(voxel->key)) {
+            leaveBulkPathElement(tree, path, changedBelow, depth--);
+        }
+        VoxelTreeElement* element = path[depth];
+        while (element->getMortonKey() != voxel->key) {
+            int childIndex = element->getMortonKey().getBranchIndexToward(voxel->key);
+            VoxelTreeElement* child = element->getChildAtIndex(childIndex);
+            element = child ? child : element->addChildAtIndex(childIndex);
+            path[++depth] = element;
+            changedBelow[depth] = false;
+        }
+
+        // as in readCodeColorBufferToTreeRecursion, we only replace children (packed ones included) if asked to
+        element->unpackChildren();
+        if (!element->isLeaf()) {
+            if (destructive) {
+                QMutexLocker locker(&bulkDeletionMutex);
+                for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+                    element->deleteChildAtIndex(i);
+                }
+            } else {
+                qDebug("WARNING! operation would require deleting children, add Voxel ignored!");
+            }
+        }
+        if (element->isLeaf()) {
+            nodeColor newColor = { voxel->color[RED_INDEX], voxel->color[GREEN_INDEX], voxel->color[BLUE_INDEX], 1 };
+            element->setColor(newColor);
+            if (element->isDirty()) {
+                changedBelow[depth - 1] = true;
+            }
+        }
+    }
+    while (depth > 0) {
+        leaveBulkPathElement(tree, path, changedBelow, depth--);
+    }
+    return changedBelow[0];
+}
+
+/// Creates one subtree's run of voxels on the build pool, keeping the element statistics that it changes apart for the
+/// caller to merge.
+class VoxelRunTask : public QRunnable {
+public:
+
+    VoxelRunTask(VoxelTree* tree, VoxelTreeElement* root, const BulkVoxel* voxels, int count, bool destructive,
+        bool& changed, OctreeElementStats& stats, QSemaphore& semaphore);
+
+    virtual void run();
+
+private:
+
+    VoxelTree* _tree;
+    VoxelTreeElement* _root;
+    const BulkVoxel* _voxels;
+    int _count;
+    bool _destructive;
+    bool& _changed;
+    OctreeElementStats& _stats;
+    QSemaphore& _semaphore;
+};
+
+VoxelRunTask::VoxelRunTask(VoxelTree* tree, VoxelTreeElement* root, const BulkVoxel* voxels, int count,
+        bool destructive, bool& changed, OctreeElementStats& stats, QSemaphore& semaphore) :
+    _tree(tree),
+    _root(root),
+    _voxels(voxels),
+    _count(count),
+    _destructive(destructive),
+    _changed(changed),
+    _stats(stats),
+    _semaphore(semaphore)
+{
+}
+
+void VoxelRunTask::run() {
+    OctreeElement::setThreadStats(&_stats);
+    _changed = createVoxelRun(_tree, _root, _voxels, _count, _destructive);
+    OctreeElement::setThreadStats(NULL);
+    _semaphore.release();
+}
+
+/// Returns the pool on which subtrees of bulk creations are built.
+static QThreadPool* getBuildPool() {
+    static QThreadPool pool;
+    return &pool;
+}
+
+/// Returns the level at which to split a batch into subtrees for the workers, or zero to build it on this thread.
+static int chooseBulkSplitLevel(const QVector<BulkVoxel>& voxels) {
+    if (voxels.size() < MIN_PARALLEL_BULK_VOXELS || QThread::idealThreadCount() < 2) {
+        return 0;
+    }
+    // a batch out of order could put two runs in the same subtree, and two workers with it
+    for (int i = 1; i < voxels.size(); i++) {
+        if (voxels.at(i).key.precedes(voxels.at(i - 1).key)) {
+            qDebug("WARNING! bulk voxels out of order, creating them on one thread.");
+            return 0;
+        }
+    }
+    int targetRuns = QThread::idealThreadCount() * BULK_SUBTREES_PER_THREAD;
+    int splitLevel = 0;
+    for (int level = 1; level <= MAX_BULK_SPLIT_LEVEL; level++) {
+        int runs = 0;
+        int shallowVoxels = 0;
+        MortonKey lastSubtreeKey = MortonKey::invalid();
+        foreach (const BulkVoxel& voxel, voxels) {
+            if (voxel.key.getLevel() < level) {
+                shallowVoxels++;
+
+            } else if (voxel.key.getAncestor(level) != lastSubtreeKey) {
+                lastSubtreeKey = voxel.key.getAncestor(level);
+                runs++;
+            }
+        }
+        if (shallowVoxels > voxels.size() / MAX_SHALLOW_BULK_VOXELS_DIVISOR) {
+            break;
+        }
+        splitLevel = level;
+        if (runs >= targetRuns) {
+            break;
+        }
+    }
+    return splitLevel;
+}
+
+/// Lets the elements above the split level that lead to changed subtrees know, deepest first.
+static void handleChangedBulkPaths(VoxelTree* tree, VoxelTreeElement* element, const QSet<MortonKey>& changedPaths) {
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        VoxelTreeElement* child = element->getChildAtIndex(i);
+        if (child && changedPaths.contains(child->getMortonKey())) {
+            handleChangedBulkPaths(tree, child, changedPaths);
+        }
+    }
+    element->handleSubtreeChanged(tree);
+}
+
+void VoxelTree::createVoxels(const QVector<BulkVoxel>& voxels, bool destructive) {
+    if (voxels.isEmpty()) {
+        return;
+    }
+    lockForWrite();
+    int splitLevel = getRoot()->getVoxelSystem() ? 0 : chooseBulkSplitLevel(voxels);
+    bool changed = false;
+    if (splitLevel == 0) {
+        changed = createVoxelRun(this, getRoot(), voxels.constData(), voxels.size(), destructive);
+
+    } else {
+        // the voxels above the split level come before any of their descendants, so they can go first
+        QVector<int> runStarts;
+        for (int i = 0; i < voxels.size(); i++) {
+            const MortonKey& key = voxels.at(i).key;
+            if (key.getLevel() < splitLevel) {
+                changed |= createVoxelRun(this, getRoot(), voxels.constData() + i, 1, destructive);
+
+            } else if (runStarts.isEmpty() ||
+                    voxels.at(runStarts.last()).key.getAncestor(splitLevel) != key.getAncestor(splitLevel)) {
+                runStarts.append(i);
+            }
+        }
+
+        // find or add each run's subtree here, then hand all but the last to the pool and build that one ourselves
+        QVector<VoxelTreeElement*> runRoots;
+        QVector<int> runEnds;
+        foreach (int runStart, runStarts) {
+            MortonKey subtreeKey = voxels.at(runStart).key.getAncestor(splitLevel);
+            VoxelTreeElement* element = getRoot();
+            while (element->getMortonKey() != subtreeKey) {
+                int childIndex = element->getMortonKey().getBranchIndexToward(subtreeKey);
+                VoxelTreeElement* child = element->getChildAtIndex(childIndex);
+                element = child ? child : element->addChildAtIndex(childIndex);
+            }
+            runRoots.append(element);
+            int runEnd = runStart + 1;
+            while (runEnd < voxels.size() && voxels.at(runEnd).key.getLevel() >= splitLevel &&
+                    voxels.at(runEnd).key.getAncestor(splitLevel) == subtreeKey) {
+                runEnd++;
+            }
+            runEnds.append(runEnd);
+        }
+        QVector<bool> runsChanged(runStarts.size());
+        QVector<OctreeElementStats> runStats(runStarts.size());
+        QSemaphore semaphore;
+        int lastRun = runStarts.size() - 1;
+        for (int i = 0; i < lastRun; i++) {
+            getBuildPool()->start(new VoxelRunTask(this, runRoots.at(i), voxels.constData() + runStarts.at(i),
+                runEnds.at(i) - runStarts.at(i), destructive, runsChanged[i], runStats[i], semaphore));
+        }
+        // our own run changes our thread's statistics, which the workers leave alone
+        runsChanged[lastRun] = createVoxelRun(this, runRoots.at(lastRun), voxels.constData() + runStarts.at(lastRun),
+            runEnds.at(lastRun) - runStarts.at(lastRun), destructive);
+        semaphore.acquire(lastRun);
+        for (int i = 0; i < lastRun; i++) {
+            OctreeElement::mergeStats(runStats.at(i));
+        }
+
+        // finish with the elements above the subtrees that changed
+        QSet<MortonKey> changedPaths;
+        for (int i = 0; i < runRoots.size(); i++) {
+            if (runsChanged.at(i)) {
+                for (MortonKey key = runRoots.at(i)->getMortonKey(); key.getLevel() > 0; ) {
+                    key = key.getParent();
+                    changedPaths.insert(key);
+                }
+            }
+        }
+        if (!changedPaths.isEmpty()) {
+            handleChangedBulkPaths(this, getRoot(), changedPaths);
+            changed = true;
+        }
+    }
+    if (changed) {
+        _isDirty = true;
+    }
+    unlock();
+}
+
+/// Appends the colored leaves at and below the element, depth first.
+static void collectVoxelsRecursion(VoxelTreeElement* element, QVector<BulkVoxel>& voxels) {
+    const VoxelBrick* brick = element->getBrick();
+    if (brick) {
+        const unsigned char* leafColor = brick->getLeafColors();
+        for (int branch = 0; branch < NUMBER_OF_CHILDREN; branch++) {
+            unsigned char leaves = brick->getBranchLeaves(branch);
+            for (int leaf = 0; leaf < NUMBER_OF_CHILDREN; leaf++) {
+                if (leaves & (1 << leaf)) {
+                    BulkVoxel voxel;
+                    voxel.key = element->getMortonKey().getChild(branch).getChild(leaf);
+                    memcpy(voxel.color, leafColor, sizeof(rgbColor));
+                    voxels.append(voxel);
+                    leafColor += BYTES_PER_COLOR;
+                }
+            }
+        }
+        return;
+    }
+    if (element->isLeaf()) {
+        if (element->isColored() && element->getMortonKey().isValid()) {
+            BulkVoxel voxel;
+            voxel.key = element->getMortonKey();
+            memcpy(voxel.color, element->getColor(), sizeof(rgbColor));
+            voxels.append(voxel);
+        }
+        return;
+    }
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        VoxelTreeElement* child = element->getChildAtIndex(i);
+        if (child) {
+            collectVoxelsRecursion(child, voxels);
+        }
+    }
+}
+
+void VoxelTree::collectVoxels(QVector<BulkVoxel>& voxels, VoxelTreeElement* subtree) {
+    collectVoxelsRecursion(subtree ? subtree : getRoot(), voxels);
+}
+
+/// How often update repacks the bricks that edits have unpacked.
+const quint64 BRICK_PACKING_INTERVAL_USECS = 1000 * 1000;
+
+/// Packs the dense subtrees at and below the element into bricks.
+static int packBricksRecursion(VoxelTreeElement* element, int minimumLevel, VoxelBrickJournal* journal) {
+    if (element->isLeaf()) {
+        return 0;
+    }
+    if (element->getMortonKey().getLevel() >= minimumLevel && element->packChildren(journal)) {
+        return 1;
+    }
+    int bricksPacked = 0;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        VoxelTreeElement* child = element->getChildAtIndex(i);
+        if (child) {
+            bricksPacked += packBricksRecursion(child, minimumLevel, journal);
+        }
+    }
+    return bricksPacked;
+}
+
+/// Packs the dense subtrees at and below the element that have changed since the given time, leaving alone those that
+/// haven't (the last packing looked at them).
+static int repackChangedRecursion(VoxelTreeElement* element, int minimumLevel, quint64 since,
+        VoxelBrickJournal* journal) {
+    if (element->isLeaf() || !element->hasChangedSince(since)) {
+        return 0;
+    }
+    if (element->getMortonKey().getLevel() >= minimumLevel && element->packChildren(journal)) {
+        return 1;
+    }
+    int bricksPacked = 0;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        VoxelTreeElement* child = element->getChildAtIndex(i);
+        if (child) {
+            bricksPacked += repackChangedRecursion(child, minimumLevel, since, journal);
+        }
+    }
+    return bricksPacked;
+}
+
+int VoxelTree::packBricks() {
+    // the elements that a VoxelSystem draws can't go missing from under it
+    if (_minimumBrickLevel <= 0 || getRoot()->getVoxelSystem()) {
+        return 0;
+    }
+    lockForWrite();
+    _lastBrickPacking = usecTimestampNow();
+
+    // we're about to look at everything, so what was unpacked before now needs no other look
+    _brickJournal.takeUnpackedKeys();
+    int bricksPacked = packBricksRecursion(getRoot(), _minimumBrickLevel, &_brickJournal);
+    unlock();
+    return bricksPacked;
+}
+
+int VoxelTree::repackBricks() {
+    if (_minimumBrickLevel <= 0 || getRoot()->getVoxelSystem()) {
+        return 0;
+    }
+    lockForWrite();
+    quint64 lastPacking = _lastBrickPacking;
+    _lastBrickPacking = usecTimestampNow();
+
+    QSet<MortonKey> unpackedKeys = _brickJournal.takeUnpackedKeys();
+    int bricksPacked = 0;
+    foreach (const MortonKey& key, unpackedKeys) {
+        // the element may since have been deleted, or packed again as part of a brick above it
+        VoxelTreeElement* element = getRoot();
+        while (element && element->getMortonKey() != key && !element->hasPackedChildren()) {
+            element = element->getChildAtIndex(element->getMortonKey().getBranchIndexToward(key));
+        }
+        if (element && element->getMortonKey() == key) {
+            bricksPacked += packBricksRecursion(element, _minimumBrickLevel, &_brickJournal);
+        }
+    }
+
+    // edits mark the paths down to what they change, so following those finds the subtrees that they've made dense
+    // where there was no brick before
+    bricksPacked += repackChangedRecursion(getRoot(), _minimumBrickLevel, lastPacking, &_brickJournal);
+    unlock();
+    return bricksPacked;
+}
+
+void VoxelTree::update() {
+    if (_minimumBrickLevel > 0 && usecTimestampNow() - _lastBrickPacking > BRICK_PACKING_INTERVAL_USECS
+            && getRoot()->hasChangedSince(_lastBrickPacking)) {
+        // the first packing (typically of the scene just loaded) walks the whole tree; after that, only what edits
+        // have unpacked or changed is looked at again
+        if (_lastBrickPacking == 0) {
+            packBricks();
+        } else {
+            repackBricks();
+        }
+    }
+}
+
 bool VoxelTree::handlesEditPacketType(PacketType packetType) const {
     // we handle these types of "edit" packets
     switch (packetType) {
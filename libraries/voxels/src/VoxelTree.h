@@ -12,13 +12,23 @@
 #ifndef hifi_VoxelTree_h
 #define hifi_VoxelTree_h
 
+#include <QtCore/QVector>
+
 #include <Octree.h>
 
+#include "VoxelBrick.h"
 #include "VoxelTreeElement.h"
 #include "VoxelEditPacketSender.h"
 
 class ReadCodeColorBufferToTreeArgs;
 
+/// A voxel to be created in bulk: see VoxelTree::createVoxels.
+class BulkVoxel {
+public:
+    MortonKey key;
+    rgbColor color;
+};
+
 class VoxelTree : public Octree {
     Q_OBJECT
 public:
@@ -35,14 +45,47 @@ public:
 
     void nudgeSubTree(VoxelTreeElement* elementToNudge, const glm::vec3& nudgeAmount, VoxelEditPacketSender& voxelEditSender);
 
-    /// reads voxels from square image with alpha as a Y-axis
+    /// reads voxels from square image with alpha as a Y-axis, creating them a band of rows at a time
     bool readFromSquareARGB32Pixels(const char *filename);
 
-    /// reads from minecraft file
+    /// reads from minecraft file, streaming the blocks in chunks rather than decoding the whole file first
     bool readFromSchematicFile(const char* filename);
 
     void readCodeColorBufferToTree(const unsigned char* codeColorBuffer, bool destructive = false);
 
+    /// Sorts voxels into the order createVoxels wants them, keeping the order of any with the same key.
+    static void sortVoxels(QVector<BulkVoxel>& voxels);
+
+    /// Creates a batch of voxels as createVoxel would one at a time, in order, but under a single write lock.  The
+    /// voxels must be sorted (see sortVoxels), so that each element is reached and reaveraged once rather than once
+    /// per voxel below it.  Large batches are split into subtrees that are built on worker threads, which element
+    /// hooks hear from, unless a VoxelSystem draws the tree (its hooks expect a single thread).
+    void createVoxels(const QVector<BulkVoxel>& voxels, bool destructive = false);
+
+    /// Appends the colored leaves of the subtree (the whole tree by default) to the list, sorted for createVoxels.
+    void collectVoxels(QVector<BulkVoxel>& voxels, VoxelTreeElement* subtree = NULL);
+
+    /// Sets the shallowest level (the root's being zero) whose elements packBricks may pack, or zero (the default) to
+    /// leave the tree unpacked.
+    void setMinimumBrickLevel(int minimumBrickLevel) { _minimumBrickLevel = minimumBrickLevel; }
+    int getMinimumBrickLevel() const { return _minimumBrickLevel; }
+
+    /// Packs each dense subtree at or below the minimum brick level into a brick (see VoxelTreeElement::packChildren),
+    /// which the tree's edits and encoding see through.  Functions that return elements (getVoxelAt, ray casts,
+    /// recurseTreeWithOperation) see a packed element as a leaf with its average color, so packing is for trees that
+    /// are edited and sent, like the server's, rather than ones that are drawn.
+    /// \return the number of bricks packed
+    int packBricks();
+
+    /// Repacks what edits have unpacked or changed since the last packing, rather than walking the whole tree as
+    /// packBricks does: the bricks they unpacked, and the dense subtrees they built where there was no brick before.
+    /// \return the number of bricks packed
+    int repackBricks();
+
+    /// Packs the tree the first time the tree has changed (as when its scene is loaded), and from then on (now and
+    /// then) repacks what edits have unpacked or changed, if the tree packs bricks.
+    virtual void update();
+
     virtual PacketType expectedDataPacketType() const { return PacketTypeVoxelData; }
     virtual bool handlesEditPacketType(PacketType packetType) const;
     virtual int processEditPacketData(PacketType packetType, const unsigned char* packetData, int packetLength,
@@ -55,6 +98,10 @@ private:
     void nudgeLeaf(VoxelTreeElement* element, void* extraData);
     void chunkifyLeaf(VoxelTreeElement* element);
     void readCodeColorBufferToTreeRecursion(VoxelTreeElement* node, ReadCodeColorBufferToTreeArgs& args);
+
+    int _minimumBrickLevel;
+    quint64 _lastBrickPacking; ///< when packBricks or repackBricks last started
+    VoxelBrickJournal _brickJournal;
 };
 
 #endif // hifi_VoxelTree_h
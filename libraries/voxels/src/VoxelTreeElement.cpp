@@ -12,12 +12,14 @@
 #include <NodeList.h>
 #include <PerfStat.h>
 
+#include "VoxelBrick.h"
 #include "VoxelConstants.h"
 #include "VoxelTreeElement.h"
 #include "VoxelTree.h"
 
 VoxelTreeElement::VoxelTreeElement(unsigned char* octalCode) : 
     OctreeElement(),
+    _brick(NULL),
     _exteriorOcclusions(OctreeElement::HalfSpace::All),
     _interiorOcclusions(OctreeElement::HalfSpace::None)
 {
@@ -25,7 +27,8 @@ VoxelTreeElement::VoxelTreeElement(unsigned char* octalCode) :
 };
 
 VoxelTreeElement::~VoxelTreeElement() {
-    _voxelMemoryUsage -= sizeof(VoxelTreeElement);
+    delete _brick;
+    getStats().voxelMemoryUsage -= sizeof(VoxelTreeElement);
 }
 
 // This will be called primarily on addChildAt(), which means we're adding a child of our
@@ -45,11 +48,44 @@ void VoxelTreeElement::init(unsigned char* octalCode) {
     _color[0] = _color[1] = _color[2] = _color[3] = 0;
     _density = 0.0f;
     OctreeElement::init(octalCode);
-    _voxelMemoryUsage += sizeof(VoxelTreeElement);
+    getStats().voxelMemoryUsage += sizeof(VoxelTreeElement);
 }
 
 bool VoxelTreeElement::requiresSplit() const {
-    return isLeaf() && isColored();
+    return isLeaf() && isColored() && !_brick;
+}
+
+VoxelTreeElement* VoxelTreeElement::addChildAtIndex(int childIndex) {
+    // our packed children have to become elements again before another can join them
+    unpackChildren();
+    return (VoxelTreeElement*)OctreeElement::addChildAtIndex(childIndex);
+}
+
+void VoxelTreeElement::unpackChildren() {
+    if (_brick) {
+        // let go of the brick first, so that adding its elements doesn't come back here
+        VoxelBrick* brick = _brick;
+        _brick = NULL;
+        brick->unpack(this);
+        delete brick;
+    }
+}
+
+bool VoxelTreeElement::packChildren(VoxelBrickJournal* journal) {
+    VoxelBrick* brick = VoxelBrick::pack(this, journal);
+    if (!brick) {
+        return false;
+    }
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        deleteChildAtIndex(i);
+    }
+    _brick = brick;
+    return true;
+}
+
+int VoxelTreeElement::appendPackedChildren(OctreePacketData* packetData, EncodeBitstreamParams& params,
+        int currentEncodeLevel, ViewFrustum::location location) const {
+    return _brick ? _brick->appendLevels(this, packetData, params, currentEncodeLevel, location) : 0;
 }
 
 void VoxelTreeElement::splitChildren() {
@@ -137,16 +173,28 @@ void VoxelTreeElement::calculateAverageFromChildren() {
     int colorArray[4] = {0,0,0,0};
     float density = 0.0f;
     for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
-        VoxelTreeElement* childAt = getChildAtIndex(i);
-        if (childAt && childAt->isColored()) {
+        // packed children keep the colors and densities that their elements had
+        const unsigned char* childColor = NULL;
+        float childDensity = 0.0f;
+        if (_brick) {
+            if (_brick->getBranchLeaves(i)) {
+                childColor = _brick->getBranchColor(i);
+                childDensity = _brick->getBranchDensity(i);
+            }
+        } else {
+            VoxelTreeElement* childAt = getChildAtIndex(i);
+            if (childAt) {
+                childColor = childAt->getColor();
+                childDensity = childAt->getDensity();
+            }
+        }
+        if (childColor && childColor[3] == 1) {
             for (int j = 0; j < 3; j++) {
-                colorArray[j] += childAt->getColor()[j]; // color averaging should always be based on true colors
+                colorArray[j] += childColor[j]; // color averaging should always be based on true colors
             }
             colorArray[3]++;
         }
-        if (childAt) {
-            density += childAt->getDensity();
-        }
+        density += childDensity;
     }
     density /= (float) NUMBER_OF_CHILDREN;
     //
@@ -25,12 +25,15 @@
 #include "ViewFrustum.h"
 #include "VoxelConstants.h"
 
+class VoxelBrick;
+class VoxelBrickJournal;
 class VoxelTree;
 class VoxelTreeElement;
 class VoxelSystem;
 
 class VoxelTreeElement : public OctreeElement {
     friend class VoxelTree; // to allow createElement to new us...
+    friend class VoxelBrick; // to restore the colors of the elements it unpacks
     
     VoxelTreeElement(unsigned char* octalCode = NULL);
 
@@ -50,6 +53,19 @@ public:
     virtual bool findSpherePenetration(const glm::vec3& center, float radius, 
                         glm::vec3& penetration, void** penetratedObject) const;
 
+    virtual bool hasPackedChildren() const { return _brick != NULL; }
+    virtual void unpackChildren();
+    virtual int appendPackedChildren(OctreePacketData* packetData, EncodeBitstreamParams& params,
+        int currentEncodeLevel, ViewFrustum::location location) const;
+
+    /// Replaces our children with a brick, if the subtree below is a dense run of leaves two levels down: see
+    /// VoxelBrick::pack.  Edits that reach below us (and addChildAtIndex) unpack the brick again.
+    /// \param journal if non-null, where the brick records our key when it's unpacked
+    /// \return whether we packed our children
+    bool packChildren(VoxelBrickJournal* journal = NULL);
+
+    /// Returns our packed children, or NULL if our children are elements.
+    const VoxelBrick* getBrick() const { return _brick; }
 
 
     glBufferIndex getBufferIndex() const { return _glBufferIndex; }
@@ -75,7 +91,7 @@ public:
 
     // type safe versions of OctreeElement methods
     VoxelTreeElement* getChildAtIndex(int childIndex) { return (VoxelTreeElement*)OctreeElement::getChildAtIndex(childIndex); }
-    VoxelTreeElement* addChildAtIndex(int childIndex) { return (VoxelTreeElement*)OctreeElement::addChildAtIndex(childIndex); }
+    VoxelTreeElement* addChildAtIndex(int childIndex);
     
 protected:
 
@@ -94,6 +110,7 @@ protected:
     nodeColor _color; /// Client and server, true color of this voxel, 4 bytes
 
 private:
+    VoxelBrick* _brick;                         ///< Server only, our children in packed form, if they're packed
     unsigned char _exteriorOcclusions;          ///< Exterior shared partition boundaries that are completely occupied
     unsigned char _interiorOcclusions;          ///< Interior shared partition boundaries with siblings
 };
@@ -0,0 +1,179 @@
+//
+//  AudioCodecTests.cpp
+//  tests/audio/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+#include <iostream>
+#include <math.h>
+
+#include <AudioCodec.h>
+#include <AudioRingBuffer.h>
+#include <SharedUtil.h>
+
+#include "AudioCodecTests.h"
+
+const int MONO_CHANNELS = 1;
+const int STEREO_CHANNELS = 2;
+const int FRAMES_PER_PACKET = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+
+/// Fills the buffer with a couple of tones and a little noise, which is about as hard on ADPCM as speech.
+static void fillWithTestSignal(int16_t* samples, int numFrames, int numChannels, int firstFrame) {
+    const float LOW_FREQUENCY = 220.0f;
+    const float HIGH_FREQUENCY = 1750.0f;
+    const float AMPLITUDE = 8000.0f;
+    const int NOISE_AMPLITUDE = 200;
+    for (int i = 0; i < numFrames; i++) {
+        float time = (firstFrame + i) / (float)SAMPLE_RATE;
+        for (int j = 0; j < numChannels; j++) {
+            float value = AMPLITUDE * sinf(2.0f * PI * LOW_FREQUENCY * time + j)
+                + 0.5f * AMPLITUDE * sinf(2.0f * PI * HIGH_FREQUENCY * time);
+            samples[i * numChannels + j] = (int16_t)value + (rand() % (2 * NOISE_AMPLITUDE)) - NOISE_AMPLITUDE;
+        }
+    }
+}
+
+static float signalToNoiseRatio(const int16_t* original, const int16_t* decoded, int numSamples) {
+    double signal = 0.0;
+    double noise = 0.0;
+    for (int i = 0; i < numSamples; i++) {
+        signal += (double)original[i] * original[i];
+        double error = (double)original[i] - decoded[i];
+        noise += error * error;
+    }
+    return (noise == 0.0) ? INFINITY : 10.0f * log10f(signal / noise);
+}
+
+void AudioCodecTests::pcmRoundTrip() {
+    int16_t samples[FRAMES_PER_PACKET * STEREO_CHANNELS];
+    fillWithTestSignal(samples, FRAMES_PER_PACKET, STEREO_CHANNELS, 0);
+
+    const AudioCodec* codec = AudioCodec::getCodec(AudioCodecType::PCM);
+    char encoded[FRAMES_PER_PACKET * STEREO_CHANNELS * sizeof(int16_t)];
+    int encodedSize = codec->encode(samples, FRAMES_PER_PACKET, STEREO_CHANNELS, encoded);
+    if (encodedSize != (int)sizeof(encoded)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: encoded size = " << encodedSize
+            << " but we expected " << sizeof(encoded) << std::endl;
+    }
+
+    int16_t decoded[FRAMES_PER_PACKET * STEREO_CHANNELS];
+    int numDecoded = codec->decode(encoded, encodedSize, decoded, FRAMES_PER_PACKET * STEREO_CHANNELS);
+    if (numDecoded != FRAMES_PER_PACKET * STEREO_CHANNELS || memcmp(samples, decoded, sizeof(samples)) != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: PCM did not round trip exactly" << std::endl;
+    }
+}
+
+void AudioCodecTests::adpcmRoundTrip() {
+    const AudioCodec* codec = AudioCodec::getCodec(AudioCodecType::ADPCM);
+    const float MIN_SIGNAL_TO_NOISE_RATIO = 20.0f;
+
+    for (int numChannels = MONO_CHANNELS; numChannels <= STEREO_CHANNELS; numChannels++) {
+        int16_t samples[FRAMES_PER_PACKET * STEREO_CHANNELS];
+        fillWithTestSignal(samples, FRAMES_PER_PACKET, numChannels, 0);
+
+        char encoded[MAX_DECODED_SAMPLES_PER_PACKET];
+        int encodedSize = codec->encode(samples, FRAMES_PER_PACKET, numChannels, encoded);
+        if (encodedSize != codec->getMaxEncodedSize(FRAMES_PER_PACKET, numChannels)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: encoded size = " << encodedSize
+                << " but we expected " << codec->getMaxEncodedSize(FRAMES_PER_PACKET, numChannels) << std::endl;
+        }
+
+        int16_t decoded[FRAMES_PER_PACKET * STEREO_CHANNELS];
+        int numDecoded = codec->decode(encoded, encodedSize, decoded, FRAMES_PER_PACKET * STEREO_CHANNELS);
+        if (numDecoded != FRAMES_PER_PACKET * numChannels) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: decoded " << numDecoded
+                << " samples but we expected " << FRAMES_PER_PACKET * numChannels << std::endl;
+            continue;
+        }
+        for (int i = 0; i < numChannels; i++) {
+            if (decoded[i] != samples[i]) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: first sample of channel " << i
+                    << " = " << decoded[i] << " but we expected " << samples[i] << std::endl;
+            }
+        }
+        float ratio = signalToNoiseRatio(samples, decoded, numDecoded);
+        if (ratio < MIN_SIGNAL_TO_NOISE_RATIO) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << numChannels << " channel signal to noise ratio = "
+                << ratio << "dB but we expected at least " << MIN_SIGNAL_TO_NOISE_RATIO << "dB" << std::endl;
+        }
+    }
+}
+
+void AudioCodecTests::adpcmRejectsMalformedBlocks() {
+    const AudioCodec* codec = AudioCodec::getCodec(AudioCodecType::ADPCM);
+    int16_t samples[FRAMES_PER_PACKET];
+    fillWithTestSignal(samples, FRAMES_PER_PACKET, MONO_CHANNELS, 0);
+
+    char encoded[MAX_DECODED_SAMPLES_PER_PACKET];
+    int encodedSize = codec->encode(samples, FRAMES_PER_PACKET, MONO_CHANNELS, encoded);
+
+    int16_t decoded[FRAMES_PER_PACKET];
+    if (codec->decode(encoded, encodedSize - 1, decoded, FRAMES_PER_PACKET) != -1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: decoded a truncated block" << std::endl;
+    }
+    if (codec->decode(encoded, encodedSize, decoded, FRAMES_PER_PACKET - 1) != -1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: decoded a block past the end of the destination" << std::endl;
+    }
+    if (AudioCodec::getCodec(AudioCodecType::ADPCM + 1)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: found a codec for an unknown type" << std::endl;
+    }
+}
+
+static void benchmarkCodec(const AudioCodec* codec, const char* name, int numChannels) {
+    // ten seconds' worth of packets
+    const int NUM_PACKETS = 10 * SAMPLE_RATE / FRAMES_PER_PACKET;
+
+    int numSamples = NUM_PACKETS * FRAMES_PER_PACKET * numChannels;
+    int16_t* samples = new int16_t[numSamples];
+    fillWithTestSignal(samples, NUM_PACKETS * FRAMES_PER_PACKET, numChannels, 0);
+
+    int maxEncodedSize = codec->getMaxEncodedSize(FRAMES_PER_PACKET, numChannels);
+    char* encoded = new char[NUM_PACKETS * maxEncodedSize];
+    int* encodedSizes = new int[NUM_PACKETS];
+
+    quint64 startTime = usecTimestampNow();
+    for (int i = 0; i < NUM_PACKETS; i++) {
+        encodedSizes[i] = codec->encode(samples + i * FRAMES_PER_PACKET * numChannels, FRAMES_PER_PACKET, numChannels,
+            encoded + i * maxEncodedSize);
+    }
+    quint64 encodeTime = usecTimestampNow() - startTime;
+
+    int16_t* decoded = new int16_t[numSamples];
+    startTime = usecTimestampNow();
+    for (int i = 0; i < NUM_PACKETS; i++) {
+        codec->decode(encoded + i * maxEncodedSize, encodedSizes[i], decoded + i * FRAMES_PER_PACKET * numChannels,
+            FRAMES_PER_PACKET * numChannels);
+    }
+    quint64 decodeTime = usecTimestampNow() - startTime;
+
+    std::cout << name << " (" << numChannels << " channel" << (numChannels == 1 ? "" : "s") << "): "
+        << encodedSizes[0] << " bytes per packet, "
+        << (float)encodedSizes[0] * 8 * SAMPLE_RATE / FRAMES_PER_PACKET / 1000.0f << " kbps, encode "
+        << (float)encodeTime / NUM_PACKETS << " usecs, decode " << (float)decodeTime / NUM_PACKETS << " usecs per packet, "
+        << signalToNoiseRatio(samples, decoded, numSamples) << "dB SNR" << std::endl;
+
+    delete[] decoded;
+    delete[] encodedSizes;
+    delete[] encoded;
+    delete[] samples;
+}
+
+void AudioCodecTests::benchmark() {
+    benchmarkCodec(AudioCodec::getCodec(AudioCodecType::PCM), "PCM", MONO_CHANNELS);
+    benchmarkCodec(AudioCodec::getCodec(AudioCodecType::ADPCM), "ADPCM", MONO_CHANNELS);
+    benchmarkCodec(AudioCodec::getCodec(AudioCodecType::PCM), "PCM", STEREO_CHANNELS);
+    benchmarkCodec(AudioCodec::getCodec(AudioCodecType::ADPCM), "ADPCM", STEREO_CHANNELS);
+}
+
+void AudioCodecTests::runAllTests() {
+    pcmRoundTrip();
+    adpcmRoundTrip();
+    adpcmRejectsMalformedBlocks();
+    benchmark();
+}
@@ -0,0 +1,28 @@
+//
+//  AudioCodecTests.h
+//  tests/audio/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioCodecTests_h
+#define hifi_AudioCodecTests_h
+
+namespace AudioCodecTests {
+
+    void pcmRoundTrip();
+    void adpcmRoundTrip();
+    void adpcmRejectsMalformedBlocks();
+
+    /// Times encoding and decoding a stream's worth of network frames with each codec, for a mono microphone stream and
+    /// a stereo mix, and prints the cost per frame along with the encoded size.
+    void benchmark();
+
+    void runAllTests();
+}
+
+#endif // hifi_AudioCodecTests_h
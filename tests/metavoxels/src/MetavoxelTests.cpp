@@ -130,6 +130,348 @@ static bool testSerialization(Bitstream::MetadataType metadataType) {
     return false;
 }
 
+/// Writes bits one byte at a time, in the manner of the original bitstream implementation; used to verify that the
+/// word-at-a-time implementation produces the same wire format.
+class ReferenceBitWriter {
+public:
+    
+    ReferenceBitWriter() : _byte(0), _position(0) { }
+    
+    const QByteArray& getData() const { return _data; }
+    
+    void write(const void* data, int bits, int offset = 0);
+    void flush();
+    
+private:
+    
+    QByteArray _data;
+    quint8 _byte;
+    int _position;
+};
+
+void ReferenceBitWriter::write(const void* data, int bits, int offset) {
+    const quint8* source = (const quint8*)data;
+    while (bits > 0) {
+        int bitsToWrite = qMin(BITS_IN_BYTE - _position, qMin(BITS_IN_BYTE - offset, bits));
+        _byte |= ((*source >> offset) & ((1 << bitsToWrite) - 1)) << _position;
+        if ((_position += bitsToWrite) == BITS_IN_BYTE) {
+            flush();
+        }
+        if ((offset += bitsToWrite) == BITS_IN_BYTE) {
+            source++;
+            offset = 0;
+        }
+        bits -= bitsToWrite;
+    }
+}
+
+void ReferenceBitWriter::flush() {
+    if (_position != 0) {
+        _data.append((char)_byte);
+        _byte = 0;
+        _position = 0;
+    }
+}
+
+/// A single bit-level write used in the bitstream tests.
+class BitWrite {
+public:
+    QByteArray data;
+    int bits;
+    int offset;
+};
+
+static QList<BitWrite> createRandomBitWrites(int count) {
+    QList<BitWrite> writes;
+    for (int i = 0; i < count; i++) {
+        BitWrite write;
+        switch (randIntInRange(0, 3)) {
+            case 0: // single bits, as with booleans and delta flags
+                write.data = createRandomBytes(1, 1);
+                write.bits = 1;
+                write.offset = randIntInRange(0, BITS_IN_BYTE - 1);
+                break;
+                
+            case 1: // small identifiers
+                write.data = createRandomBytes(4, 4);
+                write.bits = randIntInRange(1, 12);
+                write.offset = 0;
+                break;
+                
+            case 2: // whole ints and floats
+                write.data = createRandomBytes(4, 4);
+                write.bits = 32;
+                write.offset = 0;
+                break;
+                
+            case 3:
+            default: { // strings, with occasional unaligned starting points
+                const int MIN_STRING_BYTES = 2;
+                const int MAX_STRING_BYTES = 64;
+                write.data = createRandomBytes(MIN_STRING_BYTES, MAX_STRING_BYTES);
+                write.offset = randomBoolean() ? 0 : randIntInRange(1, BITS_IN_BYTE - 1);
+                write.bits = write.data.size() * BITS_IN_BYTE - write.offset - randIntInRange(0, BITS_IN_BYTE - 1);
+                break;
+            }
+        }
+        writes.append(write);
+    }
+    return writes;
+}
+
+static bool testBitstreamFormat() {
+    const int WRITE_COUNT = 10000;
+    QList<BitWrite> writes = createRandomBitWrites(WRITE_COUNT);
+    
+    QByteArray array;
+    QDataStream outStream(&array, QIODevice::WriteOnly);
+    Bitstream out(outStream);
+    ReferenceBitWriter reference;
+    foreach (const BitWrite& write, writes) {
+        out.write(write.data.constData(), write.bits, write.offset);
+        reference.write(write.data.constData(), write.bits, write.offset);
+    }
+    out.flush();
+    reference.flush();
+    
+    if (array != reference.getData()) {
+        qDebug() << "Bitstream wire format mismatch." << array.size() << reference.getData().size();
+        return true;
+    }
+    
+    QDataStream inStream(array);
+    Bitstream in(inStream);
+    foreach (const BitWrite& write, writes) {
+        QByteArray original = createRandomBytes(write.data.size(), write.data.size());
+        QByteArray read = original;
+        in.read(read.data(), write.bits, write.offset);
+        for (int i = 0; i < read.size() * BITS_IN_BYTE; i++) {
+            const char* source = (i >= write.offset && i < write.offset + write.bits) ? write.data.constData() :
+                original.constData();
+            int mask = 1 << (i % BITS_IN_BYTE);
+            if ((read.at(i / BITS_IN_BYTE) & mask) != (source[i / BITS_IN_BYTE] & mask)) {
+                qDebug() << "Bitstream read mismatch." << write.bits << write.offset << i;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void writeRecordingTestData(Bitstream& out, const SharedObjectPointer& object, const TestMessageC& message) {
+    out << object;
+    out << randomBoolean();
+    out << QVariant::fromValue(message);
+    out << object;
+}
+
+static bool testBitstreamRecording() {
+    SharedObjectPointer object = new TestSharedObjectA(randFloat());
+    TestMessageC message = createRandomMessageC();
+    
+    QByteArray directArray;
+    QDataStream directStream(&directArray, QIODevice::WriteOnly);
+    Bitstream direct(directStream);
+    direct << true;
+    srand(0xBEEF);
+    writeRecordingTestData(direct, object, message);
+    direct.flush();
+    
+    QByteArray recordingArray;
+    QDataStream recordingStream(&recordingArray, QIODevice::WriteOnly);
+    Bitstream recorder(recordingStream);
+    BitstreamRecording recording;
+    recorder.startRecording(recording);
+    srand(0xBEEF);
+    writeRecordingTestData(recorder, object, message);
+    recorder.stopRecording(recordingArray);
+    
+    QByteArray replayedArray;
+    QDataStream replayedStream(&replayedArray, QIODevice::WriteOnly);
+    Bitstream replayed(replayedStream);
+    replayed << true;
+    replayed << recording;
+    replayed.flush();
+    
+    if (directArray != replayedArray) {
+        qDebug() << "Replayed recording mismatch." << directArray.size() << replayedArray.size();
+        return true;
+    }
+    return false;
+}
+
+static bool testBitstreamThroughput() {
+    const int WRITE_COUNT = 100000;
+    const int PASSES = 10;
+    QList<BitWrite> writes = createRandomBitWrites(WRITE_COUNT);
+    
+    QByteArray array;
+    quint64 totalBits = 0;
+    quint64 writeTime = 0;
+    for (int i = 0; i < PASSES; i++) {
+        array.clear();
+        QDataStream outStream(&array, QIODevice::WriteOnly);
+        Bitstream out(outStream);
+        quint64 start = usecTimestampNow();
+        foreach (const BitWrite& write, writes) {
+            out.write(write.data.constData(), write.bits, write.offset);
+            totalBits += write.bits;
+        }
+        out.flush();
+        writeTime += usecTimestampNow() - start;
+    }
+    
+    quint64 readTime = 0;
+    QByteArray buffer(array.size(), 0);
+    for (int i = 0; i < PASSES; i++) {
+        QDataStream inStream(array);
+        Bitstream in(inStream);
+        quint64 start = usecTimestampNow();
+        foreach (const BitWrite& write, writes) {
+            in.read(buffer.data(), write.bits, write.offset);
+        }
+        readTime += usecTimestampNow() - start;
+    }
+    
+    float megabytes = totalBits / (float)(BITS_IN_BYTE * 1024 * 1024);
+    qDebug() << "Bitstream wrote" << megabytes << "MB in" << writeTime / 1000.0f << "ms," <<
+        megabytes * USECS_PER_SECOND / qMax(writeTime, (quint64)1) << "MB/s";
+    qDebug() << "Bitstream read" << megabytes << "MB in" << readTime / 1000.0f << "ms," <<
+        megabytes * USECS_PER_SECOND / qMax(readTime, (quint64)1) << "MB/s";
+    
+    // compare against the metavoxel data path, which mixes booleans with attribute values
+    const int NODE_COUNT = 200000;
+    array.clear();
+    QDataStream outStream(&array, QIODevice::WriteOnly);
+    Bitstream out(outStream);
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < NODE_COUNT; i++) {
+        bool leaf = (i % 8) != 0;
+        out << leaf;
+        if (leaf) {
+            out << i;
+        }
+    }
+    out.flush();
+    quint64 nodeWriteTime = usecTimestampNow() - start;
+    
+    QDataStream inStream(array);
+    Bitstream in(inStream);
+    start = usecTimestampNow();
+    for (int i = 0; i < NODE_COUNT; i++) {
+        bool leaf;
+        in >> leaf;
+        if (leaf != ((i % 8) != 0)) {
+            qDebug() << "Node leaf mismatch." << i;
+            return true;
+        }
+        if (leaf) {
+            int value;
+            in >> value;
+            if (value != i) {
+                qDebug() << "Node value mismatch." << i << value;
+                return true;
+            }
+        }
+    }
+    quint64 nodeReadTime = usecTimestampNow() - start;
+    qDebug() << "Streamed" << NODE_COUNT << "nodes: write" << nodeWriteTime / 1000.0f << "ms, read" <<
+        nodeReadTime / 1000.0f << "ms";
+    qDebug();
+    
+    return false;
+}
+
+static QByteArray writeMetavoxelData(const MetavoxelData& data) {
+    QByteArray array;
+    QDataStream stream(&array, QIODevice::WriteOnly);
+    Bitstream out(stream);
+    data.write(out);
+    out.flush();
+    return array;
+}
+
+static QHash<QString, qint64> getAllocatedNodeBytes() {
+    QHash<QString, qint64> bytes;
+    foreach (const AttributePointer& attribute, AttributeRegistry::getInstance()->getAttributes()) {
+        bytes.insert(attribute->getName(), attribute->getNodePool().getAllocatedBytes());
+    }
+    return bytes;
+}
+
+/// Consolidates the data and checks that its content stays the same.
+/// \param repeatedAttribute if non-null, an attribute whose nodes repeat in the data and so must take up fewer bytes
+static bool testConsolidation(const QString& name, MetavoxelData& data,
+        const AttributePointer& repeatedAttribute = AttributePointer()) {
+    QByteArray unconsolidated = writeMetavoxelData(data);
+    QHash<QString, qint64> bytesBefore = getAllocatedNodeBytes();
+    data.consolidate();
+    QHash<QString, qint64> bytesAfter = getAllocatedNodeBytes();
+    
+    // sharing subtrees must not change the content
+    if (writeMetavoxelData(data) != unconsolidated) {
+        qDebug() << "Consolidation changed the content of" << name;
+        return true;
+    }
+    for (QHash<QString, qint64>::const_iterator it = bytesBefore.constBegin(); it != bytesBefore.constEnd(); it++) {
+        if (it.value() != 0) {
+            qDebug() << name << it.key() << "node bytes: before" << it.value() << "after" << bytesAfter.value(it.key());
+        }
+    }
+    qDebug();
+    if (repeatedAttribute && bytesAfter.value(repeatedAttribute->getName()) >=
+            bytesBefore.value(repeatedAttribute->getName())) {
+        qDebug() << "Consolidation didn't share the repeated" << repeatedAttribute->getName() << "nodes of" << name;
+        return true;
+    }
+    return false;
+}
+
+static bool testNodeSharing() {
+    const int COLOR_COUNT = 4;
+    QRgb colors[COLOR_COUNT] = { qRgb(255, 0, 0), qRgb(0, 255, 0), qRgb(0, 0, 255), qRgb(255, 255, 255) };
+    
+    // blocky scene: many small boxes drawn from a small palette
+    {
+        MetavoxelData data;
+        const int BOX_COUNT = 200;
+        const float BOX_GRANULARITY = 1.0f / 64.0f;
+        for (int i = 0; i < BOX_COUNT; i++) {
+            glm::vec3 minimum(randFloatInRange(-0.5f, 0.4f), randFloatInRange(-0.5f, 0.4f),
+                randFloatInRange(-0.5f, 0.4f));
+            glm::vec3 size(randFloatInRange(0.01f, 0.1f), randFloatInRange(0.01f, 0.1f), randFloatInRange(0.01f, 0.1f));
+            QRgb color = colors[randIntInRange(0, COLOR_COUNT - 1)];
+            BoxSetEdit edit(Box(minimum, minimum + size), BOX_GRANULARITY, OwnedAttributeValue(
+                AttributeRegistry::getInstance()->getColorAttribute(), encodeInline(color)));
+            edit.apply(data, SharedObject::getWeakHash());
+        }
+        if (testConsolidation("Boxes", data)) {
+            return true;
+        }
+    }
+    
+    // spanner scene: repeated spheres, voxelized into the spanner attributes
+    {
+        MetavoxelData data;
+        const int SPHERE_COUNT = 50;
+        for (int i = 0; i < SPHERE_COUNT; i++) {
+            Sphere* sphere = new Sphere();
+            sphere->setTranslation(glm::vec3(randFloatInRange(-0.4f, 0.4f), randFloatInRange(-0.4f, 0.4f),
+                randFloatInRange(-0.4f, 0.4f)));
+            sphere->setScale(randFloatInRange(0.01f, 0.05f));
+            sphere->setColor(QColor::fromRgb(colors[randIntInRange(0, COLOR_COUNT - 1)]));
+            InsertSpannerEdit edit(AttributeRegistry::getInstance()->getSpannersAttribute(),
+                SharedObjectPointer(sphere));
+            edit.apply(data, SharedObject::getWeakHash());
+        }
+        // each sphere lands in every node that it overlaps, in equal sets that must hash alike to be shared
+        if (testConsolidation("Spheres", data, AttributeRegistry::getInstance()->getSpannersAttribute())) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool MetavoxelTests::run() {
     
     qDebug() << "Running transmission tests...";
@@ -168,6 +510,20 @@ bool MetavoxelTests::run() {
         return true;
     }
     
+    qDebug() << "Running bitstream tests...";
+    qDebug();
+    
+    if (testBitstreamFormat() || testBitstreamRecording() || testBitstreamThroughput()) {
+        return true;
+    }
+    
+    qDebug() << "Running node sharing tests...";
+    qDebug();
+    
+    if (testNodeSharing()) {
+        return true;
+    }
+    
     qDebug() << "All tests passed!";
     
     return false;
@@ -0,0 +1,201 @@
+//
+//  PacketBufferTests.cpp
+//  tests/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+#include <iostream>
+
+#include <Node.h>
+#include <PacketBuffer.h>
+#include <PacketHeaders.h>
+#include <ReceivedPacketProcessor.h>
+#include <UUID.h>
+
+#include "PacketBufferTests.h"
+
+void PacketBufferTests::uuidRoundTrip() {
+    QUuid uuid = QUuid::createUuid();
+    char rfcUUID[NUM_BYTES_RFC4122_UUID];
+    writeRfc4122(uuid, rfcUUID);
+    if (memcmp(rfcUUID, uuid.toRfc4122().constData(), NUM_BYTES_RFC4122_UUID) != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: writeRfc4122 disagrees with toRfc4122" << std::endl;
+    }
+    if (uuidFromRfc4122(rfcUUID) != uuid) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: UUID did not round trip" << std::endl;
+    }
+}
+
+void PacketBufferTests::packetViewMatchesHeaderFunctions() {
+    QUuid senderUUID = QUuid::createUuid();
+    QUuid connectionSecret = QUuid::createUuid();
+
+    QByteArray packet = byteArrayWithPopulatedHeader(PacketTypeAvatarData, senderUUID);
+    packet.append("some avatar data");
+    replaceHashInPacketGivenConnectionUUID(packet, connectionSecret);
+
+    PacketView packetView(packet);
+    if (!packetView.isValid() || packetView.getType() != PacketTypeAvatarData
+            || packetView.getHeaderSize() != numBytesForPacketHeader(packet)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: view has the wrong type or header size" << std::endl;
+    }
+    if (packetView.getSenderUUID() != uuidFromPacketHeader(packet) || packetView.getSenderUUID() != senderUUID) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: view has the wrong sender" << std::endl;
+    }
+    if (QByteArray(packetView.getHash(), NUM_BYTES_MD5_HASH) != hashFromPacketHeader(packet)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: view has the wrong hash" << std::endl;
+    }
+    if (QByteArray(packetView.getPayload(), packetView.getPayloadSize()) != "some avatar data") {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: view has the wrong payload" << std::endl;
+    }
+    if (!packetView.hashMatches(connectionSecret) || packetView.hashMatches(QUuid::createUuid())) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: hash check failed" << std::endl;
+    }
+    if (PacketView(packet.constData(), packetView.getHeaderSize() - 1).isValid()
+            || PacketView(QByteArray()).isValid()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: truncated packet passed as valid" << std::endl;
+    }
+}
+
+static int getCounter(PacketBufferPool& pool, const char* name) {
+    return pool.getStats().value(name).toInt();
+}
+
+void PacketBufferTests::steadyStateDoesNotAllocate() {
+    PacketBufferPool pool;
+    const int BUFFERS_IN_FLIGHT = 32;
+    const int NUM_ROUNDS = 100;
+    QByteArray buffers[BUFFERS_IN_FLIGHT];
+
+    for (int round = 0; round < NUM_ROUNDS; round++) {
+        for (int i = 0; i < BUFFERS_IN_FLIGHT; i++) {
+            buffers[i] = pool.take(100 + (round * BUFFERS_IN_FLIGHT + i) % MAX_PACKET_HEADER_BYTES);
+            const char* data = buffers[i].constData();
+
+            // passing the buffer along shares it rather than copying it
+            {
+                QByteArray queued = buffers[i];
+                if (queued.constData() != data) {
+                    std::cout << __FILE__ << ":" << __LINE__ << " ERROR: copying the buffer copied it" << std::endl;
+                }
+            }
+
+            // shrinking and growing within the capacity stays in place
+            buffers[i].resize(1);
+            buffers[i].resize(PACKET_BUFFER_CAPACITY);
+            if (buffers[i].constData() != data) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: resizing the buffer moved it" << std::endl;
+            }
+        }
+        for (int i = 0; i < BUFFERS_IN_FLIGHT; i++) {
+            pool.recycle(buffers[i]);
+            if (!buffers[i].isEmpty()) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: recycled buffer not emptied" << std::endl;
+            }
+        }
+    }
+    if (getCounter(pool, "packet_buffers_allocated") != BUFFERS_IN_FLIGHT) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: allocated " << getCounter(pool, "packet_buffers_allocated")
+            << " buffers but we expected " << BUFFERS_IN_FLIGHT << std::endl;
+    }
+    if (getCounter(pool, "packet_buffers_reused") != BUFFERS_IN_FLIGHT * (NUM_ROUNDS - 1)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: reused " << getCounter(pool, "packet_buffers_reused")
+            << " buffers but we expected " << BUFFERS_IN_FLIGHT * (NUM_ROUNDS - 1) << std::endl;
+    }
+    QByteArray oversized = pool.take(PACKET_BUFFER_CAPACITY + 1);
+    pool.recycle(oversized);
+    if (getCounter(pool, "packet_buffers_oversized") != 1 || pool.getNumFree() != BUFFERS_IN_FLIGHT) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: oversized buffer was pooled" << std::endl;
+    }
+}
+
+void PacketBufferTests::sharedBuffersAreNotReused() {
+    PacketBufferPool pool;
+    QByteArray buffer = pool.take(MAX_PACKET_HEADER_BYTES);
+    memset(buffer.data(), 'a', buffer.size());
+
+    // somebody keeps a copy, so the buffer mustn't be handed out again until they let go of it
+    QByteArray kept = buffer;
+    pool.recycle(buffer);
+    if (getCounter(pool, "packet_buffers_still_shared") != 1 || pool.getNumFree() != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: shared buffer was pooled" << std::endl;
+    }
+    QByteArray next = pool.take(MAX_PACKET_HEADER_BYTES);
+    memset(next.data(), 'b', next.size());
+    if (kept != QByteArray(MAX_PACKET_HEADER_BYTES, 'a')) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: kept copy was overwritten" << std::endl;
+    }
+
+    // once the last holder recycles it, it's reused
+    pool.recycle(kept);
+    if (pool.getNumFree() != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: unshared buffer was not pooled" << std::endl;
+    }
+}
+
+/// Counts the packets it's given, and lets the test run its processing on the test's thread.
+class CountingPacketProcessor : public ReceivedPacketProcessor {
+public:
+    CountingPacketProcessor() : numProcessed(0) { }
+
+    void processQueuedPackets() { process(); }
+
+    int numProcessed;
+
+protected:
+    virtual void processPacket(const SharedNodePointer& sendingNode, const QByteArray& packet) { numProcessed++; }
+};
+
+void PacketBufferTests::processedBuffersAreRecycled() {
+    PacketBufferPool& pool = PacketBufferPool::getInstance();
+    CountingPacketProcessor processor;
+    SharedNodePointer sendingNode(new Node(QUuid::createUuid(), NodeType::Agent, HifiSockAddr(), HifiSockAddr()));
+    const int PACKETS_PER_ROUND = 16;
+    const int NUM_ROUNDS = 50;
+
+    int allocatedAfterFirstRound = 0;
+    for (int round = 0; round < NUM_ROUNDS; round++) {
+        // on even rounds the reader lets go first, as it usually does; on odd ones, the processor does
+        bool readerFirst = (round % 2 == 0);
+        QByteArray readerCopies[PACKETS_PER_ROUND];
+        for (int i = 0; i < PACKETS_PER_ROUND; i++) {
+            readerCopies[i] = pool.take(MAX_PACKET_HEADER_BYTES + i);
+            processor.queueReceivedPacket(sendingNode, readerCopies[i]);
+            if (readerFirst) {
+                pool.recycle(readerCopies[i]);
+            }
+        }
+        processor.processQueuedPackets();
+        if (!readerFirst) {
+            for (int i = 0; i < PACKETS_PER_ROUND; i++) {
+                pool.recycle(readerCopies[i]);
+            }
+        }
+        if (round == 0) {
+            allocatedAfterFirstRound = getCounter(pool, "packet_buffers_allocated");
+        }
+    }
+    if (processor.numProcessed != PACKETS_PER_ROUND * NUM_ROUNDS) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: processed " << processor.numProcessed << " packets but we "
+            "expected " << PACKETS_PER_ROUND * NUM_ROUNDS << std::endl;
+    }
+    int allocatedSince = getCounter(pool, "packet_buffers_allocated") - allocatedAfterFirstRound;
+    if (allocatedSince != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: allocated " << allocatedSince
+            << " buffers once the pool was warm" << std::endl;
+    }
+}
+
+void PacketBufferTests::runAllTests() {
+    uuidRoundTrip();
+    packetViewMatchesHeaderFunctions();
+    steadyStateDoesNotAllocate();
+    sharedBuffersAreNotReused();
+    processedBuffersAreRecycled();
+}
@@ -0,0 +1,31 @@
+//
+//  PacketBufferTests.h
+//  tests/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PacketBufferTests_h
+#define hifi_PacketBufferTests_h
+
+namespace PacketBufferTests {
+
+    void uuidRoundTrip();
+    void packetViewMatchesHeaderFunctions();
+
+    /// Takes and recycles buffers as a receive loop would, and checks that the pool stops allocating once it's warm.
+    void steadyStateDoesNotAllocate();
+    void sharedBuffersAreNotReused();
+
+    /// Passes pooled buffers through a processor's queue, as the octree server's readers do, and checks that they come
+    /// back to the pool whichever of the reader and the processor lets go of them last.
+    void processedBuffersAreRecycled();
+
+    void runAllTests();
+}
+
+#endif // hifi_PacketBufferTests_h
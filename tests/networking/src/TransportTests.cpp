@@ -0,0 +1,247 @@
+//
+//  TransportTests.cpp
+//  tests/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+#include <iostream>
+
+#include <QtCore/QSharedMemory>
+#include <QtNetwork/QUdpSocket>
+
+#include <LimitedNodeList.h>
+#include <PacketBuffer.h>
+#include <SharedMemoryRing.h>
+#include <SharedUtil.h>
+
+#include "TransportTests.h"
+
+/// Returns a port that nothing else on this host will be using for a ring, by binding a socket to it.
+static quint16 reservePort(QUdpSocket& socket) {
+    socket.bind(QHostAddress::LocalHost, 0);
+    return socket.localPort();
+}
+
+static void fillDatagram(char* data, int size, int sequence) {
+    for (int i = 0; i < size; i++) {
+        data[i] = (char)(sequence + i);
+    }
+}
+
+void TransportTests::ringRoundTrip() {
+    QUdpSocket socket;
+    quint16 port = reservePort(socket);
+    const int RING_BYTES = 1024;
+    SharedMemoryRing owner;
+    SharedMemoryRing writer;
+    if (!owner.create(port, RING_BYTES) || !writer.attach(port)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: failed to set up the ring" << std::endl;
+        return;
+    }
+    HifiSockAddr senderSockAddr(QHostAddress::LocalHost, 12345);
+    char data[300];
+    QByteArray packet;
+    HifiSockAddr receivedSockAddr;
+    const int NUM_DATAGRAMS = 100;
+    for (int i = 0; i < NUM_DATAGRAMS; i++) {
+        // odd sizes, so that records don't line up with the end of the ring
+        int size = 1 + (i * 37) % (int)sizeof(data);
+        fillDatagram(data, size, i);
+        if (!writer.write(data, size, senderSockAddr)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: write " << i << " failed" << std::endl;
+            continue;
+        }
+        if (!owner.read(packet, receivedSockAddr)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: read " << i << " failed" << std::endl;
+            continue;
+        }
+        if (packet != QByteArray(data, size) || receivedSockAddr != senderSockAddr) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: datagram " << i << " did not round trip" << std::endl;
+        }
+        PacketBufferPool::getInstance().recycle(packet);
+    }
+    if (owner.read(packet, receivedSockAddr)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: read from an empty ring" << std::endl;
+    }
+}
+
+void TransportTests::fullRingDropsDatagrams() {
+    QUdpSocket socket;
+    quint16 port = reservePort(socket);
+    const int RING_BYTES = 1024;
+    SharedMemoryRing owner;
+    SharedMemoryRing writer;
+    if (!owner.create(port, RING_BYTES) || !writer.attach(port)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: failed to set up the ring" << std::endl;
+        return;
+    }
+    HifiSockAddr senderSockAddr(QHostAddress::LocalHost, 12345);
+    char data[100];
+    int numWritten = 0;
+    while (writer.write(data, sizeof(data), senderSockAddr)) {
+        numWritten++;
+    }
+    if (numWritten == 0 || numWritten * (int)sizeof(data) > RING_BYTES || owner.takeDropCount() != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: wrote " << numWritten
+            << " datagrams before the ring was full" << std::endl;
+    }
+
+    // once the owner catches up, there's room again
+    QByteArray packet;
+    HifiSockAddr receivedSockAddr;
+    int numRead = 0;
+    while (owner.read(packet, receivedSockAddr)) {
+        numRead++;
+    }
+    if (numRead != numWritten || !writer.write(data, sizeof(data), senderSockAddr)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: read " << numRead << " datagrams but we expected "
+            << numWritten << std::endl;
+    }
+    PacketBufferPool::getInstance().recycle(packet);
+}
+
+void TransportTests::closedRingRejectsWriters() {
+    QUdpSocket socket;
+    quint16 port = reservePort(socket);
+    SharedMemoryRing writer;
+    {
+        SharedMemoryRing owner;
+        owner.create(port);
+        if (!writer.attach(port)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: failed to attach to the ring" << std::endl;
+            return;
+        }
+    }
+    char data[100];
+    if (writer.write(data, sizeof(data), HifiSockAddr(QHostAddress::LocalHost, 12345))) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: wrote to a closed ring" << std::endl;
+    }
+    SharedMemoryRing lateWriter;
+    if (lateWriter.attach(port)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: attached to a closed ring" << std::endl;
+    }
+}
+
+void TransportTests::doorbellLeavesLockFree() {
+    QUdpSocket socket;
+    quint16 port = reservePort(socket);
+    SharedMemoryRing owner;
+    if (!owner.create(port)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: failed to create the ring" << std::endl;
+        return;
+    }
+    QSharedMemory memory(SharedMemoryRing::keyForPort(port));
+    if (!memory.attach() || !memory.lock()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: failed to lock the ring after creating it" << std::endl;
+        return;
+    }
+    memory.unlock();
+
+    // ringing the doorbell must wake the owner without touching the lock
+    SharedMemoryRing writer;
+    char data[100];
+    if (!writer.attach(port) || !writer.write(data, sizeof(data), HifiSockAddr(QHostAddress::LocalHost, 12345))) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: failed to write to the ring" << std::endl;
+        return;
+    }
+    owner.waitForDoorbell();
+    if (!memory.lock()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: failed to lock the ring after the doorbell rang"
+            << std::endl;
+        return;
+    }
+    memory.unlock();
+}
+
+/// Datagrams are sent in batches small enough for the socket's receive buffer, then received.
+const int BENCHMARK_BATCH_SIZE = 64;
+const int BENCHMARK_BATCHES = 200;
+
+static void benchmarkTransports(int datagramSize) {
+    char data[MAX_PACKET_SIZE];
+    fillDatagram(data, datagramSize, 0);
+    QByteArray packet;
+    HifiSockAddr senderSockAddr;
+    int numDatagrams = BENCHMARK_BATCH_SIZE * BENCHMARK_BATCHES;
+
+    QUdpSocket receiver;
+    receiver.bind(QHostAddress::LocalHost, 0);
+    QUdpSocket sender;
+    sender.bind(QHostAddress::LocalHost, 0);
+    PacketBufferPool& bufferPool = PacketBufferPool::getInstance();
+
+    int numReceived = 0;
+    quint64 startTime = usecTimestampNow();
+    for (int batch = 0; batch < BENCHMARK_BATCHES; batch++) {
+        for (int i = 0; i < BENCHMARK_BATCH_SIZE; i++) {
+            sender.writeDatagram(data, datagramSize, QHostAddress::LocalHost, receiver.localPort());
+        }
+        for (int i = 0; i < BENCHMARK_BATCH_SIZE; i++) {
+            const int WAIT_MSECS = 100;
+            if (!receiver.hasPendingDatagrams() && !receiver.waitForReadyRead(WAIT_MSECS)) {
+                break;
+            }
+            bufferPool.recycle(packet);
+            packet = bufferPool.take(receiver.pendingDatagramSize());
+            receiver.readDatagram(packet.data(), packet.size(), senderSockAddr.getAddressPointer(),
+                senderSockAddr.getPortPointer());
+            numReceived++;
+        }
+    }
+    quint64 udpTime = usecTimestampNow() - startTime;
+    if (numReceived != numDatagrams) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: received " << numReceived
+            << " datagrams over UDP but we expected " << numDatagrams << std::endl;
+    }
+
+    SharedMemoryRing owner;
+    SharedMemoryRing writer;
+    if (!owner.create(receiver.localPort()) || !writer.attach(receiver.localPort())) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: failed to set up the ring" << std::endl;
+        return;
+    }
+    HifiSockAddr writerSockAddr(QHostAddress::LocalHost, sender.localPort());
+    numReceived = 0;
+    startTime = usecTimestampNow();
+    for (int batch = 0; batch < BENCHMARK_BATCHES; batch++) {
+        for (int i = 0; i < BENCHMARK_BATCH_SIZE; i++) {
+            writer.write(data, datagramSize, writerSockAddr);
+        }
+        for (int i = 0; i < BENCHMARK_BATCH_SIZE; i++) {
+            bufferPool.recycle(packet);
+            if (!owner.read(packet, senderSockAddr)) {
+                break;
+            }
+            numReceived++;
+        }
+    }
+    quint64 ringTime = usecTimestampNow() - startTime;
+    if (numReceived != numDatagrams) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: received " << numReceived
+            << " datagrams through the ring but we expected " << numDatagrams << std::endl;
+    }
+    bufferPool.recycle(packet);
+
+    std::cout << datagramSize << " byte datagrams: UDP loopback " << (float)udpTime / numDatagrams
+        << " usecs, shared memory ring " << (float)ringTime / numDatagrams << " usecs per datagram" << std::endl;
+}
+
+void TransportTests::benchmark() {
+    benchmarkTransports(64);
+    benchmarkTransports(512);
+    benchmarkTransports(MAX_PACKET_SIZE);
+}
+
+void TransportTests::runAllTests() {
+    ringRoundTrip();
+    fullRingDropsDatagrams();
+    closedRingRejectsWriters();
+    doorbellLeavesLockFree();
+    benchmark();
+}
@@ -0,0 +1,32 @@
+//
+//  TransportTests.h
+//  tests/networking/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_TransportTests_h
+#define hifi_TransportTests_h
+
+namespace TransportTests {
+
+    /// Pushes datagrams through a small ring enough times for it to wrap, and checks they come out whole and in order.
+    void ringRoundTrip();
+    void fullRingDropsDatagrams();
+    void closedRingRejectsWriters();
+
+    /// Checks that creating the ring and ringing its doorbell leave the memory's lock free (a test that fails by hanging).
+    void doorbellLeavesLockFree();
+
+    /// Times moving datagrams of a few typical sizes from one socket to another over UDP loopback and through a shared
+    /// memory ring, and prints the cost per datagram of each.
+    void benchmark();
+
+    void runAllTests();
+}
+
+#endif // hifi_TransportTests_h
@@ -0,0 +1,18 @@
+//
+//  main.cpp
+//  tests/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "PacketBufferTests.h"
+#include "TransportTests.h"
+
+int main(int argc, char** argv) {
+    PacketBufferTests::runAllTests();
+    TransportTests::runAllTests();
+    return 0;
+}
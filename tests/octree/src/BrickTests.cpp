@@ -0,0 +1,285 @@
+//
+//  BrickTests.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <math.h>
+
+#include <OctreeElementBag.h>
+#include <OctreePacketData.h>
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+#include <VoxelBrick.h>
+#include <VoxelTree.h>
+
+#include "BrickTests.h"
+#include "TestWorld.h"
+
+/// Fills a block in the corner of the world, resolution / 4 voxels across and half as high, with the odd voxel
+/// missing: dense enough for most of it to pack, with bricks of every fullness.
+static void buildBlock(VoxelTree& tree, int resolution) {
+    srand(7);
+    int level = 0;
+    while ((1 << level) < resolution) {
+        level++;
+    }
+    const int MISSING_VOXEL_ODDS = 8;
+    QVector<BulkVoxel> voxels;
+    for (int x = 0; x < resolution / 4; x++) {
+        for (int y = 0; y < resolution / 8; y++) {
+            for (int z = 0; z < resolution / 4; z++) {
+                if (randIntInRange(0, MISSING_VOXEL_ODDS) == 0) {
+                    continue;
+                }
+                BulkVoxel voxel;
+                voxel.key = MortonKey::forCoordinates(level, x, y, z);
+                voxel.color[RED_INDEX] = randomColorValue(64);
+                voxel.color[GREEN_INDEX] = randomColorValue(64);
+                voxel.color[BLUE_INDEX] = randomColorValue(64);
+                voxels.append(voxel);
+            }
+        }
+    }
+    VoxelTree::sortVoxels(voxels);
+    tree.createVoxels(voxels);
+}
+
+/// Encodes what the frustum (if any) sees of the source a packet at a time, as the send thread does, and reads each
+/// packet into the destination, as a viewer does.
+/// \return the number of bytes encoded
+static int sendScene(VoxelTree& source, VoxelTree* destination, const ViewFrustum* viewFrustum,
+        int boundaryLevelAdjust) {
+    OctreeElementBag bag;
+    bag.insert(source.getRoot());
+    OctreePacketData packetData;
+    int bytes = 0;
+    while (!bag.isEmpty()) {
+        OctreeElement* subTree = bag.extract();
+        EncodeBitstreamParams params(INT_MAX, viewFrustum, WANT_COLOR, WANT_EXISTS_BITS, DONT_CHOP, false,
+            IGNORE_VIEW_FRUSTUM, NO_OCCLUSION_CULLING, IGNORE_COVERAGE_MAP, boundaryLevelAdjust);
+        bytes += source.encodeTreeBitstream(subTree, &packetData, bag, params);
+        if (destination) {
+            ReadBitstreamToTreeParams args(WANT_COLOR, WANT_EXISTS_BITS);
+            destination->readBitstreamToTree(packetData.getUncompressedData(), packetData.getUncompressedSize(), args);
+        }
+        packetData.reset();
+    }
+    return bytes;
+}
+
+static bool voxelsMatch(VoxelTree& first, VoxelTree& second) {
+    QVector<BulkVoxel> firstVoxels;
+    first.collectVoxels(firstVoxels);
+    QVector<BulkVoxel> secondVoxels;
+    second.collectVoxels(secondVoxels);
+    if (firstVoxels.size() != secondVoxels.size()) {
+        return false;
+    }
+    for (int i = 0; i < firstVoxels.size(); i++) {
+        if (firstVoxels.at(i).key != secondVoxels.at(i).key ||
+                memcmp(firstVoxels.at(i).color, secondVoxels.at(i).color, sizeof(rgbColor)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Checks that the packed tree holds what the unpacked one does, averages included, by copying it out.
+static bool packedTreeMatches(VoxelTree& unpackedTree, VoxelTree& packedTree) {
+    VoxelTree copy;
+    packedTree.copySubTreeIntoNewTree(packedTree.getRoot(), &copy, false);
+    return voxelsMatch(unpackedTree, packedTree) && TestWorld::subtreesMatch(unpackedTree.getRoot(), copy.getRoot());
+}
+
+void BrickTests::packedMatchesElements() {
+    const int RESOLUTION = 128;
+    const int MINIMUM_BRICK_LEVEL = 2;
+
+    VoxelTree unpackedTree(true);
+    buildBlock(unpackedTree, RESOLUTION);
+    VoxelTree packedTree(true);
+    buildBlock(packedTree, RESOLUTION);
+    if (packedTree.packBricks() != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: packed bricks with packing turned off" << std::endl;
+    }
+    packedTree.setMinimumBrickLevel(MINIMUM_BRICK_LEVEL);
+    int bricks = packedTree.packBricks();
+    if (bricks == 0 || VoxelBrick::getBrickCount() < (quint64)bricks) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: packed " << bricks << " bricks" << std::endl;
+    }
+    if (!packedTreeMatches(unpackedTree, packedTree)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: packed tree encodes differently" << std::endl;
+    }
+
+    // look across the block from beside it, so that some bricks are in view, some are cut by the frustum, and some are
+    // out of view, and step the level of detail down so that the leaves give way to the branches and then the bricks
+    ViewFrustum viewFrustum;
+    viewFrustum.setPosition(glm::vec3(0.3f, 0.05f, 0.2f) * (float)TREE_SCALE);
+    viewFrustum.setOrientation(glm::angleAxis(PI_OVER_TWO * 0.5f, glm::vec3(0.0f, 1.0f, 0.0f)));
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(1.0f);
+    viewFrustum.setNearClip(0.1f);
+    viewFrustum.setFarClip(TREE_SCALE * 4.0f);
+    viewFrustum.calculate();
+
+    const int MAX_BOUNDARY_ADJUST = 8;
+    for (int boundaryLevelAdjust = 0; boundaryLevelAdjust <= MAX_BOUNDARY_ADJUST; boundaryLevelAdjust += 2) {
+        VoxelTree unpackedView;
+        sendScene(unpackedTree, &unpackedView, &viewFrustum, boundaryLevelAdjust);
+        VoxelTree packedView;
+        sendScene(packedTree, &packedView, &viewFrustum, boundaryLevelAdjust);
+        if (!TestWorld::subtreesMatch(unpackedView.getRoot(), packedView.getRoot())) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: view of packed tree differs at boundary adjust "
+                << boundaryLevelAdjust << std::endl;
+        }
+    }
+}
+
+/// Recolors, adds, subdivides, replaces, and deletes voxels in the block, the same ones every time.
+static void editBlock(VoxelTree& tree, int resolution, int edits) {
+    srand(9);
+    float scale = 1.0f / resolution;
+    for (int i = 0; i < edits; i++) {
+        float x = randIntInRange(0, resolution / 4 - 1) * scale;
+        float y = randIntInRange(0, resolution / 8 - 1) * scale;
+        float z = randIntInRange(0, resolution / 4 - 1) * scale;
+        switch (i % 4) {
+            case 0:
+                tree.createVoxel(x, y, z, scale, 255, 0, 0);
+                break;
+            case 1:
+                tree.deleteVoxelAt(x, y, z, scale);
+                break;
+            case 2:
+                tree.createVoxel(x, y, z, scale * 0.5f, 0, 255, 0);
+                break;
+            case 3:
+                tree.createVoxel(floorf(x / (scale * 2.0f)) * scale * 2.0f, floorf(y / (scale * 2.0f)) * scale * 2.0f,
+                    floorf(z / (scale * 2.0f)) * scale * 2.0f, scale * 2.0f, 0, 0, 255, true);
+                break;
+        }
+    }
+}
+
+void BrickTests::editsMatchUnpacked() {
+    const int RESOLUTION = 64;
+    const int EDITS = 200;
+    const int MINIMUM_BRICK_LEVEL = 1;
+
+    VoxelTree unpackedTree(true);
+    buildBlock(unpackedTree, RESOLUTION);
+    VoxelTree packedTree(true);
+    buildBlock(packedTree, RESOLUTION);
+    packedTree.setMinimumBrickLevel(MINIMUM_BRICK_LEVEL);
+    packedTree.packBricks();
+
+    // recoloring a voxel unpacks its brick, and that brick alone is repacked
+    float scale = 1.0f / RESOLUTION;
+    unpackedTree.createVoxel(0.0f, 0.0f, 0.0f, scale, 255, 255, 0);
+    packedTree.createVoxel(0.0f, 0.0f, 0.0f, scale, 255, 255, 0);
+    int bricks = packedTree.repackBricks();
+    if (bricks != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: repacked " << bricks << " bricks after one edit"
+            << std::endl;
+    }
+
+    editBlock(unpackedTree, RESOLUTION, EDITS);
+    editBlock(packedTree, RESOLUTION, EDITS);
+    if (!packedTreeMatches(unpackedTree, packedTree)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: edited packed tree differs" << std::endl;
+    }
+
+    // what the edits unpacked packs again, where it's still dense enough
+    packedTree.repackBricks();
+    if (!packedTreeMatches(unpackedTree, packedTree)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: repacked tree differs" << std::endl;
+    }
+
+    // a batch reaches into the bricks as single edits do
+    QVector<BulkVoxel> voxels;
+    unpackedTree.collectVoxels(voxels);
+    for (int i = 0; i < voxels.size(); i++) {
+        voxels[i].color[RED_INDEX] = 255 - voxels.at(i).color[RED_INDEX];
+    }
+    unpackedTree.createVoxels(voxels);
+    packedTree.createVoxels(voxels);
+    if (!packedTreeMatches(unpackedTree, packedTree)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: batch-edited packed tree differs" << std::endl;
+    }
+}
+
+void BrickTests::repackFindsNewSubtrees() {
+    const int RESOLUTION = 64;
+    const int MINIMUM_BRICK_LEVEL = 1;
+
+    VoxelTree unpackedTree(true);
+    buildBlock(unpackedTree, RESOLUTION);
+    VoxelTree packedTree(true);
+    buildBlock(packedTree, RESOLUTION);
+    packedTree.setMinimumBrickLevel(MINIMUM_BRICK_LEVEL);
+    int expectedBricks = packedTree.packBricks();
+
+    // as for a server that starts empty and is filled by edits
+    VoxelTree grownTree(true);
+    grownTree.setMinimumBrickLevel(MINIMUM_BRICK_LEVEL);
+    grownTree.packBricks();
+    buildBlock(grownTree, RESOLUTION);
+    int bricks = grownTree.repackBricks();
+    if (bricks != expectedBricks) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: repacked " << bricks << " bricks in the grown tree, but "
+            << expectedBricks << " in the loaded one" << std::endl;
+    }
+    if (!packedTreeMatches(unpackedTree, grownTree)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: repacked grown tree differs" << std::endl;
+    }
+}
+
+static quint64 getMemoryUsage() {
+    return OctreeElement::getTotalMemoryUsage() + VoxelBrick::getMemoryUsage();
+}
+
+void BrickTests::benchmark() {
+    const int RESOLUTION = 256;
+    const int MINIMUM_BRICK_LEVEL = 1;
+
+    quint64 memoryBefore = getMemoryUsage();
+    VoxelTree tree(true);
+    buildBlock(tree, RESOLUTION);
+    quint64 unpackedMemory = getMemoryUsage() - memoryBefore;
+
+    // the whole tree, as for a new viewer or the persist file
+    quint64 startTime = usecTimestampNow();
+    int unpackedBytes = sendScene(tree, NULL, IGNORE_VIEW_FRUSTUM, NO_BOUNDARY_ADJUST);
+    quint64 unpackedTime = usecTimestampNow() - startTime;
+
+    tree.setMinimumBrickLevel(MINIMUM_BRICK_LEVEL);
+    startTime = usecTimestampNow();
+    int bricks = tree.packBricks();
+    quint64 packTime = usecTimestampNow() - startTime;
+    quint64 packedMemory = getMemoryUsage() - memoryBefore;
+
+    startTime = usecTimestampNow();
+    int packedBytes = sendScene(tree, NULL, IGNORE_VIEW_FRUSTUM, NO_BOUNDARY_ADJUST);
+    quint64 packedTime = usecTimestampNow() - startTime;
+
+    std::cout << "Bricks: " << bricks << " packed in " << packTime << " usecs; the scene takes " << unpackedMemory
+        << " bytes unpacked and " << packedMemory << " bytes packed, and encodes to " << unpackedBytes
+        << " bytes in " << unpackedTime << " usecs unpacked and " << packedBytes << " bytes in " << packedTime
+        << " usecs packed" << std::endl;
+}
+
+void BrickTests::runAllTests() {
+    packedMatchesElements();
+    editsMatchUnpacked();
+    repackFindsNewSubtrees();
+    benchmark();
+}
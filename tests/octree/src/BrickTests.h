@@ -0,0 +1,34 @@
+//
+//  BrickTests.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_BrickTests_h
+#define hifi_BrickTests_h
+
+namespace BrickTests {
+
+    /// Packs a dense scene into bricks and checks that it encodes to what its elements did, in full and in view of
+    /// frustums at several levels of detail.
+    void packedMatchesElements();
+
+    /// Edits a packed tree and an unpacked one alike, and checks that they still hold the same voxels and averages,
+    /// and that repacking looks at just the bricks that the edits unpacked.
+    void editsMatchUnpacked();
+
+    /// Packs an empty tree, fills it, and checks that repacking finds the dense subtrees that the edits built.
+    void repackFindsNewSubtrees();
+
+    /// Compares the memory taken and the time to encode a dense scene before and after packing it.
+    void benchmark();
+
+    void runAllTests();
+}
+
+#endif // hifi_BrickTests_h
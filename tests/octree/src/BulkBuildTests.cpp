@@ -0,0 +1,115 @@
+//
+//  BulkBuildTests.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+#include <math.h>
+
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "BulkBuildTests.h"
+#include "TestWorld.h"
+
+/// Makes the voxels of a terrain like TestWorld's, with some larger voxels and some repeats mixed in.
+static QVector<BulkVoxel> makeTerrainVoxels(int resolution) {
+    srand(7);
+    QVector<BulkVoxel> voxels;
+    float scale = 1.0f / resolution;
+    for (int i = 0; i < resolution; i++) {
+        float x = i * scale;
+        for (int j = 0; j < resolution; j++) {
+            float z = j * scale;
+            float y = floorf(TestWorld::terrainHeight(x, z) * resolution) * scale;
+            BulkVoxel voxel;
+            voxel.key = MortonKey::forVoxel(x, y, z, scale);
+            voxel.color[RED_INDEX] = randomColorValue(64);
+            voxel.color[GREEN_INDEX] = randomColorValue(64);
+            voxel.color[BLUE_INDEX] = randomColorValue(64);
+            voxels.append(voxel);
+
+            const int LARGER_VOXEL_ODDS = 256;
+            if (randIntInRange(0, LARGER_VOXEL_ODDS) == 0) {
+                voxel.key = MortonKey::forVoxel(x, y + randIntInRange(8, 64) * scale, z, scale * 4.0f);
+                voxels.append(voxel);
+            }
+            const int REPEATED_VOXEL_ODDS = 64;
+            if (randIntInRange(0, REPEATED_VOXEL_ODDS) == 0) {
+                voxel.color[RED_INDEX] = 255;
+                voxels.append(voxel);
+            }
+        }
+    }
+    VoxelTree::sortVoxels(voxels);
+    return voxels;
+}
+
+static void createOneAtATime(VoxelTree& tree, const QVector<BulkVoxel>& voxels, bool destructive) {
+    foreach (const BulkVoxel& voxel, voxels) {
+        glm::vec3 corner = voxel.key.getCorner();
+        tree.createVoxel(corner.x, corner.y, corner.z, voxel.key.getScale(), voxel.color[RED_INDEX],
+            voxel.color[GREEN_INDEX], voxel.color[BLUE_INDEX], destructive);
+    }
+}
+
+void BulkBuildTests::bulkMatchesOneAtATime() {
+    const int TERRAIN_RESOLUTION = 128;
+    QVector<BulkVoxel> voxels = makeTerrainVoxels(TERRAIN_RESOLUTION);
+
+    for (int destructive = 0; destructive < 2; destructive++) {
+        VoxelTree bulkTree(true);
+        bulkTree.createVoxels(voxels, destructive);
+
+        VoxelTree singleTree(true);
+        createOneAtATime(singleTree, voxels, destructive);
+
+        if (!TestWorld::subtreesMatch(bulkTree.getRoot(), singleTree.getRoot())) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: bulk tree differs from one built a voxel at a time"
+                << (destructive ? " (destructive)" : "") << std::endl;
+        }
+
+        // collecting the voxels and building them again should give back the same tree
+        QVector<BulkVoxel> collected;
+        bulkTree.collectVoxels(collected);
+        VoxelTree copyTree(true);
+        copyTree.createVoxels(collected, destructive);
+        if (!TestWorld::subtreesMatch(bulkTree.getRoot(), copyTree.getRoot())) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: tree built from collected voxels differs"
+                << std::endl;
+        }
+    }
+}
+
+void BulkBuildTests::benchmark() {
+    const int TERRAIN_RESOLUTION = 512;
+    QVector<BulkVoxel> voxels = makeTerrainVoxels(TERRAIN_RESOLUTION);
+
+    quint64 startTime = usecTimestampNow();
+    {
+        VoxelTree tree(true);
+        createOneAtATime(tree, voxels, true);
+    }
+    quint64 singleTime = usecTimestampNow() - startTime;
+
+    startTime = usecTimestampNow();
+    {
+        VoxelTree tree(true);
+        tree.createVoxels(voxels, true);
+    }
+    quint64 bulkTime = usecTimestampNow() - startTime;
+
+    std::cout << "Bulk build: " << voxels.size() << " voxels one at a time in " << singleTime << " usecs, in bulk in "
+        << bulkTime << " usecs (times include deleting the trees)" << std::endl;
+}
+
+void BulkBuildTests::runAllTests() {
+    bulkMatchesOneAtATime();
+    benchmark();
+}
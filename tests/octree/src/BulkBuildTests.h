@@ -0,0 +1,26 @@
+//
+//  BulkBuildTests.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_BulkBuildTests_h
+#define hifi_BulkBuildTests_h
+
+namespace BulkBuildTests {
+
+    /// Builds the same voxels in bulk and one at a time, and checks that the trees (averages included) are the same.
+    void bulkMatchesOneAtATime();
+
+    /// Compares the time taken to build a terrain in bulk and one voxel at a time.
+    void benchmark();
+
+    void runAllTests();
+}
+
+#endif // hifi_BulkBuildTests_h
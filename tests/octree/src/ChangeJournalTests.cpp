@@ -0,0 +1,156 @@
+//
+//  ChangeJournalTests.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+
+#include <OctreeChangeJournal.h>
+#include <OctreeElementBag.h>
+#include <OctreePacketData.h>
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+#include <VoxelTree.h>
+
+#include "ChangeJournalTests.h"
+#include "TestWorld.h"
+
+const float EDIT_SCALE = 1.0f / 64.0f;
+
+void ChangeJournalTests::editsAreJournaled() {
+    VoxelTree tree;
+    tree.enableChangeJournal();
+    tree.createVoxel(0.0f, 0.0f, 0.0f, EDIT_SCALE, 255, 0, 0);
+
+    OctreeChangeJournal* journal = tree.getChangeJournal();
+    quint64 version = journal->getVersion();
+    OctreeChangeSet changes;
+    if (!journal->getChangesSince(version, changes) || !changes.isEmpty()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: changes reported with nothing changed" << std::endl;
+    }
+
+    tree.createVoxel(0.5f, 0.5f, 0.5f, EDIT_SCALE, 0, 255, 0);
+    if (journal->getVersion() == version) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: edit didn't advance the version" << std::endl;
+    }
+    if (!journal->getChangesSince(version, changes)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: journal didn't reach the last version" << std::endl;
+    }
+    MortonKey editedKey = tree.getVoxelAt(0.5f, 0.5f, 0.5f, EDIT_SCALE)->getMortonKey();
+    MortonKey untouchedKey = tree.getVoxelAt(0.0f, 0.0f, 0.0f, EDIT_SCALE)->getMortonKey();
+    if (!changes.contains(editedKey) || !changes.contains(MortonKey()) ||
+            !changes.contains(editedKey.getAncestor(1))) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: edit or its path missing from the changes" << std::endl;
+    }
+    if (changes.contains(untouchedKey) || changes.contains(untouchedKey.getAncestor(1))) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: untouched voxel in the changes" << std::endl;
+    }
+
+    // another tree's edits are none of the journal's business
+    version = journal->getVersion();
+    VoxelTree otherTree;
+    otherTree.createVoxel(0.0f, 0.0f, 0.0f, EDIT_SCALE, 0, 0, 255);
+    if (journal->getVersion() != version) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: another tree's edit advanced the version" << std::endl;
+    }
+}
+
+void ChangeJournalTests::overflowIsReported() {
+    VoxelTree tree;
+    const int MAX_ENTRIES = 4;
+    tree.enableChangeJournal(MAX_ENTRIES);
+    OctreeChangeJournal* journal = tree.getChangeJournal();
+    quint64 version = journal->getVersion();
+    for (int i = 0; i < MAX_ENTRIES * 2; i++) {
+        tree.createVoxel(i * EDIT_SCALE, 0.0f, 0.0f, EDIT_SCALE, 255, 255, 255);
+    }
+    OctreeChangeSet changes;
+    if (journal->getChangesSince(version, changes)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: overflowed journal claimed every change" << std::endl;
+    }
+    if (!journal->getChangesSince(journal->getVersion(), changes)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: journal lost its latest version" << std::endl;
+    }
+}
+
+/// Encodes everything visible that the params allow, a packet at a time, as the send thread does.
+static int encodeScene(VoxelTree& tree, const ViewFrustum& viewFrustum, const OctreeChangeSet* changes) {
+    OctreeElementBag bag;
+    bag.insert(tree.getRoot());
+    OctreePacketData packetData;
+    int bytes = 0;
+    while (!bag.isEmpty()) {
+        OctreeElement* subTree = bag.extract();
+        EncodeBitstreamParams params(INT_MAX, &viewFrustum, WANT_COLOR, WANT_EXISTS_BITS, DONT_CHOP, false,
+            IGNORE_VIEW_FRUSTUM, NO_OCCLUSION_CULLING, IGNORE_COVERAGE_MAP, NO_BOUNDARY_ADJUST,
+            DEFAULT_OCTREE_SIZE_SCALE, IGNORE_LAST_SENT, changes == IGNORE_CHANGE_SET, IGNORE_SCENE_STATS,
+            IGNORE_JURISDICTION_MAP, changes);
+        bytes += tree.encodeTreeBitstream(subTree, &packetData, bag, params);
+        packetData.reset();
+    }
+    return bytes;
+}
+
+void ChangeJournalTests::incrementalSceneIsSmall() {
+    const int TERRAIN_RESOLUTION = 128;
+    VoxelTree tree;
+    tree.enableChangeJournal();
+    TestWorld::buildTerrain(tree, TERRAIN_RESOLUTION);
+
+    // look down on the world from above its middle, so that all of it is in view
+    ViewFrustum viewFrustum;
+    viewFrustum.setPosition(glm::vec3(0.5f, 2.0f, 0.5f) * (float)TREE_SCALE);
+    viewFrustum.setOrientation(glm::angleAxis(-PI_OVER_TWO, glm::vec3(1.0f, 0.0f, 0.0f)));
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(1.0f);
+    viewFrustum.setNearClip(0.1f);
+    viewFrustum.setFarClip(TREE_SCALE * 4.0f);
+    viewFrustum.calculate();
+
+    OctreeChangeJournal* journal = tree.getChangeJournal();
+    quint64 version = journal->getVersion();
+    OctreeChangeSet changes;
+    journal->getChangesSince(version, changes);
+    quint64 startTime = usecTimestampNow();
+    int idleBytes = encodeScene(tree, viewFrustum, &changes);
+    quint64 idleTime = usecTimestampNow() - startTime;
+    if (idleBytes != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: encoded " << idleBytes << " bytes with nothing changed"
+            << std::endl;
+    }
+
+    float x = 0.25f;
+    float z = 0.75f;
+    float voxelScale = 1.0f / TERRAIN_RESOLUTION;
+    tree.createVoxel(x, TestWorld::terrainHeight(x, z) + voxelScale * 4.0f, z, voxelScale, 255, 0, 255);
+
+    changes.clear();
+    journal->getChangesSince(version, changes);
+    startTime = usecTimestampNow();
+    int incrementalBytes = encodeScene(tree, viewFrustum, &changes);
+    quint64 incrementalTime = usecTimestampNow() - startTime;
+
+    startTime = usecTimestampNow();
+    int fullBytes = encodeScene(tree, viewFrustum, IGNORE_CHANGE_SET);
+    quint64 fullTime = usecTimestampNow() - startTime;
+
+    if (incrementalBytes == 0 || incrementalBytes * 10 > fullBytes) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: one edit encoded " << incrementalBytes << " bytes of "
+            << fullBytes << std::endl;
+    }
+    std::cout << "Change journal: unchanged scene in " << idleTime << " usecs, one edit in " << incrementalBytes
+        << " bytes and " << incrementalTime << " usecs, full scene in " << fullBytes << " bytes and " << fullTime
+        << " usecs" << std::endl;
+}
+
+void ChangeJournalTests::runAllTests() {
+    editsAreJournaled();
+    overflowIsReported();
+    incrementalSceneIsSmall();
+}
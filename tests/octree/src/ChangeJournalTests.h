@@ -0,0 +1,30 @@
+//
+//  ChangeJournalTests.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ChangeJournalTests_h
+#define hifi_ChangeJournalTests_h
+
+namespace ChangeJournalTests {
+
+    /// Checks that an edit is journaled as its own subtree plus the path down to it, and nothing else (and that edits to
+    /// another tree aren't journaled at all).
+    void editsAreJournaled();
+
+    /// Checks that a journal that has dropped changes says so, rather than reporting only those it kept.
+    void overflowIsReported();
+
+    /// Encodes a world after a single edit, against the change set and in full, and reports the difference.
+    void incrementalSceneIsSmall();
+
+    void runAllTests();
+}
+
+#endif // hifi_ChangeJournalTests_h
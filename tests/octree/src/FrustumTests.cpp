@@ -0,0 +1,151 @@
+//
+//  FrustumTests.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+
+#include <QtCore/QVector>
+
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+#include <VoxelTree.h>
+
+#include "FrustumTests.h"
+#include "TestWorld.h"
+
+static ViewFrustum makeViewFrustum(const glm::vec3& position, const glm::quat& orientation, float keyholeRadius) {
+    ViewFrustum viewFrustum;
+    viewFrustum.setPosition(position * (float)TREE_SCALE);
+    viewFrustum.setOrientation(orientation);
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(16.0f / 9.0f);
+    viewFrustum.setNearClip(0.1f);
+    viewFrustum.setFarClip(TREE_SCALE);
+    viewFrustum.setKeyholeRadius(keyholeRadius);
+    viewFrustum.calculate();
+    return viewFrustum;
+}
+
+static bool collectParentsOperation(OctreeElement* element, void* extraData) {
+    if (!element->isLeaf()) {
+        static_cast<QVector<OctreeElement*>*>(extraData)->append(element);
+    }
+    return true;
+}
+
+static QVector<OctreeElement*> collectParents(VoxelTree& tree) {
+    QVector<OctreeElement*> parents;
+    tree.recurseTreeWithOperation(collectParentsOperation, &parents);
+    return parents;
+}
+
+void FrustumTests::batchMatchesSingleTests(VoxelTree& tree) {
+    const float EYE_HEIGHT = 0.01f;
+    const float WIDE_KEYHOLE_RADIUS = TREE_SCALE * 0.05f;
+    glm::vec3 onTheGround(0.5f, TestWorld::terrainHeight(0.5f, 0.95f) + EYE_HEIGHT, 0.95f);
+    glm::quat lookingDown = glm::angleAxis(-PI_OVER_TWO, glm::vec3(1.0f, 0.0f, 0.0f));
+    glm::quat lookingAcross = glm::angleAxis(PI / 3.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+    ViewFrustum viewFrustums[] = {
+        makeViewFrustum(onTheGround, glm::quat(), DEFAULT_KEYHOLE_RADIUS),
+        makeViewFrustum(onTheGround, lookingAcross, WIDE_KEYHOLE_RADIUS),
+        makeViewFrustum(glm::vec3(0.25f, 0.75f, 0.25f), lookingDown, WIDE_KEYHOLE_RADIUS),
+        makeViewFrustum(glm::vec3(-0.5f, 0.3f, 0.5f), glm::angleAxis(-PI_OVER_TWO, glm::vec3(0.0f, 1.0f, 0.0f)), -1.0f)
+    };
+    QVector<OctreeElement*> parents = collectParents(tree);
+    int numLocations[3] = { 0, 0, 0 };
+    int errors = 0;
+    for (size_t v = 0; v < sizeof(viewFrustums) / sizeof(viewFrustums[0]); v++) {
+        const ViewFrustum& viewFrustum = viewFrustums[v];
+        foreach (OctreeElement* parent, parents) {
+            ViewFrustum::ChildLocations locations;
+            parent->childrenInFrustum(viewFrustum, locations);
+            for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+                OctreeElement* child = parent->getChildAtIndex(i);
+                if (!child) {
+                    continue;
+                }
+                ViewFrustum::location location = child->inFrustum(viewFrustum);
+                numLocations[location]++;
+                if (locations.getLocation(i) != location) {
+                    if (errors++ == 0) {
+                        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: view " << v << " child " << i
+                            << " classified as " << locations.getLocation(i) << " but expected " << location
+                            << std::endl;
+                    }
+                }
+                if (locations.distances[i] != child->distanceToCamera(viewFrustum) ||
+                        locations.furthestDistances[i] != child->furthestDistanceToCamera(viewFrustum)) {
+                    if (errors++ == 0) {
+                        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: view " << v << " child " << i
+                            << " distances " << locations.distances[i] << ", " << locations.furthestDistances[i]
+                            << " but expected " << child->distanceToCamera(viewFrustum) << ", "
+                            << child->furthestDistanceToCamera(viewFrustum) << std::endl;
+                    }
+                }
+            }
+        }
+    }
+    if (errors > 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << errors << " mismatches in all" << std::endl;
+    }
+    if (numLocations[ViewFrustum::OUTSIDE] == 0 || numLocations[ViewFrustum::INTERSECT] == 0 ||
+            numLocations[ViewFrustum::INSIDE] == 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: views didn't cover every location" << std::endl;
+    }
+}
+
+void FrustumTests::benchmark(VoxelTree& tree) {
+    const float EYE_HEIGHT = 0.01f;
+    ViewFrustum viewFrustum = makeViewFrustum(glm::vec3(0.5f, TestWorld::terrainHeight(0.5f, 0.95f) + EYE_HEIGHT,
+        0.95f), glm::quat(), DEFAULT_KEYHOLE_RADIUS);
+    QVector<OctreeElement*> parents = collectParents(tree);
+
+    // sum the results so that the work can't be skipped
+    const int NUM_ROUNDS = 10;
+    float singleSum = 0.0f;
+    quint64 startTime = usecTimestampNow();
+    for (int round = 0; round < NUM_ROUNDS; round++) {
+        foreach (OctreeElement* parent, parents) {
+            for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+                OctreeElement* child = parent->getChildAtIndex(i);
+                if (child) {
+                    singleSum += child->inFrustum(viewFrustum) + child->distanceToCamera(viewFrustum) +
+                        child->furthestDistanceToCamera(viewFrustum);
+                }
+            }
+        }
+    }
+    quint64 singleTime = usecTimestampNow() - startTime;
+
+    float batchSum = 0.0f;
+    startTime = usecTimestampNow();
+    for (int round = 0; round < NUM_ROUNDS; round++) {
+        foreach (OctreeElement* parent, parents) {
+            ViewFrustum::ChildLocations locations;
+            parent->childrenInFrustum(viewFrustum, locations);
+            for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+                if (parent->getChildAtIndex(i)) {
+                    batchSum += locations.getLocation(i) + locations.distances[i] + locations.furthestDistances[i];
+                }
+            }
+        }
+    }
+    quint64 batchTime = usecTimestampNow() - startTime;
+
+    int numParents = parents.size() * NUM_ROUNDS;
+    std::cout << "Classifying children: " << (float)singleTime / numParents << " usecs per element one at a time, "
+        << (float)batchTime / numParents << " usecs all at once"
+        << (singleSum == batchSum ? "" : " (with different results!)") << std::endl;
+}
+
+void FrustumTests::runAllTests(VoxelTree& tree) {
+    batchMatchesSingleTests(tree);
+    benchmark(tree);
+}
@@ -0,0 +1,29 @@
+//
+//  FrustumTests.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_FrustumTests_h
+#define hifi_FrustumTests_h
+
+class VoxelTree;
+
+namespace FrustumTests {
+
+    /// Checks that classifying children together gives exactly what testing each child alone gives, from views
+    /// inside, above, and beside the world, with and without a keyhole reaching into it.
+    void batchMatchesSingleTests(VoxelTree& tree);
+
+    /// Times classifying every element's children one at a time against doing them all at once.
+    void benchmark(VoxelTree& tree);
+
+    void runAllTests(VoxelTree& tree);
+}
+
+#endif // hifi_FrustumTests_h
@@ -0,0 +1,154 @@
+//
+//  JurisdictionTests.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <JurisdictionIndex.h>
+#include <JurisdictionMap.h>
+#include <OctalCode.h>
+#include <OctreeConstants.h>
+#include <SharedUtil.h>
+
+#include "JurisdictionTests.h"
+
+const int NUM_END_NODES_PER_SERVER = 40;
+
+static MortonKey randomKey(int level) {
+    MortonKey key;
+    for (int i = 0; i < level; i++) {
+        key = key.getChild(rand() % NUMBER_OF_CHILDREN);
+    }
+    return key;
+}
+
+/// One server for each octant, each with end nodes two levels down, and one more under the first end node.
+static void createServers(std::vector<JurisdictionMap*>& servers) {
+    srand(5);
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        MortonKey rootKey = MortonKey().getChild(i);
+        std::vector<unsigned char*> endNodes;
+        for (int j = 0; j < NUM_END_NODES_PER_SERVER; j++) {
+            MortonKey endNodeKey = rootKey.getChild(rand() % NUMBER_OF_CHILDREN).getChild(rand() % NUMBER_OF_CHILDREN);
+            endNodes.push_back(endNodeKey.createOctalCode());
+        }
+        servers.push_back(new JurisdictionMap(rootKey.createOctalCode(), endNodes));
+    }
+    MortonKey nestedRootKey(servers.at(0)->getEndNodeOctalCode(0));
+    servers.push_back(new JurisdictionMap(nestedRootKey.createOctalCode(), std::vector<unsigned char*>()));
+}
+
+static void deleteServers(std::vector<JurisdictionMap*>& servers) {
+    for (size_t i = 0; i < servers.size(); i++) {
+        delete servers.at(i);
+    }
+    servers.clear();
+}
+
+/// The check as it was before the maps had keys.
+static bool isWithinByScan(const JurisdictionMap& map, const unsigned char* octalCode) {
+    if (isAncestorOf(octalCode, map.getRootOctalCode()) || !isAncestorOf(map.getRootOctalCode(), octalCode)) {
+        return false;
+    }
+    for (int i = 0; i < map.getEndNodeCount(); i++) {
+        if (isAncestorOf(map.getEndNodeOctalCode(i), octalCode)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void JurisdictionTests::indexMatchesLinearScan() {
+    std::vector<JurisdictionMap*> servers;
+    createServers(servers);
+    JurisdictionIndex index;
+    for (size_t i = 0; i < servers.size(); i++) {
+        index.add(i, servers.at(i)->getRootKey(), servers.at(i)->getEndNodeKeys());
+    }
+
+    const int NUM_CODES = 100000;
+    const int MAX_CODE_LEVEL = 8;
+    for (int i = 0; i < NUM_CODES; i++) {
+        MortonKey key = randomKey(i % (MAX_CODE_LEVEL + 1));
+        unsigned char* octalCode = key.createOctalCode();
+        JurisdictionOwners owners;
+        index.findOwners(key, owners);
+        for (size_t j = 0; j < servers.size(); j++) {
+            bool isWithin = isWithinByScan(*servers.at(j), octalCode);
+            if (isWithin != (servers.at(j)->isMyJurisdiction(octalCode, CHECK_NODE_ONLY) == JurisdictionMap::WITHIN)) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: map disagrees with scan for server " << j
+                    << " at level " << key.getLevel() << std::endl;
+            }
+            if (isWithin != (qFind(owners.constBegin(), owners.constEnd(), (int)j) != owners.constEnd())) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: index disagrees with scan for server " << j
+                    << " at level " << key.getLevel() << std::endl;
+            }
+        }
+        delete[] octalCode;
+    }
+    deleteServers(servers);
+}
+
+void JurisdictionTests::benchmark() {
+    std::vector<JurisdictionMap*> servers;
+    createServers(servers);
+    JurisdictionIndex index;
+    for (size_t i = 0; i < servers.size(); i++) {
+        index.add(i, servers.at(i)->getRootKey(), servers.at(i)->getEndNodeKeys());
+    }
+
+    // edits come in at about the voxel sizes people paint with
+    const int NUM_CODES = 10000;
+    const int CODE_LEVEL = 10;
+    std::vector<unsigned char*> octalCodes;
+    std::vector<MortonKey> keys;
+    for (int i = 0; i < NUM_CODES; i++) {
+        keys.push_back(randomKey(CODE_LEVEL));
+        octalCodes.push_back(keys.back().createOctalCode());
+    }
+
+    int scanRouted = 0;
+    quint64 startTime = usecTimestampNow();
+    for (int i = 0; i < NUM_CODES; i++) {
+        for (size_t j = 0; j < servers.size(); j++) {
+            scanRouted += isWithinByScan(*servers.at(j), octalCodes.at(i)) ? 1 : 0;
+        }
+    }
+    quint64 scanTime = usecTimestampNow() - startTime;
+
+    int indexRouted = 0;
+    startTime = usecTimestampNow();
+    for (int i = 0; i < NUM_CODES; i++) {
+        JurisdictionOwners owners;
+        index.findOwners(MortonKey(octalCodes.at(i)), owners);
+        indexRouted += owners.size();
+    }
+    quint64 indexTime = usecTimestampNow() - startTime;
+
+    if (scanRouted != indexRouted) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: routed " << indexRouted << " edits but expected "
+            << scanRouted << std::endl;
+    }
+    std::cout << "Routing edits among " << servers.size() << " servers with "
+        << NUM_END_NODES_PER_SERVER * NUMBER_OF_CHILDREN << " end nodes: scan " << (float)scanTime / NUM_CODES
+        << " usecs, index " << (float)indexTime / NUM_CODES << " usecs per edit" << std::endl;
+
+    for (int i = 0; i < NUM_CODES; i++) {
+        delete[] octalCodes.at(i);
+    }
+    deleteServers(servers);
+}
+
+void JurisdictionTests::runAllTests() {
+    indexMatchesLinearScan();
+    benchmark();
+}
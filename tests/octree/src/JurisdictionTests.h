@@ -0,0 +1,25 @@
+//
+//  JurisdictionTests.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_JurisdictionTests_h
+#define hifi_JurisdictionTests_h
+
+namespace JurisdictionTests {
+
+    /// Splits the tree among servers with a few hundred end nodes between them, and checks the index of all their
+    /// jurisdictions against a scan of each one's end nodes.
+    void indexMatchesLinearScan();
+    void benchmark();
+
+    void runAllTests();
+}
+
+#endif // hifi_JurisdictionTests_h
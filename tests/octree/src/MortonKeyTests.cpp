@@ -0,0 +1,160 @@
+//
+//  MortonKeyTests.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <JurisdictionMap.h>
+#include <MortonKey.h>
+#include <OctalCode.h>
+#include <OctreeConstants.h>
+#include <SharedUtil.h>
+
+#include "MortonKeyTests.h"
+
+void MortonKeyTests::keysMatchOctalCodes() {
+    srand(3);
+    const int NUM_CODES = 10000;
+    for (int i = 0; i < NUM_CODES; i++) {
+        int length = i % (MAX_MORTON_KEY_LEVELS + 1);
+        unsigned char* code = new unsigned char[1];
+        *code = 0;
+        MortonKey key;
+        for (int level = 0; level < length; level++) {
+            int childIndex = rand() % NUMBER_OF_CHILDREN;
+            unsigned char* childCode = childOctalCode(code, childIndex);
+            delete[] code;
+            code = childCode;
+            key = key.getChild(childIndex);
+        }
+        if (MortonKey(code) != key || key.getLevel() != length) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: key for code of length " << length
+                << " disagrees with the one built by getChild" << std::endl;
+        }
+
+        unsigned char* keyCode = key.createOctalCode();
+        if (memcmp(keyCode, code, bytesRequiredForCodeLength(length)) != 0) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: code of length " << length << " did not round trip"
+                << std::endl;
+        }
+        delete[] keyCode;
+
+        VoxelPositionSize details;
+        voxelDetailsForCode(code, details);
+        glm::vec3 corner = key.getCorner();
+        if (corner.x != details.x || corner.y != details.y || corner.z != details.z || key.getScale() != details.s) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: corner or scale of code of length " << length
+                << " disagrees with voxelDetailsForCode" << std::endl;
+        }
+
+        for (int level = 0; level < length; level++) {
+            MortonKey ancestor = key.getAncestor(level);
+            if (!ancestor.isAncestorOf(key) || key.isAncestorOf(ancestor)
+                    || ancestor.getBranchIndexToward(key) != key.getAncestor(level + 1).getChildIndex()) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: ancestry of code of length " << length
+                    << " is wrong at level " << level << std::endl;
+            }
+        }
+        delete[] code;
+    }
+}
+
+void MortonKeyTests::tooDeepCodesAreInvalid() {
+    unsigned char* code = new unsigned char[1];
+    *code = 0;
+    for (int level = 0; level <= MAX_MORTON_KEY_LEVELS; level++) {
+        unsigned char* childCode = childOctalCode(code, level % NUMBER_OF_CHILDREN);
+        delete[] code;
+        code = childCode;
+    }
+    if (MortonKey(code).isValid()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: code deeper than a key holds gave a valid key"
+            << std::endl;
+    }
+    delete[] code;
+}
+
+static bool keyPrecedes(const MortonKey& first, const MortonKey& second) {
+    return first.precedes(second);
+}
+
+static void appendDepthFirst(const MortonKey& key, int levels, std::vector<MortonKey>& keys) {
+    keys.push_back(key);
+    if (levels > 0) {
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            appendDepthFirst(key.getChild(i), levels - 1, keys);
+        }
+    }
+}
+
+void MortonKeyTests::voxelKeysAndOrder() {
+    srand(5);
+    const int NUM_POINTS = 10000;
+    for (int i = 0; i < NUM_POINTS; i++) {
+        float x = randFloat();
+        float y = randFloat();
+        float z = (i % 7 == 0) ? 1.0f : randFloat(); // include the far edge, which belongs to the last voxel
+        float s = (1.0f + (i % 3) * 0.3f) / (1 << (i % (MAX_MORTON_KEY_LEVELS + 1)));
+        unsigned char* code = pointToVoxel(x, y, z, s);
+        if (MortonKey::forVoxel(x, y, z, s) != MortonKey(code)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: key for voxel of size " << s
+                << " disagrees with pointToVoxel" << std::endl;
+        }
+        delete[] code;
+    }
+
+    std::vector<MortonKey> depthFirst;
+    const int ORDER_LEVELS = 3;
+    appendDepthFirst(MortonKey(), ORDER_LEVELS, depthFirst);
+    std::vector<MortonKey> sorted = depthFirst;
+    std::random_shuffle(sorted.begin(), sorted.end());
+    std::sort(sorted.begin(), sorted.end(), keyPrecedes);
+    if (sorted != depthFirst) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: keys didn't sort depth first" << std::endl;
+    }
+}
+
+void MortonKeyTests::jurisdictionAreas() {
+    // a server with the first octant, less the first octant of that
+    MortonKey rootKey = MortonKey().getChild(0);
+    std::vector<unsigned char*> endNodes;
+    endNodes.push_back(rootKey.getChild(0).createOctalCode());
+    JurisdictionMap map(rootKey.createOctalCode(), endNodes);
+
+    unsigned char* treeRoot = MortonKey().createOctalCode();
+    unsigned char* within = rootKey.getChild(1).getChild(5).createOctalCode();
+    unsigned char* underEndNode = rootKey.getChild(0).getChild(5).createOctalCode();
+    unsigned char* elsewhere = MortonKey().getChild(3).createOctalCode();
+    if (map.isMyJurisdiction(treeRoot, CHECK_NODE_ONLY) != JurisdictionMap::ABOVE
+            || map.isMyJurisdiction(within, CHECK_NODE_ONLY) != JurisdictionMap::WITHIN
+            || map.isMyJurisdiction(underEndNode, CHECK_NODE_ONLY) != JurisdictionMap::BELOW
+            || map.isMyJurisdiction(elsewhere, CHECK_NODE_ONLY) != JurisdictionMap::BELOW) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: wrong jurisdiction for a node" << std::endl;
+    }
+    if (map.isMyJurisdiction(treeRoot, 0) != JurisdictionMap::ABOVE
+            || map.isMyJurisdiction(elsewhere, 0) != JurisdictionMap::BELOW) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: wrong jurisdiction for a child" << std::endl;
+    }
+    delete[] treeRoot;
+    delete[] within;
+    delete[] underEndNode;
+    delete[] elsewhere;
+}
+
+void MortonKeyTests::runAllTests() {
+    keysMatchOctalCodes();
+    tooDeepCodesAreInvalid();
+    voxelKeysAndOrder();
+    jurisdictionAreas();
+}
@@ -0,0 +1,28 @@
+//
+//  MortonKeyTests.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_MortonKeyTests_h
+#define hifi_MortonKeyTests_h
+
+namespace MortonKeyTests {
+
+    /// Builds random codes of every depth a key holds, and checks the keys against the octal code functions.
+    void keysMatchOctalCodes();
+    void tooDeepCodesAreInvalid();
+
+    /// Checks the keys for points against pointToVoxel, and the depth-first order against a walk of the tree.
+    void voxelKeysAndOrder();
+    void jurisdictionAreas();
+
+    void runAllTests();
+}
+
+#endif // hifi_MortonKeyTests_h
@@ -0,0 +1,103 @@
+//
+//  OcclusionTests.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+
+#include <CoverageMapV3.h>
+#include <OctreeElementBag.h>
+#include <OctreePacketData.h>
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+#include <VoxelTree.h>
+
+#include "OcclusionTests.h"
+#include "TestWorld.h"
+
+static OctreeProjectedPolygon boxPolygon(float x, float y, float size, float distance) {
+    OctreeProjectedPolygon polygon(BoundingBox(glm::vec2(x, y), glm::vec2(size, size)));
+    polygon.setDistance(distance);
+    polygon.setAnyInView(true);
+    polygon.setAllInView(true);
+    return polygon;
+}
+
+void OcclusionTests::nearerPolygonsOcclude() {
+    CoverageMapV3 map;
+    if (map.checkMap(boxPolygon(-0.5f, -0.5f, 1.0f, 1.0f)) != V2_STORED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: polygon in an empty map was not stored" << std::endl;
+    }
+    const bool DONT_STORE = false;
+    if (map.checkMap(boxPolygon(-0.25f, -0.25f, 0.25f, 2.0f), DONT_STORE) != V2_OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: polygon behind a larger one was not occluded" << std::endl;
+    }
+    if (map.checkMap(boxPolygon(-0.25f, -0.25f, 0.25f, 0.5f), DONT_STORE) == V2_OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: polygon in front of a larger one was occluded"
+            << std::endl;
+    }
+    if (map.checkMap(boxPolygon(0.4f, 0.4f, 0.3f, 2.0f), DONT_STORE) == V2_OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: polygon sticking out from behind another was occluded"
+            << std::endl;
+    }
+    map.erase();
+    if (map.checkMap(boxPolygon(-0.25f, -0.25f, 0.25f, 2.0f), DONT_STORE) == V2_OCCLUDED) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: polygon occluded in an erased map" << std::endl;
+    }
+}
+
+/// Encodes the whole scene visible from the view, a packet at a time, as the send thread does.
+static int encodeScene(VoxelTree& tree, const ViewFrustum& viewFrustum, CoverageMapV3* map) {
+    OctreeElementBag bag;
+    bag.insert(tree.getRoot());
+    OctreePacketData packetData;
+    int bytes = 0;
+    while (!bag.isEmpty()) {
+        OctreeElement* subTree = bag.extract();
+        EncodeBitstreamParams params(INT_MAX, &viewFrustum, WANT_COLOR, WANT_EXISTS_BITS, DONT_CHOP, false,
+            IGNORE_VIEW_FRUSTUM, map ? WANT_OCCLUSION_CULLING : NO_OCCLUSION_CULLING, map);
+        bytes += tree.encodeTreeBitstream(subTree, &packetData, bag, params);
+        packetData.reset();
+    }
+    return bytes;
+}
+
+void OcclusionTests::benchmark(VoxelTree& tree) {
+    // stand just above the terrain near one edge, looking across it, so that the nearer hills hide the further ones
+    const float EYE_HEIGHT = 0.01f;
+    glm::vec3 position(0.5f, TestWorld::terrainHeight(0.5f, 0.95f) + EYE_HEIGHT, 0.95f);
+    ViewFrustum viewFrustum;
+    viewFrustum.setPosition(position * (float)TREE_SCALE);
+    viewFrustum.setOrientation(glm::quat());
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(16.0f / 9.0f);
+    viewFrustum.setNearClip(0.1f);
+    viewFrustum.setFarClip(TREE_SCALE);
+    viewFrustum.calculate();
+
+    quint64 startTime = usecTimestampNow();
+    int plainBytes = encodeScene(tree, viewFrustum, NULL);
+    quint64 plainTime = usecTimestampNow() - startTime;
+
+    CoverageMapV3 map;
+    startTime = usecTimestampNow();
+    int culledBytes = encodeScene(tree, viewFrustum, &map);
+    quint64 culledTime = usecTimestampNow() - startTime;
+
+    int bytesSaved = plainBytes - culledBytes;
+    float usecsSpent = (float)culledTime - (float)plainTime;
+    std::cout << "Occlusion culling: " << plainBytes << " bytes in " << plainTime << " usecs without, " << culledBytes
+        << " bytes in " << culledTime << " usecs with (" << map.getOccludedCount() << " occluded); "
+        << (bytesSaved > 0 ? usecsSpent / bytesSaved : 0.0f) << " usecs spent per byte saved" << std::endl;
+}
+
+void OcclusionTests::runAllTests(VoxelTree& tree) {
+    nearerPolygonsOcclude();
+    benchmark(tree);
+}
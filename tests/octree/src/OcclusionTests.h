@@ -0,0 +1,28 @@
+//
+//  OcclusionTests.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OcclusionTests_h
+#define hifi_OcclusionTests_h
+
+class VoxelTree;
+
+namespace OcclusionTests {
+
+    void nearerPolygonsOcclude();
+
+    /// Encodes the world as a server would for somebody standing in it, with occlusion culling and without, and
+    /// reports the bytes culling saves against the time it costs.
+    void benchmark(VoxelTree& tree);
+
+    void runAllTests(VoxelTree& tree);
+}
+
+#endif // hifi_OcclusionTests_h
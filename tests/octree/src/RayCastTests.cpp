@@ -0,0 +1,161 @@
+//
+//  RayCastTests.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstdlib>
+#include <iostream>
+#include <math.h>
+
+#include <QtCore/QVector>
+
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "RayCastTests.h"
+
+/// The arguments of the exhaustive search, which is how Octree::findRayIntersection used to work.
+class ExhaustiveRayArgs {
+public:
+    glm::vec3 origin;
+    glm::vec3 direction;
+    OctreeElement* element;
+    float distance;
+    bool found;
+};
+
+static bool exhaustiveRayIntersectionOp(OctreeElement* element, void* extraData) {
+    ExhaustiveRayArgs* args = static_cast<ExhaustiveRayArgs*>(extraData);
+    AABox box = element->getAABox();
+    float distance;
+    BoxFace face;
+    if (!box.findRayIntersection(args->origin, args->direction, distance, face)) {
+        return false;
+    }
+    if (!element->isLeaf()) {
+        return true;
+    }
+    distance *= TREE_SCALE;
+    if (element->hasContent() && (!args->found || distance < args->distance)) {
+        args->element = element;
+        args->distance = distance;
+        args->found = true;
+    }
+    return false;
+}
+
+static bool findRayIntersectionExhaustively(VoxelTree& tree, const glm::vec3& origin, const glm::vec3& direction,
+                                            float& distance) {
+    ExhaustiveRayArgs args = { origin / (float)TREE_SCALE, direction, NULL, 0.0f, false };
+    tree.recurseTreeWithOperation(exhaustiveRayIntersectionOp, &args);
+    distance = args.distance;
+    return args.found;
+}
+
+/// Rays from above the terrain looking down at it, along with a share of rays that graze across it.
+static QVector<OctreeRayCast> createTestRays(int numRays) {
+    srand(2);
+    QVector<OctreeRayCast> rays;
+    for (int i = 0; i < numRays; i++) {
+        glm::vec3 origin(randFloat(), randFloatInRange(0.4f, 0.9f), randFloat());
+        glm::vec3 direction(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, -0.2f),
+            randFloatInRange(-1.0f, 1.0f));
+        const int GRAZING_RAY_ODDS = 4;
+        if (i % GRAZING_RAY_ODDS == 0) {
+            origin.y = randFloatInRange(0.2f, 0.3f);
+            direction.y = randFloatInRange(-0.05f, 0.05f);
+        }
+        rays.append(OctreeRayCast(origin * (float)TREE_SCALE, glm::normalize(direction)));
+    }
+    return rays;
+}
+
+void RayCastTests::nearestHitMatchesExhaustiveSearch(VoxelTree& tree) {
+    const int NUM_RAYS = 1000;
+    QVector<OctreeRayCast> rays = createTestRays(NUM_RAYS);
+    int numMismatches = 0;
+    for (int i = 0; i < rays.size(); i++) {
+        float expectedDistance;
+        bool expectedFound = findRayIntersectionExhaustively(tree, rays[i].origin, rays[i].direction, expectedDistance);
+
+        OctreeElement* element;
+        float distance;
+        BoxFace face;
+        bool found = tree.findRayIntersection(rays[i].origin, rays[i].direction, element, distance, face, Octree::Lock);
+
+        // neighbours share faces, so only the distance (not the element) is sure to agree
+        const float DISTANCE_EPSILON = 0.0001f * TREE_SCALE;
+        if (found != expectedFound || (found && fabsf(distance - expectedDistance) > DISTANCE_EPSILON)) {
+            numMismatches++;
+        }
+    }
+    if (numMismatches > 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << numMismatches << " of " << NUM_RAYS
+            << " rays disagreed with the exhaustive search" << std::endl;
+    }
+}
+
+void RayCastTests::batchMatchesSingleRays(VoxelTree& tree) {
+    const int NUM_RAYS = 1000;
+    QVector<OctreeRayCast> rays = createTestRays(NUM_RAYS);
+    int numIntersecting = tree.findRayIntersections(rays);
+    int expectedIntersecting = 0;
+    for (int i = 0; i < rays.size(); i++) {
+        OctreeElement* element;
+        float distance;
+        BoxFace face;
+        bool found = tree.findRayIntersection(rays[i].origin, rays[i].direction, element, distance, face, Octree::Lock);
+        if (found) {
+            expectedIntersecting++;
+        }
+        if (found != rays[i].intersects || (found && (element != rays[i].element || distance != rays[i].distance
+                || face != rays[i].face))) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: batch ray " << i << " disagreed" << std::endl;
+        }
+    }
+    if (numIntersecting != expectedIntersecting) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: batch found " << numIntersecting
+            << " intersections but we expected " << expectedIntersecting << std::endl;
+    }
+}
+
+void RayCastTests::benchmark(VoxelTree& tree) {
+    const int NUM_RAYS = 10000;
+    QVector<OctreeRayCast> rays = createTestRays(NUM_RAYS);
+
+    quint64 startTime = usecTimestampNow();
+    for (int i = 0; i < rays.size(); i++) {
+        float distance;
+        findRayIntersectionExhaustively(tree, rays[i].origin, rays[i].direction, distance);
+    }
+    quint64 exhaustiveTime = usecTimestampNow() - startTime;
+
+    startTime = usecTimestampNow();
+    for (int i = 0; i < rays.size(); i++) {
+        OctreeElement* element;
+        float distance;
+        BoxFace face;
+        tree.findRayIntersection(rays[i].origin, rays[i].direction, element, distance, face, Octree::Lock);
+    }
+    quint64 frontToBackTime = usecTimestampNow() - startTime;
+
+    startTime = usecTimestampNow();
+    tree.findRayIntersections(rays);
+    quint64 batchTime = usecTimestampNow() - startTime;
+
+    std::cout << "Ray casts: exhaustive " << (float)exhaustiveTime / NUM_RAYS << " usecs, front to back "
+        << (float)frontToBackTime / NUM_RAYS << " usecs, batched " << (float)batchTime / NUM_RAYS
+        << " usecs per ray" << std::endl;
+}
+
+void RayCastTests::runAllTests(VoxelTree& tree) {
+    nearestHitMatchesExhaustiveSearch(tree);
+    batchMatchesSingleRays(tree);
+    benchmark(tree);
+}
@@ -0,0 +1,30 @@
+//
+//  RayCastTests.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_RayCastTests_h
+#define hifi_RayCastTests_h
+
+class VoxelTree;
+
+namespace RayCastTests {
+
+    /// Checks the front to back traversal against a search of every leaf the ray passes through.
+    void nearestHitMatchesExhaustiveSearch(VoxelTree& tree);
+    void batchMatchesSingleRays(VoxelTree& tree);
+
+    /// Times casting rays from above and grazing rays across the terrain with the exhaustive search, the front to back
+    /// traversal, and the batch API, and prints the cost per ray of each.
+    void benchmark(VoxelTree& tree);
+
+    void runAllTests(VoxelTree& tree);
+}
+
+#endif // hifi_RayCastTests_h
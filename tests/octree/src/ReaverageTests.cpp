@@ -0,0 +1,122 @@
+//
+//  ReaverageTests.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+#include <math.h>
+
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "ReaverageTests.h"
+#include "TestWorld.h"
+
+/// Recolors, adds, and deletes voxels here and there, the same ones every time.
+static void editTerrain(VoxelTree& tree, int resolution, int edits) {
+    srand(3);
+    float scale = 1.0f / resolution;
+    for (int i = 0; i < edits; i++) {
+        float x = randIntInRange(0, resolution - 1) * scale;
+        float z = randIntInRange(0, resolution - 1) * scale;
+        float y = floorf(TestWorld::terrainHeight(x, z) * resolution) * scale;
+        switch (i % 3) {
+            case 0:
+                tree.createVoxel(x, y, z, scale, randomColorValue(64), randomColorValue(64), randomColorValue(64),
+                    true);
+                break;
+            case 1:
+                tree.createVoxel(x, y + scale, z, scale, 255, 0, 0);
+                break;
+            case 2:
+                tree.deleteVoxelAt(x, y, z, scale);
+                break;
+        }
+    }
+}
+
+static bool hasStaleElements(OctreeElement* element) {
+    if (element->isAverageStale()) {
+        return true;
+    }
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        OctreeElement* child = element->getChildAtIndex(i);
+        if (child && hasStaleElements(child)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReaverageTests::changedPathsMatchEager() {
+    const int TERRAIN_RESOLUTION = 64;
+    const int EDITS = 300;
+
+    VoxelTree eagerTree(true);
+    VoxelTree deferringTree(true);
+    deferringTree.setDefersReaveraging(true);
+    VoxelTree plainTree;
+
+    VoxelTree* trees[] = { &eagerTree, &deferringTree, &plainTree };
+    for (int i = 0; i < 3; i++) {
+        TestWorld::buildTerrain(*trees[i], TERRAIN_RESOLUTION);
+    }
+    // the deferring tree is brought up to date between bursts, as the server does after each packet
+    deferringTree.reaverageChangedElements();
+    for (int i = 0; i < 3; i++) {
+        editTerrain(*trees[i], TERRAIN_RESOLUTION, EDITS);
+    }
+    if (hasStaleElements(eagerTree.getRoot()) || !deferringTree.getRoot()->isAverageStale() ||
+            !plainTree.getRoot()->isAverageStale()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: changed paths weren't marked as expected" << std::endl;
+    }
+    for (int i = 1; i < 3; i++) {
+        trees[i]->reaverageChangedElements();
+        if (hasStaleElements(trees[i]->getRoot())) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: stale elements left after reaveraging" << std::endl;
+        }
+        if (!TestWorld::subtreesMatch(eagerTree.getRoot(), trees[i]->getRoot())) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: reaveraged tree " << i
+                << " differs from the one reaveraged as it went" << std::endl;
+        }
+    }
+}
+
+void ReaverageTests::benchmark() {
+    const int TERRAIN_RESOLUTION = 256;
+    const int EDITS = 3000;
+
+    VoxelTree eagerTree(true);
+    TestWorld::buildTerrain(eagerTree, TERRAIN_RESOLUTION);
+    quint64 startTime = usecTimestampNow();
+    editTerrain(eagerTree, TERRAIN_RESOLUTION, EDITS);
+    quint64 eagerTime = usecTimestampNow() - startTime;
+
+    VoxelTree deferringTree(true);
+    TestWorld::buildTerrain(deferringTree, TERRAIN_RESOLUTION);
+    deferringTree.setDefersReaveraging(true);
+    deferringTree.reaverageChangedElements();
+    startTime = usecTimestampNow();
+    editTerrain(deferringTree, TERRAIN_RESOLUTION, EDITS);
+    deferringTree.reaverageChangedElements();
+    quint64 deferredTime = usecTimestampNow() - startTime;
+
+    startTime = usecTimestampNow();
+    deferringTree.reaverageOctreeElements();
+    quint64 wholeTreeTime = usecTimestampNow() - startTime;
+
+    std::cout << "Reaveraging: " << EDITS << " edits reaveraging as they go in " << eagerTime
+        << " usecs, reaveraging their paths at the end in " << deferredTime
+        << " usecs; reaveraging the whole tree takes " << wholeTreeTime << " usecs" << std::endl;
+}
+
+void ReaverageTests::runAllTests() {
+    changedPathsMatchEager();
+    benchmark();
+}
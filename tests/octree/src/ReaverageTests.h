@@ -0,0 +1,28 @@
+//
+//  ReaverageTests.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ReaverageTests_h
+#define hifi_ReaverageTests_h
+
+namespace ReaverageTests {
+
+    /// Edits trees that reaverage as they go, defer it, and don't reaverage at all, and checks that reaveraging the
+    /// changed paths of the last two gives the averages of the first.
+    void changedPathsMatchEager();
+
+    /// Compares the time taken by a burst of edits when each reaverages its path and when the paths are reaveraged
+    /// once at the end.
+    void benchmark();
+
+    void runAllTests();
+}
+
+#endif // hifi_ReaverageTests_h
@@ -0,0 +1,301 @@
+//
+//  SchematicTests.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <zlib.h>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+
+#include <SharedUtil.h>
+#include <Tags.h>
+#include <VoxelTree.h>
+
+#include "SchematicTests.h"
+
+const int SCHEMATIC_WIDTH = 5;
+const int SCHEMATIC_HEIGHT = 4;
+const int SCHEMATIC_LENGTH = 6;
+const int SCHEMATIC_BLOCKS = SCHEMATIC_WIDTH * SCHEMATIC_HEIGHT * SCHEMATIC_LENGTH;
+
+/// Fills the block arrays from a mix of air, plain blocks, wool, slabs, stairs, and ids of 128 and above (stairs among
+/// them), with data of every value.
+static void makeBlocks(QByteArray& ids, QByteArray& data) {
+    const unsigned char BLOCK_IDS[] = { 0, 1, 2, 35, 44, 53, 128, 129, 133, 152, 155, 159, 170, 172, 173, 200, 255 };
+    const int BLOCK_ID_COUNT = sizeof(BLOCK_IDS) / sizeof(BLOCK_IDS[0]);
+    srand(11);
+    ids.resize(SCHEMATIC_BLOCKS);
+    data.resize(SCHEMATIC_BLOCKS);
+    for (int i = 0; i < SCHEMATIC_BLOCKS; i++) {
+        ids[i] = BLOCK_IDS[randIntInRange(0, BLOCK_ID_COUNT - 1)];
+        data[i] = randIntInRange(0, 15);
+    }
+}
+
+static void writeName(QDataStream& out, const char* name) {
+    out << (quint16)strlen(name);
+    out.writeRawData(name, strlen(name));
+}
+
+static void writeTagHeader(QDataStream& out, int tagId, const char* name) {
+    out << (quint8)tagId;
+    writeName(out, name);
+}
+
+static void writeByteArray(QDataStream& out, const char* name, const QByteArray& bytes) {
+    writeTagHeader(out, TAG_Byte_Array, name);
+    out << (qint32)bytes.size();
+    out.writeRawData(bytes.constData(), bytes.size());
+}
+
+/// Returns the NBT of a schematic holding the blocks, with tags of most types (lists and compounds among them) ahead of
+/// the dimensions and the block arrays, and another after them, as the editors that write schematics arrange them.
+static QByteArray makeSchematic(const QByteArray& ids, const QByteArray& data) {
+    QByteArray schematic;
+    QDataStream out(&schematic, QIODevice::WriteOnly);
+    writeTagHeader(out, TAG_Compound, "Schematic");
+
+    writeTagHeader(out, TAG_String, "Materials");
+    writeName(out, "Alpha");
+
+    const int ENTITY_COUNT = 2;
+    writeTagHeader(out, TAG_List, "Entities");
+    out << (quint8)TAG_Compound << (qint32)ENTITY_COUNT;
+    for (int i = 0; i < ENTITY_COUNT; i++) {
+        writeTagHeader(out, TAG_String, "id");
+        writeName(out, "Sheep");
+        const int POSITION_COORDINATES = 3;
+        writeTagHeader(out, TAG_List, "Pos");
+        out << (quint8)TAG_Double << (qint32)POSITION_COORDINATES;
+        for (int j = 0; j < POSITION_COORDINATES; j++) {
+            out << (qint64)(i + j);
+        }
+        writeTagHeader(out, TAG_Byte, "Color");
+        out << (quint8)i;
+        out << (quint8)TAG_End;
+    }
+
+    writeTagHeader(out, TAG_Compound, "Metadata");
+    writeTagHeader(out, TAG_Long, "WorldTime");
+    out << (qint64)123456789;
+    writeTagHeader(out, TAG_Float, "Scale");
+    out << (qint32)0x3F800000;
+    writeTagHeader(out, TAG_Int, "Version");
+    out << (qint32)2;
+    out << (quint8)TAG_End;
+
+    writeTagHeader(out, TAG_Short, "Height");
+    out << (qint16)SCHEMATIC_HEIGHT;
+    writeTagHeader(out, TAG_Short, "Length");
+    out << (qint16)SCHEMATIC_LENGTH;
+    writeTagHeader(out, TAG_Short, "Width");
+    out << (qint16)SCHEMATIC_WIDTH;
+    writeByteArray(out, "Blocks", ids);
+    writeByteArray(out, "Data", data);
+
+    writeTagHeader(out, TAG_List, "TileEntities");
+    out << (quint8)TAG_Compound << (qint32)0;
+
+    out << (quint8)TAG_End;
+    return schematic;
+}
+
+/// Writes the schematic to a temporary file, gzipped (as editors save them) or not.
+/// \return the file's path
+static QByteArray writeSchematic(const QByteArray& schematic, bool gzipped) {
+    QByteArray path = QDir::temp().filePath(gzipped ? "test-gzipped.schematic" : "test.schematic").toLocal8Bit();
+    if (gzipped) {
+        gzFile file = gzopen(path.constData(), "wb");
+        gzwrite(file, schematic.constData(), schematic.size());
+        gzclose(file);
+    } else {
+        QFile file(path);
+        file.open(QIODevice::WriteOnly);
+        file.write(schematic);
+    }
+    return path;
+}
+
+/// Decodes the schematic whole, into tags, as the importer used to.  (retrieveData streams uncompressed files
+/// incorrectly, so we hand the decoder the schematic's bytes ourselves.)
+static TagCompound* readTags(const QByteArray& schematic) {
+    std::stringstream ss(std::string(schematic.constData(), schematic.size()));
+    ss.get(); // the root's tag id
+    TagCompound* tags = new TagCompound(ss);
+    if (tags->getWidth() != SCHEMATIC_WIDTH || tags->getHeight() != SCHEMATIC_HEIGHT ||
+            tags->getLength() != SCHEMATIC_LENGTH || !tags->getBlocksId() || !tags->getBlocksData()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: tags misread the schematic" << std::endl;
+        delete tags;
+        return NULL;
+    }
+    return tags;
+}
+
+void SchematicTests::readerMatchesTags() {
+    QByteArray ids, data;
+    makeBlocks(ids, data);
+    QByteArray schematic = makeSchematic(ids, data);
+    TagCompound* tags = readTags(schematic);
+    if (!tags) {
+        return;
+    }
+    for (int gzipped = 0; gzipped < 2; gzipped++) {
+        QByteArray path = writeSchematic(schematic, gzipped);
+        SchematicReader reader;
+        if (!reader.open(path.constData())) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: couldn't open schematic, gzipped=" << gzipped
+                << std::endl;
+            QFile::remove(path);
+            continue;
+        }
+        if (reader.getWidth() != tags->getWidth() || reader.getHeight() != tags->getHeight() ||
+                reader.getLength() != tags->getLength()) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: dimensions differ, gzipped=" << gzipped << std::endl;
+        }
+
+        // read a few blocks at a time, so that the chunks straddle the rows
+        const int CHUNK_BLOCKS = 7;
+        unsigned char chunkIds[CHUNK_BLOCKS];
+        unsigned char chunkData[CHUNK_BLOCKS];
+        int blocksCompared = 0;
+        for (int blocksRead; (blocksRead = reader.read(chunkIds, chunkData, CHUNK_BLOCKS)) != 0; ) {
+            for (int i = 0; i < blocksRead; i++, blocksCompared++) {
+                if (chunkIds[i] != (unsigned char)tags->getBlocksId()[blocksCompared] ||
+                        chunkData[i] != (unsigned char)tags->getBlocksData()[blocksCompared]) {
+                    std::cout << __FILE__ << ":" << __LINE__ << " ERROR: block " << blocksCompared
+                        << " differs, gzipped=" << gzipped << std::endl;
+                }
+            }
+        }
+        if (blocksCompared != SCHEMATIC_BLOCKS) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: read " << blocksCompared << " of "
+                << SCHEMATIC_BLOCKS << " blocks, gzipped=" << gzipped << std::endl;
+        }
+        QFile::remove(path);
+    }
+    delete tags;
+}
+
+/// Creates the voxels for the tags' blocks one at a time, as the importer used to (but with the ids unsigned).
+static void importTags(VoxelTree& tree, const TagCompound& tags) {
+    int max = std::max(std::max(tags.getWidth(), tags.getLength()), tags.getHeight());
+    int scale = 1;
+    while (max > scale) {
+        scale *= 2;
+    }
+    float size = 1.0f / scale;
+    float half = size / 2;
+    int red = 128, green = 128, blue = 128;
+    for (int y = 0; y < tags.getHeight(); y++) {
+        for (int z = 0; z < tags.getLength(); z++) {
+            for (int x = 0; x < tags.getWidth(); x++) {
+                int pos = ((y * tags.getLength()) + z) * tags.getWidth() + x;
+                int id = (unsigned char)tags.getBlocksId()[pos];
+                int data = (unsigned char)tags.getBlocksData()[pos];
+
+                int create = 1;
+                computeBlockColor(id, data, red, green, blue, create);
+
+                switch (create) {
+                    case 1:
+                        tree.createVoxel(size * x, size * y, size * z, size, red, green, blue, true);
+                        break;
+                    case 2:
+                        switch (data) {
+                            case 0:
+                                tree.createVoxel(size * x + half, size * y + half, size * z, half,
+                                    red, green, blue, true);
+                                tree.createVoxel(size * x + half, size * y + half, size * z + half, half,
+                                    red, green, blue, true);
+                                break;
+                            case 1:
+                                tree.createVoxel(size * x, size * y + half, size * z, half, red, green, blue, true);
+                                tree.createVoxel(size * x, size * y + half, size * z + half, half,
+                                    red, green, blue, true);
+                                break;
+                            case 2:
+                                tree.createVoxel(size * x, size * y + half, size * z + half, half,
+                                    red, green, blue, true);
+                                tree.createVoxel(size * x + half, size * y + half, size * z + half, half,
+                                    red, green, blue, true);
+                                break;
+                            case 3:
+                                tree.createVoxel(size * x, size * y + half, size * z, half, red, green, blue, true);
+                                tree.createVoxel(size * x + half, size * y + half, size * z, half,
+                                    red, green, blue, true);
+                                break;
+                        }
+                        // There's no break on purpose.
+                    case 3:
+                        tree.createVoxel(size * x, size * y, size * z, half, red, green, blue, true);
+                        tree.createVoxel(size * x + half, size * y, size * z, half, red, green, blue, true);
+                        tree.createVoxel(size * x, size * y, size * z + half, half, red, green, blue, true);
+                        tree.createVoxel(size * x + half, size * y, size * z + half, half, red, green, blue, true);
+                        break;
+                }
+            }
+        }
+    }
+}
+
+static bool voxelsMatch(VoxelTree& first, VoxelTree& second) {
+    QVector<BulkVoxel> firstVoxels;
+    first.collectVoxels(firstVoxels);
+    QVector<BulkVoxel> secondVoxels;
+    second.collectVoxels(secondVoxels);
+    if (firstVoxels.size() != secondVoxels.size()) {
+        return false;
+    }
+    for (int i = 0; i < firstVoxels.size(); i++) {
+        if (firstVoxels.at(i).key != secondVoxels.at(i).key ||
+                memcmp(firstVoxels.at(i).color, secondVoxels.at(i).color, sizeof(rgbColor)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SchematicTests::importMatchesTags() {
+    QByteArray ids, data;
+    makeBlocks(ids, data);
+    QByteArray schematic = makeSchematic(ids, data);
+    TagCompound* tags = readTags(schematic);
+    if (!tags) {
+        return;
+    }
+    VoxelTree expectedTree;
+    importTags(expectedTree, *tags);
+    delete tags;
+
+    for (int gzipped = 0; gzipped < 2; gzipped++) {
+        QByteArray path = writeSchematic(schematic, gzipped);
+        VoxelTree tree;
+        if (!tree.readFromSchematicFile(path.constData())) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: couldn't import schematic, gzipped=" << gzipped
+                << std::endl;
+        } else if (!voxelsMatch(expectedTree, tree)) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: imported voxels differ, gzipped=" << gzipped
+                << std::endl;
+        }
+        QFile::remove(path);
+    }
+}
+
+void SchematicTests::runAllTests() {
+    readerMatchesTags();
+    importMatchesTags();
+}
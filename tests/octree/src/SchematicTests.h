@@ -0,0 +1,27 @@
+//
+//  SchematicTests.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_SchematicTests_h
+#define hifi_SchematicTests_h
+
+namespace SchematicTests {
+
+    /// Writes a small schematic (gzipped and not, with other tags ahead of the blocks) and checks that SchematicReader
+    /// reads the same dimensions and blocks as the TagCompound decoder does, block ids of 128 and above included.
+    void readerMatchesTags();
+
+    /// Imports the same schematics and checks that the voxels are those that the TagCompound decoder's blocks make.
+    void importMatchesTags();
+
+    void runAllTests();
+}
+
+#endif // hifi_SchematicTests_h
@@ -0,0 +1,57 @@
+//
+//  TestWorld.cpp
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstdlib>
+#include <cstring>
+#include <math.h>
+
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "TestWorld.h"
+
+float TestWorld::terrainHeight(float x, float z) {
+    return 0.25f + 0.05f * sinf(x * 17.0f) * cosf(z * 13.0f) + 0.02f * sinf((x + z) * 61.0f);
+}
+
+void TestWorld::buildTerrain(VoxelTree& tree, int resolution) {
+    srand(1);
+    float scale = 1.0f / resolution;
+    for (int i = 0; i < resolution; i++) {
+        float x = i * scale;
+        for (int j = 0; j < resolution; j++) {
+            float z = j * scale;
+            float y = floorf(terrainHeight(x, z) * resolution) * scale;
+            tree.createVoxel(x, y, z, scale, randomColorValue(64), randomColorValue(64), randomColorValue(64));
+
+            const int FLOATING_VOXEL_ODDS = 64;
+            if (randIntInRange(0, FLOATING_VOXEL_ODDS) == 0) {
+                tree.createVoxel(x, y + randIntInRange(8, 64) * scale, z, scale, 255, 255, 255);
+            }
+        }
+    }
+}
+
+bool TestWorld::subtreesMatch(VoxelTreeElement* first, VoxelTreeElement* second) {
+    if (first->isColored() != second->isColored() ||
+            (first->isColored() && memcmp(first->getColor(), second->getColor(), sizeof(rgbColor)) != 0)) {
+        return false;
+    }
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        VoxelTreeElement* firstChild = first->getChildAtIndex(i);
+        VoxelTreeElement* secondChild = second->getChildAtIndex(i);
+        if ((firstChild == NULL) != (secondChild == NULL) ||
+                (firstChild && !subtreesMatch(firstChild, secondChild))) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,31 @@
+//
+//  TestWorld.h
+//  tests/octree/src
+//
+//  Created by High Fidelity on 4/14/14.
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_TestWorld_h
+#define hifi_TestWorld_h
+
+class VoxelTree;
+class VoxelTreeElement;
+
+namespace TestWorld {
+
+    /// Fills the tree with rolling terrain a voxel thick, resolution voxels on a side, with the odd floating voxel
+    /// above it: a stand-in for a large world, which is the same every time.
+    void buildTerrain(VoxelTree& tree, int resolution);
+
+    /// Returns the height of the terrain's surface (in tree units) at the given point.
+    float terrainHeight(float x, float z);
+
+    /// Checks whether two subtrees have the same elements with the same colors.
+    bool subtreesMatch(VoxelTreeElement* first, VoxelTreeElement* second);
+}
+
+#endif // hifi_TestWorld_h
@@ -0,0 +1,43 @@
+//
+//  main.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <VoxelTree.h>
+
+#include "BrickTests.h"
+#include "BulkBuildTests.h"
+#include "ChangeJournalTests.h"
+#include "FrustumTests.h"
+#include "JurisdictionTests.h"
+#include "MortonKeyTests.h"
+#include "OcclusionTests.h"
+#include "RayCastTests.h"
+#include "ReaverageTests.h"
+#include "SchematicTests.h"
+#include "TestWorld.h"
+
+int main(int argc, char** argv) {
+    MortonKeyTests::runAllTests();
+    JurisdictionTests::runAllTests();
+    ChangeJournalTests::runAllTests();
+    BulkBuildTests::runAllTests();
+    ReaverageTests::runAllTests();
+    BrickTests::runAllTests();
+    SchematicTests::runAllTests();
+
+    // a quarter million voxels or so
+    const int TERRAIN_RESOLUTION = 512;
+    VoxelTree tree;
+    TestWorld::buildTerrain(tree, TERRAIN_RESOLUTION);
+
+    FrustumTests::runAllTests(tree);
+    RayCastTests::runAllTests(tree);
+    OcclusionTests::runAllTests(tree);
+    return 0;
+}
@@ -13,8 +13,11 @@
 #include <SharedUtil.h>
 #include "SceneUtils.h"
 #include <JurisdictionMap.h>
+#include <QRunnable>
 #include <QString>
 #include <QStringList>
+#include <QThreadPool>
+#include <QVector>
 
 
 int _nodeCount=0;
@@ -60,9 +63,100 @@ void voxelTutorial(VoxelTree * tree) {
 }
 
 
-void processSplitSVOFile(const char* splitSVOFile,const char* splitJurisdictionRoot,const char*  splitJurisdictionEndNodes) {
-    char outputFileName[512];
+/// Builds the SVO for one jurisdiction end node from the voxels under it in the root SVO, on the global thread pool,
+/// keeping the element statistics that it changes apart for the caller to merge.
+class BuildEndNodeTask : public QRunnable {
+public:
+
+    BuildEndNodeTask(VoxelTree* rootSVO, const unsigned char* endNodeCode, VoxelTree* endNodeTree,
+        OctreeElementStats& stats);
+
+    virtual void run();
+
+private:
+
+    void build();
+
+    VoxelTree* _rootSVO;
+    const unsigned char* _endNodeCode;
+    VoxelTree* _endNodeTree;
+    OctreeElementStats& _stats;
+};
+
+BuildEndNodeTask::BuildEndNodeTask(VoxelTree* rootSVO, const unsigned char* endNodeCode, VoxelTree* endNodeTree,
+        OctreeElementStats& stats) :
+    _rootSVO(rootSVO),
+    _endNodeCode(endNodeCode),
+    _endNodeTree(endNodeTree),
+    _stats(stats)
+{
+}
 
+void BuildEndNodeTask::run() {
+    OctreeElement::setThreadStats(&_stats);
+    build();
+    OctreeElement::setThreadStats(NULL);
+}
+
+void BuildEndNodeTask::build() {
+    // create a small voxels at corners of the endNode Tree, this will is a hack
+    // to work around a bug in voxel server that will send Voxel not exists
+    // for regions that don't contain anything even if they're not in the
+    // jurisdiction of the server
+    // This hack assumes the end nodes for demo dinner since it only guarantees
+    // nodes in the 8 child voxels of the main root voxel
+    const float verySmall = 0.015625;
+    _endNodeTree->createVoxel(0.0, 0.0, 0.0, verySmall, 1, 1, 1, true);
+    _endNodeTree->createVoxel(1.0, 0.0, 0.0, verySmall, 1, 1, 1, true);
+    _endNodeTree->createVoxel(0.0, 1.0, 0.0, verySmall, 1, 1, 1, true);
+    _endNodeTree->createVoxel(0.0, 0.0, 1.0, verySmall, 1, 1, 1, true);
+    _endNodeTree->createVoxel(1.0, 1.0, 1.0, verySmall, 1, 1, 1, true);
+    _endNodeTree->createVoxel(1.0, 1.0, 0.0, verySmall, 1, 1, 1, true);
+    _endNodeTree->createVoxel(0.0, 1.0, 1.0, verySmall, 1, 1, 1, true);
+    _endNodeTree->createVoxel(1.0, 0.0, 1.0, verySmall, 1, 1, 1, true);
+
+    // Delete the voxel for the EndNode from the temporary tree, so we can
+    // import our endNode content into it...
+    _endNodeTree->deleteOctalCodeFromTree(_endNodeCode, COLLAPSE_EMPTY_TREE);
+
+    // the root SVO isn't changed until every end node has been built, so we can all read it at once
+    VoxelPositionSize endNodeDetails;
+    voxelDetailsForCode(_endNodeCode, endNodeDetails);
+    VoxelTreeElement* endNode = _rootSVO->getVoxelAt(endNodeDetails.x, endNodeDetails.y, endNodeDetails.z,
+        endNodeDetails.s);
+    if (endNode) {
+        QVector<BulkVoxel> voxels;
+        _rootSVO->collectVoxels(voxels, endNode);
+        _endNodeTree->createVoxels(voxels);
+    }
+}
+
+/// Writes one SVO file on the global thread pool.
+class WriteSVOTask : public QRunnable {
+public:
+
+    WriteSVOTask(VoxelTree* tree, const QString& fileName);
+
+    virtual void run();
+
+private:
+
+    VoxelTree* _tree;
+    QString _fileName;
+};
+
+WriteSVOTask::WriteSVOTask(VoxelTree* tree, const QString& fileName) :
+    _tree(tree),
+    _fileName(fileName)
+{
+}
+
+void WriteSVOTask::run() {
+    qDebug() << "outputFile:" << _fileName;
+    _tree->writeToSVOFile(_fileName.toLocal8Bit().constData());
+}
+
+void processSplitSVOFile(const char* splitSVOFile,const char* splitJurisdictionRoot,const char*  splitJurisdictionEndNodes) {
     qDebug("splitSVOFile: %s Jurisdictions Root: %s EndNodes: %s",
             splitSVOFile, splitJurisdictionRoot, splitJurisdictionEndNodes);
 
@@ -75,49 +169,37 @@ void processSplitSVOFile(const char* splitSVOFile,const char* splitJurisdictionR
     printOctalCode(jurisdiction.getRootOctalCode());
 
     qDebug("Jurisdiction End Nodes: %d ", jurisdiction.getEndNodeCount());
+
+    // build the end node SVOs side by side, then write them side by side; nothing may delete an element while the
+    // writers' bags are watching for deletions, so the trees are only deleted once all have been written
+    QVector<VoxelTree*> endNodeTrees;
+    QVector<OctreeElementStats> endNodeStats(jurisdiction.getEndNodeCount());
     for (int i = 0; i < jurisdiction.getEndNodeCount(); i++) {
         unsigned char* endNodeCode = jurisdiction.getEndNodeOctalCode(i);
         qDebug("End Node: %d ", i);
         printOctalCode(endNodeCode);
 
-        // get the endNode details
-        VoxelPositionSize endNodeDetails;
-        voxelDetailsForCode(endNodeCode, endNodeDetails);
+        // endNodeTrees reaverage, since only the leaves are copied into them
+        endNodeTrees.append(new VoxelTree(true));
+        QThreadPool::globalInstance()->start(new BuildEndNodeTask(&rootSVO, endNodeCode, endNodeTrees.last(),
+            endNodeStats[i]));
+    }
+    QThreadPool::globalInstance()->waitForDone();
+    foreach (const OctreeElementStats& stats, endNodeStats) {
+        OctreeElement::mergeStats(stats);
+    }
 
-        // Now, create a split SVO for the EndNode.
-        // copy the EndNode into a temporary tree
-        VoxelTree endNodeTree;
+    for (int i = 0; i < endNodeTrees.size(); i++) {
+        QThreadPool::globalInstance()->start(new WriteSVOTask(endNodeTrees.at(i),
+            QString("splitENDNODE%1%2").arg(i).arg(splitSVOFile)));
+    }
+    QThreadPool::globalInstance()->waitForDone();
+    qDeleteAll(endNodeTrees);
 
-        // create a small voxels at corners of the endNode Tree, this will is a hack
-        // to work around a bug in voxel server that will send Voxel not exists
-        // for regions that don't contain anything even if they're not in the
-        // jurisdiction of the server
-        // This hack assumes the end nodes for demo dinner since it only guarantees
-        // nodes in the 8 child voxels of the main root voxel
-        const float verySmall = 0.015625;
-        endNodeTree.createVoxel(0.0, 0.0, 0.0, verySmall, 1, 1, 1, true);
-        endNodeTree.createVoxel(1.0, 0.0, 0.0, verySmall, 1, 1, 1, true);
-        endNodeTree.createVoxel(0.0, 1.0, 0.0, verySmall, 1, 1, 1, true);
-        endNodeTree.createVoxel(0.0, 0.0, 1.0, verySmall, 1, 1, 1, true);
-        endNodeTree.createVoxel(1.0, 1.0, 1.0, verySmall, 1, 1, 1, true);
-        endNodeTree.createVoxel(1.0, 1.0, 0.0, verySmall, 1, 1, 1, true);
-        endNodeTree.createVoxel(0.0, 1.0, 1.0, verySmall, 1, 1, 1, true);
-        endNodeTree.createVoxel(1.0, 0.0, 1.0, verySmall, 1, 1, 1, true);
-
-        // Delete the voxel for the EndNode from the temporary tree, so we can
-        // import our endNode content into it...
-        endNodeTree.deleteOctalCodeFromTree(endNodeCode, COLLAPSE_EMPTY_TREE);
-
-        VoxelTreeElement* endNode = rootSVO.getVoxelAt(endNodeDetails.x,
-                                                endNodeDetails.y,
-                                                endNodeDetails.z,
-                                                endNodeDetails.s);
-
-        rootSVO.copySubTreeIntoNewTree(endNode, &endNodeTree, false);
-
-        sprintf(outputFileName, "splitENDNODE%d%s", i, splitSVOFile);
-        qDebug("outputFile: %s", outputFileName);
-        endNodeTree.writeToSVOFile(outputFileName);
+    for (int i = 0; i < jurisdiction.getEndNodeCount(); i++) {
+        unsigned char* endNodeCode = jurisdiction.getEndNodeOctalCode(i);
+        VoxelPositionSize endNodeDetails;
+        voxelDetailsForCode(endNodeCode, endNodeDetails);
 
         // Delete the voxel for the EndNode from the root tree...
         rootSVO.deleteOctalCodeFromTree(endNodeCode, COLLAPSE_EMPTY_TREE);
@@ -126,73 +208,39 @@ void processSplitSVOFile(const char* splitSVOFile,const char* splitJurisdictionR
         // to work around a bug in voxel server that will send Voxel not exists
         // for regions that don't contain anything even if they're not in the
         // jurisdiction of the server
+        const float verySmall = 0.015625;
         float x = endNodeDetails.x + endNodeDetails.s * 0.5;
         float y = endNodeDetails.y + endNodeDetails.s * 0.5;
         float z = endNodeDetails.z + endNodeDetails.s * 0.5;
         float s = endNodeDetails.s * verySmall;
 
         rootSVO.createVoxel(x, y, z, s, 1, 1, 1, true);
-
     }
 
-    sprintf(outputFileName, "splitROOT%s", splitSVOFile);
-    qDebug("outputFile: %s", outputFileName);
-    rootSVO.writeToSVOFile(outputFileName);
+    QString outputFileName = QString("splitROOT%1").arg(splitSVOFile);
+    qDebug() << "outputFile:" << outputFileName;
+    rootSVO.writeToSVOFile(outputFileName.toLocal8Bit().constData());
 
     qDebug("exiting now");
 }
 
-class copyAndFillArgs {
-public:
-    VoxelTree* destinationTree;
-    unsigned long outCount;
-    unsigned long inCount;
-    unsigned long originalCount;
-
-};
-
-bool copyAndFillOperation(OctreeElement* element, void* extraData) {
+/// Adds a copy of each leaf to the voxels, and below it a column of voxels of the same size down to the ground.
+bool collectFillOperation(OctreeElement* element, void* extraData) {
     VoxelTreeElement* voxel = (VoxelTreeElement*)element;
-    copyAndFillArgs* args = (copyAndFillArgs*)extraData;
-    char outputMessage[128];
-
-    args->inCount++;
-    int percentDone = (100*args->inCount/args->originalCount);
-
-    // For each leaf node...
-    if (voxel->isLeaf()) {
-        // create a copy of the leaf in the copy destination
-        float x = voxel->getCorner().x;
-        float y = voxel->getCorner().y;
-        float z = voxel->getCorner().z;
-        float s = voxel->getScale();
-        unsigned char red = voxel->getColor()[RED_INDEX];
-        unsigned char green = voxel->getColor()[GREEN_INDEX];
-        unsigned char blue = voxel->getColor()[BLUE_INDEX];
-        bool destructive = true;
-
-        args->destinationTree->createVoxel(x, y, z, s, red, green, blue, destructive);
-        args->outCount++;
-
-        sprintf(outputMessage,"Completed: %d%% (%lu of %lu) - Creating voxel %lu at [%f,%f,%f,%f]",
-            percentDone,args->inCount,args->originalCount,args->outCount,x,y,z,s);
-        printf("%s",outputMessage);
-        for (unsigned int b = 0; b < strlen(outputMessage); b++) {
-            printf("\b");
-        }
-
-        // and create same sized leafs from this leaf voxel down to zero in the destination tree
-        for (float yFill = y-s; yFill >= 0.0f; yFill -= s) {
-            args->destinationTree->createVoxel(x, yFill, z, s, red, green, blue, destructive);
-
-            args->outCount++;
-
-        sprintf(outputMessage,"Completed: %d%% (%lu of %lu) - Creating fill voxel %lu at [%f,%f,%f,%f]",
-            percentDone,args->inCount,args->originalCount,args->outCount,x,y,z,s);
-            printf("%s",outputMessage);
-            for (unsigned int b = 0; b < strlen(outputMessage); b++) {
-                printf("\b");
-            }
+    QVector<BulkVoxel>* voxels = (QVector<BulkVoxel>*)extraData;
+
+    if (voxel->isLeaf() && voxel->isColored() && voxel->getMortonKey().isValid()) {
+        BulkVoxel fill;
+        memcpy(fill.color, voxel->getColor(), sizeof(rgbColor));
+
+        // step down the column in whole voxels
+        const MortonKey& key = voxel->getMortonKey();
+        int level = key.getLevel();
+        int dimension = 1 << level;
+        glm::vec3 corner = key.getCorner() * (float)dimension;
+        for (int y = (int)corner.y; y >= 0; y--) {
+            fill.key = MortonKey::forCoordinates(level, (int)corner.x, y, (int)corner.z);
+            voxels->append(fill);
         }
     }
     return true;
@@ -212,23 +260,18 @@ void processFillSVOFile(const char* fillSVOFile) {
     qDebug("Original Voxels reAveraged");
     qDebug("Nodes after reaveraging %lu nodes", originalSVO.getOctreeElementsCount());
 
-    copyAndFillArgs args;
-    args.destinationTree = &filledSVO;
-    args.inCount = 0;
-    args.outCount = 0;
-    args.originalCount = originalSVO.getOctreeElementsCount();
     qDebug("Begin processing...");
-    originalSVO.recurseTreeWithOperation(copyAndFillOperation, &args);
+    QVector<BulkVoxel> voxels;
+    originalSVO.recurseTreeWithOperation(collectFillOperation, &voxels);
+    qDebug("Voxels to create during filling %d", voxels.size());
+
+    // where columns cross, the later leaf's voxel wins, as it would if they were created one at a time
+    VoxelTree::sortVoxels(voxels);
+    bool destructive = true;
+    filledSVO.createVoxels(voxels, destructive);
     qDebug("DONE processing...");
-
-    qDebug("Original input nodes used for filling %lu nodes", args.originalCount);
-    qDebug("Input nodes traversed during filling %lu nodes", args.inCount);
-    qDebug("Nodes created during filling %lu nodes", args.outCount);
     qDebug("Nodes after filling %lu nodes", filledSVO.getOctreeElementsCount());
 
-    filledSVO.reaverageOctreeElements();
-    qDebug("Nodes after reaveraging %lu nodes", filledSVO.getOctreeElementsCount());
-
     sprintf(outputFileName, "filled%s", fillSVOFile);
     qDebug("outputFile: %s", outputFileName);
     filledSVO.writeToSVOFile(outputFileName);
@@ -236,6 +279,80 @@ void processFillSVOFile(const char* fillSVOFile) {
     qDebug("exiting now");
 }
 
+/// Reads one SVO file and collects its voxels, on the global thread pool, keeping the element statistics that it
+/// changes apart for the caller to merge.
+class ReadSVOTask : public QRunnable {
+public:
+
+    ReadSVOTask(const QString& fileName, QVector<BulkVoxel>& voxels, OctreeElementStats& stats);
+
+    virtual void run();
+
+private:
+
+    void read();
+
+    QString _fileName;
+    QVector<BulkVoxel>& _voxels;
+    OctreeElementStats& _stats;
+};
+
+ReadSVOTask::ReadSVOTask(const QString& fileName, QVector<BulkVoxel>& voxels, OctreeElementStats& stats) :
+    _fileName(fileName),
+    _voxels(voxels),
+    _stats(stats)
+{
+}
+
+void ReadSVOTask::run() {
+    OctreeElement::setThreadStats(&_stats);
+    read();
+    OctreeElement::setThreadStats(NULL);
+}
+
+void ReadSVOTask::read() {
+    VoxelTree tree;
+    if (!tree.readFromSVOFile(_fileName.toLocal8Bit().constData())) {
+        qDebug() << "Failed to read" << _fileName;
+        return;
+    }
+    tree.collectVoxels(_voxels);
+}
+
+void processImportSVOFiles(const char* importSVOFiles) {
+    qDebug("importSVOFiles: %s", importSVOFiles);
+
+    // read the files side by side, then combine their voxels into one tree, later files winning where they overlap
+    QStringList fileNames = QString(importSVOFiles).split(QString(","));
+    QVector<QVector<BulkVoxel> > fileVoxels(fileNames.size());
+    QVector<OctreeElementStats> fileStats(fileNames.size());
+    for (int i = 0; i < fileNames.size(); i++) {
+        QThreadPool::globalInstance()->start(new ReadSVOTask(fileNames.at(i), fileVoxels[i], fileStats[i]));
+    }
+    QThreadPool::globalInstance()->waitForDone();
+    foreach (const OctreeElementStats& stats, fileStats) {
+        OctreeElement::mergeStats(stats);
+    }
+
+    QVector<BulkVoxel> voxels;
+    foreach (const QVector<BulkVoxel>& someVoxels, fileVoxels) {
+        voxels += someVoxels;
+    }
+    qDebug("Voxels read from %d files: %d", fileNames.size(), voxels.size());
+    VoxelTree::sortVoxels(voxels);
+
+    VoxelTree importedSVO(true); // reaveraging
+    bool destructive = true;
+    importedSVO.createVoxels(voxels, destructive);
+    qDebug("Nodes after importing %lu nodes", importedSVO.getOctreeElementsCount());
+
+    const char* outputFileName = "imported.svo";
+    qDebug("outputFile: %s", outputFileName);
+    importedSVO.writeToSVOFile(outputFileName);
+
+    qDebug("exiting now");
+}
+
 void unitTest(VoxelTree * tree);
 
 
@@ -319,6 +436,15 @@ int main(int argc, const char * argv[])
     }
 
 
+    // Handles combining several SVOs into one, which is written to imported.svo
+    const char* IMPORT_SVO = "--importSVO";
+    const char* importSVOFiles = getCmdOption(argc, argv, IMPORT_SVO);
+    if (importSVOFiles) {
+        processImportSVOFiles(importSVOFiles);
+        return 0;
+    }
+
+
     // Handles taking an SVO and filling in the empty space below the voxels to make it solid.
     const char* FILL_SVO = "--fillSVO";
     const char* fillSVOFile = getCmdOption(argc, argv, FILL_SVO);